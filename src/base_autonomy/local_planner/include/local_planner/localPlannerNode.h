@@ -0,0 +1,130 @@
+#ifndef LOCAL_PLANNER_NODE_H
+#define LOCAL_PLANNER_NODE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+
+#include "nav_msgs/msg/odometry.hpp"
+#include "sensor_msgs/msg/point_cloud2.hpp"
+#include <sensor_msgs/msg/joy.hpp>
+#include <std_msgs/msg/float32.hpp>
+#include <std_msgs/msg/bool.hpp>
+#include <nav_msgs/msg/path.hpp>
+
+#include <geometry_msgs/msg/point_stamped.hpp>
+#include <geometry_msgs/msg/polygon_stamped.hpp>
+
+#include <pcl/filters/voxel_grid.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include "local_planner/pathLibrary.h"
+#include "local_planner/pathEvaluator.h"
+#include "local_planner/pathSetSelector.h"
+
+namespace local_planner
+{
+
+// localPlanner as a node, run by the localPlanner executable or loaded as a component, messages
+// are taken and published as unique_ptr so they are moved rather than copied with intra-process
+// comms, and the planning cycle runs on a 100 Hz timer, throws std::runtime_error when the path
+// library cannot be read
+class LocalPlannerNode : public rclcpp::Node
+{
+public:
+  explicit LocalPlannerNode(const rclcpp::NodeOptions& options);
+
+protected:
+  // virtual so a derived node can see the message the subscription hands over
+  virtual void terrainCloudHandler(sensor_msgs::msg::PointCloud2::UniquePtr terrainCloud2);
+
+private:
+  void readPathLibrary();
+
+  void odometryHandler(nav_msgs::msg::Odometry::UniquePtr odom);
+  void laserCloudHandler(sensor_msgs::msg::PointCloud2::UniquePtr laserCloud2);
+  void joystickHandler(sensor_msgs::msg::Joy::UniquePtr joy);
+  void goalHandler(geometry_msgs::msg::PointStamped::UniquePtr goal);
+  void speedHandler(std_msgs::msg::Float32::UniquePtr speed);
+  void boundaryHandler(geometry_msgs::msg::PolygonStamped::UniquePtr boundary);
+  void addedObstaclesHandler(sensor_msgs::msg::PointCloud2::UniquePtr addedObstacles2);
+  void checkObstacleHandler(std_msgs::msg::Bool::UniquePtr checkObs);
+  void plannerCycle();
+
+  std::string pathFolder;
+  std::string pathLibraryFile;
+  double sensorOffsetX = 0;
+  double sensorOffsetY = 0;
+  double laserVoxelSize = 0.05;
+  double terrainVoxelSize = 0.2;
+  bool checkObstacle = true;
+  bool useCost = false;
+  double maxSpeed = 1.0;
+  bool autonomyMode = false;
+  double autonomySpeed = 1.0;
+  double joyToSpeedDelay = 2.0;
+  double joyToCheckObstacleDelay = 5.0;
+  double goalX = 0;
+  double goalY = 0;
+  PathLibraryGrid grid;
+  PathEvaluatorParams evalParams;
+  std::vector<std::string> pathSetFolders;
+  std::vector<double> pathSetMinSpeeds;
+  std::vector<double> pathSetMaxObstacleDensities;
+  std::vector<double> pathSetAdjacentRanges;
+  PathSetSelectorParams selectorParams;
+
+  float joySpeed = 0;
+  float joySpeedRaw = 0;
+  float joyDir = 0;
+
+  double odomTime = 0;
+  double joyTime = 0;
+
+  float vehicleYaw = 0;
+  float vehicleX = 0, vehicleY = 0, vehicleZ = 0;
+
+  bool newPlannerCloud = false;
+
+  pcl::PointCloud<pcl::PointXYZI>::Ptr laserCloud;
+  pcl::PointCloud<pcl::PointXYZI>::Ptr laserCloudCrop;
+  pcl::PointCloud<pcl::PointXYZI>::Ptr terrainCloud;
+  pcl::PointCloud<pcl::PointXYZI>::Ptr terrainCloudCrop;
+  pcl::PointCloud<pcl::PointXYZI>::Ptr plannerCloud;
+  pcl::PointCloud<pcl::PointXYZI>::Ptr plannerCloudCrop;
+  pcl::PointCloud<pcl::PointXYZI>::Ptr plannerCloudSetCrop;
+  pcl::PointCloud<pcl::PointXYZI>::Ptr boundaryCloud;
+  pcl::PointCloud<pcl::PointXYZI>::Ptr addedObstacles;
+  pcl::VoxelGrid<pcl::PointXYZI> laserDwzFilter, terrainDwzFilter;
+
+  // one library and evaluator per path set, ordered from the shortest to the longest paths, a
+  // single set read from pathFolder unless pathSetFolders is given, each set evaluates within its own
+  // adjacentRange and the clouds are cropped once at the largest, that of set cropSetID
+  std::vector<std::unique_ptr<PathLibrary> > pathLibraries;
+  std::vector<std::unique_ptr<PathEvaluator> > pathEvaluators;
+  PathSetSelector pathSetSelector;
+  int pathSetID = 0;
+  int cropSetID = 0;
+  double cropRange = 0;
+  PathEvaluatorResult result;
+
+  rclcpp::Subscription<nav_msgs::msg::Odometry>::SharedPtr subOdometry;
+  rclcpp::Subscription<sensor_msgs::msg::PointCloud2>::SharedPtr subLaserCloud;
+  rclcpp::Subscription<sensor_msgs::msg::PointCloud2>::SharedPtr subTerrainCloud;
+  rclcpp::Subscription<sensor_msgs::msg::Joy>::SharedPtr subJoystick;
+  rclcpp::Subscription<geometry_msgs::msg::PointStamped>::SharedPtr subGoal;
+  rclcpp::Subscription<std_msgs::msg::Float32>::SharedPtr subSpeed;
+  rclcpp::Subscription<geometry_msgs::msg::PolygonStamped>::SharedPtr subBoundary;
+  rclcpp::Subscription<sensor_msgs::msg::PointCloud2>::SharedPtr subAddedObstacles;
+  rclcpp::Subscription<std_msgs::msg::Bool>::SharedPtr subCheckObstacle;
+  rclcpp::Publisher<nav_msgs::msg::Path>::SharedPtr pubPath;
+  rclcpp::Publisher<sensor_msgs::msg::PointCloud2>::SharedPtr pubFreePaths;
+  rclcpp::TimerBase::SharedPtr plannerTimer;
+};
+
+}
+
+#endif
@@ -0,0 +1,224 @@
+#ifndef PATH_EVALUATOR_H
+#define PATH_EVALUATOR_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include "local_planner/pathLibrary.h"
+
+// settings of the path evaluation, names and defaults follow the localPlanner parameters
+struct PathEvaluatorParams
+{
+  double vehicleLength = 0.6;
+  double vehicleWidth = 0.6;
+  bool twoWayDrive = true;
+  bool useTerrainAnalysis = false;
+  bool checkRotObstacle = false;
+  double adjacentRange = 3.5;
+  double obstacleHeightThre = 0.2;
+  double groundHeightThre = 0.1;
+  double costHeightThre = 0.1;
+  double costScore = 0.02;
+  int pointPerPathThre = 2;
+  double minRelZ = -0.5;
+  double maxRelZ = 0.25;
+  double dirWeight = 0.02;
+  double dirThre = 90.0;
+  bool dirToVehicle = false;
+  double pathScale = 1.0;
+  double minPathScale = 0.75;
+  double pathScaleStep = 0.25;
+  bool pathScaleBySpeed = true;
+  double minPathRange = 1.0;
+  double pathRangeStep = 0.5;
+  bool pathRangeBySpeed = true;
+  bool pathCropByGoal = true;
+  double goalCloseDis = 1.0;
+  double goalClearRange = 0.5;
+  bool useBitsetEval = false;
+  int threadNum = 1;
+  bool useIncrementalEval = false;
+  double incrementalDisThre = 0.05;
+  double incrementalAngThre = 2.0;
+
+  // scale path scores by the time to collision with the nearest obstacle along the path at the
+  // commanded speed, paths reaching it within ttcThre in s drop toward ttcScore
+  bool useTtcCost = false;
+  double maxSpeed = 1.0;
+  double ttcThre = 2.0;
+  double ttcScore = 0.1;
+};
+
+// vehicle and command state of one planning cycle, joySpeed is normalized by maxSpeed and
+// joyDir is in deg in the vehicle frame, the goal is only used in autonomy mode, checkObstacle
+// is switched at runtime so it is kept here rather than with the parameters
+struct PathEvaluatorState
+{
+  float vehicleX = 0;
+  float vehicleY = 0;
+  float vehicleZ = 0;
+  float vehicleYaw = 0;
+  float joySpeed = 0;
+  float joyDir = 0;
+  bool autonomyMode = false;
+  bool checkObstacle = true;
+  float goalX = 0;
+  float goalY = 0;
+};
+
+struct PathEvaluatorResult
+{
+  bool pathFound = false;
+  int selectedGroupID = -1;
+  int selectedRotDir = -1;
+  double pathScale = 1.0;
+  float pathRange = 0;
+  float relativeGoalDis = 0;
+  float joyDir = 0;
+
+  // selected start path, scaled, rotated and cropped in the vehicle frame
+  pcl::PointCloud<pcl::PointXYZ> path;
+
+  // correspondence entries visited
+  long correspondenceLookupNum = 0;
+};
+
+class PathEvaluator
+{
+public:
+  PathEvaluator();
+
+  PathEvaluator(const PathEvaluator&) = delete;
+  PathEvaluator& operator=(const PathEvaluator&) = delete;
+
+  // the path library is used in place and must outlive the evaluator
+  void setPathLibrary(const PathLibrary& pathLibrary);
+  void setParams(const PathEvaluatorParams& params);
+
+  const PathEvaluatorParams& params() const { return evalParams; }
+  int pathNum() const { return pathNumber; }
+  int groupNum() const { return groupNumber; }
+
+  // transform a map frame cloud into the vehicle frame, keep the points within adjacentRange
+  // and append them to cloudCrop, checkRelZ applies minRelZ and maxRelZ without terrain analysis
+  void cropCloud(const pcl::PointCloud<pcl::PointXYZI>& cloud, const PathEvaluatorState& state, bool checkRelZ,
+                 pcl::PointCloud<pcl::PointXYZI>& cloudCrop) const;
+
+  // score all paths against a vehicle frame cloud and select a group, the path scale and range
+  // shrink until a group is found or their minimums are reached
+  bool evaluate(const pcl::PointCloud<pcl::PointXYZI>& plannerCloudCrop, const PathEvaluatorState& state,
+                PathEvaluatorResult& result);
+
+  // sparse points of the collision free paths of the last evaluate() in the vehicle frame
+  void getFreePaths(const PathEvaluatorResult& result, pcl::PointCloud<pcl::PointXYZI>& freePaths) const;
+
+  // per-path point counts, penalties and group scores of the last evaluate(), indexed by
+  // pathNum * rotDir + pathID and groupNum * rotDir + groupID
+  const std::vector<int>& clearPaths() const { return clearPathList; }
+  const std::vector<float>& pathPenalties() const { return pathPenaltyList; }
+  const std::vector<float>& clearPathPerGroupScores() const { return clearPathPerGroupScore; }
+
+  // distance in m along each path to its first obstacle in the last evaluate() with useTtcCost,
+  // indexed as clearPaths(), paths without one hold a negative value
+  const std::vector<float>& pathObstacleDis() const { return pathObsDisList; }
+
+private:
+  // per-thread buffers, voxel indices of the cloud arrays in one rotation direction, and the
+  // occupied voxels of it with their blocking point count and max ground height
+  struct VoxelScratch
+  {
+    std::vector<int> voxelInds;
+    std::vector<int> voxelMarkStamp;
+    std::vector<int> voxelPointNum;
+    std::vector<float> voxelGroundH;
+    std::vector<int> occupiedVoxels;
+    std::vector<uint64_t> pathBlockLevels;
+    int markStamp;
+  };
+
+  struct VoxelOccupancy
+  {
+    int ind;
+    int pointNum;
+    float groundH;
+  };
+
+  bool rotDirInRange(int rotDir, float joyDir) const;
+  bool rotDirClearOfRotObstacle(int rotDir) const;
+
+  void buildCloudArrays(const pcl::PointCloud<pcl::PointXYZI>& cloud, double pathScale, float pathRange,
+                        float relativeGoalDis);
+  void computeVoxelIndices(int rotDir, std::vector<int>& voxelInds) const;
+
+  void buildVoxelPathMasks();
+  void buildCorrespondenceArcLengths();
+  void markOccupiedVoxels(VoxelScratch& scratch) const;
+  void evaluateRotDir(int rotDir, VoxelScratch& scratch);
+  void evaluateRotDirBitset(int rotDir, VoxelScratch& scratch);
+  void evaluateRotDirIncremental(int rotDir, VoxelScratch& scratch, bool rebuild);
+  void markObstacleDis(int rotDir, double pathScale, VoxelScratch& scratch);
+  void scoreRotDir(int rotDir, float joyDir, float relativeGoalDis, float speed);
+
+  PathEvaluatorParams evalParams;
+
+  int pathNumber;
+  int groupNumber;
+  int gridVoxelNumX;
+  int gridVoxelNumY;
+  int gridVoxelNum;
+  float gridVoxelSize;
+  float searchRadius;
+  float gridVoxelOffsetX;
+  float gridVoxelOffsetY;
+  int pathMaskWordNum;
+
+  const int32_t *correspondenceOffsets;
+  const int32_t *correspondencePaths;
+  const PathLibraryPoint *libraryPathPoints;
+  int libraryPathPointNum;
+
+  std::vector<pcl::PointCloud<pcl::PointXYZ> > startPaths;
+  std::vector<pcl::PointCloud<pcl::PointXYZI> > paths;
+  std::vector<int> pathList;
+  std::vector<float> endDirPathList;
+
+  std::vector<int> clearPathList;
+  std::vector<float> pathPenaltyList;
+  std::vector<float> clearPathPerGroupScore;
+  std::vector<float> pathObsDisList;
+  int clearPathNumList[36];
+
+  // planner cloud of one path scale as arrays, scaled and cropped by the goal, cloudInRange
+  // flags the points within pathRange, the others are only kept for the obstacle distances
+  std::vector<float> cloudX;
+  std::vector<float> cloudY;
+  std::vector<float> cloudH;
+  std::vector<uint8_t> cloudInRange;
+  int cloudArraySize;
+
+  // bitset evaluation, one pathNum-bit mask per voxel
+  std::vector<uint64_t> voxelPathMasks;
+
+  // time-to-collision cost, arc length in m along the path at which each correspondence entry
+  // blocks it, parallel to correspondencePaths
+  std::vector<float> correspondenceArcLengths;
+  std::vector<VoxelScratch> voxelScratch;
+
+  // incremental evaluation, occupied voxels of the last evaluation of each rotation direction
+  // sorted by index, with the unsaturated per-path point counts and penalties they produce
+  std::vector<VoxelOccupancy> rotDirOccupancy[36];
+  std::vector<int> occupancyPointNumList;
+  std::vector<float> occupancyPenaltyList;
+  float vehicleXRec, vehicleYRec, vehicleYawRec;
+
+  long correspondenceLookupList[36];
+
+  // rotation obstacle angles of the last evaluation, used by getFreePaths()
+  float minObsAngCW, minObsAngCCW;
+};
+
+#endif
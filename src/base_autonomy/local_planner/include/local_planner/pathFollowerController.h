@@ -0,0 +1,115 @@
+#ifndef PATH_FOLLOWER_CONTROLLER_H
+#define PATH_FOLLOWER_CONTROLLER_H
+
+#include <vector>
+
+// settings of the path following, names and defaults follow the pathFollower parameters
+struct PathFollowerParams
+{
+  bool twoWayDrive = true;
+  double lookAheadDis = 0.5;
+  double yawRateGain = 7.5;
+  double stopYawRateGain = 7.5;
+  double maxYawRate = 45.0;
+  double maxSpeed = 1.0;
+  double maxAccel = 1.0;
+  double switchTimeThre = 1.0;
+  double dirDiffThre = 0.1;
+  double omniDirDiffThre = 1.5;
+  double noRotSpeed = 10.0;
+  double stopDisThre = 0.2;
+  double slowDwnDisThre = 1.0;
+  double slowRate1 = 0.25;
+  double slowRate2 = 0.5;
+  double slowTime1 = 2.0;
+  double slowTime2 = 2.0;
+  double stopTime = 5.0;
+  bool useCurvToSlow = false;
+  double maxLatAccel = 1.0;
+  double curvSampleDis = 0.1;
+  bool useLatencyComp = false;
+  double latencyTime = 0.1;
+  bool noRotAtGoal = true;
+  double goalCloseDis = 1.0;
+};
+
+// vehicle and command state of one control cycle, the pose is the latest odometry, time drives
+// the drive direction switching and odomTime the slow down and stop windows started at
+// slowInitTime and stopInitTime (0 when never started), joySpeed is normalized by maxSpeed,
+// joyYaw sets the yaw rate when stopped in manual operation, safetyStop takes the /stop bits
+struct PathFollowerState
+{
+  float vehicleX = 0;
+  float vehicleY = 0;
+  float vehicleYaw = 0;
+  double time = 0;
+  double odomTime = 0;
+  double slowInitTime = 0;
+  double stopInitTime = 0;
+  float joySpeed = 0;
+  float joyYaw = 0;
+  bool autonomyMode = false;
+  int safetyStop = 0;
+};
+
+// path in the frame of the vehicle pose it is anchored at, the anchor is in the odometry frame
+struct PathFollowerPath
+{
+  float vehicleXRec = 0;
+  float vehicleYRec = 0;
+  float vehicleYawRec = 0;
+  std::vector<float> x;
+  std::vector<float> y;
+};
+
+// velocity command in the vehicle frame, m/s and rad/s
+struct PathFollowerCmd
+{
+  float speedX = 0;
+  float speedY = 0;
+  float yawRate = 0;
+};
+
+// pure pursuit like path tracking of pathFollower, the look-ahead point advances along the path
+// given to step() until resetPath() is called for a new one, the speed is ramped at maxAccel
+class PathFollowerController
+{
+public:
+  PathFollowerController();
+
+  void setParams(const PathFollowerParams& params);
+  const PathFollowerParams& params() const { return followerParams; }
+
+  // restart the look-ahead point at the beginning, call when a new path is received
+  void resetPath();
+
+  // one control cycle of dt in s
+  PathFollowerCmd step(const PathFollowerState& state, const PathFollowerPath& path, float dt);
+
+  int pathPointID() const { return pathPointInd; }
+  bool navFwd() const { return navForward; }
+  float vehicleSpeed() const { return speed; }
+  float vehicleYawRate() const { return yawRate; }
+
+  // speed limit in m/s from the curvature of the path ahead of the vehicle at vehicleXRel,
+  // vehicleYRel in the path frame
+  float curvSpeedLimit(const PathFollowerPath& path, float vehicleXRel, float vehicleYRel) const;
+
+  // vehicle pose predictTime ahead of the given one at the last command
+  void predictVehiclePose(float predictTime, float& x, float& y, float& yaw) const;
+
+  // vehicle pose predictTime ahead of the given one at cmd held constant
+  static void predictVehiclePose(const PathFollowerCmd& cmd, float predictTime, float& x, float& y, float& yaw);
+
+private:
+  PathFollowerParams followerParams;
+
+  int pathPointInd;
+  bool navForward;
+  double switchTime;
+  float speed;
+  float yawRate;
+  PathFollowerCmd lastCmd;
+};
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef PATH_FOLLOWER_NODE_H
+#define PATH_FOLLOWER_NODE_H
+
+#include "rclcpp/rclcpp.hpp"
+
+#include "nav_msgs/msg/odometry.hpp"
+#include <sensor_msgs/msg/joy.hpp>
+#include <std_msgs/msg/float32.hpp>
+#include <std_msgs/msg/int8.hpp>
+#include <nav_msgs/msg/path.hpp>
+#include <geometry_msgs/msg/twist_stamped.hpp>
+
+// For real robot, ros2_sport_client.h sets pack(1) and leaves it set, it is restored here so the
+// classes declared after it keep their usual layout in every file including this header
+#include "unitree_api/msg/request.hpp"
+#pragma pack(push)
+#include "common/ros2_sport_client.h"
+#pragma pack(pop)
+
+#include "local_planner/pathFollowerController.h"
+
+namespace local_planner
+{
+
+// pathFollower as a node, run by the pathFollower executable or loaded as a component next to
+// localPlanner so /path is moved rather than copied with intra-process comms, the controller runs
+// on a 100 Hz wall timer, or with use_sim_time once per odometry message so a simulator stepping
+// its clock on the commands is not held back by the wall clock
+class PathFollowerNode : public rclcpp::Node
+{
+public:
+  explicit PathFollowerNode(const rclcpp::NodeOptions& options);
+
+protected:
+  // virtual so a derived node can see the message the subscription hands over
+  virtual void pathHandler(nav_msgs::msg::Path::UniquePtr pathIn);
+
+private:
+  void odomHandler(nav_msgs::msg::Odometry::UniquePtr odomIn);
+  void odomHistoryPose(double time, float& x, float& y, float& z, float& roll, float& pitch, float& yaw) const;
+  void joystickHandler(sensor_msgs::msg::Joy::UniquePtr joy);
+  void speedHandler(std_msgs::msg::Float32::UniquePtr speed);
+  void stopHandler(std_msgs::msg::Int8::UniquePtr stop);
+  void followerCycle(double cycleTime);
+
+  double sensorOffsetX = 0;
+  double sensorOffsetY = 0;
+  int pubSkipNum = 1;
+  int pubSkipCount = 0;
+  bool twoWayDrive = true;
+  double lookAheadDis = 0.5;
+  double yawRateGain = 7.5;
+  double stopYawRateGain = 7.5;
+  double maxYawRate = 45.0;
+  double maxSpeed = 1.0;
+  double maxAccel = 1.0;
+  double switchTimeThre = 1.0;
+  double dirDiffThre = 0.1;
+  double omniDirDiffThre = 1.5;
+  double noRotSpeed = 10.0;
+  double stopDisThre = 0.2;
+  double slowDwnDisThre = 1.0;
+  bool useInclRateToSlow = false;
+  double inclRateThre = 120.0;
+  double slowRate1 = 0.25;
+  double slowRate2 = 0.5;
+  double slowTime1 = 2.0;
+  double slowTime2 = 2.0;
+  bool useInclToStop = false;
+  double inclThre = 45.0;
+  double stopTime = 5.0;
+  bool useCurvToSlow = false;
+  double maxLatAccel = 1.0;
+  double curvSampleDis = 0.1;
+  bool useLatencyComp = false;
+  double latencyTime = 0.1;
+  bool noRotAtStop = false;
+  bool noRotAtGoal = true;
+  bool manualMode = false;
+  bool autonomyMode = false;
+  double autonomySpeed = 1.0;
+  double joyToSpeedDelay = 2.0;
+  double goalCloseDis = 1.0;
+  bool is_real_robot = false;
+
+  float joySpeed = 0;
+  float joySpeedRaw = 0;
+  float joyYaw = 0;
+  float joyManualFwd = 0;
+  float joyManualLeft = 0;
+  float joyManualYaw = 0;
+  int safetyStop = 0;
+
+  float vehicleX = 0;
+  float vehicleY = 0;
+  float vehicleZ = 0;
+  float vehicleRoll = 0;
+  float vehiclePitch = 0;
+  float vehicleYaw = 0;
+
+  float vehicleXRec = 0;
+  float vehicleYRec = 0;
+  float vehicleZRec = 0;
+  float vehicleRollRec = 0;
+  float vehiclePitchRec = 0;
+  float vehicleYawRec = 0;
+
+  static const int odomHistoryNum = 400;
+  double odomHistoryTime[odomHistoryNum] = {0};
+  float odomHistoryX[odomHistoryNum] = {0};
+  float odomHistoryY[odomHistoryNum] = {0};
+  float odomHistoryZ[odomHistoryNum] = {0};
+  float odomHistoryRoll[odomHistoryNum] = {0};
+  float odomHistoryPitch[odomHistoryNum] = {0};
+  float odomHistoryYaw[odomHistoryNum] = {0};
+  int odomHistoryInd = -1;
+  int odomHistorySize = 0;
+
+  bool useSimTime = false;
+  double odomTime = 0;
+  double odomTimeRec = -1.0;
+  double joyTime = 0;
+  double slowInitTime = 0;
+  double stopInitTime = false;
+  bool pathInit = false;
+
+  PathFollowerPath path;
+  PathFollowerController controller;
+
+  unitree_api::msg::Request req;
+  SportClient sport_req;
+
+  rclcpp::Subscription<nav_msgs::msg::Odometry>::SharedPtr subOdom;
+  rclcpp::Subscription<nav_msgs::msg::Path>::SharedPtr subPath;
+  rclcpp::Subscription<sensor_msgs::msg::Joy>::SharedPtr subJoystick;
+  rclcpp::Subscription<std_msgs::msg::Float32>::SharedPtr subSpeed;
+  rclcpp::Subscription<std_msgs::msg::Int8>::SharedPtr subStop;
+  rclcpp::Publisher<geometry_msgs::msg::TwistStamped>::SharedPtr pubSpeed;
+  rclcpp::Publisher<unitree_api::msg::Request>::SharedPtr pubGo2Request;
+  rclcpp::TimerBase::SharedPtr followerTimer;
+};
+
+}
+
+#endif
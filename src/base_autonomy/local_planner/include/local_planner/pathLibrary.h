@@ -0,0 +1,139 @@
+#ifndef PATH_LIBRARY_H
+#define PATH_LIBRARY_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// Binary path library layout, all sections stored in host byte order right after the
+// header: startPaths, paths, pathList (PathLibraryPoint each), then the correspondence
+// table as CSR with gridVoxelNum + 1 offsets followed by correspondenceNum path IDs.
+const char pathLibraryMagic[8] = {'L', 'P', 'P', 'A', 'T', 'H', 'S', '\0'};
+const uint32_t pathLibraryVersion = 1;
+
+struct PathLibraryHeader
+{
+  char magic[8];
+  uint32_t version;
+  int32_t pathNum;
+  int32_t groupNum;
+  int32_t gridVoxelNumX;
+  int32_t gridVoxelNumY;
+  float gridVoxelSize;
+  float searchRadius;
+  float gridVoxelOffsetX;
+  float gridVoxelOffsetY;
+  int32_t startPathPointNum;
+  int32_t pathPointNum;
+  int32_t correspondenceNum;
+};
+
+// one vertex of startPaths.ply (pathID = -1), paths.ply or pathList.ply (end point)
+struct PathLibraryPoint
+{
+  float x;
+  float y;
+  float z;
+  int32_t pathID;
+  int32_t groupID;
+};
+
+// grid the correspondences of a path set are computed on, the defaults are those of
+// path_generator.m, pathGenerator and the shipped paths
+struct PathLibraryGrid
+{
+  int pathNum = 343;
+  int groupNum = 7;
+  int gridVoxelNumX = 161;
+  int gridVoxelNumY = 451;
+  float gridVoxelSize = 0.02;
+  float searchRadius = 0.55;
+  float gridVoxelOffsetX = 3.2;
+  float gridVoxelOffsetY = 4.5;
+};
+
+class PathLibrary
+{
+public:
+  PathLibrary();
+  ~PathLibrary();
+
+  PathLibrary(const PathLibrary&) = delete;
+  PathLibrary& operator=(const PathLibrary&) = delete;
+
+  // read startPaths.ply, paths.ply, pathList.ply and correspondences.txt from pathFolder
+  bool readText(const std::string& pathFolder, const PathLibraryGrid& grid);
+
+  // map a file written by writeBinary() and use it in place
+  bool readBinary(const std::string& fileName);
+
+  bool writeBinary(const std::string& fileName) const;
+
+  // map fileName, or pathFolder/pathLibrary.bin if fileName is empty, and fall back to the text
+  // files in pathFolder when no binary library is found, the grid must match either way
+  bool read(const std::string& pathFolder, const std::string& fileName, const PathLibraryGrid& grid);
+
+  // read one of several path sets, pathFolder/pathLibrary.bin carries its own grid and is taken
+  // as is, the text files have no grid information and are read with the given one
+  bool readPathSet(const std::string& pathFolder, const PathLibraryGrid& grid);
+
+  bool mapped() const { return mapAddr != NULL; }
+
+  const std::string& error() const { return errorMsg; }
+
+  bool matches(const PathLibraryGrid& grid) const;
+
+  int pathNum() const { return header.pathNum; }
+  int groupNum() const { return header.groupNum; }
+  int gridVoxelNumX() const { return header.gridVoxelNumX; }
+  int gridVoxelNumY() const { return header.gridVoxelNumY; }
+  int gridVoxelNum() const { return header.gridVoxelNumX * header.gridVoxelNumY; }
+  float gridVoxelSize() const { return header.gridVoxelSize; }
+  float searchRadius() const { return header.searchRadius; }
+  float gridVoxelOffsetX() const { return header.gridVoxelOffsetX; }
+  float gridVoxelOffsetY() const { return header.gridVoxelOffsetY; }
+
+  int startPathPointNum() const { return header.startPathPointNum; }
+  int pathPointNum() const { return header.pathPointNum; }
+  int correspondenceNum() const { return header.correspondenceNum; }
+
+  const PathLibraryPoint* startPaths() const { return startPathsPtr; }
+  const PathLibraryPoint* paths() const { return pathsPtr; }
+  const PathLibraryPoint* pathList() const { return pathListPtr; }
+
+  // paths blocked by grid voxel ind are correspondencePaths()[correspondenceOffsets()[ind]]
+  // up to correspondencePaths()[correspondenceOffsets()[ind + 1]]
+  const int32_t* correspondenceOffsets() const { return correspondenceOffsetsPtr; }
+  const int32_t* correspondencePaths() const { return correspondencePathsPtr; }
+
+private:
+  void reset();
+  void setPointers();
+
+  bool readPlyHeader(FILE *filePtr, int& pointNum);
+  bool readStartPaths(const std::string& pathFolder);
+  bool readPaths(const std::string& pathFolder);
+  bool readPathList(const std::string& pathFolder);
+  bool readCorrespondences(const std::string& pathFolder);
+
+  PathLibraryHeader header;
+  std::string errorMsg;
+
+  std::vector<PathLibraryPoint> startPathsData;
+  std::vector<PathLibraryPoint> pathsData;
+  std::vector<PathLibraryPoint> pathListData;
+  std::vector<int32_t> correspondenceOffsetsData;
+  std::vector<int32_t> correspondencePathsData;
+
+  void *mapAddr;
+  size_t mapSize;
+
+  const PathLibraryPoint *startPathsPtr;
+  const PathLibraryPoint *pathsPtr;
+  const PathLibraryPoint *pathListPtr;
+  const int32_t *correspondenceOffsetsPtr;
+  const int32_t *correspondencePathsPtr;
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef PATH_SET_SELECTOR_H
+#define PATH_SET_SELECTOR_H
+
+#include <vector>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+struct PathSetSelectorParams
+{
+  // radius around the vehicle in which the obstacle density is measured
+  double densityRange = 2.0;
+
+  // a longer path set is only taken when the speed exceeds its minimum by speedHys in m/s and
+  // the density is below its maximum by the fraction densityHys, the current set is kept down
+  // to the same margins below, so the selection does not flip every cycle near a threshold
+  double speedHys = 0.1;
+  double densityHys = 0.2;
+};
+
+// selects one of several path sets ordered from the shortest to the longest, the commanded
+// speed picks the longest set it allows and the obstacle density steps back to shorter sets
+class PathSetSelector
+{
+public:
+  PathSetSelector();
+
+  void setParams(const PathSetSelectorParams& params);
+
+  // add the next longer path set, minSpeed in m/s and maxObstacleDensity in points per m2
+  void addPathSet(double minSpeed, double maxObstacleDensity);
+
+  int pathSetNum() const { return int(minSpeeds.size()); }
+  int selected() const { return selectedID; }
+
+  // obstacle points per m2 within densityRange of a vehicle frame cloud cropped by
+  // PathEvaluator::cropCloud(), with terrain analysis only points above obstacleHeightThre count
+  float obstacleDensity(const pcl::PointCloud<pcl::PointXYZI>& cloud, bool useTerrainAnalysis,
+                        double obstacleHeightThre) const;
+
+  // speed in m/s, returns the index of the selected path set
+  int select(float speed, float obstacleDensity);
+
+private:
+  PathSetSelectorParams selectorParams;
+
+  std::vector<double> minSpeeds;
+  std::vector<double> maxObstacleDensities;
+  int selectedID;
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef VOXEL_INDICES_H
+#define VOXEL_INDICES_H
+
+// grid of the correspondences as PathEvaluator indexes it, indX runs against x from
+// gridVoxelOffsetX and indY against y scaled down toward the vehicle by searchRadius
+struct VoxelIndexGrid
+{
+  int gridVoxelNumX = 0;
+  int gridVoxelNumY = 0;
+  float gridVoxelSize = 0;
+  float searchRadius = 0;
+  float gridVoxelOffsetX = 0;
+  float gridVoxelOffsetY = 0;
+};
+
+// voxel index gridVoxelNumY * indX + indY of each point rotated by the angle of cosRotAng and
+// sinRotAng, -1 outside the grid, the vector versions keep the operation order of the scalar one
+// so the indices match it exactly
+void voxelIndicesScalar(const VoxelIndexGrid& grid, float cosRotAng, float sinRotAng, const float *xs,
+                        const float *ys, int pointNum, int *inds);
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define VOXEL_INDICES_X86 1
+
+void voxelIndicesSse2(const VoxelIndexGrid& grid, float cosRotAng, float sinRotAng, const float *xs,
+                      const float *ys, int pointNum, int *inds);
+
+// built for AVX2 whatever the compile flags, only to be called when voxelIndicesAvx2Supported()
+void voxelIndicesAvx2(const VoxelIndexGrid& grid, float cosRotAng, float sinRotAng, const float *xs,
+                      const float *ys, int pointNum, int *inds);
+
+bool voxelIndicesAvx2Supported();
+#endif
+
+// the widest version the build targets, AVX2 with LOCAL_PLANNER_AVX2, SSE2 on x86-64 and the
+// scalar one elsewhere
+void voxelIndices(const VoxelIndexGrid& grid, float cosRotAng, float sinRotAng, const float *xs,
+                  const float *ys, int pointNum, int *inds);
+
+#endif
@@ -0,0 +1,203 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <pcl/io/pcd_io.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include "local_planner/pathLibrary.h"
+#include "local_planner/pathEvaluator.h"
+
+using namespace std;
+
+// replays map frame clouds stored as PCD files through the localPlanner path evaluation and
+// reports the per-cycle latency, the clouds are cropped around a fixed vehicle pose
+void printUsage()
+{
+  printf("Usage: localPlannerBenchmark <pathFolder> <cloud.pcd> [cloud.pcd ...] [options]\n");
+  printf("Options:\n");
+  printf("  --repeat N             replays of the cloud sequence (100)\n");
+  printf("  --threadNum N          evaluation threads (1)\n");
+  printf("  --bitset               use the bitset evaluation\n");
+  printf("  --compareBitset        replay with the counter and the bitset evaluation and compare them\n");
+  printf("  --incremental          use the incremental evaluation\n");
+  printf("  --ttc                  use the time to collision cost\n");
+  printf("  --useTerrainAnalysis   clouds are terrain maps with the elevation in intensity\n");
+  printf("  --joySpeed S           normalized speed (1.0)\n");
+  printf("  --joyDir D             direction in deg without a goal (0)\n");
+  printf("  --goalX X --goalY Y    goal in the map frame, enables autonomy mode\n");
+  printf("  --vehicleX X --vehicleY Y --vehicleYaw A  vehicle pose in the map frame (0)\n");
+}
+
+double percentile(const vector<double>& sorted, double ratio)
+{
+  if (sorted.empty()) return 0;
+  int ind = int(ratio * (sorted.size() - 1) + 0.5);
+  return sorted[ind];
+}
+
+struct ReplayStats
+{
+  vector<double> cycleTimes;
+  double totalTime = 0;
+  long pointNum = 0;
+  long lookupNum = 0;
+  int foundNum = 0;
+
+  // selected group and rotation direction of each cycle, -1 if no path is found
+  vector<int> selections;
+};
+
+// replays the clouds repeatNum times through the evaluation with params, timing each cycle
+void replay(const PathLibrary& pathLibrary, const PathEvaluatorParams& params,
+            const vector<pcl::PointCloud<pcl::PointXYZI> >& clouds, const PathEvaluatorState& state, int repeatNum,
+            ReplayStats& stats)
+{
+  PathEvaluator pathEvaluator;
+  pathEvaluator.setPathLibrary(pathLibrary);
+  pathEvaluator.setParams(params);
+
+  int cloudNum = clouds.size();
+  stats.cycleTimes.reserve(repeatNum * cloudNum);
+  stats.selections.reserve(repeatNum * cloudNum);
+
+  pcl::PointCloud<pcl::PointXYZI> plannerCloudCrop;
+  PathEvaluatorResult result;
+  for (int repeat = 0; repeat < repeatNum; repeat++) {
+    for (int i = 0; i < cloudNum; i++) {
+      chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+
+      plannerCloudCrop.clear();
+      pathEvaluator.cropCloud(clouds[i], state, true, plannerCloudCrop);
+      bool pathFound = pathEvaluator.evaluate(plannerCloudCrop, state, result);
+
+      double cycleTime = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+      stats.cycleTimes.push_back(cycleTime);
+      stats.totalTime += cycleTime;
+      stats.pointNum += plannerCloudCrop.points.size();
+      stats.lookupNum += result.correspondenceLookupNum;
+      if (pathFound) stats.foundNum++;
+      stats.selections.push_back(pathFound ? pathEvaluator.groupNum() * result.selectedRotDir + result.selectedGroupID
+                                           : -1);
+    }
+  }
+
+  sort(stats.cycleTimes.begin(), stats.cycleTimes.end());
+}
+
+void printStats(const char *title, const ReplayStats& stats)
+{
+  const vector<double>& cycleTimes = stats.cycleTimes;
+  int cycleNum = cycleTimes.size();
+  if (title[0] != '\0') printf("%s\n", title);
+  printf("cycles: %d, paths found: %d\n", cycleNum, stats.foundNum);
+  printf("latency ms: mean %.3f, p50 %.3f, p90 %.3f, p99 %.3f, max %.3f\n", 1000.0 * stats.totalTime / cycleNum,
+         1000.0 * percentile(cycleTimes, 0.5), 1000.0 * percentile(cycleTimes, 0.9),
+         1000.0 * percentile(cycleTimes, 0.99), 1000.0 * cycleTimes.back());
+  printf("points per cycle: %.1f, throughput: %.0f points/s\n", double(stats.pointNum) / cycleNum,
+         stats.totalTime > 0 ? stats.pointNum / stats.totalTime : 0);
+  printf("correspondence lookups per cycle: %.0f\n", double(stats.lookupNum) / cycleNum);
+}
+
+int main(int argc, char** argv)
+{
+  string pathFolder;
+  vector<string> cloudFiles;
+  int repeatNum = 100;
+  bool compareBitset = false;
+  PathEvaluatorParams params;
+  PathEvaluatorState state;
+  state.joySpeed = 1.0;
+
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "--bitset") {
+      params.useBitsetEval = true;
+    } else if (arg == "--compareBitset") {
+      compareBitset = true;
+    } else if (arg == "--incremental") {
+      params.useIncrementalEval = true;
+    } else if (arg == "--ttc") {
+      params.useTtcCost = true;
+    } else if (arg == "--useTerrainAnalysis") {
+      params.useTerrainAnalysis = true;
+    } else if (arg.compare(0, 2, "--") == 0) {
+      if (i + 1 >= argc) {
+        printUsage();
+        return 1;
+      }
+
+      const char *val = argv[++i];
+      if (arg == "--repeat") repeatNum = atoi(val);
+      else if (arg == "--threadNum") params.threadNum = atoi(val);
+      else if (arg == "--joySpeed") state.joySpeed = atof(val);
+      else if (arg == "--joyDir") state.joyDir = atof(val);
+      else if (arg == "--goalX") { state.goalX = atof(val); state.autonomyMode = true; }
+      else if (arg == "--goalY") { state.goalY = atof(val); state.autonomyMode = true; }
+      else if (arg == "--vehicleX") state.vehicleX = atof(val);
+      else if (arg == "--vehicleY") state.vehicleY = atof(val);
+      else if (arg == "--vehicleYaw") state.vehicleYaw = atof(val);
+      else {
+        printUsage();
+        return 1;
+      }
+    } else if (pathFolder.empty()) {
+      pathFolder = arg;
+    } else {
+      cloudFiles.push_back(arg);
+    }
+  }
+
+  if (pathFolder.empty() || cloudFiles.empty() || repeatNum <= 0) {
+    printUsage();
+    return 1;
+  }
+
+  // the binary library carries its grid, the text files are read with the default one
+  PathLibraryGrid grid;
+  PathLibrary pathLibrary;
+  if (!pathLibrary.read(pathFolder, "", grid)) {
+    fprintf(stderr, "%s, exit.\n", pathLibrary.error().c_str());
+    return 1;
+  }
+
+  int cloudNum = cloudFiles.size();
+  vector<pcl::PointCloud<pcl::PointXYZI> > clouds(cloudNum);
+  for (int i = 0; i < cloudNum; i++) {
+    if (pcl::io::loadPCDFile<pcl::PointXYZI>(cloudFiles[i], clouds[i]) < 0) {
+      fprintf(stderr, "Cannot read %s, exit.\n", cloudFiles[i].c_str());
+      return 1;
+    }
+  }
+
+  if (!compareBitset) {
+    ReplayStats stats;
+    replay(pathLibrary, params, clouds, state, repeatNum, stats);
+    printStats("", stats);
+    return 0;
+  }
+
+  // the same replay with the per-path counters and with the bitset masks, the selections must agree
+  ReplayStats counterStats, bitsetStats;
+  params.useBitsetEval = false;
+  replay(pathLibrary, params, clouds, state, repeatNum, counterStats);
+  params.useBitsetEval = true;
+  replay(pathLibrary, params, clouds, state, repeatNum, bitsetStats);
+
+  int diffNum = 0;
+  for (size_t i = 0; i < counterStats.selections.size(); i++) {
+    if (counterStats.selections[i] != bitsetStats.selections[i]) diffNum++;
+  }
+
+  printStats("counter evaluation:", counterStats);
+  printStats("bitset evaluation:", bitsetStats);
+  printf("bitset speedup: %.2fx, cycles with different selections: %d\n",
+         bitsetStats.totalTime > 0 ? counterStats.totalTime / bitsetStats.totalTime : 0, diffNum);
+
+  return 0;
+}
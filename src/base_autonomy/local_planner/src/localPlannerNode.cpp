@@ -0,0 +1,501 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "rclcpp_components/register_node_macro.hpp"
+
+#include "tf2/transform_datatypes.h"
+#include "tf2_geometry_msgs/tf2_geometry_msgs.hpp"
+
+#include <pcl_conversions/pcl_conversions.h>
+
+#include "local_planner/localPlannerNode.h"
+
+using namespace std;
+
+namespace local_planner
+{
+
+const double PI = 3.1415926;
+
+LocalPlannerNode::LocalPlannerNode(const rclcpp::NodeOptions& options)
+  : Node("localPlanner", options),
+    laserCloud(new pcl::PointCloud<pcl::PointXYZI>()),
+    laserCloudCrop(new pcl::PointCloud<pcl::PointXYZI>()),
+    terrainCloud(new pcl::PointCloud<pcl::PointXYZI>()),
+    terrainCloudCrop(new pcl::PointCloud<pcl::PointXYZI>()),
+    plannerCloud(new pcl::PointCloud<pcl::PointXYZI>()),
+    plannerCloudCrop(new pcl::PointCloud<pcl::PointXYZI>()),
+    plannerCloudSetCrop(new pcl::PointCloud<pcl::PointXYZI>()),
+    boundaryCloud(new pcl::PointCloud<pcl::PointXYZI>()),
+    addedObstacles(new pcl::PointCloud<pcl::PointXYZI>())
+{
+  declare_parameter<std::string>("pathFolder", pathFolder);
+  declare_parameter<std::string>("pathLibraryFile", pathLibraryFile);
+  declare_parameter<double>("vehicleLength", evalParams.vehicleLength);
+  declare_parameter<double>("vehicleWidth", evalParams.vehicleWidth);
+  declare_parameter<double>("sensorOffsetX", sensorOffsetX);
+  declare_parameter<double>("sensorOffsetY", sensorOffsetY);
+  declare_parameter<bool>("twoWayDrive", evalParams.twoWayDrive);
+  declare_parameter<double>("laserVoxelSize", laserVoxelSize);
+  declare_parameter<double>("terrainVoxelSize", terrainVoxelSize);
+  declare_parameter<bool>("useTerrainAnalysis", evalParams.useTerrainAnalysis);
+  declare_parameter<bool>("checkObstacle", checkObstacle);
+  declare_parameter<bool>("checkRotObstacle", evalParams.checkRotObstacle);
+  declare_parameter<double>("adjacentRange", evalParams.adjacentRange);
+  declare_parameter<double>("obstacleHeightThre", evalParams.obstacleHeightThre);
+  declare_parameter<double>("groundHeightThre", evalParams.groundHeightThre);
+  declare_parameter<double>("costHeightThre", evalParams.costHeightThre);
+  declare_parameter<double>("costScore", evalParams.costScore);
+  declare_parameter<bool>("useCost", useCost);
+  declare_parameter<int>("pointPerPathThre", evalParams.pointPerPathThre);
+  declare_parameter<double>("minRelZ", evalParams.minRelZ);
+  declare_parameter<double>("maxRelZ", evalParams.maxRelZ);
+  declare_parameter<double>("maxSpeed", maxSpeed);
+  declare_parameter<double>("dirWeight", evalParams.dirWeight);
+  declare_parameter<double>("dirThre", evalParams.dirThre);
+  declare_parameter<bool>("dirToVehicle", evalParams.dirToVehicle);
+  declare_parameter<double>("pathScale", evalParams.pathScale);
+  declare_parameter<double>("minPathScale", evalParams.minPathScale);
+  declare_parameter<double>("pathScaleStep", evalParams.pathScaleStep);
+  declare_parameter<bool>("pathScaleBySpeed", evalParams.pathScaleBySpeed);
+  declare_parameter<double>("minPathRange", evalParams.minPathRange);
+  declare_parameter<double>("pathRangeStep", evalParams.pathRangeStep);
+  declare_parameter<bool>("pathRangeBySpeed", evalParams.pathRangeBySpeed);
+  declare_parameter<bool>("pathCropByGoal", evalParams.pathCropByGoal);
+  declare_parameter<bool>("autonomyMode", autonomyMode);
+  declare_parameter<double>("autonomySpeed", autonomySpeed);
+  declare_parameter<double>("joyToSpeedDelay", joyToSpeedDelay);
+  declare_parameter<double>("joyToCheckObstacleDelay", joyToCheckObstacleDelay);
+  declare_parameter<double>("goalCloseDis", evalParams.goalCloseDis);
+  declare_parameter<double>("goalClearRange", evalParams.goalClearRange);
+  declare_parameter<double>("goalX", goalX);
+  declare_parameter<double>("goalY", goalY);
+  declare_parameter<bool>("useBitsetEval", evalParams.useBitsetEval);
+  declare_parameter<int>("threadNum", evalParams.threadNum);
+  declare_parameter<bool>("useIncrementalEval", evalParams.useIncrementalEval);
+  declare_parameter<double>("incrementalDisThre", evalParams.incrementalDisThre);
+  declare_parameter<double>("incrementalAngThre", evalParams.incrementalAngThre);
+  declare_parameter<bool>("useTtcCost", evalParams.useTtcCost);
+  declare_parameter<double>("ttcThre", evalParams.ttcThre);
+  declare_parameter<double>("ttcScore", evalParams.ttcScore);
+  declare_parameter<vector<string> >("pathSetFolders", pathSetFolders);
+  declare_parameter<vector<double> >("pathSetMinSpeeds", pathSetMinSpeeds);
+  declare_parameter<vector<double> >("pathSetMaxObstacleDensities", pathSetMaxObstacleDensities);
+  declare_parameter<vector<double> >("pathSetAdjacentRanges", pathSetAdjacentRanges);
+  declare_parameter<double>("obstacleDensityRange", selectorParams.densityRange);
+  declare_parameter<double>("pathSetSpeedHys", selectorParams.speedHys);
+  declare_parameter<double>("pathSetDensityHys", selectorParams.densityHys);
+  declare_parameter<int>("pathNum", grid.pathNum);
+  declare_parameter<int>("groupNum", grid.groupNum);
+  declare_parameter<int>("gridVoxelNumX", grid.gridVoxelNumX);
+  declare_parameter<int>("gridVoxelNumY", grid.gridVoxelNumY);
+  declare_parameter<double>("gridVoxelSize", grid.gridVoxelSize);
+  declare_parameter<double>("searchRadius", grid.searchRadius);
+  declare_parameter<double>("gridVoxelOffsetX", grid.gridVoxelOffsetX);
+  declare_parameter<double>("gridVoxelOffsetY", grid.gridVoxelOffsetY);
+
+  get_parameter("pathFolder", pathFolder);
+  get_parameter("pathLibraryFile", pathLibraryFile);
+  get_parameter("vehicleLength", evalParams.vehicleLength);
+  get_parameter("vehicleWidth", evalParams.vehicleWidth);
+  get_parameter("sensorOffsetX", sensorOffsetX);
+  get_parameter("sensorOffsetY", sensorOffsetY);
+  get_parameter("twoWayDrive", evalParams.twoWayDrive);
+  get_parameter("laserVoxelSize", laserVoxelSize);
+  get_parameter("terrainVoxelSize", terrainVoxelSize);
+  get_parameter("useTerrainAnalysis", evalParams.useTerrainAnalysis);
+  get_parameter("checkObstacle", checkObstacle);
+  get_parameter("checkRotObstacle", evalParams.checkRotObstacle);
+  get_parameter("adjacentRange", evalParams.adjacentRange);
+  get_parameter("obstacleHeightThre", evalParams.obstacleHeightThre);
+  get_parameter("groundHeightThre", evalParams.groundHeightThre);
+  get_parameter("costHeightThre", evalParams.costHeightThre);
+  get_parameter("costScore", evalParams.costScore);
+  get_parameter("useCost", useCost);
+  get_parameter("pointPerPathThre", evalParams.pointPerPathThre);
+  get_parameter("minRelZ", evalParams.minRelZ);
+  get_parameter("maxRelZ", evalParams.maxRelZ);
+  get_parameter("maxSpeed", maxSpeed);
+  get_parameter("dirWeight", evalParams.dirWeight);
+  get_parameter("dirThre", evalParams.dirThre);
+  get_parameter("dirToVehicle", evalParams.dirToVehicle);
+  get_parameter("pathScale", evalParams.pathScale);
+  get_parameter("minPathScale", evalParams.minPathScale);
+  get_parameter("pathScaleStep", evalParams.pathScaleStep);
+  get_parameter("pathScaleBySpeed", evalParams.pathScaleBySpeed);
+  get_parameter("minPathRange", evalParams.minPathRange);
+  get_parameter("pathRangeStep", evalParams.pathRangeStep);
+  get_parameter("pathRangeBySpeed", evalParams.pathRangeBySpeed);
+  get_parameter("pathCropByGoal", evalParams.pathCropByGoal);
+  get_parameter("autonomyMode", autonomyMode);
+  get_parameter("autonomySpeed", autonomySpeed);
+  get_parameter("joyToSpeedDelay", joyToSpeedDelay);
+  get_parameter("joyToCheckObstacleDelay", joyToCheckObstacleDelay);
+  get_parameter("goalCloseDis", evalParams.goalCloseDis);
+  get_parameter("goalClearRange", evalParams.goalClearRange);
+  get_parameter("goalX", goalX);
+  get_parameter("goalY", goalY);
+  get_parameter("useBitsetEval", evalParams.useBitsetEval);
+  get_parameter("threadNum", evalParams.threadNum);
+  get_parameter("useIncrementalEval", evalParams.useIncrementalEval);
+  get_parameter("incrementalDisThre", evalParams.incrementalDisThre);
+  get_parameter("incrementalAngThre", evalParams.incrementalAngThre);
+  get_parameter("useTtcCost", evalParams.useTtcCost);
+  get_parameter("ttcThre", evalParams.ttcThre);
+  get_parameter("ttcScore", evalParams.ttcScore);
+  evalParams.maxSpeed = maxSpeed;
+  get_parameter("pathSetFolders", pathSetFolders);
+  get_parameter("pathSetMinSpeeds", pathSetMinSpeeds);
+  get_parameter("pathSetMaxObstacleDensities", pathSetMaxObstacleDensities);
+  get_parameter("pathSetAdjacentRanges", pathSetAdjacentRanges);
+  get_parameter("obstacleDensityRange", selectorParams.densityRange);
+  get_parameter("pathSetSpeedHys", selectorParams.speedHys);
+  get_parameter("pathSetDensityHys", selectorParams.densityHys);
+  get_parameter("pathNum", grid.pathNum);
+  get_parameter("groupNum", grid.groupNum);
+  get_parameter("gridVoxelNumX", grid.gridVoxelNumX);
+  get_parameter("gridVoxelNumY", grid.gridVoxelNumY);
+  get_parameter("gridVoxelSize", grid.gridVoxelSize);
+  get_parameter("searchRadius", grid.searchRadius);
+  get_parameter("gridVoxelOffsetX", grid.gridVoxelOffsetX);
+  get_parameter("gridVoxelOffsetY", grid.gridVoxelOffsetY);
+
+  subOdometry = create_subscription<nav_msgs::msg::Odometry>("/state_estimation", 5,
+                std::bind(&LocalPlannerNode::odometryHandler, this, std::placeholders::_1));
+  subLaserCloud = create_subscription<sensor_msgs::msg::PointCloud2>("/registered_scan", 5,
+                  std::bind(&LocalPlannerNode::laserCloudHandler, this, std::placeholders::_1));
+  subTerrainCloud = create_subscription<sensor_msgs::msg::PointCloud2>("/terrain_map", 5,
+                    std::bind(&LocalPlannerNode::terrainCloudHandler, this, std::placeholders::_1));
+  subJoystick = create_subscription<sensor_msgs::msg::Joy>("/joy", 5,
+                std::bind(&LocalPlannerNode::joystickHandler, this, std::placeholders::_1));
+  subGoal = create_subscription<geometry_msgs::msg::PointStamped>("/way_point", 5,
+            std::bind(&LocalPlannerNode::goalHandler, this, std::placeholders::_1));
+  subSpeed = create_subscription<std_msgs::msg::Float32>("/speed", 5,
+             std::bind(&LocalPlannerNode::speedHandler, this, std::placeholders::_1));
+  subBoundary = create_subscription<geometry_msgs::msg::PolygonStamped>("/navigation_boundary", 5,
+                std::bind(&LocalPlannerNode::boundaryHandler, this, std::placeholders::_1));
+  subAddedObstacles = create_subscription<sensor_msgs::msg::PointCloud2>("/added_obstacles", 5,
+                      std::bind(&LocalPlannerNode::addedObstaclesHandler, this, std::placeholders::_1));
+  subCheckObstacle = create_subscription<std_msgs::msg::Bool>("/check_obstacle", 5,
+                     std::bind(&LocalPlannerNode::checkObstacleHandler, this, std::placeholders::_1));
+
+  pubPath = create_publisher<nav_msgs::msg::Path>("/path", 5);
+  pubFreePaths = create_publisher<sensor_msgs::msg::PointCloud2>("/free_paths", 2);
+
+  RCLCPP_INFO(get_logger(), "Reading path files.");
+
+  if (autonomyMode) {
+    joySpeed = autonomySpeed / maxSpeed;
+
+    if (joySpeed < 0) joySpeed = 0;
+    else if (joySpeed > 1.0) joySpeed = 1.0;
+  }
+
+  laserDwzFilter.setLeafSize(laserVoxelSize, laserVoxelSize, laserVoxelSize);
+  terrainDwzFilter.setLeafSize(terrainVoxelSize, terrainVoxelSize, terrainVoxelSize);
+
+  readPathLibrary();
+
+  plannerTimer = create_wall_timer(std::chrono::milliseconds(10), std::bind(&LocalPlannerNode::plannerCycle, this));
+
+  RCLCPP_INFO(get_logger(), "Initialization complete.");
+}
+
+void LocalPlannerNode::readPathLibrary()
+{
+  if (pathSetFolders.empty()) {
+    pathLibraries.emplace_back(new PathLibrary());
+    PathLibrary& pathLibrary = *pathLibraries.back();
+
+    // prefer the binary library converted by pathLibraryConverter, fall back to the text files
+    if (!pathLibrary.read(pathFolder, pathLibraryFile, grid)) {
+      throw std::runtime_error(pathLibrary.error());
+    }
+    if (pathLibrary.mapped()) {
+      RCLCPP_INFO(get_logger(), "Mapped path library.");
+    }
+    pathSetSelector.addPathSet(0, 0);
+  } else {
+    int pathSetNum = pathSetFolders.size();
+    if (int(pathSetMinSpeeds.size()) != pathSetNum || int(pathSetMaxObstacleDensities.size()) != pathSetNum) {
+      throw std::runtime_error("Path set speeds and densities do not match pathSetFolders");
+    }
+    if (!pathSetAdjacentRanges.empty() && int(pathSetAdjacentRanges.size()) != pathSetNum) {
+      throw std::runtime_error("Path set adjacent ranges do not match pathSetFolders");
+    }
+
+    // relative folders are taken from pathFolder, each set may be generated with its own grid
+    for (int i = 0; i < pathSetNum; i++) {
+      string pathSetFolder = pathSetFolders[i];
+      if (pathSetFolder.empty() || pathSetFolder[0] != '/') pathSetFolder = pathFolder + "/" + pathSetFolder;
+
+      pathLibraries.emplace_back(new PathLibrary());
+      PathLibrary& pathLibrary = *pathLibraries.back();
+      if (!pathLibrary.readPathSet(pathSetFolder, grid)) {
+        throw std::runtime_error(pathLibrary.error());
+      }
+      pathSetSelector.addPathSet(pathSetMinSpeeds[i], pathSetMaxObstacleDensities[i]);
+    }
+    RCLCPP_INFO(get_logger(), "Read %d path sets.", pathSetNum);
+  }
+  pathSetSelector.setParams(selectorParams);
+
+  // adjacentRange applies to all sets unless pathSetAdjacentRanges is given
+  int pathSetNum = pathLibraries.size();
+  for (int i = 0; i < pathSetNum; i++) {
+    PathEvaluatorParams setParams = evalParams;
+    if (!pathSetAdjacentRanges.empty()) setParams.adjacentRange = pathSetAdjacentRanges[i];
+
+    pathEvaluators.emplace_back(new PathEvaluator());
+    pathEvaluators[i]->setPathLibrary(*pathLibraries[i]);
+    pathEvaluators[i]->setParams(setParams);
+
+    if (i == 0 || setParams.adjacentRange > cropRange) {
+      cropSetID = i;
+      cropRange = setParams.adjacentRange;
+    }
+  }
+}
+
+void LocalPlannerNode::odometryHandler(nav_msgs::msg::Odometry::UniquePtr odom)
+{
+  odomTime = rclcpp::Time(odom->header.stamp).seconds();
+  double roll, pitch, yaw;
+  geometry_msgs::msg::Quaternion geoQuat = odom->pose.pose.orientation;
+  tf2::Matrix3x3(tf2::Quaternion(geoQuat.x, geoQuat.y, geoQuat.z, geoQuat.w)).getRPY(roll, pitch, yaw);
+
+  vehicleYaw = yaw;
+  vehicleX = odom->pose.pose.position.x - cos(yaw) * sensorOffsetX + sin(yaw) * sensorOffsetY;
+  vehicleY = odom->pose.pose.position.y - sin(yaw) * sensorOffsetX - cos(yaw) * sensorOffsetY;
+  vehicleZ = odom->pose.pose.position.z;
+}
+
+void LocalPlannerNode::laserCloudHandler(sensor_msgs::msg::PointCloud2::UniquePtr laserCloud2)
+{
+  if (!evalParams.useTerrainAnalysis) {
+    laserCloud->clear();
+    pcl::fromROSMsg(*laserCloud2, *laserCloud);
+
+    laserCloudCrop->clear();
+    int laserCloudSize = laserCloud->points.size();
+    for (int i = 0; i < laserCloudSize; i++) {
+      const pcl::PointXYZI& point = laserCloud->points[i];
+      float dis = sqrt((point.x - vehicleX) * (point.x - vehicleX) + (point.y - vehicleY) * (point.y - vehicleY));
+      if (dis < cropRange) {
+        laserCloudCrop->push_back(point);
+      }
+    }
+
+    plannerCloud->clear();
+    laserDwzFilter.setInputCloud(laserCloudCrop);
+    laserDwzFilter.filter(*plannerCloud);
+
+    newPlannerCloud = true;
+  }
+}
+
+void LocalPlannerNode::terrainCloudHandler(sensor_msgs::msg::PointCloud2::UniquePtr terrainCloud2)
+{
+  if (evalParams.useTerrainAnalysis) {
+    terrainCloud->clear();
+    pcl::fromROSMsg(*terrainCloud2, *terrainCloud);
+
+    terrainCloudCrop->clear();
+    int terrainCloudSize = terrainCloud->points.size();
+    for (int i = 0; i < terrainCloudSize; i++) {
+      const pcl::PointXYZI& point = terrainCloud->points[i];
+      float dis = sqrt((point.x - vehicleX) * (point.x - vehicleX) + (point.y - vehicleY) * (point.y - vehicleY));
+      if (dis < cropRange && (point.intensity > evalParams.obstacleHeightThre || useCost)) {
+        terrainCloudCrop->push_back(point);
+      }
+    }
+
+    plannerCloud->clear();
+    terrainDwzFilter.setInputCloud(terrainCloudCrop);
+    terrainDwzFilter.filter(*plannerCloud);
+
+    newPlannerCloud = true;
+  }
+}
+
+void LocalPlannerNode::joystickHandler(sensor_msgs::msg::Joy::UniquePtr joy)
+{
+  joyTime = now().seconds();
+  joySpeedRaw = sqrt(joy->axes[3] * joy->axes[3] + joy->axes[4] * joy->axes[4]);
+  joySpeed = joySpeedRaw;
+  if (joySpeed > 1.0) joySpeed = 1.0;
+  if (joy->axes[4] == 0) joySpeed = 0;
+
+  if (joySpeed > 0) {
+    joyDir = atan2(joy->axes[3], joy->axes[4]) * 180 / PI;
+    if (joy->axes[4] < 0) joyDir *= -1;
+  }
+
+  if (joy->axes[4] < 0 && !evalParams.twoWayDrive) joySpeed = 0;
+
+  autonomyMode = !(joy->axes[2] > -0.1);
+  checkObstacle = joy->axes[5] > -0.1;
+}
+
+void LocalPlannerNode::goalHandler(geometry_msgs::msg::PointStamped::UniquePtr goal)
+{
+  goalX = goal->point.x;
+  goalY = goal->point.y;
+}
+
+void LocalPlannerNode::speedHandler(std_msgs::msg::Float32::UniquePtr speed)
+{
+  double speedTime = now().seconds();
+  if (autonomyMode && speedTime - joyTime > joyToSpeedDelay && joySpeedRaw == 0) {
+    joySpeed = speed->data / maxSpeed;
+
+    if (joySpeed < 0) joySpeed = 0;
+    else if (joySpeed > 1.0) joySpeed = 1.0;
+  }
+}
+
+void LocalPlannerNode::boundaryHandler(geometry_msgs::msg::PolygonStamped::UniquePtr boundary)
+{
+  boundaryCloud->clear();
+  pcl::PointXYZI point, point1, point2;
+  int boundarySize = boundary->polygon.points.size();
+
+  if (boundarySize >= 1) {
+    point2.x = boundary->polygon.points[0].x;
+    point2.y = boundary->polygon.points[0].y;
+    point2.z = boundary->polygon.points[0].z;
+  }
+
+  for (int i = 0; i < boundarySize; i++) {
+    point1 = point2;
+
+    point2.x = boundary->polygon.points[i].x;
+    point2.y = boundary->polygon.points[i].y;
+    point2.z = boundary->polygon.points[i].z;
+
+    if (point1.z == point2.z) {
+      float disX = point1.x - point2.x;
+      float disY = point1.y - point2.y;
+      float dis = sqrt(disX * disX + disY * disY);
+
+      int pointNum = int(dis / terrainVoxelSize) + 1;
+      for (int pointID = 0; pointID < pointNum; pointID++) {
+        point.x = float(pointID) / float(pointNum) * point1.x + (1.0 - float(pointID) / float(pointNum)) * point2.x;
+        point.y = float(pointID) / float(pointNum) * point1.y + (1.0 - float(pointID) / float(pointNum)) * point2.y;
+        point.z = 0;
+        point.intensity = 100.0;
+
+        for (int j = 0; j < evalParams.pointPerPathThre; j++) {
+          boundaryCloud->push_back(point);
+        }
+      }
+    }
+  }
+}
+
+void LocalPlannerNode::addedObstaclesHandler(sensor_msgs::msg::PointCloud2::UniquePtr addedObstacles2)
+{
+  addedObstacles->clear();
+  pcl::fromROSMsg(*addedObstacles2, *addedObstacles);
+
+  int addedObstaclesSize = addedObstacles->points.size();
+  for (int i = 0; i < addedObstaclesSize; i++) {
+    addedObstacles->points[i].intensity = 200.0;
+  }
+}
+
+void LocalPlannerNode::checkObstacleHandler(std_msgs::msg::Bool::UniquePtr checkObs)
+{
+  double checkObsTime = now().seconds();
+  if (autonomyMode && checkObsTime - joyTime > joyToCheckObstacleDelay) {
+    checkObstacle = checkObs->data;
+  }
+}
+
+void LocalPlannerNode::plannerCycle()
+{
+  if (!newPlannerCloud) return;
+  newPlannerCloud = false;
+
+  PathEvaluatorState state;
+  state.vehicleX = vehicleX;
+  state.vehicleY = vehicleY;
+  state.vehicleZ = vehicleZ;
+  state.vehicleYaw = vehicleYaw;
+  state.joySpeed = joySpeed;
+  state.joyDir = joyDir;
+  state.autonomyMode = autonomyMode;
+  state.checkObstacle = checkObstacle;
+  state.goalX = goalX;
+  state.goalY = goalY;
+
+  // crop at the largest range, the density and the set selected from it do not depend on the set
+  // of the last cycle
+  plannerCloudCrop->clear();
+  PathEvaluator& cropEvaluator = *pathEvaluators[cropSetID];
+  cropEvaluator.cropCloud(*plannerCloud, state, true, *plannerCloudCrop);
+  cropEvaluator.cropCloud(*boundaryCloud, state, false, *plannerCloudCrop);
+  cropEvaluator.cropCloud(*addedObstacles, state, false, *plannerCloudCrop);
+
+  if (pathSetSelector.pathSetNum() > 1) {
+    float obstacleDensity = pathSetSelector.obstacleDensity(*plannerCloudCrop, evalParams.useTerrainAnalysis,
+                                                            evalParams.obstacleHeightThre);
+    pathSetID = pathSetSelector.select(joySpeed * maxSpeed, obstacleDensity);
+  }
+
+  // the crop is in the vehicle frame, a set with a shorter range takes the points within it
+  PathEvaluator& pathEvaluator = *pathEvaluators[pathSetID];
+  pcl::PointCloud<pcl::PointXYZI>::Ptr evalCloud = plannerCloudCrop;
+  float setRange = pathEvaluator.params().adjacentRange;
+  if (setRange < cropRange) {
+    plannerCloudSetCrop->clear();
+    int cropSize = plannerCloudCrop->points.size();
+    for (int i = 0; i < cropSize; i++) {
+      const pcl::PointXYZI& point = plannerCloudCrop->points[i];
+      if (point.x * point.x + point.y * point.y < setRange * setRange) {
+        plannerCloudSetCrop->push_back(point);
+      }
+    }
+    evalCloud = plannerCloudSetCrop;
+  }
+
+  pathEvaluator.evaluate(*evalCloud, state, result);
+  joyDir = result.joyDir;
+
+  auto path = std::make_unique<nav_msgs::msg::Path>();
+  if (result.pathFound) {
+    int selectedPathLength = result.path.points.size();
+    path->poses.resize(selectedPathLength);
+    for (int i = 0; i < selectedPathLength; i++) {
+      path->poses[i].pose.position.x = result.path.points[i].x;
+      path->poses[i].pose.position.y = result.path.points[i].y;
+      path->poses[i].pose.position.z = result.path.points[i].z;
+    }
+  } else {
+    path->poses.resize(1);
+  }
+  path->header.stamp = rclcpp::Time(static_cast<uint64_t>(odomTime * 1e9));
+  path->header.frame_id = "vehicle";
+  pubPath->publish(std::move(path));
+
+  // visualization only, skip the conversion when nobody listens
+  if (pubFreePaths->get_subscription_count() + pubFreePaths->get_intra_process_subscription_count() > 0) {
+    pcl::PointCloud<pcl::PointXYZI> freePaths;
+    pathEvaluator.getFreePaths(result, freePaths);
+
+    auto freePaths2 = std::make_unique<sensor_msgs::msg::PointCloud2>();
+    pcl::toROSMsg(freePaths, *freePaths2);
+    freePaths2->header.stamp = rclcpp::Time(static_cast<uint64_t>(odomTime * 1e9));
+    freePaths2->header.frame_id = "vehicle";
+    pubFreePaths->publish(std::move(freePaths2));
+  }
+}
+
+}
+
+RCLCPP_COMPONENTS_REGISTER_NODE(local_planner::LocalPlannerNode)
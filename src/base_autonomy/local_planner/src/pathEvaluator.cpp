@@ -0,0 +1,878 @@
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "local_planner/pathEvaluator.h"
+#include "local_planner/voxelIndices.h"
+
+using namespace std;
+
+const double PI = 3.1415926;
+
+namespace
+{
+
+int threadID()
+{
+  #ifdef _OPENMP
+  return omp_get_thread_num();
+  #else
+  return 0;
+  #endif
+}
+
+}
+
+PathEvaluator::PathEvaluator()
+  : pathNumber(0), groupNumber(0), gridVoxelNumX(0), gridVoxelNumY(0), gridVoxelNum(0), gridVoxelSize(0),
+    searchRadius(0), gridVoxelOffsetX(0), gridVoxelOffsetY(0), pathMaskWordNum(0), correspondenceOffsets(NULL),
+    correspondencePaths(NULL), libraryPathPoints(NULL), libraryPathPointNum(0), cloudArraySize(0), vehicleXRec(0), vehicleYRec(0), vehicleYawRec(0), minObsAngCW(-180.0),
+    minObsAngCCW(180.0)
+{
+  memset(clearPathNumList, 0, sizeof(clearPathNumList));
+  memset(correspondenceLookupList, 0, sizeof(correspondenceLookupList));
+}
+
+void PathEvaluator::setPathLibrary(const PathLibrary& pathLibrary)
+{
+  pathNumber = pathLibrary.pathNum();
+  groupNumber = pathLibrary.groupNum();
+  gridVoxelNumX = pathLibrary.gridVoxelNumX();
+  gridVoxelNumY = pathLibrary.gridVoxelNumY();
+  gridVoxelNum = pathLibrary.gridVoxelNum();
+  gridVoxelSize = pathLibrary.gridVoxelSize();
+  searchRadius = pathLibrary.searchRadius();
+  gridVoxelOffsetX = pathLibrary.gridVoxelOffsetX();
+  gridVoxelOffsetY = pathLibrary.gridVoxelOffsetY();
+  pathMaskWordNum = (pathNumber + 63) / 64;
+
+  correspondenceOffsets = pathLibrary.correspondenceOffsets();
+  correspondencePaths = pathLibrary.correspondencePaths();
+  libraryPathPoints = pathLibrary.paths();
+  libraryPathPointNum = pathLibrary.pathPointNum();
+
+  startPaths.assign(groupNumber, pcl::PointCloud<pcl::PointXYZ>());
+  int startPathPointNum = pathLibrary.startPathPointNum();
+  const PathLibraryPoint *startPathPoints = pathLibrary.startPaths();
+  pcl::PointXYZ startPoint;
+  for (int i = 0; i < startPathPointNum; i++) {
+    if (startPathPoints[i].groupID >= 0 && startPathPoints[i].groupID < groupNumber) {
+      startPoint.x = startPathPoints[i].x;
+      startPoint.y = startPathPoints[i].y;
+      startPoint.z = startPathPoints[i].z;
+      startPaths[startPathPoints[i].groupID].push_back(startPoint);
+    }
+  }
+
+  paths.assign(pathNumber, pcl::PointCloud<pcl::PointXYZI>());
+  int pathPointNum = pathLibrary.pathPointNum();
+  const PathLibraryPoint *pathPoints = pathLibrary.paths();
+  pcl::PointXYZI point;
+  int pointSkipNum = 30;
+  int pointSkipCount = 0;
+  for (int i = 0; i < pathPointNum; i++) {
+    int pathID = pathPoints[i].pathID;
+    if (pathID >= 0 && pathID < pathNumber) {
+      pointSkipCount++;
+      if (pointSkipCount > pointSkipNum) {
+        point.x = pathPoints[i].x;
+        point.y = pathPoints[i].y;
+        point.z = pathPoints[i].z;
+        point.intensity = pathPoints[i].groupID;
+        paths[pathID].push_back(point);
+        pointSkipCount = 0;
+      }
+    }
+  }
+
+  pathList.assign(pathNumber, 0);
+  endDirPathList.assign(pathNumber, 0);
+  const PathLibraryPoint *pathEnds = pathLibrary.pathList();
+  for (int i = 0; i < pathNumber; i++) {
+    int pathID = pathEnds[i].pathID;
+    int groupID = pathEnds[i].groupID;
+    if (pathID >= 0 && pathID < pathNumber && groupID >= 0 && groupID < groupNumber) {
+      pathList[pathID] = groupID;
+      endDirPathList[pathID] = 2.0 * atan2(pathEnds[i].y, pathEnds[i].x) * 180 / PI;
+    }
+  }
+
+  clearPathList.assign(36 * pathNumber, 0);
+  pathPenaltyList.assign(36 * pathNumber, 0);
+  clearPathPerGroupScore.assign(36 * groupNumber, 0);
+  pathObsDisList.assign(36 * pathNumber, -1.0);
+  occupancyPointNumList.assign(36 * pathNumber, 0);
+  occupancyPenaltyList.assign(36 * pathNumber, 0);
+  for (int i = 0; i < 36; i++) {
+    rotDirOccupancy[i].clear();
+  }
+
+  voxelPathMasks.clear();
+  correspondenceArcLengths.clear();
+  setParams(evalParams);
+}
+
+void PathEvaluator::setParams(const PathEvaluatorParams& params)
+{
+  evalParams = params;
+  if (evalParams.threadNum < 1) evalParams.threadNum = 1;
+  #ifndef _OPENMP
+  evalParams.threadNum = 1;
+  #endif
+
+  if (correspondenceOffsets == NULL) return;
+
+  if (evalParams.useBitsetEval && voxelPathMasks.empty()) buildVoxelPathMasks();
+  if (evalParams.useTtcCost && correspondenceArcLengths.empty()) buildCorrespondenceArcLengths();
+
+  voxelScratch.resize(evalParams.threadNum);
+  if (evalParams.useBitsetEval || evalParams.useIncrementalEval || evalParams.useTtcCost) {
+    for (int i = 0; i < evalParams.threadNum; i++) {
+      if (int(voxelScratch[i].voxelMarkStamp.size()) != gridVoxelNum) {
+        voxelScratch[i].voxelMarkStamp.assign(gridVoxelNum, 0);
+        voxelScratch[i].voxelPointNum.assign(gridVoxelNum, 0);
+        voxelScratch[i].voxelGroundH.assign(gridVoxelNum, 0);
+        voxelScratch[i].markStamp = 0;
+      }
+    }
+  }
+
+  // the stored occupancy depends on the thresholds, start over
+  for (int i = 0; i < 36; i++) {
+    rotDirOccupancy[i].clear();
+  }
+  fill(occupancyPointNumList.begin(), occupancyPointNumList.end(), 0);
+  fill(occupancyPenaltyList.begin(), occupancyPenaltyList.end(), 0);
+}
+
+void PathEvaluator::cropCloud(const pcl::PointCloud<pcl::PointXYZI>& cloud, const PathEvaluatorState& state,
+                              bool checkRelZ, pcl::PointCloud<pcl::PointXYZI>& cloudCrop) const
+{
+  float sinVehicleYaw = sin(state.vehicleYaw);
+  float cosVehicleYaw = cos(state.vehicleYaw);
+
+  pcl::PointXYZI point;
+  int cloudSize = cloud.points.size();
+  for (int i = 0; i < cloudSize; i++) {
+    float pointX1 = cloud.points[i].x - state.vehicleX;
+    float pointY1 = cloud.points[i].y - state.vehicleY;
+    float pointZ1 = cloud.points[i].z - state.vehicleZ;
+
+    point.x = pointX1 * cosVehicleYaw + pointY1 * sinVehicleYaw;
+    point.y = -pointX1 * sinVehicleYaw + pointY1 * cosVehicleYaw;
+    point.z = pointZ1;
+    point.intensity = cloud.points[i].intensity;
+
+    float dis = sqrt(point.x * point.x + point.y * point.y);
+    if (dis < evalParams.adjacentRange && ((point.z > evalParams.minRelZ && point.z < evalParams.maxRelZ) ||
+        evalParams.useTerrainAnalysis || !checkRelZ)) {
+      cloudCrop.push_back(point);
+    }
+  }
+}
+
+bool PathEvaluator::rotDirInRange(int rotDir, float joyDir) const
+{
+  float angDiff = fabs(joyDir - (10.0 * rotDir - 180.0));
+  if (angDiff > 180.0) {
+    angDiff = 360.0 - angDiff;
+  }
+  return !((angDiff > evalParams.dirThre && !evalParams.dirToVehicle) ||
+           (fabs(10.0 * rotDir - 180.0) > evalParams.dirThre && fabs(joyDir) <= 90.0 && evalParams.dirToVehicle) ||
+           ((10.0 * rotDir > evalParams.dirThre && 360.0 - 10.0 * rotDir > evalParams.dirThre) && fabs(joyDir) > 90.0 &&
+           evalParams.dirToVehicle));
+}
+
+bool PathEvaluator::rotDirClearOfRotObstacle(int rotDir) const
+{
+  float rotAng = (10.0 * rotDir - 180.0) * PI / 180;
+  float rotDeg = 10.0 * rotDir;
+  if (rotDeg > 180.0) rotDeg -= 360.0;
+  return (rotAng * 180.0 / PI > minObsAngCW && rotAng * 180.0 / PI < minObsAngCCW) ||
+         (rotDeg > minObsAngCW && rotDeg < minObsAngCCW && evalParams.twoWayDrive) || !evalParams.checkRotObstacle;
+}
+
+void PathEvaluator::buildVoxelPathMasks()
+{
+  voxelPathMasks.assign(size_t(gridVoxelNum) * pathMaskWordNum, 0);
+  for (int ind = 0; ind < gridVoxelNum; ind++) {
+    uint64_t *mask = &voxelPathMasks[pathMaskWordNum * ind];
+    int blockedPathByVoxelEnd = correspondenceOffsets[ind + 1];
+    for (int j = correspondenceOffsets[ind]; j < blockedPathByVoxelEnd; j++) {
+      mask[correspondencePaths[j] / 64] |= uint64_t(1) << (correspondencePaths[j] % 64);
+    }
+  }
+}
+
+// arc length along the path of each correspondence entry to the first path point within
+// searchRadius of the voxel center, the voxel centers are those of pathGenerator, a path point
+// moves away from a voxel at most as fast as the arc length grows, so the points that cannot
+// be within searchRadius yet are skipped
+void PathEvaluator::buildCorrespondenceArcLengths()
+{
+  vector<int> pathStarts(pathNumber + 1, 0);
+  for (int i = 0; i < libraryPathPointNum; i++) {
+    int pathID = libraryPathPoints[i].pathID;
+    if (pathID >= 0 && pathID < pathNumber) pathStarts[pathID + 1]++;
+  }
+  for (int i = 0; i < pathNumber; i++) {
+    pathStarts[i + 1] += pathStarts[i];
+  }
+
+  // path points are stored in path order
+  int pointNum = pathStarts[pathNumber];
+  vector<float> pointX(pointNum), pointY(pointNum), pointArc(pointNum);
+  vector<int> pathEnds(pathStarts.begin(), pathStarts.end() - 1);
+  for (int i = 0; i < libraryPathPointNum; i++) {
+    int pathID = libraryPathPoints[i].pathID;
+    if (pathID < 0 || pathID >= pathNumber) continue;
+
+    int k = pathEnds[pathID]++;
+    pointX[k] = libraryPathPoints[i].x;
+    pointY[k] = libraryPathPoints[i].y;
+    pointArc[k] = 0;
+    if (k > pathStarts[pathID]) {
+      float disX = pointX[k] - pointX[k - 1];
+      float disY = pointY[k] - pointY[k - 1];
+      pointArc[k] = pointArc[k - 1] + sqrt(disX * disX + disY * disY);
+    }
+  }
+
+  correspondenceArcLengths.assign(correspondenceOffsets[gridVoxelNum], 0);
+  #ifdef _OPENMP
+  #pragma omp parallel for num_threads(evalParams.threadNum) schedule(dynamic)
+  #endif
+  for (int indX = 0; indX < gridVoxelNumX; indX++) {
+    float x = gridVoxelOffsetX - gridVoxelSize * indX;
+    float scaleY = x / gridVoxelOffsetX + searchRadius / gridVoxelOffsetY * (gridVoxelOffsetX - x) / gridVoxelOffsetX;
+    for (int indY = 0; indY < gridVoxelNumY; indY++) {
+      float y = scaleY * (gridVoxelOffsetY - gridVoxelSize * indY);
+      int ind = gridVoxelNumY * indX + indY;
+
+      // rounding may leave no point within searchRadius, the nearest one is taken then
+      int blockedPathByVoxelEnd = correspondenceOffsets[ind + 1];
+      for (int j = correspondenceOffsets[ind]; j < blockedPathByVoxelEnd; j++) {
+        int pathID = correspondencePaths[j];
+        vector<float>::iterator arcEnd = pointArc.begin() + pathStarts[pathID + 1];
+        float minDis = -1.0, arc = 0;
+        int k = pathStarts[pathID];
+        while (k < pathStarts[pathID + 1]) {
+          float disX = pointX[k] - x;
+          float disY = pointY[k] - y;
+          float dis = sqrt(disX * disX + disY * disY);
+          if (minDis < 0 || dis < minDis) {
+            minDis = dis;
+            arc = pointArc[k];
+          }
+          if (dis <= searchRadius) break;
+
+          float skipArc = pointArc[k] + dis - searchRadius;
+          k = lower_bound(pointArc.begin() + k + 1, arcEnd, skipArc) - pointArc.begin();
+        }
+        correspondenceArcLengths[j] = arc;
+      }
+    }
+  }
+}
+
+// copy the points that may block a path into cloudX, cloudY and cloudH, scaled by
+// pathScale, so the rotation directions run over plain arrays
+void PathEvaluator::buildCloudArrays(const pcl::PointCloud<pcl::PointXYZI>& cloud, double pathScale, float pathRange,
+                                     float relativeGoalDis)
+{
+  int cloudSize = cloud.points.size();
+  if (int(cloudX.size()) < cloudSize) {
+    cloudX.resize(cloudSize);
+    cloudY.resize(cloudSize);
+    cloudH.resize(cloudSize);
+    cloudInRange.resize(cloudSize);
+  }
+
+  cloudArraySize = 0;
+  for (int i = 0; i < cloudSize; i++) {
+    float x = cloud.points[i].x / pathScale;
+    float y = cloud.points[i].y / pathScale;
+    float dis = sqrt(x * x + y * y);
+
+    bool inRange = dis < pathRange / pathScale;
+    if ((inRange || evalParams.useTtcCost) && (dis <= (relativeGoalDis + evalParams.goalClearRange) / pathScale ||
+        !evalParams.pathCropByGoal)) {
+      cloudX[cloudArraySize] = x;
+      cloudY[cloudArraySize] = y;
+      cloudH[cloudArraySize] = cloud.points[i].intensity;
+      cloudInRange[cloudArraySize] = inRange;
+      cloudArraySize++;
+    }
+  }
+}
+
+// voxel indices of the cloud arrays rotated into one direction, -1 outside the grid
+void PathEvaluator::computeVoxelIndices(int rotDir, vector<int>& voxelInds) const
+{
+  float rotAng = (10.0 * rotDir - 180.0) * PI / 180;
+  float cosRotAng = cos(rotAng);
+  float sinRotAng = sin(rotAng);
+
+  if (int(voxelInds.size()) < cloudArraySize) voxelInds.resize(cloudArraySize);
+
+  VoxelIndexGrid grid;
+  grid.gridVoxelNumX = gridVoxelNumX;
+  grid.gridVoxelNumY = gridVoxelNumY;
+  grid.gridVoxelSize = gridVoxelSize;
+  grid.searchRadius = searchRadius;
+  grid.gridVoxelOffsetX = gridVoxelOffsetX;
+  grid.gridVoxelOffsetY = gridVoxelOffsetY;
+  voxelIndices(grid, cosRotAng, sinRotAng, cloudX.data(), cloudY.data(), cloudArraySize, voxelInds.data());
+}
+
+// walk the correspondences of every point in range for one rotation direction, only the
+// pathNum * rotDir slices of clearPathList and pathPenaltyList are written
+void PathEvaluator::evaluateRotDir(int rotDir, VoxelScratch& scratch)
+{
+  int *clearPaths = &clearPathList[pathNumber * rotDir];
+  float *pathPenalties = &pathPenaltyList[pathNumber * rotDir];
+  const int *voxelInds = scratch.voxelInds.data();
+
+  for (int i = 0; i < cloudArraySize; i++) {
+    int ind = voxelInds[i];
+    if (ind >= 0 && cloudInRange[i]) {
+      float h = cloudH[i];
+      int blockedPathByVoxelEnd = correspondenceOffsets[ind + 1];
+      correspondenceLookupList[rotDir] += blockedPathByVoxelEnd - correspondenceOffsets[ind];
+      for (int j = correspondenceOffsets[ind]; j < blockedPathByVoxelEnd; j++) {
+        if (h > evalParams.obstacleHeightThre || !evalParams.useTerrainAnalysis) {
+          clearPaths[correspondencePaths[j]]++;
+        } else {
+          if (pathPenalties[correspondencePaths[j]] < h && h > evalParams.groundHeightThre) {
+            pathPenalties[correspondencePaths[j]] = h;
+          }
+        }
+      }
+    }
+  }
+}
+
+// collect the voxels hit in one rotation direction with their blocking point count and
+// max ground height into scratch.occupiedVoxels
+void PathEvaluator::markOccupiedVoxels(VoxelScratch& scratch) const
+{
+  int *voxelMarkStamp = &scratch.voxelMarkStamp[0];
+  int *voxelPointNum = &scratch.voxelPointNum[0];
+  float *voxelGroundH = &scratch.voxelGroundH[0];
+  vector<int>& occupiedVoxels = scratch.occupiedVoxels;
+  const int *voxelInds = scratch.voxelInds.data();
+
+  scratch.markStamp++;
+  int markStamp = scratch.markStamp;
+  occupiedVoxels.clear();
+
+  for (int i = 0; i < cloudArraySize; i++) {
+    int ind = voxelInds[i];
+    if (ind >= 0 && cloudInRange[i]) {
+      float h = cloudH[i];
+      if (voxelMarkStamp[ind] != markStamp) {
+        voxelMarkStamp[ind] = markStamp;
+        voxelPointNum[ind] = 0;
+        voxelGroundH[ind] = 0;
+        occupiedVoxels.push_back(ind);
+      }
+
+      if (h > evalParams.obstacleHeightThre || !evalParams.useTerrainAnalysis) {
+        voxelPointNum[ind]++;
+      } else if (voxelGroundH[ind] < h && h > evalParams.groundHeightThre) {
+        voxelGroundH[ind] = h;
+      }
+    }
+  }
+}
+
+// alternative to evaluateRotDir(), occupied voxels are marked once and blocked paths are
+// found by ORing their path masks
+void PathEvaluator::evaluateRotDirBitset(int rotDir, VoxelScratch& scratch)
+{
+  int levelNum = evalParams.pointPerPathThre;
+  if (levelNum <= 0) return;
+  scratch.pathBlockLevels.resize(levelNum * pathMaskWordNum);
+
+  markOccupiedVoxels(scratch);
+
+  int *voxelPointNum = &scratch.voxelPointNum[0];
+  float *voxelGroundH = &scratch.voxelGroundH[0];
+  vector<int>& occupiedVoxels = scratch.occupiedVoxels;
+  uint64_t *pathBlockLevels = &scratch.pathBlockLevels[0];
+  int *clearPaths = &clearPathList[pathNumber * rotDir];
+  float *pathPenalties = &pathPenaltyList[pathNumber * rotDir];
+
+  // level k holds the paths blocked by more than k points, counts saturate at pointPerPathThre
+  for (int i = 0; i < levelNum * pathMaskWordNum; i++) {
+    pathBlockLevels[i] = 0;
+  }
+
+  int occupiedVoxelNum = occupiedVoxels.size();
+  for (int i = 0; i < occupiedVoxelNum; i++) {
+    int ind = occupiedVoxels[i];
+    int pointNum = voxelPointNum[ind];
+    if (pointNum > levelNum) pointNum = levelNum;
+
+    if (pointNum > 0) {
+      const uint64_t *mask = &voxelPathMasks[pathMaskWordNum * ind];
+      for (int k = levelNum - 1; k >= 0; k--) {
+        uint64_t *level = &pathBlockLevels[pathMaskWordNum * k];
+        if (k >= pointNum) {
+          const uint64_t *lowerLevel = &pathBlockLevels[pathMaskWordNum * (k - pointNum)];
+          for (int w = 0; w < pathMaskWordNum; w++) {
+            level[w] |= lowerLevel[w] & mask[w];
+          }
+        } else {
+          for (int w = 0; w < pathMaskWordNum; w++) {
+            level[w] |= mask[w];
+          }
+        }
+      }
+    }
+
+    float h = voxelGroundH[ind];
+    if (h > 0) {
+      int blockedPathByVoxelEnd = correspondenceOffsets[ind + 1];
+      correspondenceLookupList[rotDir] += blockedPathByVoxelEnd - correspondenceOffsets[ind];
+      for (int j = correspondenceOffsets[ind]; j < blockedPathByVoxelEnd; j++) {
+        if (pathPenalties[correspondencePaths[j]] < h) {
+          pathPenalties[correspondencePaths[j]] = h;
+        }
+      }
+    }
+  }
+
+  int blockedPathNum = 0;
+  for (int k = 0; k < levelNum; k++) {
+    const uint64_t *level = &pathBlockLevels[pathMaskWordNum * k];
+    for (int w = 0; w < pathMaskWordNum; w++) {
+      uint64_t bits = level[w];
+      if (k == levelNum - 1) blockedPathNum += __builtin_popcountll(bits);
+      while (bits) {
+        clearPaths[64 * w + __builtin_ctzll(bits)]++;
+        bits &= bits - 1;
+      }
+    }
+  }
+  clearPathNumList[rotDir] = pathNumber - blockedPathNum;
+}
+
+// alternative to evaluateRotDir(), the occupied voxels are compared with those of the previous
+// evaluation of the same rotation direction and only the correspondences of voxels whose
+// point count or ground height changed are walked, a full rebuild starts from no occupancy
+void PathEvaluator::evaluateRotDirIncremental(int rotDir, VoxelScratch& scratch, bool rebuild)
+{
+  markOccupiedVoxels(scratch);
+
+  int *voxelPointNum = &scratch.voxelPointNum[0];
+  float *voxelGroundH = &scratch.voxelGroundH[0];
+  vector<int>& occupiedVoxels = scratch.occupiedVoxels;
+  sort(occupiedVoxels.begin(), occupiedVoxels.end());
+
+  int *pointNumSlice = &occupancyPointNumList[pathNumber * rotDir];
+  float *penaltySlice = &occupancyPenaltyList[pathNumber * rotDir];
+  vector<VoxelOccupancy>& lastOccupancy = rotDirOccupancy[rotDir];
+  if (rebuild) {
+    lastOccupancy.clear();
+    for (int i = 0; i < pathNumber; i++) {
+      pointNumSlice[i] = 0;
+      penaltySlice[i] = 0;
+    }
+  }
+
+  vector<VoxelOccupancy> occupancy;
+  occupancy.reserve(occupiedVoxels.size());
+  bool penaltyDecreased = false;
+  int lastOccupancySize = lastOccupancy.size();
+  int occupiedVoxelNum = occupiedVoxels.size();
+  int i = 0, k = 0;
+  while (i < lastOccupancySize || k < occupiedVoxelNum) {
+    VoxelOccupancy last = {gridVoxelNum, 0, 0}, current = {gridVoxelNum, 0, 0};
+    if (i < lastOccupancySize) last = lastOccupancy[i];
+    if (k < occupiedVoxelNum) {
+      current.ind = occupiedVoxels[k];
+      current.pointNum = voxelPointNum[current.ind];
+      current.groundH = voxelGroundH[current.ind];
+    }
+
+    int ind = last.ind;
+    if (current.ind < last.ind) {
+      ind = current.ind;
+      last.pointNum = 0;
+      last.groundH = 0;
+      k++;
+    } else if (current.ind > last.ind) {
+      current.pointNum = 0;
+      current.groundH = 0;
+      i++;
+    } else {
+      i++;
+      k++;
+    }
+
+    if (current.ind == ind) {
+      occupancy.push_back(current);
+    }
+
+    int pointNumDiff = current.pointNum - last.pointNum;
+    if (pointNumDiff != 0 || current.groundH > last.groundH) {
+      int blockedPathByVoxelEnd = correspondenceOffsets[ind + 1];
+      correspondenceLookupList[rotDir] += blockedPathByVoxelEnd - correspondenceOffsets[ind];
+      for (int j = correspondenceOffsets[ind]; j < blockedPathByVoxelEnd; j++) {
+        pointNumSlice[correspondencePaths[j]] += pointNumDiff;
+        if (penaltySlice[correspondencePaths[j]] < current.groundH) {
+          penaltySlice[correspondencePaths[j]] = current.groundH;
+        }
+      }
+    }
+    if (current.groundH < last.groundH) {
+      penaltyDecreased = true;
+    }
+  }
+
+  // a max cannot be undone, recompute the penalties of this direction from the occupied voxels
+  if (penaltyDecreased) {
+    for (int i = 0; i < pathNumber; i++) {
+      penaltySlice[i] = 0;
+    }
+
+    int occupancySize = occupancy.size();
+    for (int i = 0; i < occupancySize; i++) {
+      float h = occupancy[i].groundH;
+      if (h > 0) {
+        int ind = occupancy[i].ind;
+        int blockedPathByVoxelEnd = correspondenceOffsets[ind + 1];
+        correspondenceLookupList[rotDir] += blockedPathByVoxelEnd - correspondenceOffsets[ind];
+        for (int j = correspondenceOffsets[ind]; j < blockedPathByVoxelEnd; j++) {
+          if (penaltySlice[correspondencePaths[j]] < h) {
+            penaltySlice[correspondencePaths[j]] = h;
+          }
+        }
+      }
+    }
+  }
+
+  lastOccupancy.swap(occupancy);
+
+  for (int i = 0; i < pathNumber; i++) {
+    clearPathList[pathNumber * rotDir + i] = pointNumSlice[i];
+    pathPenaltyList[pathNumber * rotDir + i] = penaltySlice[i];
+  }
+}
+
+// distance in m along each path of one rotation direction to its first obstacle, where the
+// path first comes within searchRadius of an occupied voxel, obstacles beyond pathRange are
+// included so paths that are clear within it still see what lies ahead
+void PathEvaluator::markObstacleDis(int rotDir, double pathScale, VoxelScratch& scratch)
+{
+  int *voxelMarkStamp = &scratch.voxelMarkStamp[0];
+  vector<int>& occupiedVoxels = scratch.occupiedVoxels;
+  const int *voxelInds = scratch.voxelInds.data();
+  float *pathObsDis = &pathObsDisList[pathNumber * rotDir];
+
+  scratch.markStamp++;
+  int markStamp = scratch.markStamp;
+  occupiedVoxels.clear();
+
+  for (int i = 0; i < cloudArraySize; i++) {
+    int ind = voxelInds[i];
+    if (ind >= 0 && (cloudH[i] > evalParams.obstacleHeightThre || !evalParams.useTerrainAnalysis) &&
+        voxelMarkStamp[ind] != markStamp) {
+      voxelMarkStamp[ind] = markStamp;
+      occupiedVoxels.push_back(ind);
+    }
+  }
+
+  int occupiedVoxelNum = occupiedVoxels.size();
+  for (int i = 0; i < occupiedVoxelNum; i++) {
+    int ind = occupiedVoxels[i];
+    int blockedPathByVoxelEnd = correspondenceOffsets[ind + 1];
+    correspondenceLookupList[rotDir] += blockedPathByVoxelEnd - correspondenceOffsets[ind];
+    for (int j = correspondenceOffsets[ind]; j < blockedPathByVoxelEnd; j++) {
+      float obsDis = pathScale * correspondenceArcLengths[j];
+      if (pathObsDis[correspondencePaths[j]] < 0 || pathObsDis[correspondencePaths[j]] > obsDis) {
+        pathObsDis[correspondencePaths[j]] = obsDis;
+      }
+    }
+  }
+}
+
+// accumulate the group scores of one rotation direction, paths are summed in a fixed order
+// so the result does not depend on the thread count
+void PathEvaluator::scoreRotDir(int rotDir, float joyDir, float relativeGoalDis, float speed)
+{
+  if (clearPathNumList[rotDir] <= 0) return;
+
+  float rotDirW;
+  if (rotDir < 18) rotDirW = fabs(fabs(rotDir - 9) + 1);
+  else rotDirW = fabs(fabs(rotDir - 27) + 1);
+
+  for (int pathID = 0; pathID < pathNumber; pathID++) {
+    int i = pathNumber * rotDir + pathID;
+    if (clearPathList[i] < evalParams.pointPerPathThre) {
+      float penaltyScore = 1.0 - pathPenaltyList[i] / evalParams.costHeightThre;
+      if (penaltyScore < evalParams.costScore) penaltyScore = evalParams.costScore;
+
+      float dirDiff = fabs(joyDir - endDirPathList[pathID] - (10.0 * rotDir - 180.0));
+      if (dirDiff > 360.0) {
+        dirDiff -= 360.0;
+      }
+      if (dirDiff > 180.0) {
+        dirDiff = 360.0 - dirDiff;
+      }
+
+      float groupDirW = 4  - fabs(pathList[pathID] - 3);
+      float score = (1 - sqrt(sqrt(evalParams.dirWeight * dirDiff))) * rotDirW * rotDirW * rotDirW * rotDirW * penaltyScore;
+      if (relativeGoalDis < evalParams.goalCloseDis) {
+        score = (1 - sqrt(sqrt(evalParams.dirWeight * dirDiff))) * groupDirW * groupDirW * penaltyScore;
+      }
+
+      if (evalParams.useTtcCost && pathObsDisList[i] >= 0 && speed > 0) {
+        float ttcScore = pathObsDisList[i] / speed / evalParams.ttcThre;
+        if (ttcScore < evalParams.ttcScore) ttcScore = evalParams.ttcScore;
+        if (ttcScore < 1.0) score *= ttcScore;
+      }
+      if (score > 0) {
+        clearPathPerGroupScore[groupNumber * rotDir + pathList[pathID]] += score;
+      }
+    }
+  }
+}
+
+bool PathEvaluator::evaluate(const pcl::PointCloud<pcl::PointXYZI>& plannerCloudCrop, const PathEvaluatorState& state,
+                             PathEvaluatorResult& result)
+{
+  const PathEvaluatorParams& p = evalParams;
+  #ifdef _OPENMP
+  int threadNum = p.threadNum;
+  #endif
+
+  float joySpeed = state.joySpeed;
+  float joyDir = state.joyDir;
+
+  float pathRange = p.adjacentRange;
+  if (p.pathRangeBySpeed) pathRange = p.adjacentRange * joySpeed;
+  if (pathRange < p.minPathRange) pathRange = p.minPathRange;
+  float relativeGoalDis = p.adjacentRange;
+
+  if (state.autonomyMode) {
+    float sinVehicleYaw = sin(state.vehicleYaw);
+    float cosVehicleYaw = cos(state.vehicleYaw);
+    float relativeGoalX = ((state.goalX - state.vehicleX) * cosVehicleYaw + (state.goalY - state.vehicleY) * sinVehicleYaw);
+    float relativeGoalY = (-(state.goalX - state.vehicleX) * sinVehicleYaw + (state.goalY - state.vehicleY) * cosVehicleYaw);
+
+    relativeGoalDis = sqrt(relativeGoalX * relativeGoalX + relativeGoalY * relativeGoalY);
+    joyDir = atan2(relativeGoalY, relativeGoalX) * 180 / PI;
+
+    if (!p.twoWayDrive) {
+      if (joyDir > 90.0) joyDir = 90.0;
+      else if (joyDir < -90.0) joyDir = -90.0;
+    }
+  }
+
+  // the incremental evaluation diffs against the occupancy of the last cycle, start over
+  // when the vehicle moved so far that little of it is expected to carry over
+  float incrementalDis = sqrt((state.vehicleX - vehicleXRec) * (state.vehicleX - vehicleXRec)
+                       + (state.vehicleY - vehicleYRec) * (state.vehicleY - vehicleYRec));
+  float incrementalAng = fabs(state.vehicleYaw - vehicleYawRec) * 180.0 / PI;
+  if (incrementalAng > 180.0) incrementalAng = 360.0 - incrementalAng;
+  bool incrementalRebuild = (incrementalDis > p.incrementalDisThre || incrementalAng > p.incrementalAngThre);
+  if (incrementalRebuild) {
+    vehicleXRec = state.vehicleX;
+    vehicleYRec = state.vehicleY;
+    vehicleYawRec = state.vehicleYaw;
+  }
+
+  for (int i = 0; i < 36; i++) {
+    correspondenceLookupList[i] = 0;
+  }
+
+  result.pathFound = false;
+  result.selectedGroupID = -1;
+  result.selectedRotDir = -1;
+  result.path.clear();
+
+  double pathScale = p.pathScale;
+  double defPathScale = p.pathScale;
+  if (p.pathScaleBySpeed) pathScale = defPathScale * joySpeed;
+  if (pathScale < p.minPathScale) pathScale = p.minPathScale;
+
+  while (pathScale >= p.minPathScale && pathRange >= p.minPathRange) {
+    fill(clearPathList.begin(), clearPathList.end(), 0);
+    fill(pathPenaltyList.begin(), pathPenaltyList.end(), 0);
+    fill(clearPathPerGroupScore.begin(), clearPathPerGroupScore.end(), 0);
+    if (p.useTtcCost) fill(pathObsDisList.begin(), pathObsDisList.end(), -1.0);
+    for (int i = 0; i < 36; i++) {
+      clearPathNumList[i] = pathNumber;
+    }
+
+    // rotation directions write disjoint slices of clearPathList and pathPenaltyList
+    if (state.checkObstacle) {
+      buildCloudArrays(plannerCloudCrop, pathScale, pathRange, relativeGoalDis);
+
+      #ifdef _OPENMP
+      #pragma omp parallel for num_threads(threadNum) schedule(dynamic)
+      #endif
+      for (int rotDir = 0; rotDir < 36; rotDir++) {
+        if (!rotDirInRange(rotDir, joyDir)) {
+          continue;
+        }
+
+        VoxelScratch& scratch = voxelScratch[threadID()];
+        computeVoxelIndices(rotDir, scratch.voxelInds);
+
+        if (p.useIncrementalEval) {
+          evaluateRotDirIncremental(rotDir, scratch, incrementalRebuild);
+        } else if (p.useBitsetEval) {
+          evaluateRotDirBitset(rotDir, scratch);
+        } else {
+          evaluateRotDir(rotDir, scratch);
+        }
+
+        if (p.useTtcCost) {
+          markObstacleDis(rotDir, pathScale, scratch);
+        }
+      }
+      incrementalRebuild = false;
+    }
+
+    minObsAngCW = -180.0;
+    minObsAngCCW = 180.0;
+    float diameter = sqrt(p.vehicleLength / 2.0 * p.vehicleLength / 2.0 + p.vehicleWidth / 2.0 * p.vehicleWidth / 2.0);
+    float angOffset = atan2(p.vehicleWidth, p.vehicleLength) * 180.0 / PI;
+    int plannerCloudCropSize = plannerCloudCrop.points.size();
+    for (int i = 0; i < plannerCloudCropSize; i++) {
+      float x = plannerCloudCrop.points[i].x / pathScale;
+      float y = plannerCloudCrop.points[i].y / pathScale;
+      float h = plannerCloudCrop.points[i].intensity;
+      float dis = sqrt(x * x + y * y);
+
+      if (dis < diameter / pathScale && (fabs(x) > p.vehicleLength / pathScale / 2.0 || fabs(y) > p.vehicleWidth / pathScale / 2.0) &&
+          (h > p.obstacleHeightThre || !p.useTerrainAnalysis) && p.checkRotObstacle) {
+        float angObs = atan2(y, x) * 180.0 / PI;
+        if (angObs > 0) {
+          if (minObsAngCCW > angObs - angOffset) minObsAngCCW = angObs - angOffset;
+          if (minObsAngCW < angObs + angOffset - 180.0) minObsAngCW = angObs + angOffset - 180.0;
+        } else {
+          if (minObsAngCW < angObs + angOffset) minObsAngCW = angObs + angOffset;
+          if (minObsAngCCW > 180.0 + angObs - angOffset) minObsAngCCW = 180.0 + angObs - angOffset;
+        }
+      }
+    }
+
+    if (minObsAngCW > 0) minObsAngCW = 0;
+    if (minObsAngCCW < 0) minObsAngCCW = 0;
+
+    #ifdef _OPENMP
+    #pragma omp parallel for num_threads(threadNum) schedule(dynamic)
+    #endif
+    for (int rotDir = 0; rotDir < 36; rotDir++) {
+      if (!rotDirInRange(rotDir, joyDir)) {
+        continue;
+      }
+
+      scoreRotDir(rotDir, joyDir, relativeGoalDis, joySpeed * p.maxSpeed);
+    }
+
+    float maxScore = 0;
+    int selectedGroupID = -1;
+    for (int i = 0; i < 36 * groupNumber; i++) {
+      int rotDir = int(i / groupNumber);
+      if (maxScore < clearPathPerGroupScore[i] && rotDirClearOfRotObstacle(rotDir)) {
+        maxScore = clearPathPerGroupScore[i];
+        selectedGroupID = i;
+      }
+    }
+
+    if (selectedGroupID >= 0) {
+      int rotDir = int(selectedGroupID / groupNumber);
+      float rotAng = (10.0 * rotDir - 180.0) * PI / 180;
+
+      selectedGroupID = selectedGroupID % groupNumber;
+      pcl::PointXYZ point;
+      int selectedPathLength = startPaths[selectedGroupID].points.size();
+      for (int i = 0; i < selectedPathLength; i++) {
+        float x = startPaths[selectedGroupID].points[i].x;
+        float y = startPaths[selectedGroupID].points[i].y;
+        float z = startPaths[selectedGroupID].points[i].z;
+        float dis = sqrt(x * x + y * y);
+
+        if (dis <= pathRange / pathScale && dis <= relativeGoalDis / pathScale) {
+          point.x = pathScale * (cos(rotAng) * x - sin(rotAng) * y);
+          point.y = pathScale * (sin(rotAng) * x + cos(rotAng) * y);
+          point.z = pathScale * z;
+          result.path.push_back(point);
+        } else {
+          break;
+        }
+      }
+
+      result.pathFound = true;
+      result.selectedGroupID = selectedGroupID;
+      result.selectedRotDir = rotDir;
+      break;
+    }
+
+    if (pathScale >= p.minPathScale + p.pathScaleStep) {
+      pathScale -= p.pathScaleStep;
+      pathRange = p.adjacentRange * pathScale / defPathScale;
+    } else {
+      pathRange -= p.pathRangeStep;
+    }
+  }
+
+  result.pathScale = pathScale;
+  result.pathRange = pathRange;
+  result.relativeGoalDis = relativeGoalDis;
+  result.joyDir = joyDir;
+
+  result.correspondenceLookupNum = 0;
+  for (int i = 0; i < 36; i++) {
+    result.correspondenceLookupNum += correspondenceLookupList[i];
+  }
+
+  return result.pathFound;
+}
+
+void PathEvaluator::getFreePaths(const PathEvaluatorResult& result, pcl::PointCloud<pcl::PointXYZI>& freePaths) const
+{
+  freePaths.clear();
+  if (!result.pathFound) return;
+
+  double pathScale = result.pathScale;
+  pcl::PointXYZI point;
+  for (int i = 0; i < 36 * pathNumber; i++) {
+    int rotDir = int(i / pathNumber);
+    float rotAng = (10.0 * rotDir - 180.0) * PI / 180;
+    if (!rotDirInRange(rotDir, result.joyDir) || !rotDirClearOfRotObstacle(rotDir)) {
+      continue;
+    }
+
+    if (clearPathList[i] < evalParams.pointPerPathThre) {
+      int freePathLength = paths[i % pathNumber].points.size();
+      for (int j = 0; j < freePathLength; j++) {
+        point = paths[i % pathNumber].points[j];
+
+        float x = point.x;
+        float y = point.y;
+        float z = point.z;
+
+        float dis = sqrt(x * x + y * y);
+        if (dis <= result.pathRange / pathScale && (dis <= (result.relativeGoalDis + evalParams.goalClearRange) / pathScale ||
+            !evalParams.pathCropByGoal)) {
+          point.x = pathScale * (cos(rotAng) * x - sin(rotAng) * y);
+          point.y = pathScale * (sin(rotAng) * x + cos(rotAng) * y);
+          point.z = pathScale * z;
+          point.intensity = 1.0;
+
+          freePaths.push_back(point);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,244 @@
+#include <math.h>
+
+#include "local_planner/pathFollowerController.h"
+
+using namespace std;
+
+const double PI = 3.1415926;
+
+PathFollowerController::PathFollowerController()
+  : pathPointInd(0), navForward(true), switchTime(0), speed(0), yawRate(0)
+{
+}
+
+void PathFollowerController::setParams(const PathFollowerParams& params)
+{
+  followerParams = params;
+}
+
+void PathFollowerController::resetPath()
+{
+  pathPointInd = 0;
+}
+
+PathFollowerCmd PathFollowerController::step(const PathFollowerState& state, const PathFollowerPath& path, float dt)
+{
+  const PathFollowerParams& p = followerParams;
+
+  // track the path from where the vehicle will be when the command takes effect
+  float vehicleX = state.vehicleX, vehicleY = state.vehicleY, vehicleYaw = state.vehicleYaw;
+  if (p.useLatencyComp) predictVehiclePose(p.latencyTime, vehicleX, vehicleY, vehicleYaw);
+
+  float vehicleXRel = cos(path.vehicleYawRec) * (vehicleX - path.vehicleXRec)
+                    + sin(path.vehicleYawRec) * (vehicleY - path.vehicleYRec);
+  float vehicleYRel = -sin(path.vehicleYawRec) * (vehicleX - path.vehicleXRec)
+                    + cos(path.vehicleYawRec) * (vehicleY - path.vehicleYRec);
+
+  int pathSize = path.x.size();
+  if (pathSize == 0) {
+    speed = 0;
+    yawRate = 0;
+    lastCmd = PathFollowerCmd();
+    return lastCmd;
+  }
+  if (pathPointInd >= pathSize) pathPointInd = pathSize - 1;
+
+  float endDisX = path.x[pathSize - 1] - vehicleXRel;
+  float endDisY = path.y[pathSize - 1] - vehicleYRel;
+  float endDis = sqrt(endDisX * endDisX + endDisY * endDisY);
+
+  float disX, disY, dis;
+  while (pathPointInd < pathSize - 1) {
+    disX = path.x[pathPointInd] - vehicleXRel;
+    disY = path.y[pathPointInd] - vehicleYRel;
+    dis = sqrt(disX * disX + disY * disY);
+    if (dis < p.lookAheadDis) {
+      pathPointInd++;
+    } else {
+      break;
+    }
+  }
+
+  disX = path.x[pathPointInd] - vehicleXRel;
+  disY = path.y[pathPointInd] - vehicleYRel;
+  dis = sqrt(disX * disX + disY * disY);
+  float pathDir = atan2(disY, disX);
+
+  float dirDiff = vehicleYaw - path.vehicleYawRec - pathDir;
+  if (dirDiff > PI) dirDiff -= 2 * PI;
+  else if (dirDiff < -PI) dirDiff += 2 * PI;
+  if (dirDiff > PI) dirDiff -= 2 * PI;
+  else if (dirDiff < -PI) dirDiff += 2 * PI;
+
+  if (p.twoWayDrive) {
+    if (fabs(dirDiff) > PI / 2 && navForward && state.time - switchTime > p.switchTimeThre) {
+      navForward = false;
+      switchTime = state.time;
+    } else if (fabs(dirDiff) < PI / 2 && !navForward && state.time - switchTime > p.switchTimeThre) {
+      navForward = true;
+      switchTime = state.time;
+    }
+  }
+
+  float joySpeed2 = p.maxSpeed * state.joySpeed;
+  if (!navForward) {
+    dirDiff += PI;
+    if (dirDiff > PI) dirDiff -= 2 * PI;
+    joySpeed2 *= -1;
+  }
+
+  if (fabs(speed) < 2.0 * p.maxAccel * dt) yawRate = -p.stopYawRateGain * dirDiff;
+  else yawRate = -p.yawRateGain * dirDiff;
+
+  if (yawRate > p.maxYawRate * PI / 180.0) yawRate = p.maxYawRate * PI / 180.0;
+  else if (yawRate < -p.maxYawRate * PI / 180.0) yawRate = -p.maxYawRate * PI / 180.0;
+
+  if (joySpeed2 == 0 && !state.autonomyMode) {
+    yawRate = p.maxYawRate * state.joyYaw * PI / 180.0;
+  } else if (pathSize <= 1 || (dis < p.stopDisThre && p.noRotAtGoal)) {
+    yawRate = 0;
+  }
+
+  if (pathSize <= 1) {
+    joySpeed2 = 0;
+  } else if (endDis / p.slowDwnDisThre < state.joySpeed) {
+    joySpeed2 *= endDis / p.slowDwnDisThre;
+  }
+
+  float joySpeed3 = joySpeed2;
+  if (state.odomTime < state.slowInitTime + p.slowTime1 && state.slowInitTime > 0) joySpeed3 *= p.slowRate1;
+  else if (state.odomTime < state.slowInitTime + p.slowTime1 + p.slowTime2 && state.slowInitTime > 0) joySpeed3 *= p.slowRate2;
+
+  if (p.useCurvToSlow) {
+    float curvSpeed = curvSpeedLimit(path, vehicleXRel, vehicleYRel);
+    if (joySpeed3 > curvSpeed) joySpeed3 = curvSpeed;
+    else if (joySpeed3 < -curvSpeed) joySpeed3 = -curvSpeed;
+  }
+
+  if ((fabs(dirDiff) < p.dirDiffThre || (dis < p.goalCloseDis && fabs(dirDiff) < p.omniDirDiffThre)) && dis > p.stopDisThre) {
+    if (speed < joySpeed3) speed += p.maxAccel * dt;
+    else if (speed > joySpeed3) speed -= p.maxAccel * dt;
+  } else {
+    if (speed > 0) speed -= p.maxAccel * dt;
+    else if (speed < 0) speed += p.maxAccel * dt;
+  }
+
+  if (fabs(speed) > p.noRotSpeed) yawRate = 0;
+
+  if (state.odomTime < state.stopInitTime + p.stopTime && state.stopInitTime > 0) {
+    speed = 0;
+    yawRate = 0;
+  }
+
+  if ((state.safetyStop & 1) > 0 && speed > 0) speed = 0;
+  if ((state.safetyStop & 2) > 0 && speed < 0) speed = 0;
+  if ((state.safetyStop & 4) > 0 && yawRate > 0) yawRate = 0;
+  if ((state.safetyStop & 8) > 0 && yawRate < 0) yawRate = 0;
+
+  if (fabs(speed) <= p.maxAccel * dt) {
+    lastCmd.speedX = 0;
+    lastCmd.speedY = 0;
+  } else {
+    lastCmd.speedX = cos(dirDiff) * speed;
+    lastCmd.speedY = -sin(dirDiff) * speed;
+  }
+  lastCmd.yawRate = yawRate;
+
+  return lastCmd;
+}
+
+// a point of curvature k allows sqrt(maxLatAccel / k), and the limit at the vehicle is kept low
+// enough to brake down to it at maxAccel over the distance in between, curvature is taken from
+// points resampled every curvSampleDis so the closely spaced path points do not amplify noise
+float PathFollowerController::curvSpeedLimit(const PathFollowerPath& path, float vehicleXRel, float vehicleYRel) const
+{
+  const PathFollowerParams& p = followerParams;
+
+  int pathSize = path.x.size();
+  float speedLimit = p.maxSpeed;
+  if (pathSize < 3 || p.maxLatAccel <= 0) return speedLimit;
+
+  // start from the path point nearest to the vehicle, those before pathPointID are all in reach
+  int nearestID = 0;
+  float minDis = -1.0;
+  for (int i = 0; i <= pathPointInd && i < pathSize; i++) {
+    float disX = path.x[i] - vehicleXRel;
+    float disY = path.y[i] - vehicleYRel;
+    float dis = disX * disX + disY * disY;
+    if (minDis < 0 || dis < minDis) {
+      minDis = dis;
+      nearestID = i;
+    }
+  }
+
+  float sampleX[3], sampleY[3], sampleDis[3];
+  sampleX[0] = path.x[nearestID];
+  sampleY[0] = path.y[nearestID];
+  sampleDis[0] = 0;
+  int sampleNum = 1;
+
+  float pathDis = 0;
+  for (int i = nearestID + 1; i < pathSize; i++) {
+    float segX = path.x[i] - path.x[i - 1];
+    float segY = path.y[i] - path.y[i - 1];
+    pathDis += sqrt(segX * segX + segY * segY);
+    if (pathDis - sampleDis[sampleNum - 1] < p.curvSampleDis) continue;
+
+    sampleX[sampleNum] = path.x[i];
+    sampleY[sampleNum] = path.y[i];
+    sampleDis[sampleNum] = pathDis;
+    sampleNum++;
+
+    if (sampleNum == 3) {
+      float ax = sampleX[1] - sampleX[0], ay = sampleY[1] - sampleY[0];
+      float bx = sampleX[2] - sampleX[1], by = sampleY[2] - sampleY[1];
+      float cx = sampleX[2] - sampleX[0], cy = sampleY[2] - sampleY[0];
+      float lengthProduct = sqrt((ax * ax + ay * ay) * (bx * bx + by * by) * (cx * cx + cy * cy));
+
+      // curvature of the circle through the three samples
+      if (lengthProduct > 0) {
+        float curv = 2.0 * fabs(ax * by - ay * bx) / lengthProduct;
+        if (curv > 0) {
+          float curvSpeed = sqrt(p.maxLatAccel / curv + 2.0 * p.maxAccel * sampleDis[1]);
+          if (speedLimit > curvSpeed) speedLimit = curvSpeed;
+        }
+      }
+
+      for (int j = 0; j < 2; j++) {
+        sampleX[j] = sampleX[j + 1];
+        sampleY[j] = sampleY[j + 1];
+        sampleDis[j] = sampleDis[j + 1];
+      }
+      sampleNum = 2;
+    }
+  }
+
+  return speedLimit;
+}
+
+void PathFollowerController::predictVehiclePose(float predictTime, float& x, float& y, float& yaw) const
+{
+  predictVehiclePose(lastCmd, predictTime, x, y, yaw);
+}
+
+// the command is held in the vehicle frame and the twist is integrated exactly along the arc it
+// describes
+void PathFollowerController::predictVehiclePose(const PathFollowerCmd& cmd, float predictTime, float& x, float& y, float& yaw)
+{
+  float rotAng = cmd.yawRate * predictTime;
+  float shiftX, shiftY;
+  if (fabs(rotAng) > 1e-4) {
+    shiftX = (cmd.speedX * sin(rotAng) + cmd.speedY * (cos(rotAng) - 1.0)) / cmd.yawRate;
+    shiftY = (cmd.speedX * (1.0 - cos(rotAng)) + cmd.speedY * sin(rotAng)) / cmd.yawRate;
+  } else {
+    shiftX = cmd.speedX * predictTime;
+    shiftY = cmd.speedY * predictTime;
+  }
+
+  float yawOri = yaw;
+  x += cos(yawOri) * shiftX - sin(yawOri) * shiftY;
+  y += sin(yawOri) * shiftX + cos(yawOri) * shiftY;
+  yaw = yawOri + rotAng;
+  if (yaw > PI) yaw -= 2 * PI;
+  else if (yaw < -PI) yaw += 2 * PI;
+}
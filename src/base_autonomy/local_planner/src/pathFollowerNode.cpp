@@ -0,0 +1,381 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include "rclcpp_components/register_node_macro.hpp"
+
+#include "tf2/transform_datatypes.h"
+#include "tf2_geometry_msgs/tf2_geometry_msgs.hpp"
+
+#include "local_planner/pathFollowerNode.h"
+
+using namespace std;
+
+namespace local_planner
+{
+
+const double PI = 3.1415926;
+
+PathFollowerNode::PathFollowerNode(const rclcpp::NodeOptions& options)
+  : Node("pathFollower", options)
+{
+  declare_parameter<double>("sensorOffsetX", sensorOffsetX);
+  declare_parameter<double>("sensorOffsetY", sensorOffsetY);
+  declare_parameter<int>("pubSkipNum", pubSkipNum);
+  declare_parameter<bool>("twoWayDrive", twoWayDrive);
+  declare_parameter<double>("lookAheadDis", lookAheadDis);
+  declare_parameter<double>("yawRateGain", yawRateGain);
+  declare_parameter<double>("stopYawRateGain", stopYawRateGain);
+  declare_parameter<double>("maxYawRate", maxYawRate);
+  declare_parameter<double>("maxSpeed", maxSpeed);
+  declare_parameter<double>("maxAccel", maxAccel);
+  declare_parameter<double>("switchTimeThre", switchTimeThre);
+  declare_parameter<double>("dirDiffThre", dirDiffThre);
+  declare_parameter<double>("omniDirDiffThre", omniDirDiffThre);
+  declare_parameter<double>("noRotSpeed", noRotSpeed);
+  declare_parameter<double>("stopDisThre", stopDisThre);
+  declare_parameter<double>("slowDwnDisThre", slowDwnDisThre);
+  declare_parameter<bool>("useInclRateToSlow", useInclRateToSlow);
+  declare_parameter<double>("inclRateThre", inclRateThre);
+  declare_parameter<double>("slowRate1", slowRate1);
+  declare_parameter<double>("slowRate2", slowRate2);
+  declare_parameter<double>("slowTime1", slowTime1);
+  declare_parameter<double>("slowTime2", slowTime2);
+  declare_parameter<bool>("useInclToStop", useInclToStop);
+  declare_parameter<double>("inclThre", inclThre);
+  declare_parameter<double>("stopTime", stopTime);
+  declare_parameter<bool>("useCurvToSlow", useCurvToSlow);
+  declare_parameter<double>("maxLatAccel", maxLatAccel);
+  declare_parameter<double>("curvSampleDis", curvSampleDis);
+  declare_parameter<bool>("useLatencyComp", useLatencyComp);
+  declare_parameter<double>("latencyTime", latencyTime);
+  declare_parameter<bool>("noRotAtStop", noRotAtStop);
+  declare_parameter<bool>("noRotAtGoal", noRotAtGoal);
+  declare_parameter<bool>("autonomyMode", autonomyMode);
+  declare_parameter<double>("autonomySpeed", autonomySpeed);
+  declare_parameter<double>("joyToSpeedDelay", joyToSpeedDelay);
+  declare_parameter<double>("goalCloseDis", goalCloseDis);
+  declare_parameter<bool>("is_real_robot", is_real_robot);
+
+  get_parameter("sensorOffsetX", sensorOffsetX);
+  get_parameter("sensorOffsetY", sensorOffsetY);
+  get_parameter("pubSkipNum", pubSkipNum);
+  get_parameter("twoWayDrive", twoWayDrive);
+  get_parameter("lookAheadDis", lookAheadDis);
+  get_parameter("yawRateGain", yawRateGain);
+  get_parameter("stopYawRateGain", stopYawRateGain);
+  get_parameter("maxYawRate", maxYawRate);
+  get_parameter("maxSpeed", maxSpeed);
+  get_parameter("maxAccel", maxAccel);
+  get_parameter("switchTimeThre", switchTimeThre);
+  get_parameter("dirDiffThre", dirDiffThre);
+  get_parameter("omniDirDiffThre", omniDirDiffThre);
+  get_parameter("noRotSpeed", noRotSpeed);
+  get_parameter("stopDisThre", stopDisThre);
+  get_parameter("slowDwnDisThre", slowDwnDisThre);
+  get_parameter("useInclRateToSlow", useInclRateToSlow);
+  get_parameter("inclRateThre", inclRateThre);
+  get_parameter("slowRate1", slowRate1);
+  get_parameter("slowRate2", slowRate2);
+  get_parameter("slowTime1", slowTime1);
+  get_parameter("slowTime2", slowTime2);
+  get_parameter("useInclToStop", useInclToStop);
+  get_parameter("inclThre", inclThre);
+  get_parameter("stopTime", stopTime);
+  get_parameter("useCurvToSlow", useCurvToSlow);
+  get_parameter("maxLatAccel", maxLatAccel);
+  get_parameter("curvSampleDis", curvSampleDis);
+  get_parameter("useLatencyComp", useLatencyComp);
+  get_parameter("latencyTime", latencyTime);
+  get_parameter("noRotAtStop", noRotAtStop);
+  get_parameter("noRotAtGoal", noRotAtGoal);
+  get_parameter("autonomyMode", autonomyMode);
+  get_parameter("autonomySpeed", autonomySpeed);
+  get_parameter("joyToSpeedDelay", joyToSpeedDelay);
+  get_parameter("goalCloseDis", goalCloseDis);
+  get_parameter("is_real_robot", is_real_robot);
+
+  PathFollowerParams followerParams;
+  followerParams.twoWayDrive = twoWayDrive;
+  followerParams.lookAheadDis = lookAheadDis;
+  followerParams.yawRateGain = yawRateGain;
+  followerParams.stopYawRateGain = stopYawRateGain;
+  followerParams.maxYawRate = maxYawRate;
+  followerParams.maxSpeed = maxSpeed;
+  followerParams.maxAccel = maxAccel;
+  followerParams.switchTimeThre = switchTimeThre;
+  followerParams.dirDiffThre = dirDiffThre;
+  followerParams.omniDirDiffThre = omniDirDiffThre;
+  followerParams.noRotSpeed = noRotSpeed;
+  followerParams.stopDisThre = stopDisThre;
+  followerParams.slowDwnDisThre = slowDwnDisThre;
+  followerParams.slowRate1 = slowRate1;
+  followerParams.slowRate2 = slowRate2;
+  followerParams.slowTime1 = slowTime1;
+  followerParams.slowTime2 = slowTime2;
+  followerParams.stopTime = stopTime;
+  followerParams.useCurvToSlow = useCurvToSlow;
+  followerParams.maxLatAccel = maxLatAccel;
+  followerParams.curvSampleDis = curvSampleDis;
+  followerParams.useLatencyComp = useLatencyComp;
+  followerParams.latencyTime = latencyTime;
+  followerParams.noRotAtGoal = noRotAtGoal;
+  followerParams.goalCloseDis = goalCloseDis;
+  controller.setParams(followerParams);
+
+  subOdom = create_subscription<nav_msgs::msg::Odometry>("/state_estimation", 5,
+            std::bind(&PathFollowerNode::odomHandler, this, std::placeholders::_1));
+  subPath = create_subscription<nav_msgs::msg::Path>("/path", 5,
+            std::bind(&PathFollowerNode::pathHandler, this, std::placeholders::_1));
+  subJoystick = create_subscription<sensor_msgs::msg::Joy>("/joy", 5,
+                std::bind(&PathFollowerNode::joystickHandler, this, std::placeholders::_1));
+  subSpeed = create_subscription<std_msgs::msg::Float32>("/speed", 5,
+             std::bind(&PathFollowerNode::speedHandler, this, std::placeholders::_1));
+  subStop = create_subscription<std_msgs::msg::Int8>("/stop", 5,
+            std::bind(&PathFollowerNode::stopHandler, this, std::placeholders::_1));
+
+  pubSpeed = create_publisher<geometry_msgs::msg::TwistStamped>("/cmd_vel", 5);
+  pubGo2Request = create_publisher<unitree_api::msg::Request>("/api/sport/request", 10);
+
+  if (autonomyMode) {
+    joySpeed = autonomySpeed / maxSpeed;
+
+    if (joySpeed < 0) joySpeed = 0;
+    else if (joySpeed > 1.0) joySpeed = 1.0;
+  }
+
+  // under sim time the odometry drives the controller, see odomHandler()
+  get_parameter("use_sim_time", useSimTime);
+  if (!useSimTime) {
+    followerTimer = create_wall_timer(std::chrono::milliseconds(10),
+                                      std::bind(&PathFollowerNode::followerCycle, this, 1.0 / 100.0));
+  }
+}
+
+void PathFollowerNode::odomHandler(nav_msgs::msg::Odometry::UniquePtr odomIn)
+{
+  odomTime = rclcpp::Time(odomIn->header.stamp).seconds();
+  double roll, pitch, yaw;
+  geometry_msgs::msg::Quaternion geoQuat = odomIn->pose.pose.orientation;
+  tf2::Matrix3x3(tf2::Quaternion(geoQuat.x, geoQuat.y, geoQuat.z, geoQuat.w)).getRPY(roll, pitch, yaw);
+
+  vehicleRoll = roll;
+  vehiclePitch = pitch;
+  vehicleYaw = yaw;
+  vehicleX = odomIn->pose.pose.position.x - cos(yaw) * sensorOffsetX + sin(yaw) * sensorOffsetY;
+  vehicleY = odomIn->pose.pose.position.y - sin(yaw) * sensorOffsetX - cos(yaw) * sensorOffsetY;
+  vehicleZ = odomIn->pose.pose.position.z;
+
+  if ((fabs(roll) > inclThre * PI / 180.0 || fabs(pitch) > inclThre * PI / 180.0) && useInclToStop) {
+    stopInitTime = rclcpp::Time(odomIn->header.stamp).seconds();
+  }
+
+  if ((fabs(odomIn->twist.twist.angular.x) > inclRateThre * PI / 180.0 ||
+       fabs(odomIn->twist.twist.angular.y) > inclRateThre * PI / 180.0) && useInclRateToSlow) {
+    slowInitTime = rclcpp::Time(odomIn->header.stamp).seconds();
+  }
+
+  odomHistoryInd = (odomHistoryInd + 1) % odomHistoryNum;
+  odomHistoryTime[odomHistoryInd] = odomTime;
+  odomHistoryX[odomHistoryInd] = vehicleX;
+  odomHistoryY[odomHistoryInd] = vehicleY;
+  odomHistoryZ[odomHistoryInd] = vehicleZ;
+  odomHistoryRoll[odomHistoryInd] = vehicleRoll;
+  odomHistoryPitch[odomHistoryInd] = vehiclePitch;
+  odomHistoryYaw[odomHistoryInd] = vehicleYaw;
+  if (odomHistorySize < odomHistoryNum) odomHistorySize++;
+
+  // one cycle per odometry over the interval since the previous one, answered with a command stamped
+  // at the odometry, which is what the lockstep simulator waits for before its next step
+  if (useSimTime) {
+    double cycleTime = odomTime - odomTimeRec;
+    if (odomTimeRec < 0 || cycleTime <= 0) cycleTime = 1.0 / 100.0;
+    odomTimeRec = odomTime;
+    pubSkipCount = 0;
+    followerCycle(cycleTime);
+  }
+}
+
+// vehicle pose at the given time interpolated from the odometry history, times beyond either end
+// of the history take the pose at that end
+void PathFollowerNode::odomHistoryPose(double time, float& x, float& y, float& z, float& roll, float& pitch,
+                                       float& yaw) const
+{
+  x = vehicleX;
+  y = vehicleY;
+  z = vehicleZ;
+  roll = vehicleRoll;
+  pitch = vehiclePitch;
+  yaw = vehicleYaw;
+  if (odomHistorySize == 0 || time >= odomHistoryTime[odomHistoryInd]) return;
+
+  // walk back from the newest entry to the pair bracketing the time
+  int laterInd = odomHistoryInd;
+  int earlierInd = laterInd;
+  for (int i = 1; i < odomHistorySize; i++) {
+    earlierInd = (odomHistoryInd - i + odomHistoryNum) % odomHistoryNum;
+    if (odomHistoryTime[earlierInd] <= time) break;
+    laterInd = earlierInd;
+  }
+
+  float ratio = 0;
+  if (odomHistoryTime[earlierInd] < time && odomHistoryTime[laterInd] > odomHistoryTime[earlierInd]) {
+    ratio = (time - odomHistoryTime[earlierInd]) / (odomHistoryTime[laterInd] - odomHistoryTime[earlierInd]);
+  } else if (odomHistoryTime[earlierInd] > time) {
+    laterInd = earlierInd;
+  }
+
+  x = odomHistoryX[earlierInd] + ratio * (odomHistoryX[laterInd] - odomHistoryX[earlierInd]);
+  y = odomHistoryY[earlierInd] + ratio * (odomHistoryY[laterInd] - odomHistoryY[earlierInd]);
+  z = odomHistoryZ[earlierInd] + ratio * (odomHistoryZ[laterInd] - odomHistoryZ[earlierInd]);
+
+  float angDiff[3];
+  angDiff[0] = odomHistoryRoll[laterInd] - odomHistoryRoll[earlierInd];
+  angDiff[1] = odomHistoryPitch[laterInd] - odomHistoryPitch[earlierInd];
+  angDiff[2] = odomHistoryYaw[laterInd] - odomHistoryYaw[earlierInd];
+  for (int i = 0; i < 3; i++) {
+    if (angDiff[i] > PI) angDiff[i] -= 2 * PI;
+    else if (angDiff[i] < -PI) angDiff[i] += 2 * PI;
+  }
+
+  roll = odomHistoryRoll[earlierInd] + ratio * angDiff[0];
+  pitch = odomHistoryPitch[earlierInd] + ratio * angDiff[1];
+  yaw = odomHistoryYaw[earlierInd] + ratio * angDiff[2];
+  if (yaw > PI) yaw -= 2 * PI;
+  else if (yaw < -PI) yaw += 2 * PI;
+}
+
+void PathFollowerNode::pathHandler(nav_msgs::msg::Path::UniquePtr pathIn)
+{
+  int pathSize = pathIn->poses.size();
+  path.x.resize(pathSize);
+  path.y.resize(pathSize);
+  for (int i = 0; i < pathSize; i++) {
+    path.x[i] = pathIn->poses[i].pose.position.x;
+    path.y[i] = pathIn->poses[i].pose.position.y;
+  }
+
+  // the planner stamps the path with the odometry it planned from, anchor the path at that pose
+  // instead of the one at arrival
+  if (useLatencyComp) {
+    odomHistoryPose(rclcpp::Time(pathIn->header.stamp).seconds(), vehicleXRec, vehicleYRec, vehicleZRec,
+                    vehicleRollRec, vehiclePitchRec, vehicleYawRec);
+  } else {
+    vehicleXRec = vehicleX;
+    vehicleYRec = vehicleY;
+    vehicleZRec = vehicleZ;
+    vehicleRollRec = vehicleRoll;
+    vehiclePitchRec = vehiclePitch;
+    vehicleYawRec = vehicleYaw;
+  }
+
+  path.vehicleXRec = vehicleXRec;
+  path.vehicleYRec = vehicleYRec;
+  path.vehicleYawRec = vehicleYawRec;
+
+  controller.resetPath();
+  pathInit = true;
+}
+
+void PathFollowerNode::joystickHandler(sensor_msgs::msg::Joy::UniquePtr joy)
+{
+  joyTime = now().seconds();
+  joySpeedRaw = sqrt(joy->axes[3] * joy->axes[3] + joy->axes[4] * joy->axes[4]);
+  joySpeed = joySpeedRaw;
+  if (joySpeed > 1.0) joySpeed = 1.0;
+  if (joy->axes[4] == 0) joySpeed = 0;
+  joyYaw = joy->axes[3];
+  if (joySpeed == 0 && noRotAtStop) joyYaw = 0;
+
+  if (joy->axes[4] < 0 && !twoWayDrive) {
+    joySpeed = 0;
+    joyYaw = 0;
+  }
+
+  joyManualFwd = joy->axes[4];
+  joyManualLeft = joy->axes[3];
+  joyManualYaw = joy->axes[0];
+
+  if (joy->axes[2] > -0.1) {
+    autonomyMode = false;
+  } else {
+    autonomyMode = true;
+  }
+
+  if (joy->axes[5] > -0.1) {
+    manualMode = false;
+  } else {
+    manualMode = true;
+  }
+}
+
+void PathFollowerNode::speedHandler(std_msgs::msg::Float32::UniquePtr speed)
+{
+  double speedTime = now().seconds();
+  if (autonomyMode && speedTime - joyTime > joyToSpeedDelay && joySpeedRaw == 0) {
+    joySpeed = speed->data / maxSpeed;
+
+    if (joySpeed < 0) joySpeed = 0;
+    else if (joySpeed > 1.0) joySpeed = 1.0;
+  }
+}
+
+void PathFollowerNode::stopHandler(std_msgs::msg::Int8::UniquePtr stop)
+{
+  safetyStop = stop->data;
+}
+
+void PathFollowerNode::followerCycle(double cycleTime)
+{
+  if (!pathInit) {
+    return;
+  }
+
+  PathFollowerState state;
+  state.vehicleX = vehicleX;
+  state.vehicleY = vehicleY;
+  state.vehicleYaw = vehicleYaw;
+  state.time = now().seconds();
+  state.odomTime = odomTime;
+  state.slowInitTime = slowInitTime;
+  state.stopInitTime = stopInitTime;
+  state.joySpeed = joySpeed;
+  state.joyYaw = joyYaw;
+  state.autonomyMode = autonomyMode;
+  state.safetyStop = safetyStop;
+
+  PathFollowerCmd cmd = controller.step(state, path, cycleTime);
+
+  pubSkipCount--;
+  if (pubSkipCount < 0) {
+    auto cmd_vel = std::make_unique<geometry_msgs::msg::TwistStamped>();
+    cmd_vel->header.stamp = rclcpp::Time(static_cast<uint64_t>(odomTime * 1e9));
+    cmd_vel->header.frame_id = "vehicle";
+    cmd_vel->twist.linear.x = cmd.speedX;
+    cmd_vel->twist.linear.y = cmd.speedY;
+    cmd_vel->twist.angular.z = cmd.yawRate;
+
+    if (manualMode) {
+      cmd_vel->twist.linear.x = maxSpeed * joyManualFwd;
+      cmd_vel->twist.linear.y = maxSpeed / 2.0 * joyManualLeft;
+      cmd_vel->twist.angular.z = maxYawRate * PI / 180.0 * joyManualYaw;
+    }
+
+    if (is_real_robot) {
+      if (cmd_vel->twist.linear.x == 0 && cmd_vel->twist.linear.y == 0 && cmd_vel->twist.angular.z == 0) {
+        sport_req.StopMove(req);
+      } else {
+        sport_req.Move(req, cmd_vel->twist.linear.x, cmd_vel->twist.linear.y, cmd_vel->twist.angular.z);
+      }
+      pubGo2Request->publish(req);
+    }
+
+    pubSpeed->publish(std::move(cmd_vel));
+
+    pubSkipCount = pubSkipNum;
+  }
+}
+
+}
+
+RCLCPP_COMPONENTS_REGISTER_NODE(local_planner::PathFollowerNode)
@@ -0,0 +1,382 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+
+#include "local_planner/pathLibrary.h"
+
+using namespace std;
+
+// full precision pi to match the MATLAB output
+const double PI = 3.14159265358979323846;
+
+// generates startPaths.ply, paths.ply, pathList.ply and correspondences.txt the same way as
+// path_generator.m, optionally followed by the binary library read by localPlanner
+double dis = 1.0;
+double angle = 27;
+int angleStepNum = 3;
+double scale = 0.65;
+double sampleStep = 0.01;
+
+double voxelSize = 0.02;
+double searchRadius = 0.55;
+double offsetX = 3.2;
+double offsetY = 4.5;
+int voxelNumX = 161;
+int voxelNumY = 451;
+
+struct PathPoint
+{
+  double x;
+  double y;
+  int pathID;
+  int groupID;
+};
+
+vector<PathPoint> startPathsAll;
+vector<PathPoint> pathsAll;
+vector<PathPoint> pathListAll;
+
+void printUsage()
+{
+  printf("Usage: pathGenerator <outputFolder> [options]\n");
+  printf("Options (defaults match path_generator.m and localPlanner):\n");
+  printf("  --dis D                length of each path segment in m (1.0)\n");
+  printf("  --angle A              max shift of the first segment in deg (27)\n");
+  printf("  --angleStepNum N       shifts per side of each segment (3), gives (2N+1) groups and (2N+1)^3 paths\n");
+  printf("  --scale S              shift scale of the following segments (0.65)\n");
+  printf("  --voxelSize S          voxel size in m (0.02)\n");
+  printf("  --searchRadius R       collision radius in m (0.55)\n");
+  printf("  --offsetX X            grid offset along X in m (3.2)\n");
+  printf("  --offsetY Y            grid offset along Y in m (4.5)\n");
+  printf("  --voxelNumX N          voxels along X (161)\n");
+  printf("  --voxelNumY N          voxels along Y (451)\n");
+  printf("  --binary               also write <outputFolder>/pathLibrary.bin\n");
+  printf("localPlanner has pathNum, groupNum and the voxel numbers compiled in, change them together.\n");
+}
+
+// values of the MATLAB colon expression first : step : last
+vector<double> colon(double first, double step, double last)
+{
+  vector<double> values;
+  int num = int(floor((last - first) / step + 1e-10)) + 1;
+  for (int i = 0; i < num; i++) {
+    values.push_back(first + i * step);
+  }
+  return values;
+}
+
+// cubic spline with not-a-knot end conditions evaluated at xq, same as MATLAB spline(),
+// which falls back to linear interpolation for two data points
+vector<double> spline(const vector<double>& x, const vector<double>& y, const vector<double>& xq)
+{
+  int n = x.size();
+  vector<double> slopes(n);
+  vector<double> dx(n - 1), divdif(n - 1);
+  for (int i = 0; i < n - 1; i++) {
+    dx[i] = x[i + 1] - x[i];
+    divdif[i] = (y[i + 1] - y[i]) / dx[i];
+  }
+
+  if (n == 2) {
+    slopes[0] = slopes[1] = divdif[0];
+  } else if (n == 3) {
+    // single parabola through all three points
+    double c2 = (divdif[1] - divdif[0]) / (x[2] - x[0]);
+    slopes[0] = divdif[0] - c2 * dx[0];
+    slopes[1] = divdif[0] + c2 * dx[0];
+    slopes[2] = divdif[1] + c2 * dx[1];
+  } else {
+    // tridiagonal system for the slopes, first and last rows from the not-a-knot condition
+    vector<double> sub(n, 0), diag(n, 0), sup(n, 0), rhs(n, 0);
+    double x31 = x[2] - x[0];
+    double xn = x[n - 1] - x[n - 3];
+    diag[0] = dx[1];
+    sup[0] = x31;
+    rhs[0] = ((dx[0] + 2 * x31) * dx[1] * divdif[0] + dx[0] * dx[0] * divdif[1]) / x31;
+    for (int i = 1; i < n - 1; i++) {
+      sub[i] = dx[i];
+      diag[i] = 2 * (dx[i] + dx[i - 1]);
+      sup[i] = dx[i - 1];
+      rhs[i] = 3 * (dx[i] * divdif[i - 1] + dx[i - 1] * divdif[i]);
+    }
+    sub[n - 1] = xn;
+    diag[n - 1] = dx[n - 3];
+    rhs[n - 1] = (dx[n - 2] * dx[n - 2] * divdif[n - 3] + (2 * xn + dx[n - 2]) * dx[n - 3] * divdif[n - 2]) / xn;
+
+    for (int i = 1; i < n; i++) {
+      double w = sub[i] / diag[i - 1];
+      diag[i] -= w * sup[i - 1];
+      rhs[i] -= w * rhs[i - 1];
+    }
+    slopes[n - 1] = rhs[n - 1] / diag[n - 1];
+    for (int i = n - 2; i >= 0; i--) {
+      slopes[i] = (rhs[i] - sup[i] * slopes[i + 1]) / diag[i];
+    }
+  }
+
+  vector<double> yq(xq.size());
+  int seg = 0;
+  for (int i = 0; i < int(xq.size()); i++) {
+    while (seg < n - 2 && xq[i] >= x[seg + 1]) seg++;
+    while (seg > 0 && xq[i] < x[seg]) seg--;
+
+    double h = dx[seg];
+    double t = xq[i] - x[seg];
+    double c3 = (slopes[seg] + slopes[seg + 1] - 2 * divdif[seg]) / (h * h);
+    double c2 = (3 * divdif[seg] - 2 * slopes[seg] - slopes[seg + 1]) / h;
+    yq[i] = ((c3 * t + c2) * t + slopes[seg]) * t + y[seg];
+  }
+
+  return yq;
+}
+
+void generatePaths()
+{
+  double deltaAngle = angle / angleStepNum;
+  vector<double> pathStartR = colon(0, sampleStep, dis);
+  int pathID = 0, groupID = 0;
+
+  vector<double> shift1List = colon(-angle, deltaAngle, angle);
+  for (int i1 = 0; i1 < int(shift1List.size()); i1++) {
+    double shift1 = shift1List[i1];
+    vector<double> wayptsStartX = {0, dis};
+    vector<double> wayptsStartY = {0, shift1};
+    vector<double> pathStartShift = spline(wayptsStartX, wayptsStartY, pathStartR);
+
+    PathPoint point;
+    for (int i = 0; i < int(pathStartR.size()); i++) {
+      point.x = pathStartR[i] * cos(pathStartShift[i] * PI / 180);
+      point.y = pathStartR[i] * sin(pathStartShift[i] * PI / 180);
+      point.pathID = -1;
+      point.groupID = groupID;
+      startPathsAll.push_back(point);
+    }
+
+    vector<double> shift2List = colon(-angle * scale + shift1, deltaAngle * scale, angle * scale + shift1);
+    for (int i2 = 0; i2 < int(shift2List.size()); i2++) {
+      double shift2 = shift2List[i2];
+      vector<double> shift3List = colon(-angle * scale * scale + shift2, deltaAngle * scale * scale,
+                                        angle * scale * scale + shift2);
+      for (int i3 = 0; i3 < int(shift3List.size()); i3++) {
+        double shift3 = shift3List[i3];
+        vector<double> wayptsX = pathStartR, wayptsY = pathStartShift;
+        wayptsX.push_back(2 * dis);
+        wayptsY.push_back(shift2);
+        wayptsX.push_back(3 * dis - 0.001);
+        wayptsY.push_back(shift3);
+        wayptsX.push_back(3 * dis);
+        wayptsY.push_back(shift3);
+
+        vector<double> pathR = colon(0, sampleStep, 3 * dis);
+        vector<double> pathShift = spline(wayptsX, wayptsY, pathR);
+
+        for (int i = 0; i < int(pathR.size()); i++) {
+          point.x = pathR[i] * cos(pathShift[i] * PI / 180);
+          point.y = pathR[i] * sin(pathShift[i] * PI / 180);
+          point.pathID = pathID;
+          point.groupID = groupID;
+          pathsAll.push_back(point);
+        }
+        pathListAll.push_back(point);
+
+        pathID++;
+      }
+    }
+
+    groupID++;
+  }
+}
+
+bool writePly(const string& fileName, const vector<PathPoint>& points, bool withPathID, const char *prefix)
+{
+  FILE *filePtr = fopen(fileName.c_str(), "w");
+  if (filePtr == NULL) {
+    return false;
+  }
+
+  fprintf(filePtr, "ply\n");
+  fprintf(filePtr, "format ascii 1.0\n");
+  fprintf(filePtr, "element vertex %d\n", int(points.size()));
+  fprintf(filePtr, "property float %sx\n", prefix);
+  fprintf(filePtr, "property float %sy\n", prefix);
+  fprintf(filePtr, "property float %sz\n", prefix);
+  if (withPathID) fprintf(filePtr, "property int path_id\n");
+  fprintf(filePtr, "property int group_id\n");
+  fprintf(filePtr, "end_header\n");
+
+  int pointNum = points.size();
+  for (int i = 0; i < pointNum; i++) {
+    if (withPathID) {
+      fprintf(filePtr, "%f %f %f %d %d\n", points[i].x, points[i].y, 0.0, points[i].pathID, points[i].groupID);
+    } else {
+      fprintf(filePtr, "%f %f %f %d\n", points[i].x, points[i].y, 0.0, points[i].groupID);
+    }
+  }
+
+  fclose(filePtr);
+  return true;
+}
+
+// a voxel is blocked by every path with a point within searchRadius, path points are bucketed
+// into searchRadius sized cells so only the 3 x 3 cells around each voxel are searched
+bool writeCorrespondences(const string& fileName)
+{
+  FILE *filePtr = fopen(fileName.c_str(), "w");
+  if (filePtr == NULL) {
+    return false;
+  }
+
+  unordered_map<long long, vector<int> > cells;
+  int pathPointNum = pathsAll.size();
+  for (int i = 0; i < pathPointNum; i++) {
+    long long cellX = (long long)floor(pathsAll[i].x / searchRadius);
+    long long cellY = (long long)floor(pathsAll[i].y / searchRadius);
+    cells[(cellX << 32) ^ (cellY & 0xffffffff)].push_back(i);
+  }
+
+  vector<int> indVoxel;
+  int indPoint = 0;
+  for (int indX = 0; indX < voxelNumX; indX++) {
+    double x = offsetX - voxelSize * indX;
+    double scaleY = x / offsetX + searchRadius / offsetY * (offsetX - x) / offsetX;
+    for (int indY = 0; indY < voxelNumY; indY++) {
+      double y = scaleY * (offsetY - voxelSize * indY);
+
+      indVoxel.clear();
+      long long cellX = (long long)floor(x / searchRadius);
+      long long cellY = (long long)floor(y / searchRadius);
+      for (long long i = cellX - 1; i <= cellX + 1; i++) {
+        for (long long j = cellY - 1; j <= cellY + 1; j++) {
+          unordered_map<long long, vector<int> >::const_iterator cell = cells.find((i << 32) ^ (j & 0xffffffff));
+          if (cell == cells.end()) continue;
+
+          int cellPointNum = cell->second.size();
+          for (int k = 0; k < cellPointNum; k++) {
+            const PathPoint& point = pathsAll[cell->second[k]];
+            double disX = point.x - x;
+            double disY = point.y - y;
+            if (disX * disX + disY * disY <= searchRadius * searchRadius) {
+              indVoxel.push_back(point.pathID);
+            }
+          }
+        }
+      }
+
+      // path points are stored in path order, so sorting groups the path IDs
+      sort(indVoxel.begin(), indVoxel.end());
+
+      fprintf(filePtr, "%d ", indPoint);
+      int pathIndRec = -1;
+      int indVoxelNum = indVoxel.size();
+      for (int j = 0; j < indVoxelNum; j++) {
+        if (indVoxel[j] == pathIndRec) continue;
+
+        fprintf(filePtr, "%d ", indVoxel[j]);
+        pathIndRec = indVoxel[j];
+      }
+      fprintf(filePtr, "-1\n");
+
+      indPoint++;
+    }
+  }
+
+  fclose(filePtr);
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+  string outputFolder;
+  bool writeBinary = false;
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "--binary") {
+      writeBinary = true;
+    } else if (arg.compare(0, 2, "--") == 0) {
+      if (i + 1 >= argc) {
+        printUsage();
+        return 1;
+      }
+
+      const char *val = argv[++i];
+      if (arg == "--dis") dis = atof(val);
+      else if (arg == "--angle") angle = atof(val);
+      else if (arg == "--angleStepNum") angleStepNum = atoi(val);
+      else if (arg == "--scale") scale = atof(val);
+      else if (arg == "--voxelSize") voxelSize = atof(val);
+      else if (arg == "--searchRadius") searchRadius = atof(val);
+      else if (arg == "--offsetX") offsetX = atof(val);
+      else if (arg == "--offsetY") offsetY = atof(val);
+      else if (arg == "--voxelNumX") voxelNumX = atoi(val);
+      else if (arg == "--voxelNumY") voxelNumY = atoi(val);
+      else {
+        printUsage();
+        return 1;
+      }
+    } else if (outputFolder.empty()) {
+      outputFolder = arg;
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  if (outputFolder.empty() || dis <= 0 || angle <= 0 || angleStepNum <= 0 || searchRadius <= 0 ||
+      voxelSize <= 0 || voxelNumX <= 0 || voxelNumY <= 0) {
+    printUsage();
+    return 1;
+  }
+
+  printf("Generating paths\n");
+  generatePaths();
+
+  if (!writePly(outputFolder + "/startPaths.ply", startPathsAll, false, "") ||
+      !writePly(outputFolder + "/paths.ply", pathsAll, true, "") ||
+      !writePly(outputFolder + "/pathList.ply", pathListAll, true, "end_")) {
+    fprintf(stderr, "Cannot write path files to %s, exit.\n", outputFolder.c_str());
+    return 1;
+  }
+
+  printf("Collision checking\n");
+  if (!writeCorrespondences(outputFolder + "/correspondences.txt")) {
+    fprintf(stderr, "Cannot write %s/correspondences.txt, exit.\n", outputFolder.c_str());
+    return 1;
+  }
+
+  int groupNum = startPathsAll.empty() ? 0 : startPathsAll.back().groupID + 1;
+  int pathNum = pathListAll.size();
+  printf("Wrote %d groups, %d paths, %d voxels to %s.\n", groupNum, pathNum, voxelNumX * voxelNumY, outputFolder.c_str());
+
+  if (writeBinary) {
+    PathLibraryGrid grid;
+    grid.pathNum = pathNum;
+    grid.groupNum = groupNum;
+    grid.gridVoxelNumX = voxelNumX;
+    grid.gridVoxelNumY = voxelNumY;
+    grid.gridVoxelSize = voxelSize;
+    grid.searchRadius = searchRadius;
+    grid.gridVoxelOffsetX = offsetX;
+    grid.gridVoxelOffsetY = offsetY;
+
+    PathLibrary pathLibrary;
+    string fileName = outputFolder + "/pathLibrary.bin";
+    if (!pathLibrary.readText(outputFolder, grid)) {
+      fprintf(stderr, "%s, exit.\n", pathLibrary.error().c_str());
+      return 1;
+    }
+    if (!pathLibrary.writeBinary(fileName)) {
+      fprintf(stderr, "Cannot write %s, exit.\n", fileName.c_str());
+      return 1;
+    }
+    printf("Wrote %s.\n", fileName.c_str());
+  }
+
+  printf("Processing complete\n");
+
+  return 0;
+}
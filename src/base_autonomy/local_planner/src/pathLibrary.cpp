@@ -0,0 +1,444 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "local_planner/pathLibrary.h"
+
+using namespace std;
+
+PathLibrary::PathLibrary()
+  : mapAddr(NULL), mapSize(0)
+{
+  reset();
+}
+
+PathLibrary::~PathLibrary()
+{
+  reset();
+}
+
+void PathLibrary::reset()
+{
+  if (mapAddr != NULL) {
+    munmap(mapAddr, mapSize);
+    mapAddr = NULL;
+    mapSize = 0;
+  }
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, pathLibraryMagic, sizeof(header.magic));
+  header.version = pathLibraryVersion;
+
+  startPathsData.clear();
+  pathsData.clear();
+  pathListData.clear();
+  correspondenceOffsetsData.clear();
+  correspondencePathsData.clear();
+
+  startPathsPtr = NULL;
+  pathsPtr = NULL;
+  pathListPtr = NULL;
+  correspondenceOffsetsPtr = NULL;
+  correspondencePathsPtr = NULL;
+}
+
+void PathLibrary::setPointers()
+{
+  startPathsPtr = startPathsData.data();
+  pathsPtr = pathsData.data();
+  pathListPtr = pathListData.data();
+  correspondenceOffsetsPtr = correspondenceOffsetsData.data();
+  correspondencePathsPtr = correspondencePathsData.data();
+}
+
+bool PathLibrary::matches(const PathLibraryGrid& grid) const
+{
+  return header.pathNum == grid.pathNum && header.groupNum == grid.groupNum &&
+         header.gridVoxelNumX == grid.gridVoxelNumX && header.gridVoxelNumY == grid.gridVoxelNumY &&
+         fabs(header.gridVoxelSize - grid.gridVoxelSize) < 1e-6 && fabs(header.searchRadius - grid.searchRadius) < 1e-6 &&
+         fabs(header.gridVoxelOffsetX - grid.gridVoxelOffsetX) < 1e-6 &&
+         fabs(header.gridVoxelOffsetY - grid.gridVoxelOffsetY) < 1e-6;
+}
+
+bool PathLibrary::readPlyHeader(FILE *filePtr, int& pointNum)
+{
+  char str[50];
+  int val;
+  string strCur, strLast;
+  pointNum = -1;
+  while (strCur != "end_header") {
+    val = fscanf(filePtr, "%49s", str);
+    if (val != 1) {
+      return false;
+    }
+
+    strLast = strCur;
+    strCur = string(str);
+
+    if (strCur == "vertex" && strLast == "element") {
+      val = fscanf(filePtr, "%d", &pointNum);
+      if (val != 1) {
+        return false;
+      }
+    }
+  }
+
+  return pointNum >= 0;
+}
+
+bool PathLibrary::readStartPaths(const string& pathFolder)
+{
+  string fileName = pathFolder + "/startPaths.ply";
+
+  FILE *filePtr = fopen(fileName.c_str(), "r");
+  if (filePtr == NULL) {
+    errorMsg = "Cannot read " + fileName;
+    return false;
+  }
+
+  int pointNum;
+  if (!readPlyHeader(filePtr, pointNum)) {
+    errorMsg = "Error reading " + fileName;
+    fclose(filePtr);
+    return false;
+  }
+
+  PathLibraryPoint point;
+  point.pathID = -1;
+  int val1, val2, val3, val4, groupID;
+  startPathsData.reserve(pointNum);
+  for (int i = 0; i < pointNum; i++) {
+    val1 = fscanf(filePtr, "%f", &point.x);
+    val2 = fscanf(filePtr, "%f", &point.y);
+    val3 = fscanf(filePtr, "%f", &point.z);
+    val4 = fscanf(filePtr, "%d", &groupID);
+
+    if (val1 != 1 || val2 != 1 || val3 != 1 || val4 != 1) {
+      errorMsg = "Error reading " + fileName;
+      fclose(filePtr);
+      return false;
+    }
+
+    if (groupID >= 0 && groupID < header.groupNum) {
+      point.groupID = groupID;
+      startPathsData.push_back(point);
+    }
+  }
+
+  fclose(filePtr);
+  return true;
+}
+
+bool PathLibrary::readPaths(const string& pathFolder)
+{
+  string fileName = pathFolder + "/paths.ply";
+
+  FILE *filePtr = fopen(fileName.c_str(), "r");
+  if (filePtr == NULL) {
+    errorMsg = "Cannot read " + fileName;
+    return false;
+  }
+
+  int pointNum;
+  if (!readPlyHeader(filePtr, pointNum)) {
+    errorMsg = "Error reading " + fileName;
+    fclose(filePtr);
+    return false;
+  }
+
+  PathLibraryPoint point;
+  int val1, val2, val3, val4, val5, pathID, groupID;
+  pathsData.reserve(pointNum);
+  for (int i = 0; i < pointNum; i++) {
+    val1 = fscanf(filePtr, "%f", &point.x);
+    val2 = fscanf(filePtr, "%f", &point.y);
+    val3 = fscanf(filePtr, "%f", &point.z);
+    val4 = fscanf(filePtr, "%d", &pathID);
+    val5 = fscanf(filePtr, "%d", &groupID);
+
+    if (val1 != 1 || val2 != 1 || val3 != 1 || val4 != 1 || val5 != 1) {
+      errorMsg = "Error reading " + fileName;
+      fclose(filePtr);
+      return false;
+    }
+
+    if (pathID >= 0 && pathID < header.pathNum) {
+      point.pathID = pathID;
+      point.groupID = groupID;
+      pathsData.push_back(point);
+    }
+  }
+
+  fclose(filePtr);
+  return true;
+}
+
+bool PathLibrary::readPathList(const string& pathFolder)
+{
+  string fileName = pathFolder + "/pathList.ply";
+
+  FILE *filePtr = fopen(fileName.c_str(), "r");
+  if (filePtr == NULL) {
+    errorMsg = "Cannot read " + fileName;
+    return false;
+  }
+
+  int pointNum;
+  if (!readPlyHeader(filePtr, pointNum)) {
+    errorMsg = "Error reading " + fileName;
+    fclose(filePtr);
+    return false;
+  }
+
+  if (pointNum != header.pathNum) {
+    errorMsg = "Incorrect path number in " + fileName;
+    fclose(filePtr);
+    return false;
+  }
+
+  PathLibraryPoint point;
+  int val1, val2, val3, val4, val5;
+  pathListData.reserve(pointNum);
+  for (int i = 0; i < pointNum; i++) {
+    val1 = fscanf(filePtr, "%f", &point.x);
+    val2 = fscanf(filePtr, "%f", &point.y);
+    val3 = fscanf(filePtr, "%f", &point.z);
+    val4 = fscanf(filePtr, "%d", &point.pathID);
+    val5 = fscanf(filePtr, "%d", &point.groupID);
+
+    if (val1 != 1 || val2 != 1 || val3 != 1 || val4 != 1 || val5 != 1) {
+      errorMsg = "Error reading " + fileName;
+      fclose(filePtr);
+      return false;
+    }
+
+    if (point.pathID >= 0 && point.pathID < header.pathNum && point.groupID >= 0 && point.groupID < header.groupNum) {
+      pathListData.push_back(point);
+    }
+  }
+
+  fclose(filePtr);
+  return true;
+}
+
+bool PathLibrary::readCorrespondences(const string& pathFolder)
+{
+  string fileName = pathFolder + "/correspondences.txt";
+
+  FILE *filePtr = fopen(fileName.c_str(), "r");
+  if (filePtr == NULL) {
+    errorMsg = "Cannot read " + fileName;
+    return false;
+  }
+
+  // the file lists voxels in order, so the CSR table is filled in a single pass
+  int gridVoxelNum = header.gridVoxelNumX * header.gridVoxelNumY;
+  correspondenceOffsetsData.assign(gridVoxelNum + 1, 0);
+  correspondencePathsData.clear();
+
+  int val1, gridVoxelID, pathID;
+  for (int i = 0; i < gridVoxelNum; i++) {
+    val1 = fscanf(filePtr, "%d", &gridVoxelID);
+    if (val1 != 1 || gridVoxelID != i) {
+      errorMsg = "Error reading " + fileName;
+      fclose(filePtr);
+      return false;
+    }
+
+    correspondenceOffsetsData[i] = correspondencePathsData.size();
+    while (1) {
+      val1 = fscanf(filePtr, "%d", &pathID);
+      if (val1 != 1) {
+        errorMsg = "Error reading " + fileName;
+        fclose(filePtr);
+        return false;
+      }
+
+      if (pathID != -1) {
+        if (pathID >= 0 && pathID < header.pathNum) {
+          correspondencePathsData.push_back(pathID);
+        }
+      } else {
+        break;
+      }
+    }
+  }
+  correspondenceOffsetsData[gridVoxelNum] = correspondencePathsData.size();
+
+  fclose(filePtr);
+  return true;
+}
+
+bool PathLibrary::readText(const string& pathFolder, const PathLibraryGrid& grid)
+{
+  reset();
+
+  header.pathNum = grid.pathNum;
+  header.groupNum = grid.groupNum;
+  header.gridVoxelNumX = grid.gridVoxelNumX;
+  header.gridVoxelNumY = grid.gridVoxelNumY;
+  header.gridVoxelSize = grid.gridVoxelSize;
+  header.searchRadius = grid.searchRadius;
+  header.gridVoxelOffsetX = grid.gridVoxelOffsetX;
+  header.gridVoxelOffsetY = grid.gridVoxelOffsetY;
+
+  if (!readStartPaths(pathFolder) || !readPaths(pathFolder) || !readPathList(pathFolder) ||
+      !readCorrespondences(pathFolder)) {
+    return false;
+  }
+
+  header.startPathPointNum = startPathsData.size();
+  header.pathPointNum = pathsData.size();
+  header.correspondenceNum = correspondencePathsData.size();
+  if (int(pathListData.size()) != header.pathNum) {
+    errorMsg = "Incorrect path number in " + pathFolder + "/pathList.ply";
+    return false;
+  }
+
+  setPointers();
+  return true;
+}
+
+bool PathLibrary::readBinary(const string& fileName)
+{
+  reset();
+
+  int fd = open(fileName.c_str(), O_RDONLY);
+  if (fd < 0) {
+    errorMsg = "Cannot read " + fileName;
+    return false;
+  }
+
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) != 0 || size_t(fileStat.st_size) < sizeof(PathLibraryHeader)) {
+    errorMsg = "Error reading " + fileName;
+    close(fd);
+    return false;
+  }
+
+  mapSize = fileStat.st_size;
+  mapAddr = mmap(NULL, mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapAddr == MAP_FAILED) {
+    mapAddr = NULL;
+    mapSize = 0;
+    errorMsg = "Cannot map " + fileName;
+    return false;
+  }
+
+  const char *data = static_cast<const char*>(mapAddr);
+  memcpy(&header, data, sizeof(header));
+  if (memcmp(header.magic, pathLibraryMagic, sizeof(header.magic)) != 0 || header.version != pathLibraryVersion ||
+      header.pathNum <= 0 || header.groupNum <= 0 || header.gridVoxelNumX <= 0 || header.gridVoxelNumY <= 0 ||
+      header.startPathPointNum < 0 || header.pathPointNum < 0 || header.correspondenceNum < 0) {
+    errorMsg = "Invalid path library header in " + fileName;
+    reset();
+    return false;
+  }
+
+  size_t gridVoxelNum = size_t(header.gridVoxelNumX) * header.gridVoxelNumY;
+  size_t expectedSize = sizeof(PathLibraryHeader)
+                      + sizeof(PathLibraryPoint) * (header.startPathPointNum + header.pathPointNum + header.pathNum)
+                      + sizeof(int32_t) * (gridVoxelNum + 1 + header.correspondenceNum);
+  if (mapSize != expectedSize) {
+    errorMsg = "Truncated or oversized path library " + fileName;
+    reset();
+    return false;
+  }
+
+  const char *sectionPtr = data + sizeof(PathLibraryHeader);
+  startPathsPtr = reinterpret_cast<const PathLibraryPoint*>(sectionPtr);
+  sectionPtr += sizeof(PathLibraryPoint) * header.startPathPointNum;
+  pathsPtr = reinterpret_cast<const PathLibraryPoint*>(sectionPtr);
+  sectionPtr += sizeof(PathLibraryPoint) * header.pathPointNum;
+  pathListPtr = reinterpret_cast<const PathLibraryPoint*>(sectionPtr);
+  sectionPtr += sizeof(PathLibraryPoint) * header.pathNum;
+  correspondenceOffsetsPtr = reinterpret_cast<const int32_t*>(sectionPtr);
+  sectionPtr += sizeof(int32_t) * (gridVoxelNum + 1);
+  correspondencePathsPtr = reinterpret_cast<const int32_t*>(sectionPtr);
+
+  // the evaluation indexes with these without checks, so a corrupted file is rejected here in one
+  // pass over the tables rather than read out of bounds later
+  bool valid = correspondenceOffsetsPtr[0] == 0 && correspondenceOffsetsPtr[gridVoxelNum] == header.correspondenceNum;
+  for (size_t i = 0; i < gridVoxelNum && valid; i++) {
+    valid = correspondenceOffsetsPtr[i] <= correspondenceOffsetsPtr[i + 1];
+  }
+  for (int i = 0; i < header.correspondenceNum && valid; i++) {
+    valid = correspondencePathsPtr[i] >= 0 && correspondencePathsPtr[i] < header.pathNum;
+  }
+  if (!valid) {
+    errorMsg = "Corrupted correspondence table in " + fileName;
+    reset();
+    return false;
+  }
+
+  for (int i = 0; i < header.pathNum && valid; i++) {
+    valid = pathListPtr[i].pathID >= 0 && pathListPtr[i].pathID < header.pathNum &&
+            pathListPtr[i].groupID >= 0 && pathListPtr[i].groupID < header.groupNum;
+  }
+  if (!valid) {
+    errorMsg = "Corrupted path list in " + fileName;
+    reset();
+    return false;
+  }
+
+  return true;
+}
+
+bool PathLibrary::writeBinary(const string& fileName) const
+{
+  FILE *filePtr = fopen(fileName.c_str(), "wb");
+  if (filePtr == NULL) {
+    return false;
+  }
+
+  size_t gridVoxelNum = size_t(header.gridVoxelNumX) * header.gridVoxelNumY;
+  bool status = fwrite(&header, sizeof(header), 1, filePtr) == 1 &&
+                fwrite(startPathsPtr, sizeof(PathLibraryPoint), header.startPathPointNum, filePtr) == size_t(header.startPathPointNum) &&
+                fwrite(pathsPtr, sizeof(PathLibraryPoint), header.pathPointNum, filePtr) == size_t(header.pathPointNum) &&
+                fwrite(pathListPtr, sizeof(PathLibraryPoint), header.pathNum, filePtr) == size_t(header.pathNum) &&
+                fwrite(correspondenceOffsetsPtr, sizeof(int32_t), gridVoxelNum + 1, filePtr) == gridVoxelNum + 1 &&
+                fwrite(correspondencePathsPtr, sizeof(int32_t), header.correspondenceNum, filePtr) == size_t(header.correspondenceNum);
+
+  if (fclose(filePtr) != 0) status = false;
+  return status;
+}
+
+bool PathLibrary::read(const string& pathFolder, const string& fileName, const PathLibraryGrid& grid)
+{
+  string binaryFile = fileName;
+  if (binaryFile == "") binaryFile = pathFolder + "/pathLibrary.bin";
+
+  if (access(binaryFile.c_str(), R_OK) == 0) {
+    if (!readBinary(binaryFile)) {
+      return false;
+    }
+    if (!matches(grid)) {
+      errorMsg = "Incorrect path library grid in " + binaryFile;
+      reset();
+      return false;
+    }
+    return true;
+  }
+
+  if (fileName != "") {
+    errorMsg = "Cannot read " + fileName;
+    return false;
+  }
+
+  return readText(pathFolder, grid);
+}
+
+bool PathLibrary::readPathSet(const string& pathFolder, const PathLibraryGrid& grid)
+{
+  string binaryFile = pathFolder + "/pathLibrary.bin";
+  if (access(binaryFile.c_str(), R_OK) == 0) {
+    return readBinary(binaryFile);
+  }
+
+  return readText(pathFolder, grid);
+}
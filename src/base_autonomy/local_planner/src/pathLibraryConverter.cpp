@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "local_planner/pathLibrary.h"
+
+using namespace std;
+
+// converts the text path set written by path_generator.m into the binary library read by localPlanner
+void printUsage()
+{
+  printf("Usage: pathLibraryConverter <pathFolder> [outputFile] [options]\n");
+  printf("  outputFile defaults to <pathFolder>/pathLibrary.bin\n");
+  printf("Options (defaults match path_generator.m and localPlanner):\n");
+  PathLibraryGrid grid;
+  printf("  --pathNum N            number of paths (%d)\n", grid.pathNum);
+  printf("  --groupNum N           number of path groups (%d)\n", grid.groupNum);
+  printf("  --gridVoxelNumX N      voxels along X (%d)\n", grid.gridVoxelNumX);
+  printf("  --gridVoxelNumY N      voxels along Y (%d)\n", grid.gridVoxelNumY);
+  printf("  --gridVoxelSize S      voxel size in m (%g)\n", grid.gridVoxelSize);
+  printf("  --searchRadius R       collision radius in m (%g)\n", grid.searchRadius);
+  printf("  --gridVoxelOffsetX X   grid offset along X in m (%g)\n", grid.gridVoxelOffsetX);
+  printf("  --gridVoxelOffsetY Y   grid offset along Y in m (%g)\n", grid.gridVoxelOffsetY);
+}
+
+int main(int argc, char** argv)
+{
+  PathLibraryGrid grid;
+
+  string pathFolder, outputFile;
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg.compare(0, 2, "--") == 0) {
+      if (i + 1 >= argc) {
+        printUsage();
+        return 1;
+      }
+
+      const char *val = argv[++i];
+      if (arg == "--pathNum") grid.pathNum = atoi(val);
+      else if (arg == "--groupNum") grid.groupNum = atoi(val);
+      else if (arg == "--gridVoxelNumX") grid.gridVoxelNumX = atoi(val);
+      else if (arg == "--gridVoxelNumY") grid.gridVoxelNumY = atoi(val);
+      else if (arg == "--gridVoxelSize") grid.gridVoxelSize = atof(val);
+      else if (arg == "--searchRadius") grid.searchRadius = atof(val);
+      else if (arg == "--gridVoxelOffsetX") grid.gridVoxelOffsetX = atof(val);
+      else if (arg == "--gridVoxelOffsetY") grid.gridVoxelOffsetY = atof(val);
+      else {
+        printUsage();
+        return 1;
+      }
+    } else if (pathFolder.empty()) {
+      pathFolder = arg;
+    } else if (outputFile.empty()) {
+      outputFile = arg;
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  if (pathFolder.empty()) {
+    printUsage();
+    return 1;
+  }
+  if (outputFile.empty()) outputFile = pathFolder + "/pathLibrary.bin";
+
+  PathLibrary pathLibrary;
+  if (!pathLibrary.readText(pathFolder, grid)) {
+    fprintf(stderr, "%s, exit.\n", pathLibrary.error().c_str());
+    return 1;
+  }
+
+  if (!pathLibrary.writeBinary(outputFile)) {
+    fprintf(stderr, "Cannot write %s, exit.\n", outputFile.c_str());
+    return 1;
+  }
+
+  printf("Wrote %s: %d start path points, %d path points, %d correspondences.\n", outputFile.c_str(),
+         pathLibrary.startPathPointNum(), pathLibrary.pathPointNum(), pathLibrary.correspondenceNum());
+
+  return 0;
+}
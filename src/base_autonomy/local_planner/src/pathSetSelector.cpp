@@ -0,0 +1,71 @@
+#include <math.h>
+
+#include "local_planner/pathSetSelector.h"
+
+using namespace std;
+
+const double PI = 3.1415926;
+
+PathSetSelector::PathSetSelector()
+  : selectedID(0)
+{
+}
+
+void PathSetSelector::setParams(const PathSetSelectorParams& params)
+{
+  selectorParams = params;
+}
+
+void PathSetSelector::addPathSet(double minSpeed, double maxObstacleDensity)
+{
+  minSpeeds.push_back(minSpeed);
+  maxObstacleDensities.push_back(maxObstacleDensity);
+}
+
+float PathSetSelector::obstacleDensity(const pcl::PointCloud<pcl::PointXYZI>& cloud, bool useTerrainAnalysis,
+                                       double obstacleHeightThre) const
+{
+  float densityRange = selectorParams.densityRange;
+  if (densityRange <= 0) return 0;
+
+  int obstaclePointNum = 0;
+  int cloudSize = cloud.points.size();
+  for (int i = 0; i < cloudSize; i++) {
+    const pcl::PointXYZI& point = cloud.points[i];
+    if (point.x * point.x + point.y * point.y < densityRange * densityRange &&
+        (!useTerrainAnalysis || point.intensity > obstacleHeightThre)) {
+      obstaclePointNum++;
+    }
+  }
+
+  return obstaclePointNum / (PI * densityRange * densityRange);
+}
+
+int PathSetSelector::select(float speed, float obstacleDensity)
+{
+  int setNum = minSpeeds.size();
+  if (setNum == 0) return 0;
+  if (selectedID >= setNum) selectedID = setNum - 1;
+
+  // the longest set that passes both checks wins, the margins are added for longer sets than the
+  // current one and taken off for the current one, set 0 is the fallback
+  int newID = 0;
+  for (int i = setNum - 1; i > 0; i--) {
+    double speedMargin = 0, densityRatio = 1.0;
+    if (i > selectedID) {
+      speedMargin = selectorParams.speedHys;
+      densityRatio = 1.0 - selectorParams.densityHys;
+    } else if (i == selectedID) {
+      speedMargin = -selectorParams.speedHys;
+      densityRatio = 1.0 + selectorParams.densityHys;
+    }
+
+    if (speed >= minSpeeds[i] + speedMargin && obstacleDensity <= maxObstacleDensities[i] * densityRatio) {
+      newID = i;
+      break;
+    }
+  }
+
+  selectedID = newID;
+  return selectedID;
+}
@@ -0,0 +1,126 @@
+#include "local_planner/voxelIndices.h"
+
+#ifdef VOXEL_INDICES_X86
+#include <immintrin.h>
+#endif
+
+namespace
+{
+
+int voxelIndex(const VoxelIndexGrid& grid, float x2, float y2)
+{
+  float scaleY = x2 / grid.gridVoxelOffsetX + grid.searchRadius / grid.gridVoxelOffsetY
+                 * (grid.gridVoxelOffsetX - x2) / grid.gridVoxelOffsetX;
+
+  int indX = int((grid.gridVoxelOffsetX + grid.gridVoxelSize / 2 - x2) / grid.gridVoxelSize);
+  int indY = int((grid.gridVoxelOffsetY + grid.gridVoxelSize / 2 - y2 / scaleY) / grid.gridVoxelSize);
+  if (indX >= 0 && indX < grid.gridVoxelNumX && indY >= 0 && indY < grid.gridVoxelNumY) {
+    return grid.gridVoxelNumY * indX + indY;
+  }
+  return -1;
+}
+
+}
+
+void voxelIndicesScalar(const VoxelIndexGrid& grid, float cosRotAng, float sinRotAng, const float *xs,
+                        const float *ys, int pointNum, int *inds)
+{
+  for (int i = 0; i < pointNum; i++) {
+    float x2 = cosRotAng * xs[i] + sinRotAng * ys[i];
+    float y2 = -sinRotAng * xs[i] + cosRotAng * ys[i];
+    inds[i] = voxelIndex(grid, x2, y2);
+  }
+}
+
+#ifdef VOXEL_INDICES_X86
+
+void voxelIndicesSse2(const VoxelIndexGrid& grid, float cosRotAng, float sinRotAng, const float *xs,
+                      const float *ys, int pointNum, int *inds)
+{
+  const __m128 cosV = _mm_set1_ps(cosRotAng);
+  const __m128 sinV = _mm_set1_ps(sinRotAng);
+  const __m128 negSinV = _mm_set1_ps(-sinRotAng);
+  const __m128 offsetXV = _mm_set1_ps(grid.gridVoxelOffsetX);
+  const __m128 radiusRatioV = _mm_set1_ps(grid.searchRadius / grid.gridVoxelOffsetY);
+  const __m128 indOffsetXV = _mm_set1_ps(grid.gridVoxelOffsetX + grid.gridVoxelSize / 2);
+  const __m128 indOffsetYV = _mm_set1_ps(grid.gridVoxelOffsetY + grid.gridVoxelSize / 2);
+  const __m128 voxelSizeV = _mm_set1_ps(grid.gridVoxelSize);
+  int indXs[4], indYs[4];
+  int i = 0;
+  for (; i + 4 <= pointNum; i += 4) {
+    __m128 x = _mm_loadu_ps(xs + i);
+    __m128 y = _mm_loadu_ps(ys + i);
+    __m128 x2 = _mm_add_ps(_mm_mul_ps(cosV, x), _mm_mul_ps(sinV, y));
+    __m128 y2 = _mm_add_ps(_mm_mul_ps(negSinV, x), _mm_mul_ps(cosV, y));
+
+    __m128 scaleY = _mm_add_ps(_mm_div_ps(x2, offsetXV), _mm_div_ps(_mm_mul_ps(radiusRatioV, _mm_sub_ps(offsetXV, x2)), offsetXV));
+    _mm_storeu_si128((__m128i*)indXs, _mm_cvttps_epi32(_mm_div_ps(_mm_sub_ps(indOffsetXV, x2), voxelSizeV)));
+    _mm_storeu_si128((__m128i*)indYs, _mm_cvttps_epi32(_mm_div_ps(_mm_sub_ps(indOffsetYV, _mm_div_ps(y2, scaleY)), voxelSizeV)));
+
+    // SSE2 has no 32-bit multiply, combine the indices per lane
+    for (int k = 0; k < 4; k++) {
+      if (indXs[k] >= 0 && indXs[k] < grid.gridVoxelNumX && indYs[k] >= 0 && indYs[k] < grid.gridVoxelNumY) {
+        inds[i + k] = grid.gridVoxelNumY * indXs[k] + indYs[k];
+      } else {
+        inds[i + k] = -1;
+      }
+    }
+  }
+
+  voxelIndicesScalar(grid, cosRotAng, sinRotAng, xs + i, ys + i, pointNum - i, inds + i);
+}
+
+__attribute__((target("avx2")))
+void voxelIndicesAvx2(const VoxelIndexGrid& grid, float cosRotAng, float sinRotAng, const float *xs,
+                      const float *ys, int pointNum, int *inds)
+{
+  const __m256 cosV = _mm256_set1_ps(cosRotAng);
+  const __m256 sinV = _mm256_set1_ps(sinRotAng);
+  const __m256 negSinV = _mm256_set1_ps(-sinRotAng);
+  const __m256 offsetXV = _mm256_set1_ps(grid.gridVoxelOffsetX);
+  const __m256 radiusRatioV = _mm256_set1_ps(grid.searchRadius / grid.gridVoxelOffsetY);
+  const __m256 indOffsetXV = _mm256_set1_ps(grid.gridVoxelOffsetX + grid.gridVoxelSize / 2);
+  const __m256 indOffsetYV = _mm256_set1_ps(grid.gridVoxelOffsetY + grid.gridVoxelSize / 2);
+  const __m256 voxelSizeV = _mm256_set1_ps(grid.gridVoxelSize);
+  const __m256i voxelNumXV = _mm256_set1_epi32(grid.gridVoxelNumX);
+  const __m256i voxelNumYV = _mm256_set1_epi32(grid.gridVoxelNumY);
+  const __m256i minusOneV = _mm256_set1_epi32(-1);
+  int i = 0;
+  for (; i + 8 <= pointNum; i += 8) {
+    __m256 x = _mm256_loadu_ps(xs + i);
+    __m256 y = _mm256_loadu_ps(ys + i);
+    __m256 x2 = _mm256_add_ps(_mm256_mul_ps(cosV, x), _mm256_mul_ps(sinV, y));
+    __m256 y2 = _mm256_add_ps(_mm256_mul_ps(negSinV, x), _mm256_mul_ps(cosV, y));
+
+    __m256 scaleY = _mm256_add_ps(_mm256_div_ps(x2, offsetXV),
+                    _mm256_div_ps(_mm256_mul_ps(radiusRatioV, _mm256_sub_ps(offsetXV, x2)), offsetXV));
+    __m256i indX = _mm256_cvttps_epi32(_mm256_div_ps(_mm256_sub_ps(indOffsetXV, x2), voxelSizeV));
+    __m256i indY = _mm256_cvttps_epi32(_mm256_div_ps(_mm256_sub_ps(indOffsetYV, _mm256_div_ps(y2, scaleY)), voxelSizeV));
+
+    __m256i valid = _mm256_and_si256(_mm256_and_si256(_mm256_cmpgt_epi32(indX, minusOneV), _mm256_cmpgt_epi32(voxelNumXV, indX)),
+                    _mm256_and_si256(_mm256_cmpgt_epi32(indY, minusOneV), _mm256_cmpgt_epi32(voxelNumYV, indY)));
+    __m256i ind = _mm256_add_epi32(_mm256_mullo_epi32(voxelNumYV, indX), indY);
+    _mm256_storeu_si256((__m256i*)(inds + i), _mm256_or_si256(_mm256_and_si256(valid, ind), _mm256_andnot_si256(valid, minusOneV)));
+  }
+
+  voxelIndicesScalar(grid, cosRotAng, sinRotAng, xs + i, ys + i, pointNum - i, inds + i);
+}
+
+bool voxelIndicesAvx2Supported()
+{
+  return __builtin_cpu_supports("avx2");
+}
+
+#endif
+
+void voxelIndices(const VoxelIndexGrid& grid, float cosRotAng, float sinRotAng, const float *xs,
+                  const float *ys, int pointNum, int *inds)
+{
+  #if defined(VOXEL_INDICES_X86) && defined(__AVX2__)
+  voxelIndicesAvx2(grid, cosRotAng, sinRotAng, xs, ys, pointNum, inds);
+  #elif defined(VOXEL_INDICES_X86)
+  voxelIndicesSse2(grid, cosRotAng, sinRotAng, xs, ys, pointNum, inds);
+  #else
+  voxelIndicesScalar(grid, cosRotAng, sinRotAng, xs, ys, pointNum, inds);
+  #endif
+}
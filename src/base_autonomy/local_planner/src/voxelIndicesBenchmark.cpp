@@ -0,0 +1,128 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "local_planner/pathLibrary.h"
+#include "local_planner/voxelIndices.h"
+
+using namespace std;
+
+const double PI = 3.1415926;
+
+// times the voxel indices of the path evaluation, the scalar, SSE2 and AVX2 versions on random
+// points around the vehicle in all 36 rotation directions, on the grid of the shipped paths
+void printUsage()
+{
+  printf("Usage: voxelIndicesBenchmark [options]\n");
+  printf("Options:\n");
+  printf("  --pointNum N           points per rotation direction (5000)\n");
+  printf("  --range R              radius of the points around the vehicle in m (3.5)\n");
+  printf("  --repeat N             passes over the 36 rotation directions (200)\n");
+}
+
+typedef void (*VoxelIndicesFunc)(const VoxelIndexGrid& grid, float cosRotAng, float sinRotAng, const float *xs,
+                                 const float *ys, int pointNum, int *inds);
+
+// runs one version repeatNum times over the 36 rotation directions, returns the time in s, the
+// indices of the last pass are left in inds, pointNum per direction
+double timeVoxelIndices(VoxelIndicesFunc func, const VoxelIndexGrid& grid, const vector<float>& xs,
+                        const vector<float>& ys, int repeatNum, vector<int>& inds)
+{
+  int pointNum = xs.size();
+  inds.resize(36 * pointNum);
+
+  chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+  for (int repeat = 0; repeat < repeatNum; repeat++) {
+    for (int rotDir = 0; rotDir < 36; rotDir++) {
+      float rotAng = (10.0 * rotDir - 180.0) * PI / 180;
+      func(grid, cos(rotAng), sin(rotAng), xs.data(), ys.data(), pointNum, &inds[pointNum * rotDir]);
+    }
+  }
+  return chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+}
+
+void printResult(const char *name, double time, double scalarTime, long indexNum, const vector<int>& inds,
+                 const vector<int>& scalarInds)
+{
+  int diffNum = 0;
+  for (size_t i = 0; i < inds.size(); i++) {
+    if (inds[i] != scalarInds[i]) diffNum++;
+  }
+
+  printf("%-7s %8.3f ms, %12.0f points/s, speedup %.2fx, indices different from scalar: %d\n", name, 1000.0 * time,
+         time > 0 ? indexNum / time : 0, time > 0 ? scalarTime / time : 0, diffNum);
+}
+
+int main(int argc, char** argv)
+{
+  int pointNum = 5000;
+  double range = 3.5;
+  int repeatNum = 200;
+
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (i + 1 >= argc) {
+      printUsage();
+      return 1;
+    }
+
+    const char *val = argv[++i];
+    if (arg == "--pointNum") pointNum = atoi(val);
+    else if (arg == "--range") range = atof(val);
+    else if (arg == "--repeat") repeatNum = atoi(val);
+    else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  if (pointNum <= 0 || range <= 0 || repeatNum <= 0) {
+    printUsage();
+    return 1;
+  }
+
+  PathLibraryGrid libraryGrid;
+  VoxelIndexGrid grid;
+  grid.gridVoxelNumX = libraryGrid.gridVoxelNumX;
+  grid.gridVoxelNumY = libraryGrid.gridVoxelNumY;
+  grid.gridVoxelSize = libraryGrid.gridVoxelSize;
+  grid.searchRadius = libraryGrid.searchRadius;
+  grid.gridVoxelOffsetX = libraryGrid.gridVoxelOffsetX;
+  grid.gridVoxelOffsetY = libraryGrid.gridVoxelOffsetY;
+
+  // uniform in the disk, as the cropped planner cloud around the vehicle
+  srand(1);
+  vector<float> xs(pointNum), ys(pointNum);
+  for (int i = 0; i < pointNum; i++) {
+    float dis = range * sqrt(rand() / (RAND_MAX + 1.0));
+    float ang = 2 * PI * rand() / (RAND_MAX + 1.0);
+    xs[i] = dis * cos(ang);
+    ys[i] = dis * sin(ang);
+  }
+
+  long indexNum = 36L * pointNum * repeatNum;
+  printf("points: %d, rotation directions: 36, repeat: %d\n", pointNum, repeatNum);
+
+  vector<int> scalarInds, inds;
+  double scalarTime = timeVoxelIndices(voxelIndicesScalar, grid, xs, ys, repeatNum, scalarInds);
+  printResult("scalar", scalarTime, scalarTime, indexNum, scalarInds, scalarInds);
+
+  #ifdef VOXEL_INDICES_X86
+  double time = timeVoxelIndices(voxelIndicesSse2, grid, xs, ys, repeatNum, inds);
+  printResult("SSE2", time, scalarTime, indexNum, inds, scalarInds);
+
+  if (voxelIndicesAvx2Supported()) {
+    time = timeVoxelIndices(voxelIndicesAvx2, grid, xs, ys, repeatNum, inds);
+    printResult("AVX2", time, scalarTime, indexNum, inds, scalarInds);
+  } else {
+    printf("AVX2    not supported by this CPU\n");
+  }
+  #else
+  printf("SSE2 and AVX2 are only built on x86-64\n");
+  #endif
+
+  return 0;
+}
@@ -0,0 +1,541 @@
+#include <math.h>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "rclcpp/rclcpp.hpp"
+#include "nav_msgs/msg/odometry.hpp"
+#include "nav_msgs/msg/path.hpp"
+#include "rosgraph_msgs/msg/clock.hpp"
+#include "sensor_msgs/msg/point_cloud2.hpp"
+#include <geometry_msgs/msg/twist_stamped.hpp>
+#include <pcl_conversions/pcl_conversions.h>
+
+#include "local_planner/localPlannerNode.h"
+#include "local_planner/pathFollowerNode.h"
+#include "terrain_analysis/terrainAnalysisNode.h"
+
+#include "testPaths.h"
+
+using namespace std;
+
+namespace
+{
+
+// stands in for terrainAnalysis, publishes /terrain_map as unique_ptr the way it does
+class TerrainMapProducer : public rclcpp::Node
+{
+public:
+  explicit TerrainMapProducer(const rclcpp::NodeOptions& options)
+    : Node("terrainMapProducer", options)
+  {
+    pubTerrainMap = create_publisher<sensor_msgs::msg::PointCloud2>("/terrain_map", 2);
+  }
+
+  // address of the message handed to the publisher
+  const void* publish(const pcl::PointCloud<pcl::PointXYZI>& cloud)
+  {
+    auto terrainMap = std::make_unique<sensor_msgs::msg::PointCloud2>();
+    pcl::toROSMsg(cloud, *terrainMap);
+    terrainMap->header.frame_id = "map";
+    const void* address = terrainMap.get();
+    pubTerrainMap->publish(std::move(terrainMap));
+    return address;
+  }
+
+  rclcpp::Publisher<sensor_msgs::msg::PointCloud2>::SharedPtr pubTerrainMap;
+};
+
+// stands in for localPlanner, publishes /path as unique_ptr the way it does
+class PathProducer : public rclcpp::Node
+{
+public:
+  explicit PathProducer(const rclcpp::NodeOptions& options)
+    : Node("pathProducer", options)
+  {
+    pubPath = create_publisher<nav_msgs::msg::Path>("/path", 5);
+  }
+
+  // poses poseSpacing apart straight ahead of the vehicle
+  const void* publish(int poseNum, float poseSpacing = 0)
+  {
+    auto path = std::make_unique<nav_msgs::msg::Path>();
+    path->poses.resize(poseNum);
+    for (int i = 0; i < poseNum; i++) path->poses[i].pose.position.x = i * poseSpacing;
+    path->header.frame_id = "vehicle";
+    const void* address = path.get();
+    pubPath->publish(std::move(path));
+    return address;
+  }
+
+  rclcpp::Publisher<nav_msgs::msg::Path>::SharedPtr pubPath;
+};
+
+// takes the messages of a topic as unique_ptr like the localPlanner and pathFollower callbacks,
+// the messages are kept so their addresses are not reused
+template <typename MessageT>
+class UniquePtrConsumer : public rclcpp::Node
+{
+public:
+  UniquePtrConsumer(const string& name, const string& topic, const rclcpp::NodeOptions& options)
+    : Node(name, options)
+  {
+    subscription = create_subscription<MessageT>(topic, 5, [this](typename MessageT::UniquePtr message) {
+      addresses.push_back(message.get());
+      messages.push_back(std::move(message));
+    });
+  }
+
+  vector<const void*> addresses;
+  vector<typename MessageT::UniquePtr> messages;
+  typename rclcpp::Subscription<MessageT>::SharedPtr subscription;
+};
+
+// the planner with its /terrain_map callback recording the address of each message it is handed
+class RecordingPlannerNode : public local_planner::LocalPlannerNode
+{
+public:
+  explicit RecordingPlannerNode(const rclcpp::NodeOptions& options) : LocalPlannerNode(options) {}
+
+  vector<const void*> terrainMapAddresses;
+
+protected:
+  void terrainCloudHandler(sensor_msgs::msg::PointCloud2::UniquePtr terrainCloud2) override
+  {
+    terrainMapAddresses.push_back(terrainCloud2.get());
+    LocalPlannerNode::terrainCloudHandler(std::move(terrainCloud2));
+  }
+};
+
+// the follower with its /path callback recording the address and size of each message it is handed
+class RecordingFollowerNode : public local_planner::PathFollowerNode
+{
+public:
+  explicit RecordingFollowerNode(const rclcpp::NodeOptions& options) : PathFollowerNode(options) {}
+
+  vector<const void*> pathAddresses;
+  vector<size_t> pathSizes;
+  double pathMaxAbsY = 0;
+
+protected:
+  void pathHandler(nav_msgs::msg::Path::UniquePtr pathIn) override
+  {
+    pathAddresses.push_back(pathIn.get());
+    pathSizes.push_back(pathIn->poses.size());
+    for (size_t i = 0; i < pathIn->poses.size(); i++) {
+      pathMaxAbsY = max(pathMaxAbsY, fabs(pathIn->poses[i].pose.position.y));
+    }
+    PathFollowerNode::pathHandler(std::move(pathIn));
+  }
+};
+
+// stands in for the state estimation and the registered scans, a vehicle standing in a corridor with
+// walls 0.8 m high and 0.6 m to either side
+class ScanProducer : public rclcpp::Node
+{
+public:
+  explicit ScanProducer(const rclcpp::NodeOptions& options)
+    : Node("scanProducer", options)
+  {
+    pubOdometry = create_publisher<nav_msgs::msg::Odometry>("/state_estimation", 5);
+    pubScan = create_publisher<sensor_msgs::msg::PointCloud2>("/registered_scan", 5);
+
+    pcl::PointXYZI point;
+    point.intensity = 0;
+    for (float x = -4.0; x <= 4.0; x += 0.1) {
+      for (float y = -0.5; y <= 0.5; y += 0.1) {
+        point.x = x;
+        point.y = y;
+        point.z = 0;
+        scan.push_back(point);
+      }
+      for (float z = 0; z <= 0.8; z += 0.1) {
+        point.x = x;
+        point.z = z;
+        point.y = 0.6;
+        scan.push_back(point);
+        point.y = -0.6;
+        scan.push_back(point);
+      }
+    }
+  }
+
+  void publish(double time)
+  {
+    auto odom = std::make_unique<nav_msgs::msg::Odometry>();
+    odom->header.stamp = rclcpp::Time(static_cast<uint64_t>(time * 1e9));
+    odom->header.frame_id = "map";
+    odom->pose.pose.position.z = 0.75;
+    odom->pose.pose.orientation.w = 1.0;
+    pubOdometry->publish(std::move(odom));
+
+    auto scan2 = std::make_unique<sensor_msgs::msg::PointCloud2>();
+    pcl::toROSMsg(scan, *scan2);
+    scan2->header.stamp = rclcpp::Time(static_cast<uint64_t>(time * 1e9));
+    scan2->header.frame_id = "map";
+    pubScan->publish(std::move(scan2));
+  }
+
+  pcl::PointCloud<pcl::PointXYZI> scan;
+  rclcpp::Publisher<nav_msgs::msg::Odometry>::SharedPtr pubOdometry;
+  rclcpp::Publisher<sensor_msgs::msg::PointCloud2>::SharedPtr pubScan;
+};
+
+// stands in for the headless vehicleSimulator, publishes /clock and then the odometry at that time
+class SimClockProducer : public rclcpp::Node
+{
+public:
+  explicit SimClockProducer(const rclcpp::NodeOptions& options)
+    : Node("simClockProducer", options)
+  {
+    pubClock = create_publisher<rosgraph_msgs::msg::Clock>("/clock", 5);
+    pubOdometry = create_publisher<nav_msgs::msg::Odometry>("/state_estimation", 5);
+  }
+
+  void publish(double time)
+  {
+    auto clock = std::make_unique<rosgraph_msgs::msg::Clock>();
+    clock->clock = rclcpp::Time(static_cast<uint64_t>(time * 1e9));
+    pubClock->publish(std::move(clock));
+
+    auto odom = std::make_unique<nav_msgs::msg::Odometry>();
+    odom->header.stamp = rclcpp::Time(static_cast<uint64_t>(time * 1e9));
+    odom->header.frame_id = "map";
+    odom->pose.pose.orientation.w = 1.0;
+    pubOdometry->publish(std::move(odom));
+  }
+
+  rclcpp::Publisher<rosgraph_msgs::msg::Clock>::SharedPtr pubClock;
+  rclcpp::Publisher<nav_msgs::msg::Odometry>::SharedPtr pubOdometry;
+};
+
+class LocalPlannerNodeTest : public ::testing::Test
+{
+protected:
+  static void SetUpTestCase()
+  {
+    rclcpp::init(0, NULL);
+  }
+
+  static void TearDownTestCase()
+  {
+    rclcpp::shutdown();
+  }
+
+  // spins until the consumer has messageNum messages or the timeout passes
+  template <typename MessageT>
+  static bool spinUntil(rclcpp::executors::SingleThreadedExecutor& executor, const UniquePtrConsumer<MessageT>& consumer,
+                        size_t messageNum, double timeout = 5.0)
+  {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeout);
+    while (consumer.messages.size() < messageNum && std::chrono::steady_clock::now() < deadline) {
+      executor.spin_once(std::chrono::milliseconds(10));
+    }
+    return consumer.messages.size() >= messageNum;
+  }
+
+  // spins for the given wall time
+  static void spinFor(rclcpp::executors::SingleThreadedExecutor& executor, double duration)
+  {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(duration);
+    while (std::chrono::steady_clock::now() < deadline) {
+      executor.spin_once(std::chrono::milliseconds(10));
+    }
+  }
+
+  static rclcpp::NodeOptions intraProcessOptions()
+  {
+    return rclcpp::NodeOptions().use_intra_process_comms(true);
+  }
+};
+
+}
+
+// with intra-process comms and the planner as the only subscriber, the /terrain_map cloud published
+// the way terrainAnalysis does reaches the planner's callback without a copy
+TEST_F(LocalPlannerNodeTest, TerrainMapIsMovedIntoPlanner)
+{
+  rclcpp::NodeOptions plannerOptions = intraProcessOptions();
+  plannerOptions.parameter_overrides({
+    rclcpp::Parameter("pathFolder", testPathFolder),
+    rclcpp::Parameter("useTerrainAnalysis", true),
+  });
+
+  auto producer = std::make_shared<TerrainMapProducer>(intraProcessOptions());
+  auto planner = std::make_shared<RecordingPlannerNode>(plannerOptions);
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(producer);
+  executor.add_node(planner);
+  ASSERT_EQ(producer->pubTerrainMap->get_subscription_count(), 1u);
+  ASSERT_EQ(producer->pubTerrainMap->get_intra_process_subscription_count(), 1u);
+
+  pcl::PointCloud<pcl::PointXYZI> cloud;
+  corridorCloud(1.0, 4.0, 1.5, 0, 0.05, cloud);
+  vector<const void*> addresses;
+  for (int i = 0; i < 3; i++) {
+    addresses.push_back(producer->publish(cloud));
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (planner->terrainMapAddresses.size() < addresses.size() && std::chrono::steady_clock::now() < deadline) {
+      executor.spin_once(std::chrono::milliseconds(10));
+    }
+  }
+
+  EXPECT_EQ(planner->terrainMapAddresses, addresses);
+}
+
+// the same for /path published the way localPlanner does and the follower's callback
+TEST_F(LocalPlannerNodeTest, PathIsMovedIntoFollower)
+{
+  auto producer = std::make_shared<PathProducer>(intraProcessOptions());
+  auto follower = std::make_shared<RecordingFollowerNode>(intraProcessOptions());
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(producer);
+  executor.add_node(follower);
+  ASSERT_EQ(producer->pubPath->get_subscription_count(), 1u);
+  ASSERT_EQ(producer->pubPath->get_intra_process_subscription_count(), 1u);
+
+  vector<const void*> addresses;
+  for (int i = 0; i < 3; i++) {
+    addresses.push_back(producer->publish(10 * (i + 1)));
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (follower->pathAddresses.size() < addresses.size() && std::chrono::steady_clock::now() < deadline) {
+      executor.spin_once(std::chrono::milliseconds(10));
+    }
+  }
+
+  EXPECT_EQ(follower->pathAddresses, addresses);
+  EXPECT_EQ(follower->pathSizes, (vector<size_t>{10, 20, 30}));
+}
+
+// with use_sim_time the follower answers each odometry with one command stamped at it rather than
+// running on the wall clock, and ramps the speed over the odometry intervals, the odometry comes
+// 0.05 s of sim time apart with more wall time than a 100 Hz cycle between them
+TEST_F(LocalPlannerNodeTest, SimTimeFollowerAnswersEachOdometry)
+{
+  const int odomNum = 10;
+  const double odomInterval = 0.05;
+  const double maxAccel = 1.0;
+
+  rclcpp::NodeOptions followerOptions;
+  followerOptions.parameter_overrides({
+    rclcpp::Parameter("use_sim_time", true),
+    rclcpp::Parameter("autonomyMode", true),
+    rclcpp::Parameter("autonomySpeed", 1.0),
+    rclcpp::Parameter("maxAccel", maxAccel),
+  });
+
+  auto pathProducer = std::make_shared<PathProducer>(rclcpp::NodeOptions());
+  auto clockProducer = std::make_shared<SimClockProducer>(rclcpp::NodeOptions());
+  auto follower = std::make_shared<local_planner::PathFollowerNode>(followerOptions);
+  auto consumer = std::make_shared<UniquePtrConsumer<geometry_msgs::msg::TwistStamped> >("cmdConsumer", "/cmd_vel",
+                                                                                       rclcpp::NodeOptions());
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(pathProducer);
+  executor.add_node(clockProducer);
+  executor.add_node(follower);
+  executor.add_node(consumer);
+
+  double time = 1700000000.0;
+  clockProducer->publish(time);
+  spinFor(executor, 0.05);
+  pathProducer->publish(50, 0.1);
+  spinFor(executor, 0.05);
+  ASSERT_TRUE(consumer->messages.empty());
+
+  vector<double> odomTimes;
+  for (int i = 0; i < odomNum; i++) {
+    time += odomInterval;
+    odomTimes.push_back(rclcpp::Time(static_cast<uint64_t>(time * 1e9)).seconds());
+    clockProducer->publish(time);
+    spinFor(executor, 0.05);
+  }
+
+  ASSERT_EQ(consumer->messages.size(), size_t(odomNum));
+  for (int i = 0; i < odomNum; i++) {
+    EXPECT_NEAR(rclcpp::Time(consumer->messages[i]->header.stamp).seconds(), odomTimes[i], 1e-6);
+  }
+  // the odometry before the path gives the first command its interval
+  EXPECT_NEAR(consumer->messages.back()->twist.linear.x, maxAccel * odomNum * odomInterval, 1e-3);
+}
+
+// the planner between the two in one process, its /terrain_map subscription is the only one and
+// is handed the published cloud itself, the path down the corridor comes out on /path
+TEST_F(LocalPlannerNodeTest, PlansOnIntraProcessTerrainMap)
+{
+  rclcpp::NodeOptions plannerOptions = intraProcessOptions();
+  plannerOptions.parameter_overrides({
+    rclcpp::Parameter("pathFolder", testPathFolder),
+    rclcpp::Parameter("useTerrainAnalysis", true),
+    rclcpp::Parameter("autonomyMode", true),
+    rclcpp::Parameter("autonomySpeed", 1.0),
+    rclcpp::Parameter("goalX", 3.0),
+  });
+
+  auto producer = std::make_shared<TerrainMapProducer>(intraProcessOptions());
+  auto planner = std::make_shared<RecordingPlannerNode>(plannerOptions);
+  auto consumer = std::make_shared<UniquePtrConsumer<nav_msgs::msg::Path> >("pathConsumer", "/path",
+                                                                            intraProcessOptions());
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(producer);
+  executor.add_node(planner);
+  executor.add_node(consumer);
+  ASSERT_EQ(producer->pubTerrainMap->get_intra_process_subscription_count(), 1u);
+
+  pcl::PointCloud<pcl::PointXYZI> cloud;
+  corridorCloud(1.0, 4.0, 0, 0, 0.05, cloud);
+  const void* address = producer->publish(cloud);
+  ASSERT_TRUE(spinUntil(executor, *consumer, 1));
+  EXPECT_EQ(planner->terrainMapAddresses, vector<const void*>{address});
+
+  const nav_msgs::msg::Path& path = *consumer->messages.back();
+  EXPECT_EQ(path.header.frame_id, "vehicle");
+  ASSERT_GT(path.poses.size(), 1u);
+  for (size_t i = 0; i < path.poses.size(); i++) {
+    EXPECT_LT(fabs(path.poses[i].pose.position.y), 1.0) << "pose " << i;
+  }
+  EXPECT_GT(path.poses.back().pose.position.x, 0.5);
+}
+
+// terrainAnalysis, localPlanner and pathFollower loaded together as in local_planner_container.launch,
+// each of /terrain_map and /path has a single intra-process subscriber so the message is moved along,
+// the scans of the corridor keep the paths between the walls though the goal is off to the left, and
+// end up as a forward command on /cmd_vel
+TEST_F(LocalPlannerNodeTest, TerrainPlannerFollowerChain)
+{
+  rclcpp::NodeOptions plannerOptions = intraProcessOptions();
+  plannerOptions.parameter_overrides({
+    rclcpp::Parameter("pathFolder", testPathFolder),
+    rclcpp::Parameter("useTerrainAnalysis", true),
+    rclcpp::Parameter("autonomyMode", true),
+    rclcpp::Parameter("autonomySpeed", 1.0),
+    rclcpp::Parameter("goalX", 3.0),
+    rclcpp::Parameter("goalY", 3.0),
+  });
+  rclcpp::NodeOptions followerOptions = intraProcessOptions();
+  followerOptions.parameter_overrides({
+    rclcpp::Parameter("autonomyMode", true),
+    rclcpp::Parameter("autonomySpeed", 1.0),
+  });
+
+  auto producer = std::make_shared<ScanProducer>(intraProcessOptions());
+  auto terrain = std::make_shared<terrain_analysis::TerrainAnalysisNode>(intraProcessOptions());
+  auto planner = std::make_shared<RecordingPlannerNode>(plannerOptions);
+  auto follower = std::make_shared<RecordingFollowerNode>(followerOptions);
+  auto consumer = std::make_shared<UniquePtrConsumer<geometry_msgs::msg::TwistStamped> >("cmdConsumer", "/cmd_vel",
+                                                                                       intraProcessOptions());
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(producer);
+  executor.add_node(terrain);
+  executor.add_node(planner);
+  executor.add_node(follower);
+  executor.add_node(consumer);
+  ASSERT_EQ(terrain->count_subscribers("/terrain_map"), 1u);
+  ASSERT_EQ(planner->count_subscribers("/path"), 1u);
+
+  // 2 s of scans at 10 Hz
+  double time = 1700000000.0;
+  for (int scanID = 0; scanID < 20; scanID++) {
+    producer->publish(time);
+    time += 0.1;
+    for (int i = 0; i < 10; i++) {
+      executor.spin_once(std::chrono::milliseconds(10));
+    }
+  }
+
+  ASSERT_FALSE(planner->terrainMapAddresses.empty());
+  ASSERT_FALSE(follower->pathAddresses.empty());
+  // the walls less half the vehicle width
+  EXPECT_LT(follower->pathMaxAbsY, 0.6 - 0.3);
+  ASSERT_FALSE(consumer->messages.empty());
+  EXPECT_GT(consumer->messages.back()->twist.linear.x, 0);
+}
+
+// two path sets with their own adjacentRange, the long one selected at the autonomy speed sees a box
+// beyond the range of the short one from the first cycle on, none of its free paths run through the
+// box, slowed down the short one keeps its paths within its range
+TEST_F(LocalPlannerNodeTest, PathSetsUseOwnAdjacentRange)
+{
+  const double shortRange = 1.5, longRange = 3.5;
+  auto runPlanner = [&](double speed) {
+    rclcpp::NodeOptions plannerOptions = intraProcessOptions();
+    plannerOptions.parameter_overrides({
+      rclcpp::Parameter("pathFolder", testPathFolder),
+      rclcpp::Parameter("pathSetFolders", vector<string>{".", "."}),
+      rclcpp::Parameter("pathSetMinSpeeds", vector<double>{0, 0.5}),
+      rclcpp::Parameter("pathSetMaxObstacleDensities", vector<double>{100.0, 100.0}),
+      rclcpp::Parameter("pathSetAdjacentRanges", vector<double>{shortRange, longRange}),
+      rclcpp::Parameter("useTerrainAnalysis", true),
+      rclcpp::Parameter("autonomyMode", true),
+      rclcpp::Parameter("autonomySpeed", speed),
+      rclcpp::Parameter("goalX", 5.0),
+    });
+
+    auto producer = std::make_shared<TerrainMapProducer>(intraProcessOptions());
+    auto planner = std::make_shared<local_planner::LocalPlannerNode>(plannerOptions);
+    auto consumer = std::make_shared<UniquePtrConsumer<sensor_msgs::msg::PointCloud2> >(
+      "freePathConsumer", "/free_paths", intraProcessOptions());
+    rclcpp::executors::SingleThreadedExecutor executor;
+    executor.add_node(producer);
+    executor.add_node(planner);
+    executor.add_node(consumer);
+
+    pcl::PointCloud<pcl::PointXYZI> cloud;
+    corridorCloud(1.0, 4.0, 2.5, 0, 0.05, cloud);
+    producer->publish(cloud);
+    pcl::PointCloud<pcl::PointXYZI> freePaths;
+    if (spinUntil(executor, *consumer, 1)) pcl::fromROSMsg(*consumer->messages.front(), freePaths);
+    return freePaths;
+  };
+
+  {
+    SCOPED_TRACE("long set");
+    pcl::PointCloud<pcl::PointXYZI> freePaths = runPlanner(1.0);
+    ASSERT_FALSE(freePaths.empty());
+    float maxDis = 0;
+    for (size_t i = 0; i < freePaths.points.size(); i++) {
+      const pcl::PointXYZI& point = freePaths.points[i];
+      maxDis = max(maxDis, float(sqrt(point.x * point.x + point.y * point.y)));
+      EXPECT_FALSE(fabs(point.x - 2.5) < 0.2 && fabs(point.y) < 0.2) << point.x << " " << point.y;
+    }
+    EXPECT_GT(maxDis, shortRange);
+  }
+  {
+    SCOPED_TRACE("short set");
+    pcl::PointCloud<pcl::PointXYZI> freePaths = runPlanner(0.2);
+    ASSERT_FALSE(freePaths.empty());
+    for (size_t i = 0; i < freePaths.points.size(); i++) {
+      const pcl::PointXYZI& point = freePaths.points[i];
+      EXPECT_LE(sqrt(point.x * point.x + point.y * point.y), shortRange + 0.01);
+    }
+  }
+}
+
+// a missing path library fails the construction instead of ending the process, so a container
+// loading the component stays up
+TEST_F(LocalPlannerNodeTest, ThrowsWithoutPathLibrary)
+{
+  rclcpp::NodeOptions plannerOptions;
+  plannerOptions.parameter_overrides({
+    rclcpp::Parameter("pathFolder", testPathFolder + "/missing"),
+  });
+  EXPECT_THROW(local_planner::LocalPlannerNode planner(plannerOptions), std::runtime_error);
+
+  plannerOptions.parameter_overrides({
+    rclcpp::Parameter("pathFolder", testPathFolder),
+    rclcpp::Parameter("pathSetFolders", vector<string>{"."}),
+  });
+  EXPECT_THROW(local_planner::LocalPlannerNode planner(plannerOptions), std::runtime_error);
+
+  plannerOptions.parameter_overrides({
+    rclcpp::Parameter("pathFolder", testPathFolder),
+    rclcpp::Parameter("pathSetFolders", vector<string>{"."}),
+    rclcpp::Parameter("pathSetMinSpeeds", vector<double>{0}),
+    rclcpp::Parameter("pathSetMaxObstacleDensities", vector<double>{0}),
+    rclcpp::Parameter("pathSetAdjacentRanges", vector<double>{2.0, 3.5}),
+  });
+  EXPECT_THROW(local_planner::LocalPlannerNode planner(plannerOptions), std::runtime_error);
+}
@@ -0,0 +1,425 @@
+#include <math.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "local_planner/pathEvaluator.h"
+#include "local_planner/pathLibrary.h"
+
+#include "testPaths.h"
+
+using namespace std;
+
+namespace
+{
+
+class PathEvaluatorTest : public ::testing::Test
+{
+protected:
+  static void SetUpTestCase()
+  {
+    pathLibrary = new PathLibrary();
+    ASSERT_TRUE(pathLibrary->readBinary(testPathFolder + "/pathLibrary.bin")) << pathLibrary->error();
+  }
+
+  static void TearDownTestCase()
+  {
+    delete pathLibrary;
+    pathLibrary = NULL;
+  }
+
+  static void setUpEvaluator(const PathEvaluatorParams& params, PathEvaluator& pathEvaluator)
+  {
+    pathEvaluator.setPathLibrary(*pathLibrary);
+    pathEvaluator.setParams(params);
+  }
+
+  // one evaluation by a freshly set up evaluator
+  static bool evaluate(const PathEvaluatorParams& params, const PathEvaluatorState& state,
+                       const pcl::PointCloud<pcl::PointXYZI>& cloud, PathEvaluator& pathEvaluator,
+                       PathEvaluatorResult& result)
+  {
+    setUpEvaluator(params, pathEvaluator);
+    return pathEvaluator.evaluate(cloud, state, result);
+  }
+
+  // clouds the evaluation modes are compared on, random points with and without terrain
+  // analysis heights and corridors of several widths with a box in different places
+  static vector<pcl::PointCloud<pcl::PointXYZI> > testClouds()
+  {
+    vector<pcl::PointCloud<pcl::PointXYZI> > clouds;
+    pcl::PointCloud<pcl::PointXYZI> cloud;
+    for (unsigned seed = 1; seed <= 4; seed++) {
+      randomObstacleCloud(500 * seed, seed, 3.5, cloud);
+      clouds.push_back(cloud);
+    }
+    corridorCloud(1.0, 4.0, 0, 0, 0.05, cloud);
+    clouds.push_back(cloud);
+    corridorCloud(0.8, 4.0, 1.5, 0.3, 0.05, cloud);
+    clouds.push_back(cloud);
+    corridorCloud(1.2, 4.0, 2.5, -0.5, 0.05, cloud);
+    clouds.push_back(cloud);
+    corridorCloud(0.6, 4.0, 1.0, 0, 0.05, cloud);
+    clouds.push_back(cloud);
+    return clouds;
+  }
+
+  static PathLibrary *pathLibrary;
+};
+
+PathLibrary *PathEvaluatorTest::pathLibrary = NULL;
+
+}
+
+// the bitset evaluation saturates the per-path counts at pointPerPathThre, below that the counts,
+// the penalties, the group scores and the selection equal those of the counter evaluation
+TEST_F(PathEvaluatorTest, BitsetMatchesCounter)
+{
+  vector<pcl::PointCloud<pcl::PointXYZI> > clouds = testClouds();
+  for (int useTerrainAnalysis = 0; useTerrainAnalysis < 2; useTerrainAnalysis++) {
+    for (size_t cloudID = 0; cloudID < clouds.size(); cloudID++) {
+      SCOPED_TRACE(::testing::Message() << "cloud " << cloudID << ", useTerrainAnalysis " << useTerrainAnalysis);
+
+      PathEvaluatorParams params;
+      params.useTerrainAnalysis = useTerrainAnalysis;
+      PathEvaluatorState state;
+      state.joySpeed = 1.0;
+      state.joyDir = 20.0 * cloudID - 60.0;
+
+      PathEvaluator counterEvaluator, bitsetEvaluator;
+      PathEvaluatorResult counterResult, bitsetResult;
+      evaluate(params, state, clouds[cloudID], counterEvaluator, counterResult);
+      params.useBitsetEval = true;
+      evaluate(params, state, clouds[cloudID], bitsetEvaluator, bitsetResult);
+
+      const vector<int>& counterClearPaths = counterEvaluator.clearPaths();
+      const vector<int>& bitsetClearPaths = bitsetEvaluator.clearPaths();
+      ASSERT_EQ(counterClearPaths.size(), bitsetClearPaths.size());
+      int blockedNum = 0;
+      for (size_t i = 0; i < counterClearPaths.size(); i++) {
+        ASSERT_EQ(min(counterClearPaths[i], params.pointPerPathThre), bitsetClearPaths[i]) << "path " << i;
+        if (bitsetClearPaths[i] >= params.pointPerPathThre) blockedNum++;
+      }
+      EXPECT_GT(blockedNum, 0);
+
+      EXPECT_EQ(counterEvaluator.pathPenalties(), bitsetEvaluator.pathPenalties());
+      EXPECT_EQ(counterEvaluator.clearPathPerGroupScores(), bitsetEvaluator.clearPathPerGroupScores());
+      EXPECT_EQ(counterResult.pathFound, bitsetResult.pathFound);
+      EXPECT_EQ(counterResult.selectedGroupID, bitsetResult.selectedGroupID);
+      EXPECT_EQ(counterResult.selectedRotDir, bitsetResult.selectedRotDir);
+      EXPECT_EQ(counterResult.pathScale, bitsetResult.pathScale);
+    }
+  }
+}
+
+// paths are summed in a fixed order per rotation direction, so the scores do not depend on the
+// thread count in any of the evaluation modes
+TEST_F(PathEvaluatorTest, ThreadCountDoesNotChangeScores)
+{
+  vector<pcl::PointCloud<pcl::PointXYZI> > clouds = testClouds();
+  for (int mode = 0; mode < 3; mode++) {
+    for (size_t cloudID = 0; cloudID < clouds.size(); cloudID++) {
+      SCOPED_TRACE(::testing::Message() << "cloud " << cloudID << ", mode " << mode);
+
+      PathEvaluatorParams params;
+      params.useTerrainAnalysis = true;
+      params.useBitsetEval = mode == 1;
+      params.useIncrementalEval = mode == 2;
+      params.dirThre = 180.0;
+      PathEvaluatorState state;
+      state.joySpeed = 1.0;
+
+      PathEvaluator singleEvaluator, multiEvaluator;
+      PathEvaluatorResult singleResult, multiResult;
+      params.threadNum = 1;
+      evaluate(params, state, clouds[cloudID], singleEvaluator, singleResult);
+      params.threadNum = 4;
+      evaluate(params, state, clouds[cloudID], multiEvaluator, multiResult);
+
+      EXPECT_EQ(singleEvaluator.clearPaths(), multiEvaluator.clearPaths());
+      EXPECT_EQ(singleEvaluator.pathPenalties(), multiEvaluator.pathPenalties());
+      EXPECT_EQ(singleEvaluator.clearPathPerGroupScores(), multiEvaluator.clearPathPerGroupScores());
+      EXPECT_EQ(singleResult.selectedGroupID, multiResult.selectedGroupID);
+      EXPECT_EQ(singleResult.selectedRotDir, multiResult.selectedRotDir);
+    }
+  }
+}
+
+// an unchanged cloud leaves nothing to walk in the second cycle, the selection stays the same and
+// equals that of the full evaluation
+TEST_F(PathEvaluatorTest, IncrementalSkipsUnchangedCloud)
+{
+  pcl::PointCloud<pcl::PointXYZI> cloud;
+  randomObstacleCloud(60, 5, 3.5, cloud);
+
+  PathEvaluatorParams params;
+  params.useTerrainAnalysis = true;
+  PathEvaluatorState state;
+  state.joySpeed = 1.0;
+
+  PathEvaluator fullEvaluator;
+  PathEvaluatorResult fullResult;
+  evaluate(params, state, cloud, fullEvaluator, fullResult);
+  ASSERT_TRUE(fullResult.pathFound);
+  ASSERT_EQ(fullResult.pathScale, params.pathScale);
+
+  params.useIncrementalEval = true;
+  PathEvaluator incrementalEvaluator;
+  setUpEvaluator(params, incrementalEvaluator);
+  PathEvaluatorResult firstResult, secondResult;
+  incrementalEvaluator.evaluate(cloud, state, firstResult);
+  vector<int> firstClearPaths = incrementalEvaluator.clearPaths();
+  vector<float> firstScores = incrementalEvaluator.clearPathPerGroupScores();
+  incrementalEvaluator.evaluate(cloud, state, secondResult);
+
+  EXPECT_EQ(firstClearPaths, fullEvaluator.clearPaths());
+  EXPECT_EQ(firstScores, fullEvaluator.clearPathPerGroupScores());
+  EXPECT_EQ(incrementalEvaluator.clearPaths(), firstClearPaths);
+  EXPECT_EQ(incrementalEvaluator.pathPenalties(), fullEvaluator.pathPenalties());
+  EXPECT_EQ(incrementalEvaluator.clearPathPerGroupScores(), firstScores);
+  EXPECT_EQ(secondResult.selectedGroupID, fullResult.selectedGroupID);
+  EXPECT_EQ(secondResult.selectedRotDir, fullResult.selectedRotDir);
+  EXPECT_EQ(firstResult.selectedGroupID, fullResult.selectedGroupID);
+
+  EXPECT_GT(firstResult.correspondenceLookupNum, 0);
+  EXPECT_LT(secondResult.correspondenceLookupNum, firstResult.correspondenceLookupNum);
+}
+
+// lowering the ground under some voxels cannot be undone in the running max, the penalties of
+// those directions are recomputed and match a full evaluation of the new cloud
+TEST_F(PathEvaluatorTest, IncrementalRecomputesDecreasedPenalties)
+{
+  pcl::PointCloud<pcl::PointXYZI> highCloud, lowCloud;
+  randomObstacleCloud(60, 6, 3.5, highCloud);
+  pcl::PointXYZI point;
+  point.z = 0;
+  for (int i = 0; i < 20; i++) {
+    point.x = 1.0 + 0.05 * i;
+    point.y = 0.2 - 0.02 * i;
+    point.intensity = 0.18;
+    highCloud.push_back(point);
+  }
+
+  // the same points, the added ones lower and every second one gone
+  lowCloud = highCloud;
+  int addedStart = highCloud.points.size() - 20;
+  for (int i = 0; i < 20; i++) {
+    lowCloud.points[addedStart + i].intensity = i % 2 == 0 ? 0.12 : 0;
+  }
+
+  PathEvaluatorParams params;
+  params.useTerrainAnalysis = true;
+  PathEvaluatorState state;
+  state.joySpeed = 1.0;
+
+  PathEvaluator fullEvaluator;
+  PathEvaluatorResult fullResult;
+  evaluate(params, state, lowCloud, fullEvaluator, fullResult);
+
+  params.useIncrementalEval = true;
+  PathEvaluator incrementalEvaluator;
+  setUpEvaluator(params, incrementalEvaluator);
+  PathEvaluatorResult highResult, lowResult;
+  incrementalEvaluator.evaluate(highCloud, state, highResult);
+  vector<float> highPenalties = incrementalEvaluator.pathPenalties();
+  incrementalEvaluator.evaluate(lowCloud, state, lowResult);
+
+  ASSERT_NE(highPenalties, fullEvaluator.pathPenalties());
+  EXPECT_EQ(incrementalEvaluator.pathPenalties(), fullEvaluator.pathPenalties());
+  EXPECT_EQ(incrementalEvaluator.clearPaths(), fullEvaluator.clearPaths());
+  EXPECT_EQ(incrementalEvaluator.clearPathPerGroupScores(), fullEvaluator.clearPathPerGroupScores());
+  EXPECT_EQ(lowResult.selectedGroupID, fullResult.selectedGroupID);
+  EXPECT_EQ(lowResult.selectedRotDir, fullResult.selectedRotDir);
+}
+
+// in a corridor with a box ahead, the selected path and all the free paths stay between the walls
+// and clear of the box, without the box the selected path goes straight down the corridor
+TEST_F(PathEvaluatorTest, CorridorPathsAvoidWallsAndBox)
+{
+  const float halfWidth = 1.0;
+  for (int withBox = 0; withBox < 2; withBox++) {
+    SCOPED_TRACE(::testing::Message() << "withBox " << withBox);
+
+    pcl::PointCloud<pcl::PointXYZI> cloud;
+    corridorCloud(halfWidth, 4.0, withBox ? 1.5 : 0, 0, 0.05, cloud);
+
+    PathEvaluatorParams params;
+    params.useTerrainAnalysis = true;
+    PathEvaluatorState state;
+    state.joySpeed = 1.0;
+
+    PathEvaluator pathEvaluator;
+    PathEvaluatorResult result;
+    ASSERT_TRUE(evaluate(params, state, cloud, pathEvaluator, result));
+    ASSERT_TRUE(result.pathFound);
+    ASSERT_GT(result.path.points.size(), 0u);
+
+    float endY = 0;
+    for (size_t i = 0; i < result.path.points.size(); i++) {
+      const pcl::PointXYZ& point = result.path.points[i];
+      EXPECT_LT(fabs(point.y), halfWidth) << "selected path point " << i;
+      if (withBox) {
+        EXPECT_FALSE(fabs(point.x - 1.5) < 0.2 && fabs(point.y) < 0.2) << "selected path point " << i;
+      }
+      endY = point.y;
+    }
+    if (!withBox) {
+      EXPECT_LT(fabs(endY), 0.25);
+    }
+
+    pcl::PointCloud<pcl::PointXYZI> freePaths;
+    pathEvaluator.getFreePaths(result, freePaths);
+    ASSERT_GT(freePaths.points.size(), 0u);
+    for (size_t i = 0; i < freePaths.points.size(); i++) {
+      const pcl::PointXYZI& point = freePaths.points[i];
+      EXPECT_LT(fabs(point.y), halfWidth) << "free path point " << i;
+      if (withBox) {
+        EXPECT_FALSE(fabs(point.x - 1.5) < 0.2 && fabs(point.y) < 0.2) << "free path point " << i;
+      }
+    }
+  }
+}
+
+// with the time-to-collision cost, a near and a far group of obstacle points at voxel centers
+// straight ahead, the distance of each path is the arc length to its first point within
+// searchRadius of either group, which is not the straight-line distance of the points
+TEST_F(PathEvaluatorTest, ObstacleDisIsArcLengthAlongPath)
+{
+  float voxelSize = pathLibrary->gridVoxelSize();
+  float offsetX = pathLibrary->gridVoxelOffsetX();
+  float offsetY = pathLibrary->gridVoxelOffsetY();
+  float searchRadius = pathLibrary->searchRadius();
+
+  // voxel centers as pathGenerator computes them, near ones to the left and far ones to the right
+  pcl::PointCloud<pcl::PointXYZI> cloud;
+  pcl::PointXYZI point;
+  point.z = 0;
+  point.intensity = 1.0;
+  for (int group = 0; group < 2; group++) {
+    for (int i = 0; i < 3; i++) {
+      for (int j = 0; j < 3; j++) {
+        float x = (group == 0 ? 1.0 : 2.2) + 0.04 * i;
+        float y = (group == 0 ? 0.5 : -0.4) + 0.04 * j;
+        int indX = int((offsetX - x) / voxelSize + 0.5);
+        point.x = offsetX - voxelSize * indX;
+        float scaleY = point.x / offsetX + searchRadius / offsetY * (offsetX - point.x) / offsetX;
+        int indY = int((offsetY - y / scaleY) / voxelSize + 0.5);
+        point.y = scaleY * (offsetY - voxelSize * indY);
+        cloud.push_back(point);
+      }
+    }
+  }
+
+  PathEvaluatorParams params;
+  params.useTtcCost = true;
+  params.pathCropByGoal = false;
+  PathEvaluatorState state;
+  state.joySpeed = 1.0;
+
+  PathEvaluator pathEvaluator;
+  PathEvaluatorResult result;
+  evaluate(params, state, cloud, pathEvaluator, result);
+  ASSERT_EQ(result.pathScale, 1.0);
+
+  // straight ahead, the vehicle frame is the path frame
+  int pathNum = pathLibrary->pathNum();
+  const float *obstacleDis = &pathEvaluator.pathObstacleDis()[pathNum * 18];
+
+  vector<float> arcs(pathNum, 0), expectedDis(pathNum, -1.0), lineDis(pathNum, -1.0);
+  vector<bool> pointReached(cloud.points.size());
+  int lastPathID = -1;
+  const PathLibraryPoint *pathPoints = pathLibrary->paths();
+  for (int i = 0; i < pathLibrary->pathPointNum(); i++) {
+    int pathID = pathPoints[i].pathID;
+    if (pathID != lastPathID) {
+      fill(pointReached.begin(), pointReached.end(), false);
+    } else {
+      float disX = pathPoints[i].x - pathPoints[i - 1].x;
+      float disY = pathPoints[i].y - pathPoints[i - 1].y;
+      arcs[pathID] += sqrt(disX * disX + disY * disY);
+    }
+    lastPathID = pathID;
+
+    for (size_t j = 0; j < cloud.points.size(); j++) {
+      float disX = pathPoints[i].x - cloud.points[j].x;
+      float disY = pathPoints[i].y - cloud.points[j].y;
+      if (!pointReached[j] && sqrt(disX * disX + disY * disY) <= searchRadius) {
+        pointReached[j] = true;
+        if (expectedDis[pathID] < 0 || expectedDis[pathID] > arcs[pathID]) expectedDis[pathID] = arcs[pathID];
+        float pointDis = sqrt(cloud.points[j].x * cloud.points[j].x + cloud.points[j].y * cloud.points[j].y);
+        if (lineDis[pathID] < 0 || lineDis[pathID] > pointDis) lineDis[pathID] = pointDis;
+      }
+    }
+  }
+
+  int nearNum = 0, farNum = 0, differentNum = 0;
+  for (int i = 0; i < pathNum; i++) {
+    ASSERT_EQ(obstacleDis[i] >= 0, expectedDis[i] >= 0) << "path " << i;
+    if (expectedDis[i] < 0) continue;
+
+    EXPECT_NEAR(obstacleDis[i], expectedDis[i], 1e-3) << "path " << i;
+    if (expectedDis[i] < 1.0) nearNum++;
+    else farNum++;
+    if (fabs(expectedDis[i] - lineDis[i]) > 0.1) differentNum++;
+  }
+  EXPECT_GT(nearNum, 0);
+  EXPECT_GT(farNum, 0);
+  EXPECT_GT(differentNum, 0);
+}
+
+// obstacles beyond pathRange block no path, without the time-to-collision cost the straight group
+// wins whichever side the near obstacle is on, with it the paths toward the near obstacle lose and
+// the selected group turns toward the far one, swapping the obstacles flips the selection
+TEST_F(PathEvaluatorTest, TtcCostTurnsAwayFromNearObstacle)
+{
+  PathEvaluatorParams params;
+  params.pathCropByGoal = false;
+  params.pathScaleBySpeed = false;
+  params.pathRangeBySpeed = false;
+  params.adjacentRange = 1.0;
+  PathEvaluatorState state;
+  state.joySpeed = 1.0;
+
+  // endY of the selected path and its group by useTtcCost and by the side of the near obstacle
+  float endY[2][2];
+  int groupIDs[2][2];
+  for (int useTtcCost = 0; useTtcCost < 2; useTtcCost++) {
+    for (int nearLeft = 0; nearLeft < 2; nearLeft++) {
+      SCOPED_TRACE(::testing::Message() << "useTtcCost " << useTtcCost << " nearLeft " << nearLeft);
+
+      pcl::PointCloud<pcl::PointXYZI> cloud;
+      pcl::PointXYZI point;
+      point.z = 0;
+      point.intensity = 1.0;
+      for (int left = 0; left < 2; left++) {
+        float x = (left == nearLeft) ? 1.3 : 2.6;
+        float y = left ? 0.4 : -0.4;
+        for (int i = 0; i < 3; i++) {
+          for (int j = 0; j < 3; j++) {
+            point.x = x + 0.04 * i;
+            point.y = y + 0.04 * j;
+            cloud.push_back(point);
+          }
+        }
+      }
+
+      params.useTtcCost = useTtcCost;
+      PathEvaluator pathEvaluator;
+      PathEvaluatorResult result;
+      ASSERT_TRUE(evaluate(params, state, cloud, pathEvaluator, result));
+      ASSERT_EQ(result.pathScale, 1.0);
+      ASSERT_EQ(result.pathRange, 1.0);
+      ASSERT_GT(result.path.points.size(), 0u);
+      endY[useTtcCost][nearLeft] = result.path.points.back().y;
+      groupIDs[useTtcCost][nearLeft] = pathEvaluator.groupNum() * result.selectedRotDir + result.selectedGroupID;
+    }
+  }
+
+  EXPECT_EQ(groupIDs[0][0], groupIDs[0][1]);
+  EXPECT_LT(fabs(endY[0][0]), 0.05);
+  EXPECT_NE(groupIDs[1][0], groupIDs[1][1]);
+  EXPECT_GT(endY[1][0], 0.1);
+  EXPECT_LT(endY[1][1], -0.1);
+}
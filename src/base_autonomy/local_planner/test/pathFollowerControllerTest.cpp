@@ -0,0 +1,507 @@
+#include <math.h>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "local_planner/pathFollowerController.h"
+
+using namespace std;
+
+namespace
+{
+
+const float PI = 3.1415926;
+const float pathPointStep = 0.01;
+
+// straight path along x from the origin
+PathFollowerPath straightPath(float length)
+{
+  PathFollowerPath path;
+  int pointNum = round(length / pathPointStep);
+  for (int i = 0; i <= pointNum; i++) {
+    path.x.push_back(i * pathPointStep);
+    path.y.push_back(0);
+  }
+  return path;
+}
+
+// straight lead-in along x, then an arc of radius turning left by arcAng
+PathFollowerPath arcPath(float leadDis, float radius, float arcAng)
+{
+  PathFollowerPath path = straightPath(leadDis);
+  int pointNum = round(arcAng * radius / pathPointStep);
+  for (int i = 1; i <= pointNum; i++) {
+    float ang = i * pathPointStep / radius;
+    path.x.push_back(leadDis + radius * sin(ang));
+    path.y.push_back(radius - radius * cos(ang));
+  }
+  return path;
+}
+
+// segments of segLength alternating between headings of +/- halfAng about x, each corner turns
+// by 2 * halfAng, the first segment is firstSegLength long
+PathFollowerPath zigZagPath(float firstSegLength, float segLength, float halfAng, int segNum)
+{
+  PathFollowerPath path;
+  float x = 0, y = 0;
+  for (int seg = 0; seg < segNum; seg++) {
+    float heading = seg % 2 == 0 ? halfAng : -halfAng;
+    float length = seg == 0 ? firstSegLength : segLength;
+    int pointNum = round(length / pathPointStep);
+    for (int i = 0; i < pointNum; i++) {
+      path.x.push_back(x + i * pathPointStep * cos(heading));
+      path.y.push_back(y + i * pathPointStep * sin(heading));
+    }
+    x += pointNum * pathPointStep * cos(heading);
+    y += pointNum * pathPointStep * sin(heading);
+  }
+  path.x.push_back(x);
+  path.y.push_back(y);
+  return path;
+}
+
+PathFollowerParams curvParams()
+{
+  PathFollowerParams params;
+  params.maxSpeed = 5.0;
+  params.maxAccel = 1.0;
+  params.useCurvToSlow = true;
+  params.maxLatAccel = 1.0;
+  params.curvSampleDis = 0.1;
+  return params;
+}
+
+float curvSpeedLimit(const PathFollowerParams& params, const PathFollowerPath& path)
+{
+  PathFollowerController controller;
+  controller.setParams(params);
+  return controller.curvSpeedLimit(path, 0, 0);
+}
+
+// the 5 ms kinematic step of vehicleSimulator with no sensor offset, the yaw is advanced first
+// and the speeds are applied at the new yaw
+const float simStep = 0.005;
+
+void simulateVehicle(const PathFollowerCmd& cmd, float time, float& x, float& y, float& yaw)
+{
+  int stepNum = round(time / simStep);
+  for (int i = 0; i < stepNum; i++) {
+    yaw += simStep * cmd.yawRate;
+    if (yaw > PI) yaw -= 2 * PI;
+    else if (yaw < -PI) yaw += 2 * PI;
+
+    x += simStep * cos(yaw) * cmd.speedX - simStep * sin(yaw) * cmd.speedY;
+    y += simStep * sin(yaw) * cmd.speedX + simStep * cos(yaw) * cmd.speedY;
+  }
+}
+
+PathFollowerCmd makeCmd(float speedX, float speedY, float yawRate)
+{
+  PathFollowerCmd cmd;
+  cmd.speedX = speedX;
+  cmd.speedY = speedY;
+  cmd.yawRate = yawRate;
+  return cmd;
+}
+
+// steps of dt from state.time on with the vehicle held in place, the times advance together
+PathFollowerCmd runSteps(PathFollowerController& controller, PathFollowerState& state,
+                         const PathFollowerPath& path, int stepNum, float dt)
+{
+  PathFollowerCmd cmd;
+  for (int i = 0; i < stepNum; i++) {
+    state.time += dt;
+    state.odomTime = state.time;
+    cmd = controller.step(state, path, dt);
+  }
+  return cmd;
+}
+
+float angleDiff(float yaw1, float yaw2)
+{
+  float diff = yaw1 - yaw2;
+  if (diff > PI) diff -= 2 * PI;
+  else if (diff < -PI) diff += 2 * PI;
+  return diff;
+}
+
+// the prediction is the exact arc, the simulator steps turn the speed by half a step of yaw
+// early, which shifts the position by up to speed * yawRate * simStep / 2 per s
+void expectPredictionMatchesSimulator(const PathFollowerCmd& cmd)
+{
+  const float startYaws[] = {0, 1.0, -2.5, 3.1};
+  const float predictTimes[] = {0.005, 0.1, 0.25, 0.5, 1.0};
+  for (float startYaw : startYaws) {
+    for (float predictTime : predictTimes) {
+      float x = 1.5, y = -2.0, yaw = startYaw;
+      PathFollowerController::predictVehiclePose(cmd, predictTime, x, y, yaw);
+
+      float simX = 1.5, simY = -2.0, simYaw = startYaw;
+      simulateVehicle(cmd, predictTime, simX, simY, simYaw);
+
+      float speed = sqrt(cmd.speedX * cmd.speedX + cmd.speedY * cmd.speedY);
+      float disTol = speed * fabs(cmd.yawRate) * simStep / 2 * predictTime + 1e-4;
+      EXPECT_NEAR(x, simX, disTol) << "yaw " << startYaw << ", time " << predictTime;
+      EXPECT_NEAR(y, simY, disTol) << "yaw " << startYaw << ", time " << predictTime;
+      EXPECT_NEAR(angleDiff(yaw, simYaw), 0, 1e-4) << "yaw " << startYaw << ", time " << predictTime;
+      EXPECT_LE(fabs(yaw), PI + 1e-4);
+    }
+  }
+}
+
+}
+
+TEST(PathFollowerController, StraightPathIsNotLimited)
+{
+  PathFollowerParams params = curvParams();
+  EXPECT_FLOAT_EQ(curvSpeedLimit(params, straightPath(5.0)), params.maxSpeed);
+}
+
+TEST(PathFollowerController, ArcLimitsLateralAccel)
+{
+  // on the arc from the start, the limit is sqrt(maxLatAccel * radius) plus the braking
+  // allowance to the first sample
+  PathFollowerParams params = curvParams();
+  for (float radius : {0.5f, 1.0f, 2.0f, 4.0f}) {
+    for (float latAccel : {0.5f, 1.0f, 2.0f}) {
+      params.maxLatAccel = latAccel;
+      float expected = sqrt(latAccel * radius + 2.0 * params.maxAccel * params.curvSampleDis);
+      EXPECT_NEAR(curvSpeedLimit(params, arcPath(0, radius, PI / 2)), expected, 0.03 * expected)
+          << "radius " << radius << ", maxLatAccel " << latAccel;
+    }
+  }
+
+  // never above maxSpeed on a wide arc
+  params.maxLatAccel = 1.0;
+  params.maxSpeed = 1.0;
+  EXPECT_FLOAT_EQ(curvSpeedLimit(params, arcPath(0, 4.0, PI / 2)), params.maxSpeed);
+}
+
+TEST(PathFollowerController, SpeedRampsDownBeforeArc)
+{
+  // the limit at the vehicle allows braking at maxAccel to sqrt(maxLatAccel * radius) at the arc
+  PathFollowerParams params = curvParams();
+  const float radius = 0.5;
+  float lastLimit = 0;
+  for (float leadDis : {0.0f, 0.25f, 0.5f, 1.0f, 2.0f, 4.0f}) {
+    float limit = curvSpeedLimit(params, arcPath(leadDis, radius, PI / 2));
+    float expected = sqrt(params.maxLatAccel * radius + 2.0 * params.maxAccel * leadDis);
+    EXPECT_GE(limit, expected - 0.03) << "lead-in " << leadDis;
+    EXPECT_LE(limit, sqrt(expected * expected + 2.0 * params.maxAccel * params.curvSampleDis) + 0.03)
+        << "lead-in " << leadDis;
+    EXPECT_GT(limit, lastLimit) << "lead-in " << leadDis;
+    lastLimit = limit;
+  }
+}
+
+TEST(PathFollowerController, ZigZagLimitedByCorners)
+{
+  // with the middle of three samples at a corner turning by 2 * halfAng, they lie on a circle of
+  // curvature 2 * sin(halfAng) / curvSampleDis, at half of that with the corner between samples,
+  // the first corner is firstSegLength ahead
+  PathFollowerParams params = curvParams();
+  const float segLength = 1.0;
+  for (float firstSegLength : {0.1f, 0.5f, 1.0f}) {
+    float lastLimit = params.maxSpeed;
+    for (float halfAng : {0.1f, 0.3f, 0.6f, 0.9f}) {
+      float limit = curvSpeedLimit(params, zigZagPath(firstSegLength, segLength, halfAng, 6));
+      float cornerCurv = 2.0 * sin(halfAng) / params.curvSampleDis;
+      float upper = sqrt(2.0 * params.maxLatAccel / cornerCurv
+                       + 2.0 * params.maxAccel * (firstSegLength + params.curvSampleDis));
+      float lower = sqrt(params.maxLatAccel / cornerCurv
+                       + 2.0 * params.maxAccel * (firstSegLength - params.curvSampleDis));
+      EXPECT_LE(limit, upper) << "first segment " << firstSegLength << ", half angle " << halfAng;
+      EXPECT_GE(limit, lower) << "first segment " << firstSegLength << ", half angle " << halfAng;
+      EXPECT_LT(limit, lastLimit) << "first segment " << firstSegLength << ", half angle " << halfAng;
+      lastLimit = limit;
+    }
+  }
+}
+
+TEST(PathFollowerController, SpeedSettlesAtCurvLimit)
+{
+  // autonomous drive at full speed toward a tight arc, the speed ramps at maxAccel and stops at
+  // the curvature limit instead of maxSpeed
+  PathFollowerParams params = curvParams();
+  params.maxSpeed = 2.0;
+  params.dirDiffThre = 1.0;
+  params.slowDwnDisThre = 0.1;
+  PathFollowerPath path = arcPath(0.5, 0.5, PI / 2);
+
+  PathFollowerController controller;
+  controller.setParams(params);
+  float limit = controller.curvSpeedLimit(path, 0, 0);
+  ASSERT_LT(limit, params.maxSpeed - 0.5);
+
+  PathFollowerState state;
+  state.joySpeed = 1.0;
+  state.autonomyMode = true;
+  const float dt = 0.01;
+  for (int i = 0; i < 500; i++) {
+    state.time = state.odomTime = i * dt;
+    controller.step(state, path, dt);
+    EXPECT_LE(controller.vehicleSpeed(), limit + params.maxAccel * dt);
+  }
+  EXPECT_NEAR(controller.vehicleSpeed(), limit, params.maxAccel * dt);
+
+  // off by default, the same drive reaches maxSpeed
+  params.useCurvToSlow = false;
+  PathFollowerController unlimited;
+  unlimited.setParams(params);
+  for (int i = 0; i < 500; i++) {
+    state.time = state.odomTime = i * dt;
+    unlimited.step(state, path, dt);
+  }
+  EXPECT_NEAR(unlimited.vehicleSpeed(), params.maxSpeed, params.maxAccel * dt);
+}
+
+TEST(PathFollowerController, PredictionMatchesSimulatorStraight)
+{
+  expectPredictionMatchesSimulator(makeCmd(1.0, 0, 0));
+  expectPredictionMatchesSimulator(makeCmd(-0.8, 0, 0));
+  expectPredictionMatchesSimulator(makeCmd(0.5, 0.3, 0));
+  expectPredictionMatchesSimulator(makeCmd(0, -0.4, 0));
+  expectPredictionMatchesSimulator(makeCmd(0, 0, 0));
+}
+
+TEST(PathFollowerController, PredictionMatchesSimulatorRotation)
+{
+  expectPredictionMatchesSimulator(makeCmd(0, 0, 0.8));
+  expectPredictionMatchesSimulator(makeCmd(0, 0, -0.8));
+  expectPredictionMatchesSimulator(makeCmd(0, 0, 45.0 * PI / 180.0));
+  expectPredictionMatchesSimulator(makeCmd(0, 0, 3.0));
+}
+
+TEST(PathFollowerController, PredictionMatchesSimulatorCombined)
+{
+  expectPredictionMatchesSimulator(makeCmd(1.0, 0, 0.5));
+  expectPredictionMatchesSimulator(makeCmd(1.0, 0, -0.5));
+  expectPredictionMatchesSimulator(makeCmd(-0.6, 0, 0.8));
+  expectPredictionMatchesSimulator(makeCmd(1.0, 0.3, 1.5));
+  expectPredictionMatchesSimulator(makeCmd(0.4, -0.4, -2.0));
+
+  // below the 1e-4 rad turn the straight line is taken
+  expectPredictionMatchesSimulator(makeCmd(1.0, 0, 5e-5));
+}
+
+TEST(PathFollowerController, PredictionUsesLastCommand)
+{
+  // the latency compensation predicts with the command of the last step
+  PathFollowerParams params;
+  params.dirDiffThre = 1.0;
+  PathFollowerController controller;
+  controller.setParams(params);
+
+  PathFollowerState state;
+  state.vehicleYaw = 0.3;
+  state.joySpeed = 1.0;
+  state.autonomyMode = true;
+  PathFollowerPath path = arcPath(0.5, 1.0, PI / 2);
+  PathFollowerCmd cmd;
+  for (int i = 0; i < 50; i++) {
+    state.time = state.odomTime = i * 0.01;
+    cmd = controller.step(state, path, 0.01);
+  }
+  ASSERT_GT(cmd.speedX, 0.2);
+  ASSERT_GT(fabs(cmd.yawRate), 0.1);
+
+  float x = 0.2, y = 0.1, yaw = 0.3;
+  controller.predictVehiclePose(0.1, x, y, yaw);
+  float expectedX = 0.2, expectedY = 0.1, expectedYaw = 0.3;
+  PathFollowerController::predictVehiclePose(cmd, 0.1, expectedX, expectedY, expectedYaw);
+  EXPECT_FLOAT_EQ(x, expectedX);
+  EXPECT_FLOAT_EQ(y, expectedY);
+  EXPECT_FLOAT_EQ(yaw, expectedYaw);
+}
+
+TEST(PathFollowerController, SwitchesToReverseForPathBehind)
+{
+  PathFollowerParams params;
+  PathFollowerController controller;
+  controller.setParams(params);
+
+  PathFollowerState state;
+  state.joySpeed = 1.0;
+  state.autonomyMode = true;
+  PathFollowerPath ahead = straightPath(3.0);
+  PathFollowerPath behind = straightPath(3.0);
+  for (size_t i = 0; i < behind.x.size(); i++) behind.x[i] = -behind.x[i];
+
+  // forward at maxSpeed on the path ahead
+  const float dt = 0.01;
+  PathFollowerCmd cmd = runSteps(controller, state, ahead, 200, dt);
+  EXPECT_TRUE(controller.navFwd());
+  EXPECT_NEAR(cmd.speedX, params.maxSpeed, params.maxAccel * dt);
+
+  // a path behind flips to reverse, the speed ramps through zero to -maxSpeed without turning
+  controller.resetPath();
+  float lastSpeed = controller.vehicleSpeed();
+  for (int i = 0; i < 300; i++) {
+    cmd = runSteps(controller, state, behind, 1, dt);
+    EXPECT_FALSE(controller.navFwd());
+    if (lastSpeed > -params.maxSpeed + params.maxAccel * dt) {
+      EXPECT_NEAR(controller.vehicleSpeed(), lastSpeed - params.maxAccel * dt, 1e-5);
+    }
+    EXPECT_NEAR(cmd.yawRate, 0, 1e-4);
+    lastSpeed = controller.vehicleSpeed();
+  }
+  EXPECT_NEAR(cmd.speedX, -params.maxSpeed, params.maxAccel * dt);
+
+  // no switch within switchTimeThre of the start or of the last switch
+  controller.resetPath();
+  PathFollowerController quick;
+  quick.setParams(params);
+  PathFollowerState quickState;
+  quickState.joySpeed = 1.0;
+  quickState.autonomyMode = true;
+  runSteps(quick, quickState, ahead, 1, dt);
+  runSteps(quick, quickState, behind, 1, dt);
+  EXPECT_TRUE(quick.navFwd());
+  quickState.time += params.switchTimeThre;
+  runSteps(quick, quickState, behind, 1, dt);
+  EXPECT_FALSE(quick.navFwd());
+  runSteps(quick, quickState, ahead, int(params.switchTimeThre / dt) - 10, dt);
+  EXPECT_FALSE(quick.navFwd());
+  runSteps(quick, quickState, ahead, 20, dt);
+  EXPECT_TRUE(quick.navFwd());
+
+  cmd = runSteps(controller, state, ahead, 300, dt);
+  EXPECT_TRUE(controller.navFwd());
+  EXPECT_NEAR(cmd.speedX, params.maxSpeed, params.maxAccel * dt);
+}
+
+TEST(PathFollowerController, OneWayDriveTurnsInsteadOfReversing)
+{
+  PathFollowerParams params;
+  params.twoWayDrive = false;
+  PathFollowerController controller;
+  controller.setParams(params);
+
+  PathFollowerState state;
+  state.joySpeed = 1.0;
+  state.autonomyMode = true;
+  PathFollowerPath behind = straightPath(3.0);
+  for (size_t i = 0; i < behind.x.size(); i++) {
+    behind.x[i] = -behind.x[i];
+    behind.y[i] = -0.01 * i;
+  }
+
+  PathFollowerCmd cmd = runSteps(controller, state, behind, 300, 0.01);
+  EXPECT_TRUE(controller.navFwd());
+  EXPECT_FLOAT_EQ(controller.vehicleSpeed(), 0);
+  EXPECT_FLOAT_EQ(fabs(cmd.yawRate), params.maxYawRate * PI / 180.0);
+}
+
+TEST(PathFollowerController, StopsAtGoal)
+{
+  PathFollowerParams params;
+  params.maxSpeed = 2.0;
+  PathFollowerController controller;
+  controller.setParams(params);
+
+  PathFollowerState state;
+  state.joySpeed = 1.0;
+  state.autonomyMode = true;
+  const float dt = 0.01;
+  runSteps(controller, state, straightPath(5.0), 300, dt);
+  ASSERT_NEAR(controller.vehicleSpeed(), params.maxSpeed, params.maxAccel * dt);
+
+  // the goal slightly off to the side and within stopDisThre, the speed ramps down at maxAccel
+  // and the vehicle does not turn toward it
+  PathFollowerPath goal = straightPath(0.1);
+  for (size_t i = 0; i < goal.y.size(); i++) goal.y[i] = 0.5 * goal.x[i];
+  controller.resetPath();
+  float lastSpeed = controller.vehicleSpeed();
+  PathFollowerCmd cmd;
+  for (int i = 0; i < 300; i++) {
+    cmd = runSteps(controller, state, goal, 1, dt);
+    if (lastSpeed > params.maxAccel * dt) {
+      EXPECT_NEAR(controller.vehicleSpeed(), lastSpeed - params.maxAccel * dt, 1e-4);
+    } else {
+      EXPECT_LE(fabs(controller.vehicleSpeed()), params.maxAccel * dt + 1e-4);
+      EXPECT_FLOAT_EQ(cmd.speedX, 0);
+    }
+    EXPECT_FLOAT_EQ(cmd.yawRate, 0);
+    lastSpeed = controller.vehicleSpeed();
+  }
+  EXPECT_FLOAT_EQ(cmd.speedX, 0);
+  EXPECT_FLOAT_EQ(cmd.speedY, 0);
+
+  // a path of a single point stops the vehicle as well, even straight ahead
+  PathFollowerPath point;
+  point.x.push_back(2.0);
+  point.y.push_back(0);
+  cmd = runSteps(controller, state, point, 10, dt);
+  EXPECT_FLOAT_EQ(cmd.speedX, 0);
+  EXPECT_FLOAT_EQ(cmd.yawRate, 0);
+
+  // an empty path gives a zero command right away
+  runSteps(controller, state, straightPath(5.0), 300, dt);
+  cmd = runSteps(controller, state, PathFollowerPath(), 1, dt);
+  EXPECT_FLOAT_EQ(controller.vehicleSpeed(), 0);
+  EXPECT_FLOAT_EQ(cmd.speedX, 0);
+  EXPECT_FLOAT_EQ(cmd.yawRate, 0);
+}
+
+TEST(PathFollowerController, SlowsDownNearPathEnd)
+{
+  // within slowDwnDisThre of the end the speed is scaled by the distance left
+  PathFollowerParams params;
+  params.maxSpeed = 2.0;
+  params.slowDwnDisThre = 1.0;
+  const float dt = 0.01;
+  for (float length : {0.4f, 0.6f, 0.8f, 2.0f}) {
+    PathFollowerController controller;
+    controller.setParams(params);
+    PathFollowerState state;
+    state.joySpeed = 1.0;
+    state.autonomyMode = true;
+    PathFollowerCmd cmd = runSteps(controller, state, straightPath(length), 500, dt);
+    float expected = params.maxSpeed * min(length / float(params.slowDwnDisThre), 1.0f);
+    EXPECT_NEAR(cmd.speedX, expected, params.maxAccel * dt + 1e-3) << "length " << length;
+  }
+}
+
+TEST(PathFollowerController, SlowAndStopWindows)
+{
+  PathFollowerParams params;
+  params.maxSpeed = 2.0;
+  params.maxAccel = 10.0;
+  const float dt = 0.01;
+  PathFollowerPath path = straightPath(5.0);
+
+  PathFollowerController controller;
+  controller.setParams(params);
+  PathFollowerState state;
+  state.joySpeed = 1.0;
+  state.autonomyMode = true;
+  runSteps(controller, state, path, 100, dt);
+  ASSERT_NEAR(controller.vehicleSpeed(), params.maxSpeed, params.maxAccel * dt);
+
+  // slowRate1 for slowTime1, then slowRate2 for slowTime2, then back to full speed
+  state.slowInitTime = state.time;
+  runSteps(controller, state, path, int(0.9 * params.slowTime1 / dt), dt);
+  EXPECT_NEAR(controller.vehicleSpeed(), params.slowRate1 * params.maxSpeed, params.maxAccel * dt);
+  runSteps(controller, state, path, int(params.slowTime2 / dt), dt);
+  EXPECT_NEAR(controller.vehicleSpeed(), params.slowRate2 * params.maxSpeed, params.maxAccel * dt);
+  runSteps(controller, state, path, int(0.5 * params.slowTime1 / dt), dt);
+  EXPECT_NEAR(controller.vehicleSpeed(), params.maxSpeed, params.maxAccel * dt);
+
+  // stopped for stopTime
+  state.stopInitTime = state.time;
+  PathFollowerCmd cmd = runSteps(controller, state, path, 1, dt);
+  EXPECT_FLOAT_EQ(controller.vehicleSpeed(), 0);
+  EXPECT_FLOAT_EQ(cmd.speedX, 0);
+  cmd = runSteps(controller, state, path, int(0.9 * params.stopTime / dt), dt);
+  EXPECT_FLOAT_EQ(cmd.speedX, 0);
+  cmd = runSteps(controller, state, path, int(0.5 * params.stopTime / dt), dt);
+  EXPECT_NEAR(cmd.speedX, params.maxSpeed, params.maxAccel * dt);
+
+  // the safety stop bits block forward motion only
+  state.safetyStop = 1;
+  cmd = runSteps(controller, state, path, 1, dt);
+  EXPECT_FLOAT_EQ(cmd.speedX, 0);
+  state.safetyStop = 2;
+  cmd = runSteps(controller, state, path, 100, dt);
+  EXPECT_NEAR(cmd.speedX, params.maxSpeed, params.maxAccel * dt);
+}
@@ -0,0 +1,84 @@
+#include <math.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace std;
+
+namespace
+{
+
+// header words up to end_header and all values after it
+bool readPly(const string& fileName, vector<string>& header, vector<double>& values)
+{
+  FILE *filePtr = fopen(fileName.c_str(), "r");
+  if (filePtr == NULL) return false;
+
+  char str[50];
+  header.clear();
+  while (header.empty() || header.back() != "end_header") {
+    if (fscanf(filePtr, "%49s", str) != 1) {
+      fclose(filePtr);
+      return false;
+    }
+    header.push_back(str);
+  }
+
+  values.clear();
+  double value;
+  while (fscanf(filePtr, "%lf", &value) == 1) {
+    values.push_back(value);
+  }
+
+  bool status = feof(filePtr);
+  fclose(filePtr);
+  return status;
+}
+
+// the shipped files were written by path_generator.m with %f, MATLAB rounding leaves some
+// coordinates that are zero here as -0.000000, so the values are compared within the last digit
+void comparePly(const string& name)
+{
+  SCOPED_TRACE(name);
+
+  vector<string> shippedHeader, generatedHeader;
+  vector<double> shippedValues, generatedValues;
+  ASSERT_TRUE(readPly(string(SHIPPED_PATH_FOLDER) + "/" + name, shippedHeader, shippedValues));
+  ASSERT_TRUE(readPly(string(GENERATED_PATH_FOLDER) + "/" + name, generatedHeader, generatedValues));
+
+  EXPECT_EQ(shippedHeader, generatedHeader);
+  ASSERT_EQ(shippedValues.size(), generatedValues.size());
+  ASSERT_GT(shippedValues.size(), 0u);
+
+  double maxError = 0;
+  size_t maxErrorInd = 0;
+  for (size_t i = 0; i < shippedValues.size(); i++) {
+    double error = fabs(shippedValues[i] - generatedValues[i]);
+    if (error > maxError) {
+      maxError = error;
+      maxErrorInd = i;
+    }
+  }
+  EXPECT_LE(maxError, 1.5e-6) << "value " << maxErrorInd << ": " << shippedValues[maxErrorInd] << " shipped, "
+                              << generatedValues[maxErrorInd] << " generated";
+}
+
+}
+
+// pathGenerator with its defaults reproduces the shipped output of path_generator.m
+TEST(PathGenerator, MatchesShippedStartPaths)
+{
+  comparePly("startPaths.ply");
+}
+
+TEST(PathGenerator, MatchesShippedPaths)
+{
+  comparePly("paths.ply");
+}
+
+TEST(PathGenerator, MatchesShippedPathList)
+{
+  comparePly("pathList.ply");
+}
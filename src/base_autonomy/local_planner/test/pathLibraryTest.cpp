@@ -0,0 +1,198 @@
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "local_planner/pathEvaluator.h"
+#include "local_planner/pathLibrary.h"
+
+#include "testPaths.h"
+
+using namespace std;
+
+namespace
+{
+
+void evaluateCloud(const PathLibrary& pathLibrary, const pcl::PointCloud<pcl::PointXYZI>& cloud,
+                   PathEvaluator& pathEvaluator)
+{
+  PathEvaluatorParams params;
+  params.useTerrainAnalysis = true;
+  pathEvaluator.setPathLibrary(pathLibrary);
+  pathEvaluator.setParams(params);
+
+  PathEvaluatorState state;
+  state.joySpeed = 1.0;
+  PathEvaluatorResult result;
+  pathEvaluator.evaluate(cloud, state, result);
+}
+
+// a library of 3 paths in 2 groups on a 2 x 3 grid written as text, read and written back as
+// binary, the tables are then corrupted in place in copies of the file
+class SmallPathLibrary : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    char folder[] = "/tmp/pathLibraryTestXXXXXX";
+    ASSERT_TRUE(mkdtemp(folder) != NULL);
+    pathFolder = folder;
+
+    writeFile("startPaths.ply", "ply\nelement vertex 2\nend_header\n0 0 0 0\n0.1 0 0 1\n");
+    writeFile("paths.ply", "ply\nelement vertex 3\nend_header\n0 0 0 0 0\n0.1 0 0 1 1\n0.1 0.1 0 2 1\n");
+    writeFile("pathList.ply", "ply\nelement vertex 3\nend_header\n0 0 0 0 0\n0.1 0 0 1 1\n0.1 0.1 0 2 1\n");
+    writeFile("correspondences.txt", "0 0 1 -1\n1 -1\n2 2 -1\n3 0 1 2 -1\n4 -1\n5 1 -1\n");
+
+    grid.pathNum = 3;
+    grid.groupNum = 2;
+    grid.gridVoxelNumX = 2;
+    grid.gridVoxelNumY = 3;
+    grid.gridVoxelSize = 0.1;
+    grid.searchRadius = 0.1;
+    grid.gridVoxelOffsetX = 0.2;
+    grid.gridVoxelOffsetY = 0.2;
+
+    PathLibrary pathLibrary;
+    ASSERT_TRUE(pathLibrary.readText(pathFolder, grid)) << pathLibrary.error();
+    ASSERT_TRUE(pathLibrary.writeBinary(pathFolder + "/pathLibrary.bin"));
+
+    FILE *filePtr = fopen((pathFolder + "/pathLibrary.bin").c_str(), "rb");
+    ASSERT_TRUE(filePtr != NULL);
+    int c;
+    while ((c = fgetc(filePtr)) != EOF) binary.push_back(c);
+    fclose(filePtr);
+
+    offsetsPos = sizeof(PathLibraryHeader) + sizeof(PathLibraryPoint) * (pathLibrary.startPathPointNum() +
+                 pathLibrary.pathPointNum() + pathLibrary.pathNum());
+    pathsPos = offsetsPos + sizeof(int32_t) * (pathLibrary.gridVoxelNum() + 1);
+    pathListPos = offsetsPos - sizeof(PathLibraryPoint) * pathLibrary.pathNum();
+  }
+
+  void TearDown() override
+  {
+    string command = "rm -rf " + pathFolder;
+    EXPECT_EQ(system(command.c_str()), 0);
+  }
+
+  void writeFile(const string& name, const string& content)
+  {
+    FILE *filePtr = fopen((pathFolder + "/" + name).c_str(), "w");
+    ASSERT_TRUE(filePtr != NULL);
+    fputs(content.c_str(), filePtr);
+    fclose(filePtr);
+  }
+
+  // a copy of the binary library with the int32 at byte pos replaced
+  bool readPatched(size_t pos, int32_t value, PathLibrary& pathLibrary)
+  {
+    vector<char> patched = binary;
+    memcpy(&patched[pos], &value, sizeof(value));
+
+    string fileName = pathFolder + "/patched.bin";
+    FILE *filePtr = fopen(fileName.c_str(), "wb");
+    if (filePtr == NULL) return false;
+    fwrite(patched.data(), 1, patched.size(), filePtr);
+    fclose(filePtr);
+
+    return pathLibrary.readBinary(fileName);
+  }
+
+  string pathFolder;
+  PathLibraryGrid grid;
+  vector<char> binary;
+  size_t offsetsPos, pathsPos, pathListPos;
+};
+
+}
+
+TEST_F(SmallPathLibrary, ReadsIntactBinary)
+{
+  PathLibrary pathLibrary;
+  ASSERT_TRUE(pathLibrary.readBinary(pathFolder + "/pathLibrary.bin")) << pathLibrary.error();
+  EXPECT_TRUE(pathLibrary.matches(grid));
+  EXPECT_EQ(pathLibrary.correspondenceNum(), 7);
+  EXPECT_EQ(pathLibrary.correspondenceOffsets()[3], 3);
+  EXPECT_EQ(pathLibrary.correspondencePaths()[5], 2);
+}
+
+TEST_F(SmallPathLibrary, RejectsDecreasingOffsets)
+{
+  PathLibrary pathLibrary;
+  EXPECT_FALSE(readPatched(offsetsPos + 2 * sizeof(int32_t), 0, pathLibrary));
+  EXPECT_FALSE(pathLibrary.mapped());
+}
+
+TEST_F(SmallPathLibrary, RejectsOffsetsOutOfRange)
+{
+  PathLibrary pathLibrary;
+  EXPECT_FALSE(readPatched(offsetsPos + 4 * sizeof(int32_t), 100, pathLibrary));
+  EXPECT_FALSE(readPatched(offsetsPos + 1 * sizeof(int32_t), -1, pathLibrary));
+}
+
+TEST_F(SmallPathLibrary, RejectsPathIDsOutOfRange)
+{
+  PathLibrary pathLibrary;
+  EXPECT_FALSE(readPatched(pathsPos + 3 * sizeof(int32_t), 3, pathLibrary));
+  EXPECT_FALSE(readPatched(pathsPos, -1, pathLibrary));
+}
+
+TEST_F(SmallPathLibrary, RejectsGroupIDsOutOfRange)
+{
+  PathLibrary pathLibrary;
+  size_t groupIDPos = pathListPos + sizeof(PathLibraryPoint) + offsetof(PathLibraryPoint, groupID);
+  EXPECT_FALSE(readPatched(groupIDPos, 2, pathLibrary));
+  EXPECT_FALSE(readPatched(groupIDPos, -1, pathLibrary));
+  EXPECT_TRUE(readPatched(groupIDPos, 0, pathLibrary)) << pathLibrary.error();
+}
+
+// the library converted by pathLibraryConverter holds the same tables as the text files and
+// gives the same evaluation
+TEST(PathLibrary, BinaryMatchesText)
+{
+  PathLibrary textLibrary, binaryLibrary;
+  ASSERT_TRUE(textLibrary.readText(testPathFolder, PathLibraryGrid())) << textLibrary.error();
+  ASSERT_TRUE(binaryLibrary.readBinary(testPathFolder + "/pathLibrary.bin")) << binaryLibrary.error();
+  EXPECT_FALSE(textLibrary.mapped());
+  EXPECT_TRUE(binaryLibrary.mapped());
+  ASSERT_TRUE(binaryLibrary.matches(PathLibraryGrid()));
+
+  ASSERT_EQ(textLibrary.startPathPointNum(), binaryLibrary.startPathPointNum());
+  ASSERT_EQ(textLibrary.pathPointNum(), binaryLibrary.pathPointNum());
+  ASSERT_EQ(textLibrary.correspondenceNum(), binaryLibrary.correspondenceNum());
+  EXPECT_EQ(memcmp(textLibrary.paths(), binaryLibrary.paths(), sizeof(PathLibraryPoint) * textLibrary.pathPointNum()), 0);
+  EXPECT_EQ(memcmp(textLibrary.correspondenceOffsets(), binaryLibrary.correspondenceOffsets(),
+                   sizeof(int32_t) * (textLibrary.gridVoxelNum() + 1)), 0);
+  EXPECT_EQ(memcmp(textLibrary.correspondencePaths(), binaryLibrary.correspondencePaths(),
+                   sizeof(int32_t) * textLibrary.correspondenceNum()), 0);
+
+  pcl::PointCloud<pcl::PointXYZI> cloud;
+  randomObstacleCloud(2000, 1, 3.5, cloud);
+
+  PathEvaluator textEvaluator, binaryEvaluator;
+  evaluateCloud(textLibrary, cloud, textEvaluator);
+  evaluateCloud(binaryLibrary, cloud, binaryEvaluator);
+
+  const vector<int>& textClearPaths = textEvaluator.clearPaths();
+  const vector<int>& binaryClearPaths = binaryEvaluator.clearPaths();
+  const vector<float>& textPenalties = textEvaluator.pathPenalties();
+  const vector<float>& binaryPenalties = binaryEvaluator.pathPenalties();
+  ASSERT_EQ(textClearPaths.size(), binaryClearPaths.size());
+  ASSERT_EQ(textPenalties.size(), binaryPenalties.size());
+
+  int blockedNum = 0, penalizedNum = 0;
+  for (size_t i = 0; i < textClearPaths.size(); i++) {
+    ASSERT_EQ(textClearPaths[i], binaryClearPaths[i]) << "path " << i;
+    ASSERT_EQ(textPenalties[i], binaryPenalties[i]) << "path " << i;
+    if (textClearPaths[i] > 0) blockedNum++;
+    if (textPenalties[i] > 0) penalizedNum++;
+  }
+
+  // the cloud has to exercise both tables
+  EXPECT_GT(blockedNum, 0);
+  EXPECT_GT(penalizedNum, 0);
+}
@@ -0,0 +1,124 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "local_planner/pathSetSelector.h"
+
+using namespace std;
+
+namespace
+{
+
+// three sets as in the launch files, shortest to longest
+void addThreePathSets(double density1, double density2, PathSetSelector& selector)
+{
+  PathSetSelectorParams params;
+  params.speedHys = 0.1;
+  params.densityHys = 0.2;
+  selector.setParams(params);
+  selector.addPathSet(0, 0);
+  selector.addPathSet(0.5, density1);
+  selector.addPathSet(1.0, density2);
+}
+
+// set switches over a sequence of selections
+int countSwitches(PathSetSelector& selector, const vector<float>& speeds, const vector<float>& densities)
+{
+  int switchNum = 0;
+  int lastID = selector.selected();
+  for (size_t i = 0; i < speeds.size(); i++) {
+    int id = selector.select(speeds[i], densities[i]);
+    if (id != lastID) switchNum++;
+    lastID = id;
+  }
+  return switchNum;
+}
+
+}
+
+TEST(PathSetSelector, NoPathSets)
+{
+  PathSetSelector selector;
+  EXPECT_EQ(selector.select(2.0, 0), 0);
+}
+
+// without obstacles the speed alone picks the set, a longer set is taken above its minimum speed
+// plus speedHys and left below the minimum minus speedHys
+TEST(PathSetSelector, SwitchesBySpeed)
+{
+  PathSetSelector selector;
+  addThreePathSets(1e6, 1e6, selector);
+
+  EXPECT_EQ(selector.select(0.3, 0), 0);
+  EXPECT_EQ(selector.select(0.55, 0), 0);
+  EXPECT_EQ(selector.select(0.62, 0), 1);
+  EXPECT_EQ(selector.select(1.05, 0), 1);
+  EXPECT_EQ(selector.select(1.12, 0), 2);
+  EXPECT_EQ(selector.select(0.95, 0), 2);
+  EXPECT_EQ(selector.select(0.88, 0), 1);
+  EXPECT_EQ(selector.select(0.45, 0), 1);
+  EXPECT_EQ(selector.select(0.38, 0), 0);
+
+  // a jump skips the sets in between both ways
+  EXPECT_EQ(selector.select(1.5, 0), 2);
+  EXPECT_EQ(selector.select(0.1, 0), 0);
+}
+
+// at full speed the obstacle density steps back to shorter sets, the current set is kept up to
+// its maximum density plus densityHys and a longer one is taken below its maximum minus densityHys
+TEST(PathSetSelector, DensityOverridesSpeed)
+{
+  PathSetSelector selector;
+  addThreePathSets(2.0, 1.0, selector);
+
+  EXPECT_EQ(selector.select(2.0, 0.5), 2);
+  EXPECT_EQ(selector.select(2.0, 1.1), 2);
+  EXPECT_EQ(selector.select(2.0, 1.3), 1);
+  EXPECT_EQ(selector.select(2.0, 2.3), 1);
+  EXPECT_EQ(selector.select(2.0, 2.5), 0);
+  EXPECT_EQ(selector.select(2.0, 1.7), 0);
+  EXPECT_EQ(selector.select(2.0, 1.5), 1);
+  EXPECT_EQ(selector.select(2.0, 0.9), 1);
+  EXPECT_EQ(selector.select(2.0, 0.7), 2);
+
+  // dense enough for every longer set, the speed does not matter
+  EXPECT_EQ(selector.select(2.0, 10.0), 0);
+  EXPECT_EQ(selector.select(0.7, 10.0), 0);
+}
+
+// a speed or density oscillating within the margins around a threshold keeps whichever set is
+// selected, one leaving the margins switches every time
+TEST(PathSetSelector, NoFlappingAtThresholds)
+{
+  vector<float> speeds, densities;
+  for (int i = 0; i < 100; i++) {
+    speeds.push_back(i % 2 == 0 ? 1.05 : 0.95);
+    densities.push_back(0);
+  }
+  for (int startID = 1; startID <= 2; startID++) {
+    PathSetSelector selector;
+    addThreePathSets(1e6, 1e6, selector);
+    ASSERT_EQ(selector.select(startID == 1 ? 0.7 : 1.5, 0), startID);
+    EXPECT_EQ(countSwitches(selector, speeds, densities), 0) << "start set " << startID;
+  }
+
+  for (int i = 0; i < 100; i++) {
+    speeds[i] = 2.0;
+    densities[i] = i % 2 == 0 ? 1.1 : 0.9;
+  }
+  for (int startID = 1; startID <= 2; startID++) {
+    PathSetSelector selector;
+    addThreePathSets(2.0, 1.0, selector);
+    ASSERT_EQ(selector.select(2.0, startID == 1 ? 1.5 : 0.5), startID);
+    EXPECT_EQ(countSwitches(selector, speeds, densities), 0) << "start set " << startID;
+  }
+
+  for (int i = 0; i < 100; i++) {
+    speeds[i] = i % 2 == 0 ? 1.15 : 0.85;
+    densities[i] = 0;
+  }
+  PathSetSelector selector;
+  addThreePathSets(1e6, 1e6, selector);
+  selector.select(0.7, 0);
+  EXPECT_EQ(countSwitches(selector, speeds, densities), 100);
+}
@@ -0,0 +1,68 @@
+#ifndef TEST_PATHS_H
+#define TEST_PATHS_H
+
+#include <math.h>
+#include <random>
+#include <string>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include "local_planner/pathLibrary.h"
+
+// the shipped paths with the correspondences written by pathGenerator and their binary library,
+// set up by the local_planner_test_paths target
+const std::string testPathFolder = TEST_PATH_FOLDER;
+
+// vehicle frame points within range of the vehicle, the intensity is the height above the
+// ground as terrain analysis gives it, from the ground up to well above obstacleHeightThre
+inline void randomObstacleCloud(int pointNum, unsigned seed, float range, pcl::PointCloud<pcl::PointXYZI>& cloud)
+{
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<float> coordDist(-range, range);
+  std::uniform_real_distribution<float> heightDist(0, 0.5);
+
+  cloud.clear();
+  pcl::PointXYZI point;
+  while (int(cloud.points.size()) < pointNum) {
+    point.x = coordDist(generator);
+    point.y = coordDist(generator);
+    point.z = 0;
+    point.intensity = heightDist(generator);
+    if (sqrt(point.x * point.x + point.y * point.y) < range) {
+      cloud.push_back(point);
+    }
+  }
+}
+
+// two walls along x at y = +/- halfWidth from -length to length and, with boxX > 0, a 0.4 m box
+// centered at boxX, boxY, all points blocking, pointStep in m
+inline void corridorCloud(float halfWidth, float length, float boxX, float boxY, float pointStep,
+                          pcl::PointCloud<pcl::PointXYZI>& cloud)
+{
+  cloud.clear();
+  pcl::PointXYZI point;
+  point.z = 0;
+  point.intensity = 1.0;
+  int pointNum = int(2 * length / pointStep) + 1;
+  for (int i = 0; i < pointNum; i++) {
+    point.x = -length + i * pointStep;
+    point.y = halfWidth;
+    cloud.push_back(point);
+    point.y = -halfWidth;
+    cloud.push_back(point);
+  }
+
+  if (boxX > 0) {
+    int boxPointNum = int(0.4 / pointStep) + 1;
+    for (int i = 0; i < boxPointNum; i++) {
+      for (int j = 0; j < boxPointNum; j++) {
+        point.x = boxX - 0.2 + i * pointStep;
+        point.y = boxY - 0.2 + j * pointStep;
+        cloud.push_back(point);
+      }
+    }
+  }
+}
+
+#endif
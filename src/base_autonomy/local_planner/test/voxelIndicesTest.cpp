@@ -0,0 +1,143 @@
+#include <math.h>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "local_planner/pathLibrary.h"
+#include "local_planner/voxelIndices.h"
+
+using namespace std;
+
+namespace
+{
+
+const double PI = 3.1415926;
+
+VoxelIndexGrid shippedGrid()
+{
+  PathLibraryGrid pathGrid;
+  VoxelIndexGrid grid;
+  grid.gridVoxelNumX = pathGrid.gridVoxelNumX;
+  grid.gridVoxelNumY = pathGrid.gridVoxelNumY;
+  grid.gridVoxelSize = pathGrid.gridVoxelSize;
+  grid.searchRadius = pathGrid.searchRadius;
+  grid.gridVoxelOffsetX = pathGrid.gridVoxelOffsetX;
+  grid.gridVoxelOffsetY = pathGrid.gridVoxelOffsetY;
+  return grid;
+}
+
+// random points over and around the grid, points on the voxel boundaries of the unrotated grid
+// and just off them, and points beyond every edge, an odd count so the scalar tails run
+void testPoints(const VoxelIndexGrid& grid, vector<float>& xs, vector<float>& ys)
+{
+  std::mt19937 generator(1);
+  std::uniform_real_distribution<float> xDist(-1.0, grid.gridVoxelOffsetX + 1.0);
+  std::uniform_real_distribution<float> yDist(-grid.gridVoxelOffsetY - 1.0, grid.gridVoxelOffsetY + 1.0);
+  for (int i = 0; i < 2000; i++) {
+    xs.push_back(xDist(generator));
+    ys.push_back(yDist(generator));
+  }
+
+  for (int indX = -2; indX <= grid.gridVoxelNumX + 2; indX += 3) {
+    float x = grid.gridVoxelOffsetX + grid.gridVoxelSize / 2 - grid.gridVoxelSize * indX;
+    float scaleY = x / grid.gridVoxelOffsetX + grid.searchRadius / grid.gridVoxelOffsetY
+                   * (grid.gridVoxelOffsetX - x) / grid.gridVoxelOffsetX;
+    for (int indY = -2; indY <= grid.gridVoxelNumY + 2; indY += 7) {
+      float y = scaleY * (grid.gridVoxelOffsetY + grid.gridVoxelSize / 2 - grid.gridVoxelSize * indY);
+      for (int k = -1; k <= 1; k++) {
+        xs.push_back(nextafterf(x, k < 0 ? -INFINITY : INFINITY));
+        ys.push_back(k == 0 ? y : nextafterf(y, k < 0 ? -INFINITY : INFINITY));
+        xs.push_back(x);
+        ys.push_back(y);
+      }
+    }
+  }
+
+  float edgePoints[][2] = {{-20.0, 0}, {20.0, 0}, {1.0, -20.0}, {1.0, 20.0}, {0, 0}, {grid.gridVoxelOffsetX, 0},
+                           {-grid.gridVoxelSize / 2, 0}, {0, grid.gridVoxelOffsetY}};
+  for (size_t i = 0; i < sizeof(edgePoints) / sizeof(edgePoints[0]); i++) {
+    xs.push_back(edgePoints[i][0]);
+    ys.push_back(edgePoints[i][1]);
+  }
+
+  if (xs.size() % 2 == 0) {
+    xs.push_back(1.0);
+    ys.push_back(0.1);
+  }
+}
+
+// indices of one version against the scalar ones in every rotation direction
+template <typename VoxelIndicesFunc>
+void compareWithScalar(VoxelIndicesFunc voxelIndicesFunc)
+{
+  VoxelIndexGrid grid = shippedGrid();
+  vector<float> xs, ys;
+  testPoints(grid, xs, ys);
+  int pointNum = xs.size();
+
+  int insideNum = 0, outsideNum = 0;
+  vector<int> scalarInds(pointNum), inds(pointNum);
+  for (int rotDir = 0; rotDir < 36; rotDir++) {
+    float rotAng = (10.0 * rotDir - 180.0) * PI / 180;
+    float cosRotAng = cos(rotAng);
+    float sinRotAng = sin(rotAng);
+
+    voxelIndicesScalar(grid, cosRotAng, sinRotAng, xs.data(), ys.data(), pointNum, scalarInds.data());
+    voxelIndicesFunc(grid, cosRotAng, sinRotAng, xs.data(), ys.data(), pointNum, inds.data());
+    for (int i = 0; i < pointNum; i++) {
+      ASSERT_EQ(scalarInds[i], inds[i]) << "rotDir " << rotDir << ", point " << i << " at " << xs[i] << ", " << ys[i];
+      if (scalarInds[i] >= 0) insideNum++;
+      else outsideNum++;
+    }
+  }
+  EXPECT_GT(insideNum, 0);
+  EXPECT_GT(outsideNum, 0);
+}
+
+}
+
+// the indices follow voxel boundaries both ways, just before and after them
+TEST(VoxelIndices, ScalarFollowsGrid)
+{
+  VoxelIndexGrid grid = shippedGrid();
+  float x = grid.gridVoxelOffsetX + grid.gridVoxelSize / 2 - grid.gridVoxelSize * 40;
+  float xs[3] = {nextafterf(x, INFINITY), x + grid.gridVoxelSize / 2, nextafterf(x, -INFINITY)};
+  float ys[3] = {0, 0, 0};
+  int inds[3];
+  voxelIndicesScalar(grid, 1.0, 0, xs, ys, 3, inds);
+
+  int indY = grid.gridVoxelNumY / 2;
+  EXPECT_EQ(inds[0], grid.gridVoxelNumY * 39 + indY);
+  EXPECT_EQ(inds[1], grid.gridVoxelNumY * 39 + indY);
+  EXPECT_EQ(inds[2], grid.gridVoxelNumY * 40 + indY);
+
+  xs[0] = grid.gridVoxelOffsetX + 2 * grid.gridVoxelSize;
+  xs[1] = -grid.gridVoxelSize * grid.gridVoxelNumX;
+  xs[2] = 1.0;
+  ys[2] = 10.0;
+  voxelIndicesScalar(grid, 1.0, 0, xs, ys, 3, inds);
+  EXPECT_EQ(inds[0], -1);
+  EXPECT_EQ(inds[1], -1);
+  EXPECT_EQ(inds[2], -1);
+}
+
+TEST(VoxelIndices, DispatchMatchesScalar)
+{
+  compareWithScalar(voxelIndices);
+}
+
+#ifdef VOXEL_INDICES_X86
+TEST(VoxelIndices, Sse2MatchesScalar)
+{
+  compareWithScalar(voxelIndicesSse2);
+}
+
+TEST(VoxelIndices, Avx2MatchesScalar)
+{
+  if (!voxelIndicesAvx2Supported()) {
+    GTEST_SKIP() << "the CPU has no AVX2";
+  }
+  compareWithScalar(voxelIndicesAvx2);
+}
+#endif
@@ -0,0 +1,23 @@
+#ifndef SENSOR_SCAN_TRANSFORM_H
+#define SENSOR_SCAN_TRANSFORM_H
+
+#include "nav_msgs/msg/odometry.hpp"
+#include "sensor_msgs/msg/point_cloud2.hpp"
+#include "tf2/LinearMath/Transform.h"
+
+// the registered scan brought from the map frame into the sensor frame, transformToSensor is the
+// inverse of the sensor pose in the map frame, the points are read from the x, y and z fields of
+// scanIn in place and written to scanOut in the pcl::PointXYZ layout, x, y, z and a padding float
+// per point, as pcl::toROSMsg() lays them out, every point is carried over, NaN ones included, so
+// is_dense is that of scanIn, returns false and leaves scanOut empty when scanIn has no float x, y
+// or z field, is not in the byte order of the host or its data is shorter than its layout
+bool transformScanToSensor(const sensor_msgs::msg::PointCloud2& scanIn, const tf2::Transform& transformToSensor,
+                           sensor_msgs::msg::PointCloud2& scanOut);
+
+// odometry at ratio of the way from odometry1 to odometry2, linear in the position and spherical
+// linear in the orientation, the header and twist are those of the nearer one, ratio is clamped to
+// [0, 1] and the ends return the odometry as is
+void interpolateOdometry(const nav_msgs::msg::Odometry& odometry1, const nav_msgs::msg::Odometry& odometry2,
+                         double ratio, nav_msgs::msg::Odometry& odometryOut);
+
+#endif
@@ -0,0 +1,184 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "sensor_msgs/msg/point_cloud2.hpp"
+#include "tf2/LinearMath/Quaternion.h"
+#include "tf2/LinearMath/Transform.h"
+
+#include <pcl_conversions/pcl_conversions.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include "sensor_scan_generation/sensorScanTransform.h"
+
+using namespace std;
+
+// transforms a synthetic registered scan into the sensor frame with transformScanToSensor() and
+// with the pcl round trip sensorScanGeneration used before, fromROSMsg(), the inverse transform
+// taken per point and toROSMsg(), checks that both give the same message and reports the latency
+// and throughput of each
+void printUsage()
+{
+  printf("Usage: sensorScanBenchmark [options]\n");
+  printf("Options:\n");
+  printf("  --points N             points per scan (100000)\n");
+  printf("  --repeat N             scans per run (100)\n");
+}
+
+double percentile(const vector<double>& sorted, double ratio)
+{
+  if (sorted.empty()) return 0;
+  int ind = int(ratio * (sorted.size() - 1) + 0.5);
+  return sorted[ind];
+}
+
+void transformScanByPcl(const sensor_msgs::msg::PointCloud2& scanIn, const tf2::Transform& transformToMap,
+                        sensor_msgs::msg::PointCloud2& scanOut)
+{
+  pcl::PointCloud<pcl::PointXYZ> laserCloudIn, laserCLoudInSensorFrame;
+  pcl::fromROSMsg(scanIn, laserCloudIn);
+
+  int laserCloudInNum = laserCloudIn.points.size();
+  pcl::PointXYZ p1;
+  tf2::Vector3 vec;
+  for (int i = 0; i < laserCloudInNum; i++) {
+    p1 = laserCloudIn.points[i];
+    vec.setX(p1.x);
+    vec.setY(p1.y);
+    vec.setZ(p1.z);
+
+    vec = transformToMap.inverse() * vec;
+
+    p1.x = vec.x();
+    p1.y = vec.y();
+    p1.z = vec.z();
+
+    laserCLoudInSensorFrame.points.push_back(p1);
+  }
+
+  pcl::toROSMsg(laserCLoudInSensorFrame, scanOut);
+}
+
+// a registered scan in the pcl::PointXYZI layout, points on a sphere around the sensor
+void buildScan(int pointNum, const tf2::Transform& transformToMap, sensor_msgs::msg::PointCloud2& scan)
+{
+  pcl::PointCloud<pcl::PointXYZI> cloud;
+  cloud.points.resize(pointNum);
+  for (int i = 0; i < pointNum; i++) {
+    float azimuth = 0.01 * i;
+    float elevation = 0.5 * sin(0.0007 * i);
+    float range = 1.0 + 20.0 * (i % 97) / 97.0;
+    tf2::Vector3 vec(range * cos(elevation) * cos(azimuth), range * cos(elevation) * sin(azimuth),
+                     range * sin(elevation));
+    vec = transformToMap * vec;
+
+    cloud.points[i].x = vec.x();
+    cloud.points[i].y = vec.y();
+    cloud.points[i].z = vec.z();
+    cloud.points[i].intensity = i % 256;
+  }
+  cloud.width = pointNum;
+  cloud.height = 1;
+
+  pcl::toROSMsg(cloud, scan);
+}
+
+void runScans(const sensor_msgs::msg::PointCloud2& scanIn, const tf2::Transform& transformToMap, int repeatNum,
+              bool usePcl, sensor_msgs::msg::PointCloud2& scanOut, const char* name)
+{
+  vector<double> scanTimes;
+  scanTimes.reserve(repeatNum);
+  double totalTime = 0;
+
+  for (int i = 0; i < repeatNum; i++) {
+    chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+
+    if (usePcl) {
+      transformScanByPcl(scanIn, transformToMap, scanOut);
+    } else {
+      sensor_msgs::msg::PointCloud2 scanData;
+      transformScanToSensor(scanIn, transformToMap.inverse(), scanData);
+      scanOut = move(scanData);
+    }
+
+    double scanTime = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    scanTimes.push_back(scanTime);
+    totalTime += scanTime;
+  }
+
+  sort(scanTimes.begin(), scanTimes.end());
+  printf("%s latency ms: mean %.3f, p50 %.3f, p90 %.3f, max %.3f, Mpoints/s %.1f\n", name,
+         1000.0 * totalTime / repeatNum, 1000.0 * percentile(scanTimes, 0.5), 1000.0 * percentile(scanTimes, 0.9),
+         1000.0 * scanTimes.back(), 1.0e-6 * scanIn.width * scanIn.height * repeatNum / totalTime);
+}
+
+bool sameScan(const sensor_msgs::msg::PointCloud2& scan1, const sensor_msgs::msg::PointCloud2& scan2)
+{
+  if (scan1.height != scan2.height || scan1.width != scan2.width || scan1.point_step != scan2.point_step ||
+      scan1.row_step != scan2.row_step || scan1.is_bigendian != scan2.is_bigendian ||
+      scan1.is_dense != scan2.is_dense || scan1.fields.size() != scan2.fields.size() ||
+      scan1.data.size() != scan2.data.size()) {
+    return false;
+  }
+
+  for (size_t i = 0; i < scan1.fields.size(); i++) {
+    if (scan1.fields[i].name != scan2.fields[i].name || scan1.fields[i].offset != scan2.fields[i].offset ||
+        scan1.fields[i].datatype != scan2.fields[i].datatype || scan1.fields[i].count != scan2.fields[i].count) {
+      return false;
+    }
+  }
+
+  return scan1.data.empty() || memcmp(scan1.data.data(), scan2.data.data(), scan1.data.size()) == 0;
+}
+
+int main(int argc, char** argv)
+{
+  int pointNum = 100000;
+  int repeatNum = 100;
+
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg.compare(0, 2, "--") == 0 && i + 1 < argc) {
+      const char *val = argv[++i];
+      if (arg == "--points") pointNum = atoi(val);
+      else if (arg == "--repeat") repeatNum = atoi(val);
+      else {
+        printUsage();
+        return 1;
+      }
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  if (pointNum < 0 || repeatNum <= 0) {
+    printUsage();
+    return 1;
+  }
+
+  tf2::Quaternion rotation;
+  rotation.setRPY(0.05, -0.1, 2.3);
+  tf2::Transform transformToMap(rotation, tf2::Vector3(12.3, -4.5, 0.8));
+
+  sensor_msgs::msg::PointCloud2 scanIn, scanOutPcl, scanOut;
+  buildScan(pointNum, transformToMap, scanIn);
+  printf("scan points: %d, point step: %d\n", pointNum, int(scanIn.point_step));
+
+  runScans(scanIn, transformToMap, repeatNum, true, scanOutPcl, "pcl round trip");
+  runScans(scanIn, transformToMap, repeatNum, false, scanOut, "in place      ");
+
+  if (!sameScan(scanOutPcl, scanOut)) {
+    printf("output differs from the pcl round trip\n");
+    return 1;
+  }
+  printf("output matches the pcl round trip\n");
+
+  return 0;
+}
@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <iostream>
+#include <deque>
 #include "rclcpp/rclcpp.hpp"
 
 #include "nav_msgs/msg/odometry.hpp"
@@ -12,21 +13,10 @@
 #include "tf2_ros/transform_broadcaster.h"
 #include "tf2_geometry_msgs/tf2_geometry_msgs.hpp"
 
-#include <pcl_conversions/pcl_conversions.h>
-#include <pcl/point_cloud.h>
-#include <pcl/point_types.h>
-
-#include "message_filters/subscriber.h"
-#include "message_filters/synchronizer.h"
-#include "message_filters/sync_policies/approximate_time.h"
-#include "rmw/types.h"
-#include "rmw/qos_profiles.h"
+#include "sensor_scan_generation/sensorScanTransform.h"
 
 using namespace std;
 
-pcl::PointCloud<pcl::PointXYZ>::Ptr laserCloudIn(new pcl::PointCloud<pcl::PointXYZ>());
-pcl::PointCloud<pcl::PointXYZ>::Ptr laserCLoudInSensorFrame(new pcl::PointCloud<pcl::PointXYZ>());
-
 double robotX = 0;
 double robotY = 0;
 double robotZ = 0;
@@ -44,40 +34,53 @@ geometry_msgs::msg::TransformStamped transformTfGeom ;
 unique_ptr<tf2_ros::TransformBroadcaster> tfBroadcasterPointer;
 shared_ptr<rclcpp::Publisher<sensor_msgs::msg::PointCloud2>> pubLaserCloud;
 
-void laserCloudAndOdometryHandler(const nav_msgs::msg::Odometry::ConstSharedPtr odometry,
-                                  const sensor_msgs::msg::PointCloud2::ConstSharedPtr laserCloud2)
+const int odomHistoryNum = 400;
+nav_msgs::msg::Odometry odomHistory[odomHistoryNum];
+double odomHistoryTime[odomHistoryNum] = {0};
+int odomHistoryInd = -1;
+int odomHistorySize = 0;
+
+// scans newer than the latest odometry wait for the odometry past them, at most laserCloudQueueNum
+// of them, beyond that the oldest goes out with the latest odometry
+const int laserCloudQueueNum = 5;
+deque<sensor_msgs::msg::PointCloud2::ConstSharedPtr> laserCloudQueue;
+
+// odometry at the given time interpolated from the odometry history, times beyond either end of
+// the history take the odometry at that end
+void odomHistoryPose(double time, nav_msgs::msg::Odometry& odometry)
 {
-  laserCloudIn->clear();
-  laserCLoudInSensorFrame->clear();
+  // walk back from the newest entry to the pair bracketing the time
+  int laterInd = odomHistoryInd;
+  int earlierInd = laterInd;
+  for (int i = 1; i < odomHistorySize; i++) {
+    if (odomHistoryTime[earlierInd] <= time) break;
+    laterInd = earlierInd;
+    earlierInd = (odomHistoryInd - i + odomHistoryNum) % odomHistoryNum;
+  }
 
-  pcl::fromROSMsg(*laserCloud2, *laserCloudIn);
+  double ratio = 0;
+  if (odomHistoryTime[earlierInd] < time && odomHistoryTime[laterInd] > odomHistoryTime[earlierInd]) {
+    ratio = (time - odomHistoryTime[earlierInd]) / (odomHistoryTime[laterInd] - odomHistoryTime[earlierInd]);
+  }
 
-  odometryIn = *odometry;
+  interpolateOdometry(odomHistory[earlierInd], odomHistory[laterInd], ratio, odometry);
+}
+
+void laserCloudAndOdometryHandler(const nav_msgs::msg::Odometry& odometry,
+                                  const sensor_msgs::msg::PointCloud2::ConstSharedPtr laserCloud2)
+{
+  odometryIn = odometry;
 
   transformToMap.setOrigin(
       tf2::Vector3(odometryIn.pose.pose.position.x, odometryIn.pose.pose.position.y, odometryIn.pose.pose.position.z));
   transformToMap.setRotation(tf2::Quaternion(odometryIn.pose.pose.orientation.x, odometryIn.pose.pose.orientation.y,
                                             odometryIn.pose.pose.orientation.z, odometryIn.pose.pose.orientation.w));
 
-  int laserCloudInNum = laserCloudIn->points.size();
-
-  pcl::PointXYZ p1;
-  tf2::Vector3 vec;
-
-  for (int i = 0; i < laserCloudInNum; i++)
-  {
-    p1 = laserCloudIn->points[i];
-    vec.setX(p1.x);
-    vec.setY(p1.y);
-    vec.setZ(p1.z);
-
-    vec = transformToMap.inverse() * vec;
-
-    p1.x = vec.x();
-    p1.y = vec.y();
-    p1.z = vec.z();
-
-    laserCLoudInSensorFrame->points.push_back(p1);
+  // the inverse is taken once per scan and the points are transformed straight from the message buffer
+  sensor_msgs::msg::PointCloud2 scan_data;
+  if (!transformScanToSensor(*laserCloud2, transformToMap.inverse(), scan_data)) {
+    RCLCPP_WARN(rclcpp::get_logger("sensor_scan"), "Cannot read the points of the registered scan, skipped.");
+    return;
   }
 
   odometryIn.header.stamp = laserCloud2->header.stamp;
@@ -91,44 +94,63 @@ void laserCloudAndOdometryHandler(const nav_msgs::msg::Odometry::ConstSharedPtr
   transformTfGeom.child_frame_id = "sensor_at_scan";
   tfBroadcasterPointer->sendTransform(transformTfGeom);
 
-  sensor_msgs::msg::PointCloud2 scan_data;
-  pcl::toROSMsg(*laserCLoudInSensorFrame, scan_data);
   scan_data.header.stamp = laserCloud2->header.stamp;
   scan_data.header.frame_id = "sensor_at_scan";
   pubLaserCloud->publish(scan_data);
 }
 
+void laserCloudAtScanTime(const sensor_msgs::msg::PointCloud2::ConstSharedPtr laserCloud2)
+{
+  nav_msgs::msg::Odometry odometry;
+  odomHistoryPose(rclcpp::Time(laserCloud2->header.stamp).seconds(), odometry);
+  laserCloudAndOdometryHandler(odometry, laserCloud2);
+}
+
+void odometryHandler(const nav_msgs::msg::Odometry::ConstSharedPtr odometry)
+{
+  double odomTime = rclcpp::Time(odometry->header.stamp).seconds();
+  if (odomHistorySize > 0) {
+    if (odomTime == odomHistoryTime[odomHistoryInd]) return;
+    // time went back, e.g. a replay restarted, the history starts over
+    if (odomTime < odomHistoryTime[odomHistoryInd]) odomHistorySize = 0;
+  }
+
+  odomHistoryInd = (odomHistoryInd + 1) % odomHistoryNum;
+  odomHistory[odomHistoryInd] = *odometry;
+  odomHistoryTime[odomHistoryInd] = odomTime;
+  if (odomHistorySize < odomHistoryNum) odomHistorySize++;
+
+  while (!laserCloudQueue.empty() && rclcpp::Time(laserCloudQueue.front()->header.stamp).seconds() <= odomTime) {
+    laserCloudAtScanTime(laserCloudQueue.front());
+    laserCloudQueue.pop_front();
+  }
+}
+
+void laserCloudHandler(const sensor_msgs::msg::PointCloud2::ConstSharedPtr laserCloud2)
+{
+  if (odomHistorySize > 0 && laserCloudQueue.empty() &&
+      rclcpp::Time(laserCloud2->header.stamp).seconds() <= odomHistoryTime[odomHistoryInd]) {
+    laserCloudAtScanTime(laserCloud2);
+    return;
+  }
+
+  laserCloudQueue.push_back(laserCloud2);
+  while (int(laserCloudQueue.size()) > laserCloudQueueNum) {
+    if (odomHistorySize > 0) laserCloudAtScanTime(laserCloudQueue.front());
+    laserCloudQueue.pop_front();
+  }
+}
+
 int main(int argc, char** argv)
 {
   rclcpp::init(argc, argv);
   auto nh = rclcpp::Node::make_shared("sensor_scan");
 
-  // ROS message filters
-  message_filters::Subscriber<nav_msgs::msg::Odometry> subOdometry;
-  message_filters::Subscriber<sensor_msgs::msg::PointCloud2> subLaserCloud;
-
-  typedef message_filters::sync_policies::ApproximateTime<nav_msgs::msg::Odometry, sensor_msgs::msg::PointCloud2> syncPolicy;
-  typedef message_filters::Synchronizer<syncPolicy> Sync;
-  boost::shared_ptr<Sync> sync_;
-  
-  // Define qos_profile as the pre-defined rmw_qos_profile_sensor_data, but with depth equal to 1.
-  rmw_qos_profile_t qos_profile=
-  {
-    RMW_QOS_POLICY_HISTORY_KEEP_LAST,
-    1,
-    RMW_QOS_POLICY_RELIABILITY_BEST_EFFORT,
-    RMW_QOS_POLICY_DURABILITY_VOLATILE,
-    RMW_QOS_DEADLINE_DEFAULT,
-    RMW_QOS_LIFESPAN_DEFAULT,
-    RMW_QOS_POLICY_LIVELINESS_SYSTEM_DEFAULT,
-    RMW_QOS_LIVELINESS_LEASE_DURATION_DEFAULT,
-    false
-  };
-
-  subOdometry.subscribe(nh, "/state_estimation", qos_profile);
-  subLaserCloud.subscribe(nh, "/registered_scan", qos_profile);
-  sync_.reset(new Sync(syncPolicy(100), subOdometry, subLaserCloud));
-  sync_->registerCallback(std::bind(laserCloudAndOdometryHandler, placeholders::_1, placeholders::_2));
+  // sensor data QoS with depth 1 for the scans, the odometry keeps a few more to fill the history
+  auto subOdometry = nh->create_subscription<nav_msgs::msg::Odometry>(
+      "/state_estimation", rclcpp::SensorDataQoS().keep_last(10), odometryHandler);
+  auto subLaserCloud = nh->create_subscription<sensor_msgs::msg::PointCloud2>(
+      "/registered_scan", rclcpp::SensorDataQoS().keep_last(1), laserCloudHandler);
   pubOdometryPointer = nh->create_publisher<nav_msgs::msg::Odometry>("/state_estimation_at_scan", 5);
 
   tfBroadcasterPointer = std::make_unique<tf2_ros::TransformBroadcaster>(*nh);
@@ -0,0 +1,128 @@
+#include <string.h>
+#include <string>
+
+#include "tf2/LinearMath/Quaternion.h"
+
+#include "sensor_scan_generation/sensorScanTransform.h"
+
+using namespace std;
+
+// byte offset of a float field, -1 if the cloud does not have it
+static int floatFieldOffset(const sensor_msgs::msg::PointCloud2& cloud, const string& name)
+{
+  for (const sensor_msgs::msg::PointField& field : cloud.fields) {
+    if (field.name == name) {
+      if (field.datatype != sensor_msgs::msg::PointField::FLOAT32) return -1;
+      return field.offset;
+    }
+  }
+  return -1;
+}
+
+// the fields are read and written in the byte order of the host
+static bool hostIsBigEndian()
+{
+  const uint16_t word = 1;
+  uint8_t firstByte;
+  memcpy(&firstByte, &word, 1);
+  return firstByte == 0;
+}
+
+bool transformScanToSensor(const sensor_msgs::msg::PointCloud2& scanIn, const tf2::Transform& transformToSensor,
+                           sensor_msgs::msg::PointCloud2& scanOut)
+{
+  const int pointStepOut = 4 * sizeof(float);
+  const char* fieldNames[3] = {"x", "y", "z"};
+
+  scanOut.height = 1;
+  scanOut.width = 0;
+  scanOut.fields.resize(3);
+  for (int i = 0; i < 3; i++) {
+    scanOut.fields[i].name = fieldNames[i];
+    scanOut.fields[i].offset = i * sizeof(float);
+    scanOut.fields[i].datatype = sensor_msgs::msg::PointField::FLOAT32;
+    scanOut.fields[i].count = 1;
+  }
+  scanOut.is_bigendian = hostIsBigEndian();
+  scanOut.point_step = pointStepOut;
+  scanOut.row_step = 0;
+  scanOut.is_dense = scanIn.is_dense;
+  scanOut.data.clear();
+
+  if (bool(scanIn.is_bigendian) != scanOut.is_bigendian) return false;
+
+  int offsetX = floatFieldOffset(scanIn, "x");
+  int offsetY = floatFieldOffset(scanIn, "y");
+  int offsetZ = floatFieldOffset(scanIn, "z");
+  if (offsetX < 0 || offsetY < 0 || offsetZ < 0) return false;
+
+  int scanInWidth = scanIn.width;
+  int scanInHeight = scanIn.height;
+  int scanInNum = scanInWidth * scanInHeight;
+  if (scanInNum == 0) return true;
+  if (scanIn.data.size() < size_t(scanInHeight - 1) * scanIn.row_step + size_t(scanInWidth) * scanIn.point_step) {
+    return false;
+  }
+
+  scanOut.width = scanInNum;
+  scanOut.row_step = pointStepOut * scanInNum;
+  scanOut.data.resize(scanOut.row_step);
+
+  float pointOut[4] = {0, 0, 0, 1.0};
+  tf2::Vector3 vec;
+  uint8_t* outPtr = scanOut.data.data();
+  for (int row = 0; row < scanInHeight; row++) {
+    const uint8_t* inPtr = scanIn.data.data() + size_t(row) * scanIn.row_step;
+    for (int col = 0; col < scanInWidth; col++) {
+      float x, y, z;
+      memcpy(&x, inPtr + offsetX, sizeof(float));
+      memcpy(&y, inPtr + offsetY, sizeof(float));
+      memcpy(&z, inPtr + offsetZ, sizeof(float));
+
+      vec.setValue(x, y, z);
+      vec = transformToSensor * vec;
+
+      pointOut[0] = vec.x();
+      pointOut[1] = vec.y();
+      pointOut[2] = vec.z();
+      memcpy(outPtr, pointOut, pointStepOut);
+
+      inPtr += scanIn.point_step;
+      outPtr += pointStepOut;
+    }
+  }
+
+  return true;
+}
+
+void interpolateOdometry(const nav_msgs::msg::Odometry& odometry1, const nav_msgs::msg::Odometry& odometry2,
+                         double ratio, nav_msgs::msg::Odometry& odometryOut)
+{
+  if (ratio <= 0) {
+    odometryOut = odometry1;
+    return;
+  } else if (ratio >= 1.0) {
+    odometryOut = odometry2;
+    return;
+  }
+
+  odometryOut = ratio < 0.5 ? odometry1 : odometry2;
+
+  const geometry_msgs::msg::Point& position1 = odometry1.pose.pose.position;
+  const geometry_msgs::msg::Point& position2 = odometry2.pose.pose.position;
+  odometryOut.pose.pose.position.x = position1.x + ratio * (position2.x - position1.x);
+  odometryOut.pose.pose.position.y = position1.y + ratio * (position2.y - position1.y);
+  odometryOut.pose.pose.position.z = position1.z + ratio * (position2.z - position1.z);
+
+  // slerp() takes the shorter way around
+  const geometry_msgs::msg::Quaternion& geoQuat1 = odometry1.pose.pose.orientation;
+  const geometry_msgs::msg::Quaternion& geoQuat2 = odometry2.pose.pose.orientation;
+  tf2::Quaternion quat1(geoQuat1.x, geoQuat1.y, geoQuat1.z, geoQuat1.w);
+  tf2::Quaternion quat2(geoQuat2.x, geoQuat2.y, geoQuat2.z, geoQuat2.w);
+  tf2::Quaternion quat = quat1.slerp(quat2, ratio);
+
+  odometryOut.pose.pose.orientation.x = quat.x();
+  odometryOut.pose.pose.orientation.y = quat.y();
+  odometryOut.pose.pose.orientation.z = quat.z();
+  odometryOut.pose.pose.orientation.w = quat.w();
+}
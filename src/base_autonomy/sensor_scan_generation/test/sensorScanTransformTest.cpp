@@ -0,0 +1,298 @@
+#include <math.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "nav_msgs/msg/odometry.hpp"
+#include "sensor_msgs/msg/point_cloud2.hpp"
+#include "tf2/LinearMath/Quaternion.h"
+#include "tf2/LinearMath/Transform.h"
+
+#include <pcl_conversions/pcl_conversions.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include "sensor_scan_generation/sensorScanTransform.h"
+
+using namespace std;
+
+namespace
+{
+
+// byte layout of a registered scan, float x, y, z and intensity fields at their offsets, rows of
+// width points followed by rowPadding bytes
+struct ScanLayout
+{
+  int offsetX, offsetY, offsetZ, offsetIntensity;
+  int pointStep;
+  int rowPadding;
+};
+
+// points on a sphere around the sensor in the map frame, every nanEvery-th point NaN if not 0
+void buildScan(const ScanLayout& layout, int width, int height, const tf2::Transform& transformToMap, int nanEvery,
+               sensor_msgs::msg::PointCloud2& scan)
+{
+  const char* fieldNames[4] = {"x", "y", "z", "intensity"};
+  const int fieldOffsets[4] = {layout.offsetX, layout.offsetY, layout.offsetZ, layout.offsetIntensity};
+
+  scan.height = height;
+  scan.width = width;
+  scan.fields.resize(4);
+  for (int i = 0; i < 4; i++) {
+    scan.fields[i].name = fieldNames[i];
+    scan.fields[i].offset = fieldOffsets[i];
+    scan.fields[i].datatype = sensor_msgs::msg::PointField::FLOAT32;
+    scan.fields[i].count = 1;
+  }
+  scan.is_bigendian = false;
+  scan.point_step = layout.pointStep;
+  scan.row_step = layout.pointStep * width + layout.rowPadding;
+  scan.is_dense = nanEvery == 0;
+  scan.data.assign(size_t(scan.row_step) * height, 0xab);
+
+  for (int i = 0; i < width * height; i++) {
+    float azimuth = 0.01 * i;
+    float elevation = 0.5 * sin(0.0007 * i);
+    float range = 1.0 + 20.0 * (i % 97) / 97.0;
+    tf2::Vector3 vec(range * cos(elevation) * cos(azimuth), range * cos(elevation) * sin(azimuth),
+                     range * sin(elevation));
+    vec = transformToMap * vec;
+
+    float point[4] = {float(vec.x()), float(vec.y()), float(vec.z()), float(i % 256)};
+    if (nanEvery > 0 && i % nanEvery == 0) point[0] = point[1] = point[2] = NAN;
+
+    uint8_t* pointPtr = scan.data.data() + size_t(i / width) * scan.row_step + size_t(i % width) * layout.pointStep;
+    for (int j = 0; j < 4; j++) memcpy(pointPtr + fieldOffsets[j], &point[j], sizeof(float));
+  }
+}
+
+// the pcl round trip sensorScanGeneration used before, fromROSMsg(), the inverse transform taken
+// per point and toROSMsg()
+void transformScanByPcl(const sensor_msgs::msg::PointCloud2& scanIn, const tf2::Transform& transformToMap,
+                        sensor_msgs::msg::PointCloud2& scanOut)
+{
+  pcl::PointCloud<pcl::PointXYZ> laserCloudIn, laserCLoudInSensorFrame;
+  pcl::fromROSMsg(scanIn, laserCloudIn);
+
+  int laserCloudInNum = laserCloudIn.points.size();
+  pcl::PointXYZ p1;
+  tf2::Vector3 vec;
+  for (int i = 0; i < laserCloudInNum; i++) {
+    p1 = laserCloudIn.points[i];
+    vec.setX(p1.x);
+    vec.setY(p1.y);
+    vec.setZ(p1.z);
+
+    vec = transformToMap.inverse() * vec;
+
+    p1.x = vec.x();
+    p1.y = vec.y();
+    p1.z = vec.z();
+
+    laserCLoudInSensorFrame.points.push_back(p1);
+  }
+
+  pcl::toROSMsg(laserCLoudInSensorFrame, scanOut);
+}
+
+// the same layout and bytes, is_dense is left to the caller as the round trip always sets it
+void expectSameScan(const sensor_msgs::msg::PointCloud2& scan, const sensor_msgs::msg::PointCloud2& refScan)
+{
+  EXPECT_EQ(scan.height, refScan.height);
+  EXPECT_EQ(scan.width, refScan.width);
+  EXPECT_EQ(scan.point_step, refScan.point_step);
+  EXPECT_EQ(scan.row_step, refScan.row_step);
+  EXPECT_EQ(scan.is_bigendian, refScan.is_bigendian);
+  ASSERT_EQ(scan.fields.size(), refScan.fields.size());
+  for (size_t i = 0; i < refScan.fields.size(); i++) {
+    EXPECT_EQ(scan.fields[i].name, refScan.fields[i].name);
+    EXPECT_EQ(scan.fields[i].offset, refScan.fields[i].offset);
+    EXPECT_EQ(scan.fields[i].datatype, refScan.fields[i].datatype);
+    EXPECT_EQ(scan.fields[i].count, refScan.fields[i].count);
+  }
+  ASSERT_EQ(scan.data.size(), refScan.data.size());
+  for (size_t i = 0; i < refScan.data.size(); i++) {
+    ASSERT_EQ(scan.data[i], refScan.data[i]) << "byte " << i;
+  }
+}
+
+tf2::Transform sensorPose(double roll, double pitch, double yaw, double x, double y, double z)
+{
+  tf2::Quaternion rotation;
+  rotation.setRPY(roll, pitch, yaw);
+  return tf2::Transform(rotation, tf2::Vector3(x, y, z));
+}
+
+const ScanLayout pclPointXYZILayout = {0, 4, 8, 16, 32, 0};
+
+// a sensor turning at rotRate about a fixed axis from a start orientation with yaw near pi, so the
+// yaw wraps around, while moving at a constant velocity, the quaternion is negated when flip is set
+const double rotRate = 3.0;
+const tf2::Vector3 rotAxis(0.2, -0.3, 1.0);
+
+tf2::Quaternion motionRotation(double time)
+{
+  tf2::Quaternion rotation0;
+  rotation0.setRPY(0.1, -0.05, 2.9);
+  return rotation0 * tf2::Quaternion(rotAxis, rotRate * time);
+}
+
+void motionOdometry(double time, bool flip, nav_msgs::msg::Odometry& odometry)
+{
+  odometry.header.stamp.sec = int(floor(time));
+  odometry.header.stamp.nanosec = int((time - floor(time)) * 1.0e9);
+  odometry.pose.pose.position.x = 1.0 + 2.0 * time;
+  odometry.pose.pose.position.y = -3.0 - 0.5 * time;
+  odometry.pose.pose.position.z = 0.75 + 0.1 * time;
+
+  tf2::Quaternion rotation = motionRotation(time);
+  if (flip) rotation = -rotation;
+  odometry.pose.pose.orientation.x = rotation.x();
+  odometry.pose.pose.orientation.y = rotation.y();
+  odometry.pose.pose.orientation.z = rotation.z();
+  odometry.pose.pose.orientation.w = rotation.w();
+
+  odometry.twist.twist.linear.x = time;
+}
+
+// orientation of the odometry the same rotation as the quaternion, either sign
+void expectSameRotation(const nav_msgs::msg::Odometry& odometry, const tf2::Quaternion& rotation)
+{
+  const geometry_msgs::msg::Quaternion& geoQuat = odometry.pose.pose.orientation;
+  double sign = geoQuat.x * rotation.x() + geoQuat.y * rotation.y() + geoQuat.z * rotation.z() +
+                geoQuat.w * rotation.w() < 0 ? -1.0 : 1.0;
+  EXPECT_NEAR(geoQuat.x, sign * rotation.x(), 1e-12);
+  EXPECT_NEAR(geoQuat.y, sign * rotation.y(), 1e-12);
+  EXPECT_NEAR(geoQuat.z, sign * rotation.z(), 1e-12);
+  EXPECT_NEAR(geoQuat.w, sign * rotation.w(), 1e-12);
+}
+
+}
+
+TEST(SensorScanTransform, MatchesPclRoundTrip)
+{
+  // the pcl::PointXYZI layout of the registered scan, a packed one with the intensity first and an
+  // organized one with padding after each row
+  const ScanLayout layouts[] = {pclPointXYZILayout, {4, 8, 12, 0, 16, 0}, {0, 4, 8, 12, 20, 12}};
+  const int widths[] = {5000, 3001, 250};
+  const int heights[] = {1, 1, 16};
+  const tf2::Transform transformsToMap[] = {sensorPose(0.05, -0.1, 2.3, 12.3, -4.5, 0.8),
+                                            sensorPose(-0.3, 0.2, -3.0, -250.0, 1000.0, -3.5)};
+
+  for (int i = 0; i < 3; i++) {
+    for (const tf2::Transform& transformToMap : transformsToMap) {
+      SCOPED_TRACE("layout " + to_string(i));
+      sensor_msgs::msg::PointCloud2 scanIn, scanOut, refScanOut;
+      buildScan(layouts[i], widths[i], heights[i], transformToMap, 0, scanIn);
+
+      EXPECT_TRUE(transformScanToSensor(scanIn, transformToMap.inverse(), scanOut));
+      transformScanByPcl(scanIn, transformToMap, refScanOut);
+      expectSameScan(scanOut, refScanOut);
+      EXPECT_EQ(scanOut.is_dense, refScanOut.is_dense);
+    }
+  }
+}
+
+TEST(SensorScanTransform, KeepsNanPointsAndIsDense)
+{
+  // NaN points are carried over as the round trip carries them, and the scan stays marked as
+  // having them
+  tf2::Transform transformToMap = sensorPose(0.05, -0.1, 2.3, 12.3, -4.5, 0.8);
+  sensor_msgs::msg::PointCloud2 scanIn, scanOut, refScanOut;
+  buildScan(pclPointXYZILayout, 1000, 1, transformToMap, 7, scanIn);
+
+  EXPECT_TRUE(transformScanToSensor(scanIn, transformToMap.inverse(), scanOut));
+  transformScanByPcl(scanIn, transformToMap, refScanOut);
+  expectSameScan(scanOut, refScanOut);
+  EXPECT_FALSE(scanOut.is_dense);
+
+  for (int i = 0; i < 1000; i++) {
+    float x;
+    memcpy(&x, scanOut.data.data() + i * scanOut.point_step, sizeof(float));
+    EXPECT_EQ(bool(isnan(x)), i % 7 == 0) << "point " << i;
+  }
+}
+
+TEST(SensorScanTransform, EmptyScan)
+{
+  tf2::Transform transformToMap = sensorPose(0, 0, 1.0, 1.0, 2.0, 0.5);
+  sensor_msgs::msg::PointCloud2 scanIn, scanOut, refScanOut;
+  buildScan(pclPointXYZILayout, 0, 1, transformToMap, 0, scanIn);
+
+  EXPECT_TRUE(transformScanToSensor(scanIn, transformToMap.inverse(), scanOut));
+  transformScanByPcl(scanIn, transformToMap, refScanOut);
+  expectSameScan(scanOut, refScanOut);
+}
+
+TEST(SensorScanTransform, RejectsUnreadableScans)
+{
+  tf2::Transform transformToMap = sensorPose(0, 0, 1.0, 1.0, 2.0, 0.5);
+  sensor_msgs::msg::PointCloud2 scan;
+  buildScan(pclPointXYZILayout, 100, 1, transformToMap, 0, scan);
+
+  vector<sensor_msgs::msg::PointCloud2> scansIn(4, scan);
+  scansIn[0].fields[2].name = "w";
+  scansIn[1].fields[0].datatype = sensor_msgs::msg::PointField::FLOAT64;
+  scansIn[2].data.pop_back();
+  scansIn[3].is_bigendian = !scan.is_bigendian;
+
+  for (size_t i = 0; i < scansIn.size(); i++) {
+    SCOPED_TRACE("scan " + to_string(i));
+    sensor_msgs::msg::PointCloud2 scanOut = scan;
+    EXPECT_FALSE(transformScanToSensor(scansIn[i], transformToMap.inverse(), scanOut));
+    EXPECT_EQ(scanOut.width, 0u);
+    EXPECT_TRUE(scanOut.data.empty());
+  }
+}
+
+TEST(InterpolateOdometry, ConstantRateRotation)
+{
+  // odometry every 0.05 s, 0.15 rad apart, the interpolated pose is the motion at the time in
+  // between, with the quaternion of every other odometry negated
+  const double odomInterval = 0.05;
+  for (int i = 0; i < 40; i++) {
+    double time1 = odomInterval * i, time2 = odomInterval * (i + 1);
+    nav_msgs::msg::Odometry odometry1, odometry2, odometry;
+    motionOdometry(time1, i % 2 == 1, odometry1);
+    motionOdometry(time2, i % 2 == 0, odometry2);
+
+    for (int j = 0; j <= 10; j++) {
+      double ratio = 0.1 * j;
+      double time = time1 + ratio * (time2 - time1);
+      SCOPED_TRACE("time " + to_string(time));
+      interpolateOdometry(odometry1, odometry2, ratio, odometry);
+
+      nav_msgs::msg::Odometry refOdometry;
+      motionOdometry(time, false, refOdometry);
+      EXPECT_NEAR(odometry.pose.pose.position.x, refOdometry.pose.pose.position.x, 1e-12);
+      EXPECT_NEAR(odometry.pose.pose.position.y, refOdometry.pose.pose.position.y, 1e-12);
+      EXPECT_NEAR(odometry.pose.pose.position.z, refOdometry.pose.pose.position.z, 1e-12);
+      expectSameRotation(odometry, motionRotation(time));
+
+      // the stamp and twist are those of the nearer odometry
+      const nav_msgs::msg::Odometry& nearOdometry = ratio < 0.5 ? odometry1 : odometry2;
+      EXPECT_EQ(odometry.header.stamp.sec, nearOdometry.header.stamp.sec);
+      EXPECT_EQ(odometry.header.stamp.nanosec, nearOdometry.header.stamp.nanosec);
+      EXPECT_EQ(odometry.twist.twist.linear.x, nearOdometry.twist.twist.linear.x);
+    }
+  }
+}
+
+TEST(InterpolateOdometry, RatioBeyondEnds)
+{
+  nav_msgs::msg::Odometry odometry1, odometry2, odometry;
+  motionOdometry(0.5, false, odometry1);
+  motionOdometry(0.55, true, odometry2);
+
+  interpolateOdometry(odometry1, odometry2, -0.5, odometry);
+  EXPECT_EQ(odometry.pose.pose.position.x, odometry1.pose.pose.position.x);
+  EXPECT_EQ(odometry.pose.pose.orientation.w, odometry1.pose.pose.orientation.w);
+  EXPECT_EQ(odometry.header.stamp.nanosec, odometry1.header.stamp.nanosec);
+
+  interpolateOdometry(odometry1, odometry2, 1.5, odometry);
+  EXPECT_EQ(odometry.pose.pose.position.x, odometry2.pose.pose.position.x);
+  EXPECT_EQ(odometry.pose.pose.orientation.w, odometry2.pose.pose.orientation.w);
+  EXPECT_EQ(odometry.header.stamp.nanosec, odometry2.header.stamp.nanosec);
+}
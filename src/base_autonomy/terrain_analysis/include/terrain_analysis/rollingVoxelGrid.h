@@ -0,0 +1,58 @@
+#ifndef ROLLING_VOXEL_GRID_H
+#define ROLLING_VOXEL_GRID_H
+
+#include <vector>
+
+// square grid of cells following the vehicle, cells are addressed by indX, indY in 0 to width - 1
+// relative to the current window, or by the flat index width * indX + indY, the window is a ring
+// over the storage so moving it by one cell only advances the origin, the caller clears the row
+// or column that enters while every other cell keeps its contents in place
+template <typename T>
+class RollingVoxelGrid
+{
+public:
+  explicit RollingVoxelGrid(int width)
+    : gridWidth(width), originX(0), originY(0), cells(width * width)
+  {
+  }
+
+  int width() const { return gridWidth; }
+  int size() const { return gridWidth * gridWidth; }
+
+  T& at(int indX, int indY) { return cells[storageIndex(indX, indY)]; }
+  const T& at(int indX, int indY) const { return cells[storageIndex(indX, indY)]; }
+
+  T& operator[](int ind) { return at(ind / gridWidth, ind % gridWidth); }
+  const T& operator[](int ind) const { return at(ind / gridWidth, ind % gridWidth); }
+
+  // move the window one cell toward -x (dir < 0) or +x (dir > 0), the cells leaving on one side
+  // enter on the other as row 0 or row width - 1 with their old contents
+  void shiftX(int dir)
+  {
+    if (dir < 0) originX = originX > 0 ? originX - 1 : gridWidth - 1;
+    else if (dir > 0) originX = originX < gridWidth - 1 ? originX + 1 : 0;
+  }
+
+  void shiftY(int dir)
+  {
+    if (dir < 0) originY = originY > 0 ? originY - 1 : gridWidth - 1;
+    else if (dir > 0) originY = originY < gridWidth - 1 ? originY + 1 : 0;
+  }
+
+private:
+  int storageIndex(int indX, int indY) const
+  {
+    int x = indX + originX;
+    if (x >= gridWidth) x -= gridWidth;
+    int y = indY + originY;
+    if (y >= gridWidth) y -= gridWidth;
+    return gridWidth * x + y;
+  }
+
+  int gridWidth;
+  int originX;
+  int originY;
+  std::vector<T> cells;
+};
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef TERRAIN_ANALYSIS_NODE_H
+#define TERRAIN_ANALYSIS_NODE_H
+
+#include "rclcpp/rclcpp.hpp"
+
+#include "nav_msgs/msg/odometry.hpp"
+#include "nav_msgs/msg/occupancy_grid.hpp"
+#include "sensor_msgs/msg/point_cloud2.hpp"
+#include <sensor_msgs/msg/joy.hpp>
+#include <std_msgs/msg/float32.hpp>
+#include <std_msgs/msg/float32_multi_array.hpp>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include "terrain_analysis/terrainExtAnalysis.h"
+#include "terrain_analysis/terrainLocalAnalysis.h"
+#include "terrain_analysis/terrainVoxelMap.h"
+
+namespace terrain_analysis
+{
+
+// terrainAnalysis as a node, run by the terrainAnalysis executable or loaded as a component next to
+// localPlanner, messages are taken and /terrain_map is published as unique_ptr so it is moved rather
+// than copied with intra-process comms, and the scans are processed on a 100 Hz timer
+class TerrainAnalysisNode : public rclcpp::Node
+{
+public:
+  explicit TerrainAnalysisNode(const rclcpp::NodeOptions& options);
+
+private:
+  void odometryHandler(nav_msgs::msg::Odometry::UniquePtr odom);
+  void laserCloudHandler(sensor_msgs::msg::PointCloud2::UniquePtr laserCloud2);
+  void joystickHandler(sensor_msgs::msg::Joy::UniquePtr joy);
+  void clearingHandler(std_msgs::msg::Float32::UniquePtr dis);
+  void extClearingHandler(std_msgs::msg::Float32::UniquePtr dis);
+  void analysisCycle();
+
+  double scanVoxelSize = 0.05;
+  double decayTime = 2.0;
+  double noDecayDis = 4.0;
+  double clearingDis = 8.0;
+  bool clearingCloud = false;
+  bool useSorting = true;
+  double quantileZ = 0.25;
+  bool considerDrop = false;
+  bool limitGroundLift = false;
+  double maxGroundLift = 0.15;
+  bool clearDyObs = false;
+  double minDyObsDis = 0.3;
+  double minDyObsAngle = 0;
+  double minDyObsRelZ = -0.5;
+  double absDyObsRelZThre = 0.2;
+  double minDyObsVFOV = -16.0;
+  double maxDyObsVFOV = 16.0;
+  int minDyObsPointNum = 1;
+  bool noDataObstacle = false;
+  int noDataBlockSkipNum = 0;
+  int minBlockPointNum = 10;
+  double maxElevBelowVeh = -0.6;
+  double noDataAreaMinX = 0.3;
+  double noDataAreaMaxX = 1.8;
+  double noDataAreaMinY = -0.9;
+  double noDataAreaMaxY = 0.9;
+  double vehicleHeight = 1.5;
+  int voxelPointUpdateThre = 100;
+  double voxelTimeUpdateThre = 2.0;
+  double minRelZ = -1.5;
+  double maxRelZ = 0.2;
+  double disRatioZ = 0.2;
+  int threadNum = 1;
+  bool publishElevGrid = false;
+  double elevGridObsThre = 0.15;
+
+  // terrain analysis in extended scale as a second level on the same scans, settings follow the
+  // terrainAnalysisExt parameters
+  bool useExtLevel = false;
+  double extScanVoxelSize = 0.1;
+  double extDecayTime = 10.0;
+  double extNoDecayDis = 0;
+  double extClearingDis = 30.0;
+  bool extClearingCloud = false;
+  bool extUseSorting = false;
+  double extQuantileZ = 0.25;
+  double extVehicleHeight = 1.5;
+  int extVoxelPointUpdateThre = 100;
+  double extVoxelTimeUpdateThre = 2.0;
+  double extLowerBoundZ = -1.5;
+  double extUpperBoundZ = 1.0;
+  double extDisRatioZ = 0.1;
+  bool extCheckTerrainConn = true;
+  double extTerrainUnderVehicle = -0.75;
+  double extTerrainConnThre = 0.5;
+  double extCeilingFilteringThre = 2.0;
+  double extLocalTerrainMapRadius = 4.0;
+  bool extUseMultiLayer = false;
+  int extMaxLayerNum = 3;
+  double extLayerGapThre = 0.3;
+  double extLayerClearance = 0.6;
+
+  pcl::PointCloud<pcl::PointXYZI>::Ptr laserCloud;
+  pcl::PointCloud<pcl::PointXYZI>::Ptr laserCloudCrop;
+  pcl::PointCloud<pcl::PointXYZI>::Ptr terrainCloud;
+  pcl::PointCloud<pcl::PointXYZI>::Ptr terrainCloudElev;
+  pcl::PointCloud<pcl::PointXYZI>::Ptr extLaserCloudCrop;
+  pcl::PointCloud<pcl::PointXYZI>::Ptr extTerrainCloud;
+  pcl::PointCloud<pcl::PointXYZI>::Ptr extTerrainCloudElev;
+
+  TerrainVoxelMap terrainVoxelMap;
+  TerrainVoxelMap extTerrainVoxelMap;
+  TerrainLocalAnalysis terrainLocalAnalysis;
+  TerrainExtAnalysis terrainExtAnalysis;
+
+  double laserCloudTime = 0;
+  bool newlaserCloud = false;
+
+  double systemInitTime = 0;
+  bool systemInited = false;
+  int noDataInited = 0;
+
+  float vehicleRoll = 0, vehiclePitch = 0, vehicleYaw = 0;
+  float vehicleX = 0, vehicleY = 0, vehicleZ = 0;
+  float vehicleXRec = 0, vehicleYRec = 0;
+
+  rclcpp::Subscription<nav_msgs::msg::Odometry>::SharedPtr subOdometry;
+  rclcpp::Subscription<sensor_msgs::msg::PointCloud2>::SharedPtr subLaserCloud;
+  rclcpp::Subscription<sensor_msgs::msg::Joy>::SharedPtr subJoystick;
+  rclcpp::Subscription<std_msgs::msg::Float32>::SharedPtr subClearing;
+  rclcpp::Subscription<std_msgs::msg::Float32>::SharedPtr subExtClearing;
+  rclcpp::Publisher<sensor_msgs::msg::PointCloud2>::SharedPtr pubLaserCloud;
+  rclcpp::Publisher<nav_msgs::msg::OccupancyGrid>::SharedPtr pubTerrainGrid;
+  rclcpp::Publisher<std_msgs::msg::Float32MultiArray>::SharedPtr pubTerrainGridLayers;
+  rclcpp::Publisher<sensor_msgs::msg::PointCloud2>::SharedPtr pubExtTerrainCloud;
+  rclcpp::TimerBase::SharedPtr analysisTimer;
+};
+
+}
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef TERRAIN_EXT_ANALYSIS_H
+#define TERRAIN_EXT_ANALYSIS_H
+
+#include <vector>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+// settings of the terrain analysis in extended scale, names and defaults follow the
+// terrainAnalysisExt parameters
+struct TerrainExtParams
+{
+  float planarVoxelSize = 0.4;
+  int planarVoxelWidth = 101;
+  bool useSorting = false;
+  double quantileZ = 0.25;
+  double vehicleHeight = 1.5;
+  double lowerBoundZ = -1.5;
+  double upperBoundZ = 1.0;
+  double disRatioZ = 0.1;
+  bool checkTerrainConn = true;
+  double terrainUnderVehicle = -0.75;
+  double terrainConnThre = 0.5;
+  double ceilingFilteringThre = 2.0;
+  double localTerrainMapRadius = 4.0;
+  bool useMultiLayer = false;
+  int maxLayerNum = 3;
+  double layerGapThre = 0.3;
+  double layerClearance = 0.6;
+};
+
+// ground elevation on planar voxels around the vehicle, with the voxels not connected to the one
+// under the vehicle left out when checkTerrainConn is set, the search from that voxel steps up to
+// 10 voxels to observed voxels whose elevations differ by less than terrainConnThre, and a voxel
+// first found from one more than ceilingFilteringThre above or below it is left out as ceiling, the
+// output is the terrain cloud beyond localTerrainMapRadius with the height above the ground as
+// intensity, and the local terrain map within it as is
+
+// with useMultiLayer, the point elevations of a planar voxel are split into up to maxLayerNum
+// height intervals where they are more than layerGapThre apart, the interval nearest to the
+// ground under the vehicle is the ground of the voxel, points below it are left out, and so are
+// points of the intervals above it when the gap up to them leaves layerClearance, i.e. the
+// vehicle fits under them as under a table, a bridge or a flight of stairs
+class TerrainExtAnalysis
+{
+public:
+  explicit TerrainExtAnalysis(const TerrainExtParams& params = TerrainExtParams());
+
+  void setParams(const TerrainExtParams& params);
+  const TerrainExtParams& params() const { return extParams; }
+
+  void compute(const pcl::PointCloud<pcl::PointXYZI>& terrainCloud,
+               const pcl::PointCloud<pcl::PointXYZI>& terrainCloudLocal, float vehicleX, float vehicleY,
+               float vehicleZ, pcl::PointCloud<pcl::PointXYZI>& terrainCloudElev);
+
+private:
+  float planarVoxelLayerGround(int ind, float footElev);
+  void labelTerrainConn(float vehicleZ);
+  int findConnRoot(int ind);
+
+  TerrainExtParams extParams;
+  int planarVoxelHalfWidth;
+  int planarVoxelNum;
+
+  std::vector<float> planarVoxelElev;
+  std::vector<int> planarVoxelConn;
+  std::vector<std::vector<float>> planarPointElev;
+
+  // height intervals of the planar voxels, maxLayerNum per voxel from the lowest, and the point
+  // elevations kept for each voxel in multi-layer mode
+  std::vector<int> planarVoxelLayerNum;
+  std::vector<float> planarVoxelLayerLow;
+  std::vector<float> planarVoxelLayerHigh;
+  std::vector<float> planarVoxelLayerElev;
+  std::vector<float> planarVoxelKeepMin;
+  std::vector<float> planarVoxelKeepMax;
+
+  // union-find over the planar voxels, a set is rooted at its lowest index, the set of the voxel
+  // under the vehicle with its lowest elevation within reach along each row, and the search queue
+  // that cuts the ceiling out of it, voxels are only appended
+  std::vector<int> planarVoxelParent;
+  std::vector<char> planarVoxelInSet;
+  std::vector<float> planarVoxelMinElev;
+  std::vector<int> planarVoxelQueue;
+
+  // inputs of the last connectivity labeling, its labels are kept while they do not change
+  bool connRecValid;
+  std::vector<float> connElevRec;
+  std::vector<char> connObservedRec;
+};
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef TERRAIN_LOCAL_ANALYSIS_H
+#define TERRAIN_LOCAL_ANALYSIS_H
+
+#include <stdint.h>
+#include <vector>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+// settings of the terrain analysis around the vehicle, names and defaults follow the
+// terrainAnalysis parameters
+struct TerrainLocalParams
+{
+  float planarVoxelSize = 0.2;
+  int planarVoxelWidth = 51;
+  bool useSorting = true;
+  double quantileZ = 0.25;
+  bool considerDrop = false;
+  bool limitGroundLift = false;
+  double maxGroundLift = 0.15;
+  bool clearDyObs = false;
+  double minDyObsDis = 0.3;
+  double minDyObsAngle = 0;
+  double minDyObsRelZ = -0.5;
+  double absDyObsRelZThre = 0.2;
+  double minDyObsVFOV = -16.0;
+  double maxDyObsVFOV = 16.0;
+  int minDyObsPointNum = 1;
+  bool noDataObstacle = false;
+  int noDataBlockSkipNum = 0;
+  int minBlockPointNum = 10;
+  double maxElevBelowVeh = -0.6;
+  double noDataAreaMinX = 0.3;
+  double noDataAreaMaxX = 1.8;
+  double noDataAreaMinY = -0.9;
+  double noDataAreaMaxY = 0.9;
+  double vehicleHeight = 1.5;
+  double minRelZ = -1.5;
+  double maxRelZ = 0.2;
+  int threadNum = 1;
+};
+
+// ground elevation on planar voxels around the vehicle from the stacked terrain points, each point
+// counts toward its voxel and the 8 around it, the output is the terrain cloud with the height
+// above the ground as intensity, voxels seen in the current scan where the stacked points fail the
+// dynamic obstacle check are left out with clearDyObs, and with noDataObstacle and markNoData,
+// voxels of too few points in the no data area ahead of the vehicle are filled as obstacles
+
+// the passes run on threadNum OpenMP threads, each thread fills its own buckets over a contiguous
+// block of points and the buckets are appended in thread order, so the output is the same for any
+// number of threads
+class TerrainLocalAnalysis
+{
+public:
+  explicit TerrainLocalAnalysis(const TerrainLocalParams& params = TerrainLocalParams());
+
+  void setParams(const TerrainLocalParams& params);
+  const TerrainLocalParams& params() const { return localParams; }
+
+  // laserCloudCrop is the current scan in the crop range of the terrain voxels, the vehicle pose
+  // is in the map frame with roll, pitch and yaw in rad
+  void compute(const pcl::PointCloud<pcl::PointXYZI>& terrainCloud,
+               const pcl::PointCloud<pcl::PointXYZI>& laserCloudCrop, float vehicleX, float vehicleY,
+               float vehicleZ, float vehicleRoll, float vehiclePitch, float vehicleYaw, bool markNoData,
+               pcl::PointCloud<pcl::PointXYZI>& terrainCloudElev);
+
+  // the planar voxels as a grid from terrainCloudElev of the last compute(), cell (indX, indY) spans
+  // planarVoxelSize from vehicleX + planarVoxelSize * (indX - planarVoxelHalfWidth - 0.5) and the
+  // same in y, occupancy[planarVoxelWidth * indY + indX] is 100 where a point of terrainCloudElev
+  // in it reaches elevGridObsThre above the ground, 0 where observed and -1 otherwise, layers holds
+  // the ground elevation (NaN where unobserved), the max height above the ground and the observed
+  // flag at [planarVoxelNum * layer + planarVoxelWidth * indX + indY]
+  void computeGrid(const pcl::PointCloud<pcl::PointXYZI>& terrainCloudElev, float vehicleX, float vehicleY,
+                   float elevGridObsThre, std::vector<int8_t>& occupancy, std::vector<float>& layers);
+
+  // results of the last compute() by flat index planarVoxelWidth * indX + indY
+  float voxelElev(int ind) const { return planarVoxelElev[ind]; }
+  int voxelPointNum(int ind) const { return planarPointElev[ind].size(); }
+  int voxelDyObs(int ind) const { return planarVoxelDyObs[ind]; }
+
+private:
+  TerrainLocalParams localParams;
+  int planarVoxelHalfWidth;
+  int planarVoxelNum;
+
+  // angle thresholds of the dynamic obstacle check as slopes, valid as the angles are within
+  // +-90 deg
+  float minDyObsSlope;
+  float minDyObsVFOVSlope;
+  float maxDyObsVFOVSlope;
+
+  std::vector<float> planarVoxelElev;
+  std::vector<int> planarVoxelEdge;
+  std::vector<int> planarVoxelDyObs;
+  std::vector<std::vector<float>> planarPointElev;
+  std::vector<float> planarVoxelMaxHeight;
+
+  // buckets of threads 1 and up, thread 0 fills the arrays above directly
+  std::vector<std::vector<float>> threadPlanarPointElev;
+  std::vector<std::vector<int>> threadPlanarVoxelDyObs;
+  std::vector<pcl::PointCloud<pcl::PointXYZI>> threadTerrainCloudElev;
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef TERRAIN_VOXEL_MAP_H
+#define TERRAIN_VOXEL_MAP_H
+
+#include <vector>
+
+#include <pcl/filters/voxel_grid.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include "terrain_analysis/rollingVoxelGrid.h"
+
+// settings of the stacked terrain voxels, names and defaults follow the terrainAnalysis parameters,
+// terrainAnalysisExt passes its lowerBoundZ and upperBoundZ as minRelZ and maxRelZ
+struct TerrainVoxelMapParams
+{
+  float terrainVoxelSize = 1.0;
+  int terrainVoxelWidth = 21;
+  double scanVoxelSize = 0.05;
+  double decayTime = 2.0;
+  double noDecayDis = 4.0;
+  int voxelPointUpdateThre = 100;
+  double voxelTimeUpdateThre = 2.0;
+  double minRelZ = -1.5;
+  double maxRelZ = 0.2;
+  double disRatioZ = 0.2;
+};
+
+// registered scans stacked in square voxels around the vehicle, the grid rolls with the vehicle and
+// a voxel is downsampled, decayed and cleared once enough points or time have gone into it, point
+// intensities hold the scan time in s since the first scan
+class TerrainVoxelMap
+{
+public:
+  explicit TerrainVoxelMap(const TerrainVoxelMapParams& params = TerrainVoxelMapParams());
+
+  // apply new settings, the map starts over empty
+  void setParams(const TerrainVoxelMapParams& params);
+  const TerrainVoxelMapParams& params() const { return mapParams; }
+
+  // whether a scan point at relZ above the vehicle and dis away from it horizontally is kept
+  bool inCropRange(float relZ, float dis) const
+  {
+    return relZ > mapParams.minRelZ - mapParams.disRatioZ * dis &&
+           relZ < mapParams.maxRelZ + mapParams.disRatioZ * dis &&
+           dis < mapParams.terrainVoxelSize * (halfWidth + 1);
+  }
+
+  // append the points of a registered scan kept by inCropRange() to cloudCrop with scanTime as intensity
+  void cropScan(const pcl::PointCloud<pcl::PointXYZI>& scan, float vehicleX, float vehicleY, float vehicleZ,
+                double scanTime, pcl::PointCloud<pcl::PointXYZI>& cloudCrop) const;
+
+  // roll the grid to the vehicle, stack the cropped points and refresh the voxels due, clearingDis
+  // only applies with clearingCloud
+  void update(const pcl::PointCloud<pcl::PointXYZI>& cloudCrop, float vehicleX, float vehicleY, float vehicleZ,
+              double scanTime, bool clearingCloud, double clearingDis);
+
+  // append the voxels within halfRange voxels of the center to cloud
+  void collect(int halfRange, pcl::PointCloud<pcl::PointXYZI>& cloud) const;
+
+private:
+  TerrainVoxelMapParams mapParams;
+  int halfWidth;
+  int shiftX;
+  int shiftY;
+
+  RollingVoxelGrid<pcl::PointCloud<pcl::PointXYZI>::Ptr> voxelCloud;
+  std::vector<int> voxelUpdateNum;
+  std::vector<float> voxelUpdateTime;
+
+  pcl::VoxelGrid<pcl::PointXYZI> downSizeFilter;
+  pcl::PointCloud<pcl::PointXYZI>::Ptr cloudDwz;
+};
+
+// ground elevation of a planar voxel from the point elevations gathered for it, the quantileZ
+// element with useSorting, capped at maxGroundLift above the lowest with limitGroundLift, and the
+// lowest otherwise, pointElev must not be empty and is reordered
+float planarVoxelGround(std::vector<float>& pointElev, bool useSorting, double quantileZ, bool limitGroundLift,
+                        double maxGroundLift);
+
+#endif
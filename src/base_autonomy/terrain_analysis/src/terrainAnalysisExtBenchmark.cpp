@@ -0,0 +1,228 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include "terrain_analysis/terrainExtAnalysis.h"
+#include "terrain_analysis/terrainVoxelMap.h"
+
+using namespace std;
+
+// runs the extended terrain analysis on a synthetic multi-level terrain, flat ground with a ramp
+// along +x up to a plateau and an overhang over the -x, +y quadrant that hides part of the ground
+// under it, and reports the per-cycle latency with and without the terrain connectivity check,
+// --quantile times the ground pick of dense planar voxels instead
+void printUsage()
+{
+  printf("Usage: terrainAnalysisExtBenchmark [options]\n");
+  printf("Options:\n");
+  printf("  --repeat N             cycles per run (100)\n");
+  printf("  --slope S              ramp slope (0.3)\n");
+  printf("  --plateau H            plateau height in m (3.0)\n");
+  printf("  --noOverhang           leave out the overhang\n");
+  printf("  --useMultiLayer        use the multi-layer ground\n");
+  printf("  --vehicleX X --vehicleY Y --vehicleZ Z  vehicle position (0, 0, 0.75)\n");
+  printf("  --vehicleStep D        vehicle move along x per cycle in m, 0 keeps the labels (0.01)\n");
+  printf("  --quantile             time planarVoxelGround against sorting each planar voxel\n");
+  printf("  --voxelNum N           planar voxels in the quantile mode (10201)\n");
+  printf("  --voxelPoints N        points per planar voxel in the quantile mode (400)\n");
+  printf("  --quantileZ Q          quantile in the quantile mode (0.25)\n");
+}
+
+double percentile(const vector<double>& sorted, double ratio)
+{
+  if (sorted.empty()) return 0;
+  int ind = int(ratio * (sorted.size() - 1) + 0.5);
+  return sorted[ind];
+}
+
+void buildTerrain(float slope, float plateau, bool overhang, pcl::PointCloud<pcl::PointXYZI>& cloud)
+{
+  pcl::PointXYZI point;
+  point.intensity = 0;
+  for (int indX = -200; indX <= 200; indX++) {
+    for (int indY = -200; indY <= 200; indY++) {
+      point.x = 0.1 * indX;
+      point.y = 0.1 * indY;
+
+      bool underOverhang = overhang && point.x > -14.0 && point.x < -6.0 && point.y > 4.0 && point.y < 14.0;
+      if (!underOverhang || point.y < 9.0) {
+        point.z = point.x > 6.0 ? min(slope * (point.x - 6.0f), plateau) : 0;
+        cloud.push_back(point);
+      }
+      if (underOverhang) {
+        point.z = 2.6;
+        cloud.push_back(point);
+      }
+    }
+  }
+}
+
+void runCycles(TerrainExtAnalysis& terrainExtAnalysis, const pcl::PointCloud<pcl::PointXYZI>& terrainCloud,
+               int repeatNum, float vehicleX, float vehicleY, float vehicleZ, float vehicleStep, const char* name)
+{
+  pcl::PointCloud<pcl::PointXYZI> terrainCloudLocal, terrainCloudElev;
+  vector<double> cycleTimes;
+  cycleTimes.reserve(repeatNum);
+  long pointNum = 0;
+  double totalTime = 0;
+
+  for (int i = 0; i < repeatNum; i++) {
+    chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+
+    terrainExtAnalysis.compute(terrainCloud, terrainCloudLocal, vehicleX + vehicleStep * i, vehicleY, vehicleZ,
+                               terrainCloudElev);
+
+    double cycleTime = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    cycleTimes.push_back(cycleTime);
+    totalTime += cycleTime;
+    pointNum += terrainCloudElev.points.size();
+  }
+
+  sort(cycleTimes.begin(), cycleTimes.end());
+  printf("%s latency ms: mean %.3f, p50 %.3f, p90 %.3f, max %.3f, output points %.0f\n", name,
+         1000.0 * totalTime / repeatNum, 1000.0 * percentile(cycleTimes, 0.5), 1000.0 * percentile(cycleTimes, 0.9),
+         1000.0 * cycleTimes.back(), double(pointNum) / repeatNum);
+}
+
+// the ground pick as it was made by sorting the whole planar voxel
+float sortedVoxelGround(vector<float>& pointElev, double quantileZ)
+{
+  int pointElevSize = pointElev.size();
+  sort(pointElev.begin(), pointElev.end());
+
+  int quantileID = int(quantileZ * pointElevSize);
+  if (quantileID < 0) quantileID = 0;
+  else if (quantileID >= pointElevSize) quantileID = pointElevSize - 1;
+  return pointElev[quantileID];
+}
+
+// dense planar voxels as gathered under a vehicle standing still, a ground band with obstacle
+// points above it, each voxel is copied before a pass since the ground pick reorders it
+void runQuantile(int voxelNum, int voxelPoints, double quantileZ, int repeatNum)
+{
+  mt19937 generator(1);
+  uniform_real_distribution<float> groundDist(-0.05, 0.05);
+  uniform_real_distribution<float> obstacleDist(0.1, 1.5);
+  uniform_real_distribution<float> ratioDist(0, 1.0);
+  vector<vector<float> > voxels(voxelNum);
+  for (int i = 0; i < voxelNum; i++) {
+    voxels[i].resize(voxelPoints);
+    for (int j = 0; j < voxelPoints; j++) {
+      voxels[i][j] = ratioDist(generator) < 0.2 ? obstacleDist(generator) : groundDist(generator);
+    }
+  }
+
+  vector<vector<float> > pointElevs;
+  vector<float> sortElevs(voxelNum), nthElevs(voxelNum);
+  double sortTime = 0, nthTime = 0;
+  for (int i = 0; i < repeatNum; i++) {
+    pointElevs = voxels;
+    chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+    for (int j = 0; j < voxelNum; j++) {
+      sortElevs[j] = sortedVoxelGround(pointElevs[j], quantileZ);
+    }
+    sortTime += chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+
+    pointElevs = voxels;
+    startTime = chrono::steady_clock::now();
+    for (int j = 0; j < voxelNum; j++) {
+      nthElevs[j] = planarVoxelGround(pointElevs[j], true, quantileZ, false, 0);
+    }
+    nthTime += chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+  }
+
+  int diffNum = 0;
+  for (int j = 0; j < voxelNum; j++) {
+    if (sortElevs[j] != nthElevs[j]) diffNum++;
+  }
+
+  printf("planar voxels: %d, points per voxel: %d, quantileZ: %.2f\n", voxelNum, voxelPoints, quantileZ);
+  printf("sort        ms per pass: %.3f, ns per voxel: %.1f\n", 1000.0 * sortTime / repeatNum,
+         1.0e9 * sortTime / repeatNum / voxelNum);
+  printf("nth_element ms per pass: %.3f, ns per voxel: %.1f\n", 1000.0 * nthTime / repeatNum,
+         1.0e9 * nthTime / repeatNum / voxelNum);
+  printf("speedup: %.2fx, voxels with different ground: %d\n", nthTime > 0 ? sortTime / nthTime : 0, diffNum);
+}
+
+int main(int argc, char** argv)
+{
+  int repeatNum = 100;
+  float slope = 0.3, plateau = 3.0;
+  bool overhang = true;
+  bool useMultiLayer = false;
+  bool quantile = false;
+  int voxelNum = 10201, voxelPoints = 400;
+  double quantileZ = 0.25;
+  float vehicleX = 0, vehicleY = 0, vehicleZ = 0.75, vehicleStep = 0.01;
+
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "--noOverhang") {
+      overhang = false;
+    } else if (arg == "--useMultiLayer") {
+      useMultiLayer = true;
+    } else if (arg == "--quantile") {
+      quantile = true;
+    } else if (arg.compare(0, 2, "--") == 0 && i + 1 < argc) {
+      const char *val = argv[++i];
+      if (arg == "--repeat") repeatNum = atoi(val);
+      else if (arg == "--slope") slope = atof(val);
+      else if (arg == "--plateau") plateau = atof(val);
+      else if (arg == "--vehicleX") vehicleX = atof(val);
+      else if (arg == "--vehicleY") vehicleY = atof(val);
+      else if (arg == "--vehicleZ") vehicleZ = atof(val);
+      else if (arg == "--vehicleStep") vehicleStep = atof(val);
+      else if (arg == "--voxelNum") voxelNum = atoi(val);
+      else if (arg == "--voxelPoints") voxelPoints = atoi(val);
+      else if (arg == "--quantileZ") quantileZ = atof(val);
+      else {
+        printUsage();
+        return 1;
+      }
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  if (repeatNum <= 0 || voxelNum <= 0 || voxelPoints <= 0) {
+    printUsage();
+    return 1;
+  }
+
+  if (quantile) {
+    runQuantile(voxelNum, voxelPoints, quantileZ, repeatNum);
+    return 0;
+  }
+
+  pcl::PointCloud<pcl::PointXYZI> terrainCloud;
+  buildTerrain(slope, plateau, overhang, terrainCloud);
+  printf("terrain points: %d\n", int(terrainCloud.points.size()));
+
+  // settings of terrain_analysis_ext.launch
+  TerrainExtParams params;
+  params.useSorting = true;
+  params.quantileZ = 0.1;
+  params.lowerBoundZ = -2.5;
+  params.upperBoundZ = 1.0;
+  params.disRatioZ = 0.1;
+  params.useMultiLayer = useMultiLayer;
+
+  params.checkTerrainConn = false;
+  TerrainExtAnalysis terrainExtAnalysis(params);
+  runCycles(terrainExtAnalysis, terrainCloud, repeatNum, vehicleX, vehicleY, vehicleZ, vehicleStep, "no connectivity");
+
+  params.checkTerrainConn = true;
+  terrainExtAnalysis.setParams(params);
+  runCycles(terrainExtAnalysis, terrainCloud, repeatNum, vehicleX, vehicleY, vehicleZ, vehicleStep, "connectivity   ");
+
+  return 0;
+}
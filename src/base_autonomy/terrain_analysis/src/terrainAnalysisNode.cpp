@@ -0,0 +1,425 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <memory>
+#include "rclcpp_components/register_node_macro.hpp"
+
+#include "tf2/transform_datatypes.h"
+#include "tf2_geometry_msgs/tf2_geometry_msgs.hpp"
+
+#include <pcl_conversions/pcl_conversions.h>
+
+#include "terrain_analysis/terrainAnalysisNode.h"
+
+using namespace std;
+
+namespace terrain_analysis
+{
+
+// terrain voxel parameters
+const float terrainVoxelSize = 1.0;
+const int terrainVoxelWidth = 21;
+const float extTerrainVoxelSize = 2.0;
+const int extTerrainVoxelWidth = 41;
+
+// planar voxel parameters
+const float planarVoxelSize = 0.2;
+const int planarVoxelWidth = 51;
+const int planarVoxelHalfWidth = (planarVoxelWidth - 1) / 2;
+const int planarVoxelNum = planarVoxelWidth * planarVoxelWidth;
+const float extPlanarVoxelSize = 0.4;
+const int extPlanarVoxelWidth = 101;
+
+TerrainAnalysisNode::TerrainAnalysisNode(const rclcpp::NodeOptions& options)
+  : Node("terrainAnalysis", options),
+    laserCloud(new pcl::PointCloud<pcl::PointXYZI>()),
+    laserCloudCrop(new pcl::PointCloud<pcl::PointXYZI>()),
+    terrainCloud(new pcl::PointCloud<pcl::PointXYZI>()),
+    terrainCloudElev(new pcl::PointCloud<pcl::PointXYZI>()),
+    extLaserCloudCrop(new pcl::PointCloud<pcl::PointXYZI>()),
+    extTerrainCloud(new pcl::PointCloud<pcl::PointXYZI>()),
+    extTerrainCloudElev(new pcl::PointCloud<pcl::PointXYZI>())
+{
+  declare_parameter<double>("scanVoxelSize", scanVoxelSize);
+  declare_parameter<double>("decayTime", decayTime);
+  declare_parameter<double>("noDecayDis", noDecayDis);
+  declare_parameter<double>("clearingDis", clearingDis);
+  declare_parameter<bool>("useSorting", useSorting);
+  declare_parameter<double>("quantileZ", quantileZ);
+  declare_parameter<bool>("considerDrop", considerDrop);
+  declare_parameter<bool>("limitGroundLift", limitGroundLift);
+  declare_parameter<double>("maxGroundLift", maxGroundLift);
+  declare_parameter<bool>("clearDyObs", clearDyObs);
+  declare_parameter<double>("minDyObsDis", minDyObsDis);
+  declare_parameter<double>("minDyObsAngle", minDyObsAngle);
+  declare_parameter<double>("minDyObsRelZ", minDyObsRelZ);
+  declare_parameter<double>("absDyObsRelZThre", absDyObsRelZThre);
+  declare_parameter<double>("minDyObsVFOV", minDyObsVFOV);
+  declare_parameter<double>("maxDyObsVFOV", maxDyObsVFOV);
+  declare_parameter<int>("minDyObsPointNum", minDyObsPointNum);
+  declare_parameter<bool>("noDataObstacle", noDataObstacle);
+  declare_parameter<int>("noDataBlockSkipNum", noDataBlockSkipNum);
+  declare_parameter<int>("minBlockPointNum", minBlockPointNum);
+  declare_parameter<double>("maxElevBelowVeh", maxElevBelowVeh);
+  declare_parameter<double>("noDataAreaMinX", noDataAreaMinX);
+  declare_parameter<double>("noDataAreaMaxX", noDataAreaMaxX);
+  declare_parameter<double>("noDataAreaMinY", noDataAreaMinY);
+  declare_parameter<double>("noDataAreaMaxY", noDataAreaMaxY);
+  declare_parameter<double>("vehicleHeight", vehicleHeight);
+  declare_parameter<int>("voxelPointUpdateThre", voxelPointUpdateThre);
+  declare_parameter<double>("voxelTimeUpdateThre", voxelTimeUpdateThre);
+  declare_parameter<double>("minRelZ", minRelZ);
+  declare_parameter<double>("maxRelZ", maxRelZ);
+  declare_parameter<double>("disRatioZ", disRatioZ);
+  declare_parameter<int>("threadNum", threadNum);
+  declare_parameter<bool>("publishElevGrid", publishElevGrid);
+  declare_parameter<double>("elevGridObsThre", elevGridObsThre);
+  declare_parameter<bool>("useExtLevel", useExtLevel);
+  declare_parameter<double>("extScanVoxelSize", extScanVoxelSize);
+  declare_parameter<double>("extDecayTime", extDecayTime);
+  declare_parameter<double>("extNoDecayDis", extNoDecayDis);
+  declare_parameter<double>("extClearingDis", extClearingDis);
+  declare_parameter<bool>("extUseSorting", extUseSorting);
+  declare_parameter<double>("extQuantileZ", extQuantileZ);
+  declare_parameter<double>("extVehicleHeight", extVehicleHeight);
+  declare_parameter<int>("extVoxelPointUpdateThre", extVoxelPointUpdateThre);
+  declare_parameter<double>("extVoxelTimeUpdateThre", extVoxelTimeUpdateThre);
+  declare_parameter<double>("extLowerBoundZ", extLowerBoundZ);
+  declare_parameter<double>("extUpperBoundZ", extUpperBoundZ);
+  declare_parameter<double>("extDisRatioZ", extDisRatioZ);
+  declare_parameter<bool>("extCheckTerrainConn", extCheckTerrainConn);
+  declare_parameter<double>("extTerrainUnderVehicle", extTerrainUnderVehicle);
+  declare_parameter<double>("extTerrainConnThre", extTerrainConnThre);
+  declare_parameter<double>("extCeilingFilteringThre", extCeilingFilteringThre);
+  declare_parameter<double>("extLocalTerrainMapRadius", extLocalTerrainMapRadius);
+  declare_parameter<bool>("extUseMultiLayer", extUseMultiLayer);
+  declare_parameter<int>("extMaxLayerNum", extMaxLayerNum);
+  declare_parameter<double>("extLayerGapThre", extLayerGapThre);
+  declare_parameter<double>("extLayerClearance", extLayerClearance);
+
+  get_parameter("scanVoxelSize", scanVoxelSize);
+  get_parameter("decayTime", decayTime);
+  get_parameter("noDecayDis", noDecayDis);
+  get_parameter("clearingDis", clearingDis);
+  get_parameter("useSorting", useSorting);
+  get_parameter("quantileZ", quantileZ);
+  get_parameter("considerDrop", considerDrop);
+  get_parameter("limitGroundLift", limitGroundLift);
+  get_parameter("maxGroundLift", maxGroundLift);
+  get_parameter("clearDyObs", clearDyObs);
+  get_parameter("minDyObsDis", minDyObsDis);
+  get_parameter("minDyObsAngle", minDyObsAngle);
+  get_parameter("minDyObsRelZ", minDyObsRelZ);
+  get_parameter("absDyObsRelZThre", absDyObsRelZThre);
+  get_parameter("minDyObsVFOV", minDyObsVFOV);
+  get_parameter("maxDyObsVFOV", maxDyObsVFOV);
+  get_parameter("minDyObsPointNum", minDyObsPointNum);
+  get_parameter("noDataObstacle", noDataObstacle);
+  get_parameter("noDataBlockSkipNum", noDataBlockSkipNum);
+  get_parameter("minBlockPointNum", minBlockPointNum);
+  get_parameter("maxElevBelowVeh", maxElevBelowVeh);
+  get_parameter("noDataAreaMinX", noDataAreaMinX);
+  get_parameter("noDataAreaMaxX", noDataAreaMaxX);
+  get_parameter("noDataAreaMinY", noDataAreaMinY);
+  get_parameter("noDataAreaMaxY", noDataAreaMaxY);
+  get_parameter("vehicleHeight", vehicleHeight);
+  get_parameter("voxelPointUpdateThre", voxelPointUpdateThre);
+  get_parameter("voxelTimeUpdateThre", voxelTimeUpdateThre);
+  get_parameter("minRelZ", minRelZ);
+  get_parameter("maxRelZ", maxRelZ);
+  get_parameter("disRatioZ", disRatioZ);
+  get_parameter("threadNum", threadNum);
+  get_parameter("publishElevGrid", publishElevGrid);
+  get_parameter("elevGridObsThre", elevGridObsThre);
+  get_parameter("useExtLevel", useExtLevel);
+  get_parameter("extScanVoxelSize", extScanVoxelSize);
+  get_parameter("extDecayTime", extDecayTime);
+  get_parameter("extNoDecayDis", extNoDecayDis);
+  get_parameter("extClearingDis", extClearingDis);
+  get_parameter("extUseSorting", extUseSorting);
+  get_parameter("extQuantileZ", extQuantileZ);
+  get_parameter("extVehicleHeight", extVehicleHeight);
+  get_parameter("extVoxelPointUpdateThre", extVoxelPointUpdateThre);
+  get_parameter("extVoxelTimeUpdateThre", extVoxelTimeUpdateThre);
+  get_parameter("extLowerBoundZ", extLowerBoundZ);
+  get_parameter("extUpperBoundZ", extUpperBoundZ);
+  get_parameter("extDisRatioZ", extDisRatioZ);
+  get_parameter("extCheckTerrainConn", extCheckTerrainConn);
+  get_parameter("extTerrainUnderVehicle", extTerrainUnderVehicle);
+  get_parameter("extTerrainConnThre", extTerrainConnThre);
+  get_parameter("extCeilingFilteringThre", extCeilingFilteringThre);
+  get_parameter("extLocalTerrainMapRadius", extLocalTerrainMapRadius);
+  get_parameter("extUseMultiLayer", extUseMultiLayer);
+  get_parameter("extMaxLayerNum", extMaxLayerNum);
+  get_parameter("extLayerGapThre", extLayerGapThre);
+  get_parameter("extLayerClearance", extLayerClearance);
+
+  subOdometry = create_subscription<nav_msgs::msg::Odometry>("/state_estimation", 5,
+                std::bind(&TerrainAnalysisNode::odometryHandler, this, std::placeholders::_1));
+  subLaserCloud = create_subscription<sensor_msgs::msg::PointCloud2>("/registered_scan", 5,
+                  std::bind(&TerrainAnalysisNode::laserCloudHandler, this, std::placeholders::_1));
+  subJoystick = create_subscription<sensor_msgs::msg::Joy>("/joy", 5,
+                std::bind(&TerrainAnalysisNode::joystickHandler, this, std::placeholders::_1));
+  subClearing = create_subscription<std_msgs::msg::Float32>("/map_clearing", 5,
+                std::bind(&TerrainAnalysisNode::clearingHandler, this, std::placeholders::_1));
+
+  pubLaserCloud = create_publisher<sensor_msgs::msg::PointCloud2>("/terrain_map", 2);
+  pubTerrainGrid = create_publisher<nav_msgs::msg::OccupancyGrid>("/terrain_grid", 2);
+  pubTerrainGridLayers = create_publisher<std_msgs::msg::Float32MultiArray>("/terrain_grid_layers", 2);
+
+  if (useExtLevel) {
+    subExtClearing = create_subscription<std_msgs::msg::Float32>("/cloud_clearing", 5,
+                     std::bind(&TerrainAnalysisNode::extClearingHandler, this, std::placeholders::_1));
+    pubExtTerrainCloud = create_publisher<sensor_msgs::msg::PointCloud2>("/terrain_map_ext", 2);
+  }
+
+  TerrainVoxelMapParams mapParams;
+  mapParams.terrainVoxelSize = terrainVoxelSize;
+  mapParams.terrainVoxelWidth = terrainVoxelWidth;
+  mapParams.scanVoxelSize = scanVoxelSize;
+  mapParams.decayTime = decayTime;
+  mapParams.noDecayDis = noDecayDis;
+  mapParams.voxelPointUpdateThre = voxelPointUpdateThre;
+  mapParams.voxelTimeUpdateThre = voxelTimeUpdateThre;
+  mapParams.minRelZ = minRelZ;
+  mapParams.maxRelZ = maxRelZ;
+  mapParams.disRatioZ = disRatioZ;
+  terrainVoxelMap.setParams(mapParams);
+
+  TerrainLocalParams localParams;
+  localParams.planarVoxelSize = planarVoxelSize;
+  localParams.planarVoxelWidth = planarVoxelWidth;
+  localParams.useSorting = useSorting;
+  localParams.quantileZ = quantileZ;
+  localParams.considerDrop = considerDrop;
+  localParams.limitGroundLift = limitGroundLift;
+  localParams.maxGroundLift = maxGroundLift;
+  localParams.clearDyObs = clearDyObs;
+  localParams.minDyObsDis = minDyObsDis;
+  localParams.minDyObsAngle = minDyObsAngle;
+  localParams.minDyObsRelZ = minDyObsRelZ;
+  localParams.absDyObsRelZThre = absDyObsRelZThre;
+  localParams.minDyObsVFOV = minDyObsVFOV;
+  localParams.maxDyObsVFOV = maxDyObsVFOV;
+  localParams.minDyObsPointNum = minDyObsPointNum;
+  localParams.noDataObstacle = noDataObstacle;
+  localParams.noDataBlockSkipNum = noDataBlockSkipNum;
+  localParams.minBlockPointNum = minBlockPointNum;
+  localParams.maxElevBelowVeh = maxElevBelowVeh;
+  localParams.noDataAreaMinX = noDataAreaMinX;
+  localParams.noDataAreaMaxX = noDataAreaMaxX;
+  localParams.noDataAreaMinY = noDataAreaMinY;
+  localParams.noDataAreaMaxY = noDataAreaMaxY;
+  localParams.vehicleHeight = vehicleHeight;
+  localParams.minRelZ = minRelZ;
+  localParams.maxRelZ = maxRelZ;
+  localParams.threadNum = threadNum;
+  terrainLocalAnalysis.setParams(localParams);
+
+  if (useExtLevel) {
+    TerrainVoxelMapParams extMapParams;
+    extMapParams.terrainVoxelSize = extTerrainVoxelSize;
+    extMapParams.terrainVoxelWidth = extTerrainVoxelWidth;
+    extMapParams.scanVoxelSize = extScanVoxelSize;
+    extMapParams.decayTime = extDecayTime;
+    extMapParams.noDecayDis = extNoDecayDis;
+    extMapParams.voxelPointUpdateThre = extVoxelPointUpdateThre;
+    extMapParams.voxelTimeUpdateThre = extVoxelTimeUpdateThre;
+    extMapParams.minRelZ = extLowerBoundZ;
+    extMapParams.maxRelZ = extUpperBoundZ;
+    extMapParams.disRatioZ = extDisRatioZ;
+    extTerrainVoxelMap.setParams(extMapParams);
+
+    TerrainExtParams extParams;
+    extParams.planarVoxelSize = extPlanarVoxelSize;
+    extParams.planarVoxelWidth = extPlanarVoxelWidth;
+    extParams.useSorting = extUseSorting;
+    extParams.quantileZ = extQuantileZ;
+    extParams.vehicleHeight = extVehicleHeight;
+    extParams.lowerBoundZ = extLowerBoundZ;
+    extParams.upperBoundZ = extUpperBoundZ;
+    extParams.disRatioZ = extDisRatioZ;
+    extParams.checkTerrainConn = extCheckTerrainConn;
+    extParams.terrainUnderVehicle = extTerrainUnderVehicle;
+    extParams.terrainConnThre = extTerrainConnThre;
+    extParams.ceilingFilteringThre = extCeilingFilteringThre;
+    extParams.localTerrainMapRadius = extLocalTerrainMapRadius;
+    extParams.useMultiLayer = extUseMultiLayer;
+    extParams.maxLayerNum = extMaxLayerNum;
+    extParams.layerGapThre = extLayerGapThre;
+    extParams.layerClearance = extLayerClearance;
+    terrainExtAnalysis.setParams(extParams);
+  }
+
+  analysisTimer = create_wall_timer(std::chrono::milliseconds(10),
+                                    std::bind(&TerrainAnalysisNode::analysisCycle, this));
+}
+
+// state estimation callback function
+void TerrainAnalysisNode::odometryHandler(nav_msgs::msg::Odometry::UniquePtr odom)
+{
+  double roll, pitch, yaw;
+  geometry_msgs::msg::Quaternion geoQuat = odom->pose.pose.orientation;
+  tf2::Matrix3x3(tf2::Quaternion(geoQuat.x, geoQuat.y, geoQuat.z, geoQuat.w)).getRPY(roll, pitch, yaw);
+
+  vehicleRoll = roll;
+  vehiclePitch = pitch;
+  vehicleYaw = yaw;
+  vehicleX = odom->pose.pose.position.x;
+  vehicleY = odom->pose.pose.position.y;
+  vehicleZ = odom->pose.pose.position.z;
+
+  if (noDataInited == 0) {
+    vehicleXRec = vehicleX;
+    vehicleYRec = vehicleY;
+    noDataInited = 1;
+  }
+  if (noDataInited == 1) {
+    float dis = sqrt((vehicleX - vehicleXRec) * (vehicleX - vehicleXRec) +
+                     (vehicleY - vehicleYRec) * (vehicleY - vehicleYRec));
+    if (dis >= noDecayDis) noDataInited = 2;
+  }
+}
+
+// registered laser scan callback function
+void TerrainAnalysisNode::laserCloudHandler(sensor_msgs::msg::PointCloud2::UniquePtr laserCloud2)
+{
+  laserCloudTime = rclcpp::Time(laserCloud2->header.stamp).seconds();
+  if (!systemInited) {
+    systemInitTime = laserCloudTime;
+    systemInited = true;
+  }
+
+  laserCloud->clear();
+  pcl::fromROSMsg(*laserCloud2, *laserCloud);
+
+  // one pass over the scan crops it for both levels
+  pcl::PointXYZI point;
+  laserCloudCrop->clear();
+  extLaserCloudCrop->clear();
+  int laserCloudSize = laserCloud->points.size();
+  for (int i = 0; i < laserCloudSize; i++) {
+    point = laserCloud->points[i];
+    point.intensity = laserCloudTime - systemInitTime;
+
+    float dis = sqrt((point.x - vehicleX) * (point.x - vehicleX) + (point.y - vehicleY) * (point.y - vehicleY));
+    if (terrainVoxelMap.inCropRange(point.z - vehicleZ, dis)) {
+      laserCloudCrop->push_back(point);
+    }
+    if (useExtLevel && extTerrainVoxelMap.inCropRange(point.z - vehicleZ, dis)) {
+      extLaserCloudCrop->push_back(point);
+    }
+  }
+
+  newlaserCloud = true;
+}
+
+// joystick callback function
+void TerrainAnalysisNode::joystickHandler(sensor_msgs::msg::Joy::UniquePtr joy)
+{
+  if (joy->buttons[5] > 0.5) {
+    noDataInited = 0;
+    clearingCloud = true;
+    extClearingCloud = true;
+  }
+}
+
+// cloud clearing callback function
+void TerrainAnalysisNode::clearingHandler(std_msgs::msg::Float32::UniquePtr dis)
+{
+  noDataInited = 0;
+  clearingDis = dis->data;
+  clearingCloud = true;
+}
+
+// extended level clearing callback function
+void TerrainAnalysisNode::extClearingHandler(std_msgs::msg::Float32::UniquePtr dis)
+{
+  extClearingDis = dis->data;
+  extClearingCloud = true;
+}
+
+void TerrainAnalysisNode::analysisCycle()
+{
+  if (!newlaserCloud) {
+    return;
+  }
+  newlaserCloud = false;
+
+  // stack registered laser scans, roll over and refresh the terrain voxels
+  terrainVoxelMap.update(*laserCloudCrop, vehicleX, vehicleY, vehicleZ, laserCloudTime - systemInitTime, clearingCloud,
+                         clearingDis);
+
+  terrainCloud->clear();
+  terrainVoxelMap.collect(5, *terrainCloud);
+
+  // estimate ground and compute elevation for each point
+  terrainLocalAnalysis.compute(*terrainCloud, *laserCloudCrop, vehicleX, vehicleY, vehicleZ, vehicleRoll, vehiclePitch,
+                               vehicleYaw, noDataInited == 2, *terrainCloudElev);
+
+  clearingCloud = false;
+
+  // publish points with elevation
+  std_msgs::msg::Header header;
+  header.stamp = rclcpp::Time(static_cast<uint64_t>(laserCloudTime * 1e9));
+  header.frame_id = "map";
+  auto terrainCloud2 = std::make_unique<sensor_msgs::msg::PointCloud2>();
+  pcl::toROSMsg(*terrainCloudElev, *terrainCloud2);
+  terrainCloud2->header = header;
+  pubLaserCloud->publish(std::move(terrainCloud2));
+
+  // the planar voxels as /terrain_grid and /terrain_grid_layers, layout in TerrainLocalAnalysis::computeGrid()
+  if (publishElevGrid) {
+    nav_msgs::msg::OccupancyGrid terrainGrid;
+    terrainGrid.header = header;
+    terrainGrid.info.map_load_time = header.stamp;
+    terrainGrid.info.resolution = planarVoxelSize;
+    terrainGrid.info.width = planarVoxelWidth;
+    terrainGrid.info.height = planarVoxelWidth;
+    terrainGrid.info.origin.position.x = vehicleX - planarVoxelSize * (planarVoxelHalfWidth + 0.5);
+    terrainGrid.info.origin.position.y = vehicleY - planarVoxelSize * (planarVoxelHalfWidth + 0.5);
+    terrainGrid.info.origin.position.z = vehicleZ;
+    terrainGrid.info.origin.orientation.w = 1.0;
+
+    std_msgs::msg::Float32MultiArray terrainGridLayers;
+    terrainGridLayers.layout.dim.resize(3);
+    terrainGridLayers.layout.dim[0].label = "layer";
+    terrainGridLayers.layout.dim[0].size = 3;
+    terrainGridLayers.layout.dim[0].stride = 3 * planarVoxelNum;
+    terrainGridLayers.layout.dim[1].label = "x";
+    terrainGridLayers.layout.dim[1].size = planarVoxelWidth;
+    terrainGridLayers.layout.dim[1].stride = planarVoxelNum;
+    terrainGridLayers.layout.dim[2].label = "y";
+    terrainGridLayers.layout.dim[2].size = planarVoxelWidth;
+    terrainGridLayers.layout.dim[2].stride = planarVoxelWidth;
+    terrainGridLayers.layout.data_offset = 0;
+    terrainLocalAnalysis.computeGrid(*terrainCloudElev, vehicleX, vehicleY, elevGridObsThre, terrainGrid.data,
+                                     terrainGridLayers.data);
+
+    pubTerrainGrid->publish(terrainGrid);
+    pubTerrainGridLayers->publish(terrainGridLayers);
+  }
+
+  // extended level on the same scan, with the terrain map above as the local part
+  if (useExtLevel) {
+    extTerrainVoxelMap.update(*extLaserCloudCrop, vehicleX, vehicleY, vehicleZ, laserCloudTime - systemInitTime,
+                              extClearingCloud, extClearingDis);
+
+    extTerrainCloud->clear();
+    extTerrainVoxelMap.collect(10, *extTerrainCloud);
+
+    terrainExtAnalysis.compute(*extTerrainCloud, *terrainCloudElev, vehicleX, vehicleY, vehicleZ, *extTerrainCloudElev);
+
+    extClearingCloud = false;
+
+    auto extTerrainCloud2 = std::make_unique<sensor_msgs::msg::PointCloud2>();
+    pcl::toROSMsg(*extTerrainCloudElev, *extTerrainCloud2);
+    extTerrainCloud2->header = header;
+    pubExtTerrainCloud->publish(std::move(extTerrainCloud2));
+  }
+}
+
+}
+
+RCLCPP_COMPONENTS_REGISTER_NODE(terrain_analysis::TerrainAnalysisNode)
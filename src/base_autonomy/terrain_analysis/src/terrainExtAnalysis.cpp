@@ -0,0 +1,322 @@
+#include <math.h>
+#include <algorithm>
+
+#include "terrain_analysis/terrainExtAnalysis.h"
+#include "terrain_analysis/terrainVoxelMap.h"
+
+using namespace std;
+
+TerrainExtAnalysis::TerrainExtAnalysis(const TerrainExtParams& params)
+{
+  setParams(params);
+}
+
+void TerrainExtAnalysis::setParams(const TerrainExtParams& params)
+{
+  extParams = params;
+  planarVoxelHalfWidth = (extParams.planarVoxelWidth - 1) / 2;
+  planarVoxelNum = extParams.planarVoxelWidth * extParams.planarVoxelWidth;
+
+  planarVoxelElev.assign(planarVoxelNum, 0);
+  planarVoxelConn.assign(planarVoxelNum, 0);
+  planarPointElev.assign(planarVoxelNum, vector<float>());
+
+  if (extParams.maxLayerNum < 1) extParams.maxLayerNum = 1;
+  int layerNum = extParams.useMultiLayer ? extParams.maxLayerNum * planarVoxelNum : 0;
+  planarVoxelLayerNum.assign(extParams.useMultiLayer ? planarVoxelNum : 0, 0);
+  planarVoxelLayerLow.assign(layerNum, 0);
+  planarVoxelLayerHigh.assign(layerNum, 0);
+  planarVoxelLayerElev.assign(layerNum, 0);
+  planarVoxelKeepMin.assign(extParams.useMultiLayer ? planarVoxelNum : 0, 0);
+  planarVoxelKeepMax.assign(extParams.useMultiLayer ? planarVoxelNum : 0, 0);
+
+  planarVoxelParent.assign(planarVoxelNum, 0);
+  planarVoxelInSet.assign(planarVoxelNum, 0);
+  planarVoxelMinElev.assign(planarVoxelNum, 0);
+  planarVoxelQueue.clear();
+  planarVoxelQueue.reserve(planarVoxelNum);
+
+  connRecValid = false;
+  connElevRec.assign(planarVoxelNum, 0);
+  connObservedRec.assign(planarVoxelNum, 0);
+}
+
+void TerrainExtAnalysis::compute(const pcl::PointCloud<pcl::PointXYZI>& terrainCloud,
+                                 const pcl::PointCloud<pcl::PointXYZI>& terrainCloudLocal, float vehicleX,
+                                 float vehicleY, float vehicleZ, pcl::PointCloud<pcl::PointXYZI>& terrainCloudElev)
+{
+  const TerrainExtParams& p = extParams;
+  float planarVoxelSize = p.planarVoxelSize;
+  int planarVoxelWidth = p.planarVoxelWidth;
+
+  // estimate ground and compute elevation for each point
+  for (int i = 0; i < planarVoxelNum; i++) {
+    planarVoxelElev[i] = 0;
+    planarPointElev[i].clear();
+  }
+
+  pcl::PointXYZI point;
+  int terrainCloudSize = terrainCloud.points.size();
+  for (int i = 0; i < terrainCloudSize; i++) {
+    point = terrainCloud.points[i];
+    float dis = sqrt((point.x - vehicleX) * (point.x - vehicleX) + (point.y - vehicleY) * (point.y - vehicleY));
+    if (point.z - vehicleZ > p.lowerBoundZ - p.disRatioZ * dis &&
+        point.z - vehicleZ < p.upperBoundZ + p.disRatioZ * dis) {
+      int indX = int((point.x - vehicleX + planarVoxelSize / 2) / planarVoxelSize) + planarVoxelHalfWidth;
+      int indY = int((point.y - vehicleY + planarVoxelSize / 2) / planarVoxelSize) + planarVoxelHalfWidth;
+
+      if (point.x - vehicleX + planarVoxelSize / 2 < 0) indX--;
+      if (point.y - vehicleY + planarVoxelSize / 2 < 0) indY--;
+
+      for (int dX = -1; dX <= 1; dX++) {
+        for (int dY = -1; dY <= 1; dY++) {
+          if (indX + dX >= 0 && indX + dX < planarVoxelWidth && indY + dY >= 0 && indY + dY < planarVoxelWidth) {
+            planarPointElev[planarVoxelWidth * (indX + dX) + indY + dY].push_back(point.z);
+          }
+        }
+      }
+    }
+  }
+
+  float footElev = vehicleZ + p.terrainUnderVehicle;
+  for (int i = 0; i < planarVoxelNum; i++) {
+    if (planarPointElev[i].size() > 0) {
+      if (p.useMultiLayer) planarVoxelElev[i] = planarVoxelLayerGround(i, footElev);
+      else planarVoxelElev[i] = planarVoxelGround(planarPointElev[i], p.useSorting, p.quantileZ, false, 0);
+    }
+  }
+
+  // check terrain connectivity to remove ceiling
+  if (p.checkTerrainConn) labelTerrainConn(vehicleZ);
+
+  // compute terrain map beyond localTerrainMapRadius
+  terrainCloudElev.clear();
+  for (int i = 0; i < terrainCloudSize; i++) {
+    point = terrainCloud.points[i];
+    float dis = sqrt((point.x - vehicleX) * (point.x - vehicleX) + (point.y - vehicleY) * (point.y - vehicleY));
+    if (point.z - vehicleZ > p.lowerBoundZ - p.disRatioZ * dis &&
+        point.z - vehicleZ < p.upperBoundZ + p.disRatioZ * dis && dis > p.localTerrainMapRadius) {
+      int indX = int((point.x - vehicleX + planarVoxelSize / 2) / planarVoxelSize) + planarVoxelHalfWidth;
+      int indY = int((point.y - vehicleY + planarVoxelSize / 2) / planarVoxelSize) + planarVoxelHalfWidth;
+
+      if (point.x - vehicleX + planarVoxelSize / 2 < 0) indX--;
+      if (point.y - vehicleY + planarVoxelSize / 2 < 0) indY--;
+
+      if (indX >= 0 && indX < planarVoxelWidth && indY >= 0 && indY < planarVoxelWidth) {
+        int ind = planarVoxelWidth * indX + indY;
+        float disZ = fabs(point.z - planarVoxelElev[ind]);
+        bool inLayer = !p.useMultiLayer || (point.z >= planarVoxelKeepMin[ind] && point.z < planarVoxelKeepMax[ind]);
+        if (disZ < p.vehicleHeight && (planarVoxelConn[ind] == 2 || !p.checkTerrainConn) && inLayer) {
+          point.intensity = disZ;
+          terrainCloudElev.push_back(point);
+        }
+      }
+    }
+  }
+
+  // merge in local terrain map within localTerrainMapRadius
+  int terrainCloudLocalSize = terrainCloudLocal.points.size();
+  for (int i = 0; i < terrainCloudLocalSize; i++) {
+    point = terrainCloudLocal.points[i];
+    float dis = sqrt((point.x - vehicleX) * (point.x - vehicleX) + (point.y - vehicleY) * (point.y - vehicleY));
+    if (dis <= p.localTerrainMapRadius) {
+      terrainCloudElev.push_back(point);
+    }
+  }
+}
+
+// splits the sorted elevations at the gaps, the intervals beyond maxLayerNum - 1 are kept as one,
+// each interval takes its ground elevation the same way a single-layer voxel does
+float TerrainExtAnalysis::planarVoxelLayerGround(int ind, float footElev)
+{
+  const TerrainExtParams& p = extParams;
+  vector<float>& pointElev = planarPointElev[ind];
+  sort(pointElev.begin(), pointElev.end());
+
+  int layerInd = p.maxLayerNum * ind;
+  int layerNum = 0, layerStartID = 0;
+  int pointElevSize = pointElev.size();
+  for (int j = 1; j <= pointElevSize; j++) {
+    if (j < pointElevSize && (pointElev[j] - pointElev[j - 1] <= p.layerGapThre || layerNum == p.maxLayerNum - 1)) {
+      continue;
+    }
+
+    int quantileID = layerStartID;
+    if (p.useSorting) quantileID += int(p.quantileZ * (j - layerStartID));
+    if (quantileID > j - 1) quantileID = j - 1;
+
+    planarVoxelLayerLow[layerInd + layerNum] = pointElev[layerStartID];
+    planarVoxelLayerHigh[layerInd + layerNum] = pointElev[j - 1];
+    planarVoxelLayerElev[layerInd + layerNum] = pointElev[quantileID];
+    layerNum++;
+    layerStartID = j;
+  }
+  planarVoxelLayerNum[ind] = layerNum;
+
+  int groundLayer = 0;
+  for (int j = 1; j < layerNum; j++) {
+    if (fabs(planarVoxelLayerElev[layerInd + j] - footElev) <
+        fabs(planarVoxelLayerElev[layerInd + groundLayer] - footElev)) {
+      groundLayer = j;
+    }
+  }
+
+  planarVoxelKeepMin[ind] = planarVoxelLayerLow[layerInd + groundLayer];
+  planarVoxelKeepMax[ind] = HUGE_VALF;
+  if (groundLayer < layerNum - 1 && planarVoxelLayerLow[layerInd + groundLayer + 1] -
+                                    planarVoxelLayerHigh[layerInd + groundLayer] >= p.layerClearance) {
+    planarVoxelKeepMax[ind] = planarVoxelLayerLow[layerInd + groundLayer + 1];
+  }
+
+  return planarVoxelLayerElev[layerInd + groundLayer];
+}
+
+int TerrainExtAnalysis::findConnRoot(int ind)
+{
+  while (planarVoxelParent[ind] != ind) {
+    planarVoxelParent[ind] = planarVoxelParent[planarVoxelParent[ind]];
+    ind = planarVoxelParent[ind];
+  }
+  return ind;
+}
+
+// planarVoxelConn is 2 for the voxels connected to the one under the vehicle, -1 for ceiling and
+// 0 otherwise, as by a breadth-first search from the voxel under the vehicle where a voxel first
+// found from a connected one more than ceilingFilteringThre above or below it is ceiling and is
+// not searched from
+
+// the voxels the search can reach are the set of the voxel under the vehicle in a union-find over
+// the pairs within reach under terrainConnThre, and it can only cut ceiling out of the set where
+// two voxels of it within reach are more than ceilingFilteringThre apart, without such a pair the
+// set is the result, with one which voxels are cut depends on the order the search finds them in,
+// so the search is run over the set
+void TerrainExtAnalysis::labelTerrainConn(float vehicleZ)
+{
+  const TerrainExtParams& p = extParams;
+  int planarVoxelWidth = p.planarVoxelWidth;
+  const int connRange = 10;
+
+  int centerInd = planarVoxelWidth * planarVoxelHalfWidth + planarVoxelHalfWidth;
+  if (planarPointElev[centerInd].size() == 0) planarVoxelElev[centerInd] = vehicleZ + p.terrainUnderVehicle;
+
+  // the labels only depend on which voxels are observed and their elevations, so they carry over
+  // while none of these changes, as when the vehicle stands still
+  bool connUnchanged = connRecValid;
+  for (int i = 0; i < planarVoxelNum && connUnchanged; i++) {
+    char observed = planarPointElev[i].size() > 0 || i == centerInd;
+    if (observed != connObservedRec[i] || (observed && planarVoxelElev[i] != connElevRec[i])) connUnchanged = false;
+  }
+  if (connUnchanged) return;
+
+  for (int i = 0; i < planarVoxelNum; i++) {
+    connObservedRec[i] = planarPointElev[i].size() > 0 || i == centerInd;
+    connElevRec[i] = planarVoxelElev[i];
+    planarVoxelParent[i] = i;
+  }
+  connRecValid = true;
+
+  // each pair of observed voxels within connRange is checked once, from the lower index
+  for (int indX = 0; indX < planarVoxelWidth; indX++) {
+    for (int indY = 0; indY < planarVoxelWidth; indY++) {
+      int ind = planarVoxelWidth * indX + indY;
+      if (!connObservedRec[ind]) continue;
+
+      // the root of ind only changes by its own unions, so it is looked up once
+      float elev = planarVoxelElev[ind];
+      int root = findConnRoot(ind);
+      for (int dX = 0; dX <= connRange && indX + dX < planarVoxelWidth; dX++) {
+        int minIndY = dX == 0 ? indY + 1 : max(indY - connRange, 0);
+        int maxIndY = min(indY + connRange, planarVoxelWidth - 1);
+        int rowInd = planarVoxelWidth * (indX + dX);
+        for (int indY2 = minIndY; indY2 <= maxIndY; indY2++) {
+          int ind2 = rowInd + indY2;
+          if (connObservedRec[ind2] && fabs(elev - planarVoxelElev[ind2]) < p.terrainConnThre &&
+              planarVoxelParent[ind2] != root) {
+            int root2 = findConnRoot(ind2);
+            if (root < root2) {
+              planarVoxelParent[root2] = root;
+            } else if (root2 < root) {
+              planarVoxelParent[root] = root2;
+              root = root2;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // lowest elevation of the set within connRange of each voxel, as a row then a column pass, two
+  // voxels of the set within reach more than ceilingFilteringThre apart show as the higher one
+  // being that much above it
+  int centerRoot = findConnRoot(centerInd);
+  for (int i = 0; i < planarVoxelNum; i++) {
+    planarVoxelInSet[i] = connObservedRec[i] && findConnRoot(i) == centerRoot;
+  }
+
+  for (int indX = 0; indX < planarVoxelWidth; indX++) {
+    for (int indY = 0; indY < planarVoxelWidth; indY++) {
+      float minElev = HUGE_VALF;
+      int maxIndY = min(indY + connRange, planarVoxelWidth - 1);
+      for (int indY2 = max(indY - connRange, 0); indY2 <= maxIndY; indY2++) {
+        int ind = planarVoxelWidth * indX + indY2;
+        if (planarVoxelInSet[ind]) minElev = min(minElev, planarVoxelElev[ind]);
+      }
+      planarVoxelMinElev[planarVoxelWidth * indX + indY] = minElev;
+    }
+  }
+
+  bool ceilingInSet = false;
+  for (int ind = 0; ind < planarVoxelNum && !ceilingInSet; ind++) {
+    if (!planarVoxelInSet[ind]) continue;
+
+    int indX = int(ind / planarVoxelWidth);
+    int indY = ind % planarVoxelWidth;
+    int maxIndX = min(indX + connRange, planarVoxelWidth - 1);
+    for (int indX2 = max(indX - connRange, 0); indX2 <= maxIndX; indX2++) {
+      if (planarVoxelElev[ind] - planarVoxelMinElev[planarVoxelWidth * indX2 + indY] > p.ceilingFilteringThre) {
+        ceilingInSet = true;
+        break;
+      }
+    }
+  }
+
+  if (!ceilingInSet) {
+    for (int i = 0; i < planarVoxelNum; i++) {
+      planarVoxelConn[i] = planarVoxelInSet[i] ? 2 : 0;
+    }
+    return;
+  }
+
+  // the search only steps to and marks voxels of the set, the others stay at 0 either way
+  for (int i = 0; i < planarVoxelNum; i++) {
+    planarVoxelConn[i] = 0;
+  }
+
+  planarVoxelQueue.clear();
+  planarVoxelQueue.push_back(centerInd);
+  planarVoxelConn[centerInd] = 1;
+  for (size_t queueID = 0; queueID < planarVoxelQueue.size(); queueID++) {
+    int front = planarVoxelQueue[queueID];
+    planarVoxelConn[front] = 2;
+
+    float elev = planarVoxelElev[front];
+    int indX = int(front / planarVoxelWidth);
+    int indY = front % planarVoxelWidth;
+    int maxIndX = min(indX + connRange, planarVoxelWidth - 1);
+    int minIndY = max(indY - connRange, 0);
+    int maxIndY = min(indY + connRange, planarVoxelWidth - 1);
+    for (int indX2 = max(indX - connRange, 0); indX2 <= maxIndX; indX2++) {
+      for (int ind = planarVoxelWidth * indX2 + minIndY; ind <= planarVoxelWidth * indX2 + maxIndY; ind++) {
+        if (planarVoxelConn[ind] == 0 && planarVoxelInSet[ind]) {
+          float elevDiff = fabs(elev - planarVoxelElev[ind]);
+          if (elevDiff < p.terrainConnThre) {
+            planarVoxelQueue.push_back(ind);
+            planarVoxelConn[ind] = 1;
+          } else if (elevDiff > p.ceilingFilteringThre) {
+            planarVoxelConn[ind] = -1;
+          }
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,367 @@
+#include <math.h>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "terrain_analysis/terrainLocalAnalysis.h"
+#include "terrain_analysis/terrainVoxelMap.h"
+
+using namespace std;
+
+const double PI = 3.1415926;
+
+TerrainLocalAnalysis::TerrainLocalAnalysis(const TerrainLocalParams& params)
+{
+  setParams(params);
+}
+
+void TerrainLocalAnalysis::setParams(const TerrainLocalParams& params)
+{
+  localParams = params;
+  if (localParams.threadNum < 1) localParams.threadNum = 1;
+  #ifndef _OPENMP
+  localParams.threadNum = 1;
+  #endif
+
+  planarVoxelHalfWidth = (localParams.planarVoxelWidth - 1) / 2;
+  planarVoxelNum = localParams.planarVoxelWidth * localParams.planarVoxelWidth;
+
+  minDyObsSlope = tan(localParams.minDyObsAngle * PI / 180.0);
+  minDyObsVFOVSlope = tan(localParams.minDyObsVFOV * PI / 180.0);
+  maxDyObsVFOVSlope = tan(localParams.maxDyObsVFOV * PI / 180.0);
+
+  planarVoxelElev.assign(planarVoxelNum, 0);
+  planarVoxelEdge.assign(planarVoxelNum, 0);
+  planarVoxelDyObs.assign(planarVoxelNum, 0);
+  planarPointElev.assign(planarVoxelNum, vector<float>());
+  planarVoxelMaxHeight.assign(planarVoxelNum, 0);
+
+  int threadNum = localParams.threadNum;
+  threadPlanarPointElev.assign((threadNum - 1) * planarVoxelNum, vector<float>());
+  threadPlanarVoxelDyObs.assign(threadNum - 1, vector<int>(planarVoxelNum, 0));
+  threadTerrainCloudElev.assign(threadNum - 1, pcl::PointCloud<pcl::PointXYZI>());
+}
+
+void TerrainLocalAnalysis::compute(const pcl::PointCloud<pcl::PointXYZI>& terrainCloud,
+                                   const pcl::PointCloud<pcl::PointXYZI>& laserCloudCrop, float vehicleX,
+                                   float vehicleY, float vehicleZ, float vehicleRoll, float vehiclePitch,
+                                   float vehicleYaw, bool markNoData,
+                                   pcl::PointCloud<pcl::PointXYZI>& terrainCloudElev)
+{
+  const TerrainLocalParams& p = localParams;
+  float planarVoxelSize = p.planarVoxelSize;
+  int planarVoxelWidth = p.planarVoxelWidth;
+  int threadNum = p.threadNum;
+
+  // estimate ground and compute elevation for each point
+  for (int i = 0; i < planarVoxelNum; i++) {
+    planarVoxelElev[i] = 0;
+    planarVoxelEdge[i] = 0;
+    planarVoxelDyObs[i] = 0;
+    planarPointElev[i].clear();
+  }
+
+  // yaw, then pitch, then roll, as one matrix
+  float sinVehicleRoll = sin(vehicleRoll), cosVehicleRoll = cos(vehicleRoll);
+  float sinVehiclePitch = sin(vehiclePitch), cosVehiclePitch = cos(vehiclePitch);
+  float sinVehicleYaw = sin(vehicleYaw), cosVehicleYaw = cos(vehicleYaw);
+  float vehicleRot[3][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+  if (p.clearDyObs) {
+    vehicleRot[0][0] = cosVehiclePitch * cosVehicleYaw;
+    vehicleRot[0][1] = cosVehiclePitch * sinVehicleYaw;
+    vehicleRot[0][2] = -sinVehiclePitch;
+    vehicleRot[1][0] = -cosVehicleRoll * sinVehicleYaw + sinVehicleRoll * sinVehiclePitch * cosVehicleYaw;
+    vehicleRot[1][1] = cosVehicleRoll * cosVehicleYaw + sinVehicleRoll * sinVehiclePitch * sinVehicleYaw;
+    vehicleRot[1][2] = sinVehicleRoll * cosVehiclePitch;
+    vehicleRot[2][0] = sinVehicleRoll * sinVehicleYaw + cosVehicleRoll * sinVehiclePitch * cosVehicleYaw;
+    vehicleRot[2][1] = -sinVehicleRoll * cosVehicleYaw + cosVehicleRoll * sinVehiclePitch * sinVehicleYaw;
+    vehicleRot[2][2] = cosVehicleRoll * cosVehiclePitch;
+  }
+
+  int terrainCloudSize = terrainCloud.points.size();
+  #ifdef _OPENMP
+  #pragma omp parallel num_threads(threadNum)
+  #endif
+  {
+    int threadID = 0;
+    #ifdef _OPENMP
+    threadID = omp_get_thread_num();
+    #endif
+    vector<float>* pointElev = planarPointElev.data();
+    int* voxelDyObs = planarVoxelDyObs.data();
+    if (threadID > 0) {
+      pointElev = &threadPlanarPointElev[(threadID - 1) * planarVoxelNum];
+      voxelDyObs = threadPlanarVoxelDyObs[threadID - 1].data();
+    }
+
+    // static scheduling hands each thread one contiguous block of points in thread order
+    #ifdef _OPENMP
+    #pragma omp for schedule(static)
+    #endif
+    for (int i = 0; i < terrainCloudSize; i++) {
+      const pcl::PointXYZI& point = terrainCloud.points[i];
+
+      int indX = int((point.x - vehicleX + planarVoxelSize / 2) / planarVoxelSize) + planarVoxelHalfWidth;
+      int indY = int((point.y - vehicleY + planarVoxelSize / 2) / planarVoxelSize) + planarVoxelHalfWidth;
+
+      if (point.x - vehicleX + planarVoxelSize / 2 < 0) indX--;
+      if (point.y - vehicleY + planarVoxelSize / 2 < 0) indY--;
+
+      if (point.z - vehicleZ > p.minRelZ && point.z - vehicleZ < p.maxRelZ) {
+        for (int dX = -1; dX <= 1; dX++) {
+          for (int dY = -1; dY <= 1; dY++) {
+            if (indX + dX >= 0 && indX + dX < planarVoxelWidth && indY + dY >= 0 && indY + dY < planarVoxelWidth) {
+              pointElev[planarVoxelWidth * (indX + dX) + indY + dY].push_back(point.z);
+            }
+          }
+        }
+      }
+
+      if (p.clearDyObs) {
+        if (indX >= 0 && indX < planarVoxelWidth && indY >= 0 && indY < planarVoxelWidth) {
+          float pointX1 = point.x - vehicleX;
+          float pointY1 = point.y - vehicleY;
+          float pointZ1 = point.z - vehicleZ;
+
+          float dis1 = sqrt(pointX1 * pointX1 + pointY1 * pointY1);
+          if (dis1 > p.minDyObsDis) {
+            if (pointZ1 - p.minDyObsRelZ > dis1 * minDyObsSlope) {
+              float pointX4 = vehicleRot[0][0] * pointX1 + vehicleRot[0][1] * pointY1 + vehicleRot[0][2] * pointZ1;
+              float pointY4 = vehicleRot[1][0] * pointX1 + vehicleRot[1][1] * pointY1 + vehicleRot[1][2] * pointZ1;
+              float pointZ4 = vehicleRot[2][0] * pointX1 + vehicleRot[2][1] * pointY1 + vehicleRot[2][2] * pointZ1;
+
+              float dis4 = sqrt(pointX4 * pointX4 + pointY4 * pointY4);
+              if ((pointZ4 > dis4 * minDyObsVFOVSlope && pointZ4 < dis4 * maxDyObsVFOVSlope) ||
+                  fabs(pointZ4) < p.absDyObsRelZThre) {
+                voxelDyObs[planarVoxelWidth * indX + indY]++;
+              }
+            }
+          } else {
+            voxelDyObs[planarVoxelWidth * indX + indY] += p.minDyObsPointNum;
+          }
+        }
+      }
+    }
+  }
+
+  #ifdef _OPENMP
+  #pragma omp parallel for num_threads(threadNum) schedule(static)
+  #endif
+  for (int i = 0; i < planarVoxelNum; i++) {
+    for (int j = 0; j < threadNum - 1; j++) {
+      vector<float>& pointElev = threadPlanarPointElev[j * planarVoxelNum + i];
+      planarPointElev[i].insert(planarPointElev[i].end(), pointElev.begin(), pointElev.end());
+      pointElev.clear();
+
+      planarVoxelDyObs[i] += threadPlanarVoxelDyObs[j][i];
+      threadPlanarVoxelDyObs[j][i] = 0;
+    }
+  }
+
+  if (p.clearDyObs) {
+    int laserCloudCropSize = laserCloudCrop.points.size();
+    #ifdef _OPENMP
+    #pragma omp parallel for num_threads(threadNum) schedule(static)
+    #endif
+    for (int i = 0; i < laserCloudCropSize; i++) {
+      const pcl::PointXYZI& point = laserCloudCrop.points[i];
+
+      int indX = int((point.x - vehicleX + planarVoxelSize / 2) / planarVoxelSize) + planarVoxelHalfWidth;
+      int indY = int((point.y - vehicleY + planarVoxelSize / 2) / planarVoxelSize) + planarVoxelHalfWidth;
+
+      if (point.x - vehicleX + planarVoxelSize / 2 < 0) indX--;
+      if (point.y - vehicleY + planarVoxelSize / 2 < 0) indY--;
+
+      if (indX >= 0 && indX < planarVoxelWidth && indY >= 0 && indY < planarVoxelWidth) {
+        float pointX1 = point.x - vehicleX;
+        float pointY1 = point.y - vehicleY;
+        float pointZ1 = point.z - vehicleZ;
+
+        // straight above or below the vehicle the angle is +-90 deg, or 0 deg right at
+        // minDyObsRelZ, which a negative minDyObsAngle still lets through
+        float dis1 = sqrt(pointX1 * pointX1 + pointY1 * pointY1);
+        double relZ1 = pointZ1 - p.minDyObsRelZ;
+        if (relZ1 > dis1 * minDyObsSlope || (dis1 == 0 && relZ1 == 0 && p.minDyObsAngle < 0)) {
+          #ifdef _OPENMP
+          #pragma omp atomic write
+          #endif
+          planarVoxelDyObs[planarVoxelWidth * indX + indY] = 0;
+        }
+      }
+    }
+  }
+
+  #ifdef _OPENMP
+  #pragma omp parallel for num_threads(threadNum) schedule(dynamic, 64)
+  #endif
+  for (int i = 0; i < planarVoxelNum; i++) {
+    if (planarPointElev[i].size() > 0) {
+      planarVoxelElev[i] = planarVoxelGround(planarPointElev[i], p.useSorting, p.quantileZ, p.limitGroundLift,
+                                             p.maxGroundLift);
+    }
+  }
+
+  // the buckets are emptied up front, the runtime may start fewer threads than asked for and the
+  // buckets of threads that do not run are still appended below
+  terrainCloudElev.clear();
+  for (int i = 0; i < threadNum - 1; i++) {
+    threadTerrainCloudElev[i].clear();
+  }
+
+  #ifdef _OPENMP
+  #pragma omp parallel num_threads(threadNum)
+  #endif
+  {
+    int threadID = 0;
+    #ifdef _OPENMP
+    threadID = omp_get_thread_num();
+    #endif
+    pcl::PointCloud<pcl::PointXYZI>& cloudElev = threadID > 0 ? threadTerrainCloudElev[threadID - 1] : terrainCloudElev;
+
+    #ifdef _OPENMP
+    #pragma omp for schedule(static)
+    #endif
+    for (int i = 0; i < terrainCloudSize; i++) {
+      pcl::PointXYZI point = terrainCloud.points[i];
+      if (point.z - vehicleZ > p.minRelZ && point.z - vehicleZ < p.maxRelZ) {
+        int indX = int((point.x - vehicleX + planarVoxelSize / 2) / planarVoxelSize) + planarVoxelHalfWidth;
+        int indY = int((point.y - vehicleY + planarVoxelSize / 2) / planarVoxelSize) + planarVoxelHalfWidth;
+
+        if (point.x - vehicleX + planarVoxelSize / 2 < 0) indX--;
+        if (point.y - vehicleY + planarVoxelSize / 2 < 0) indY--;
+
+        if (indX >= 0 && indX < planarVoxelWidth && indY >= 0 && indY < planarVoxelWidth) {
+          int ind = planarVoxelWidth * indX + indY;
+          if (planarVoxelDyObs[ind] < p.minDyObsPointNum || !p.clearDyObs) {
+            float disZ = point.z - planarVoxelElev[ind];
+            if (p.considerDrop) disZ = fabs(disZ);
+            int planarPointElevSize = planarPointElev[ind].size();
+            if (disZ >= 0 && disZ < p.vehicleHeight && planarPointElevSize >= p.minBlockPointNum) {
+              point.intensity = disZ;
+              cloudElev.push_back(point);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  for (int i = 0; i < threadNum - 1; i++) {
+    terrainCloudElev += threadTerrainCloudElev[i];
+  }
+
+  if (p.noDataObstacle && markNoData) {
+    for (int i = 0; i < planarVoxelNum; i++) {
+      int indX = int(i / planarVoxelWidth);
+      int indY = i % planarVoxelWidth;
+
+      float pointX1 = planarVoxelSize * (indX - planarVoxelHalfWidth);
+      float pointY1 = planarVoxelSize * (indY - planarVoxelHalfWidth);
+
+      float pointX2 = pointX1 * cosVehicleYaw + pointY1 * sinVehicleYaw;
+      float pointY2 = -pointX1 * sinVehicleYaw + pointY1 * cosVehicleYaw;
+
+      if (pointX2 > p.noDataAreaMinX && pointX2 < p.noDataAreaMaxX && pointY2 > p.noDataAreaMinY &&
+          pointY2 < p.noDataAreaMaxY) {
+        int planarPointElevSize = planarPointElev[i].size();
+        if (planarPointElevSize < p.minBlockPointNum || planarVoxelElev[i] - vehicleZ < p.maxElevBelowVeh) {
+          planarVoxelEdge[i] = 1;
+        }
+      }
+    }
+
+    for (int noDataBlockSkipCount = 0; noDataBlockSkipCount < p.noDataBlockSkipNum; noDataBlockSkipCount++) {
+      for (int i = 0; i < planarVoxelNum; i++) {
+        if (planarVoxelEdge[i] >= 1) {
+          int indX = int(i / planarVoxelWidth);
+          int indY = i % planarVoxelWidth;
+          bool edgeVoxel = false;
+          for (int dX = -1; dX <= 1; dX++) {
+            for (int dY = -1; dY <= 1; dY++) {
+              if (indX + dX >= 0 && indX + dX < planarVoxelWidth && indY + dY >= 0 && indY + dY < planarVoxelWidth) {
+                if (planarVoxelEdge[planarVoxelWidth * (indX + dX) + indY + dY] < planarVoxelEdge[i]) {
+                  edgeVoxel = true;
+                }
+              }
+            }
+          }
+
+          if (!edgeVoxel) planarVoxelEdge[i]++;
+        }
+      }
+    }
+
+    pcl::PointXYZI point;
+    for (int i = 0; i < planarVoxelNum; i++) {
+      if (planarVoxelEdge[i] > p.noDataBlockSkipNum) {
+        int indX = int(i / planarVoxelWidth);
+        int indY = i % planarVoxelWidth;
+
+        point.x = planarVoxelSize * (indX - planarVoxelHalfWidth) + vehicleX;
+        point.y = planarVoxelSize * (indY - planarVoxelHalfWidth) + vehicleY;
+        point.z = vehicleZ;
+        point.intensity = p.vehicleHeight;
+
+        point.x -= planarVoxelSize / 4.0;
+        point.y -= planarVoxelSize / 4.0;
+        terrainCloudElev.push_back(point);
+
+        point.x += planarVoxelSize / 2.0;
+        terrainCloudElev.push_back(point);
+
+        point.y += planarVoxelSize / 2.0;
+        terrainCloudElev.push_back(point);
+
+        point.x -= planarVoxelSize / 2.0;
+        terrainCloudElev.push_back(point);
+      }
+    }
+  }
+}
+
+void TerrainLocalAnalysis::computeGrid(const pcl::PointCloud<pcl::PointXYZI>& terrainCloudElev, float vehicleX,
+                                       float vehicleY, float elevGridObsThre, vector<int8_t>& occupancy,
+                                       vector<float>& layers)
+{
+  float planarVoxelSize = localParams.planarVoxelSize;
+  int planarVoxelWidth = localParams.planarVoxelWidth;
+
+  for (int i = 0; i < planarVoxelNum; i++) {
+    planarVoxelMaxHeight[i] = 0;
+  }
+
+  int terrainCloudElevSize = terrainCloudElev.points.size();
+  for (int i = 0; i < terrainCloudElevSize; i++) {
+    const pcl::PointXYZI& point = terrainCloudElev.points[i];
+
+    int indX = int((point.x - vehicleX + planarVoxelSize / 2) / planarVoxelSize) + planarVoxelHalfWidth;
+    int indY = int((point.y - vehicleY + planarVoxelSize / 2) / planarVoxelSize) + planarVoxelHalfWidth;
+
+    if (point.x - vehicleX + planarVoxelSize / 2 < 0) indX--;
+    if (point.y - vehicleY + planarVoxelSize / 2 < 0) indY--;
+
+    if (indX >= 0 && indX < planarVoxelWidth && indY >= 0 && indY < planarVoxelWidth) {
+      int ind = planarVoxelWidth * indX + indY;
+      if (planarVoxelMaxHeight[ind] < point.intensity) planarVoxelMaxHeight[ind] = point.intensity;
+    }
+  }
+
+  occupancy.resize(planarVoxelNum);
+  layers.resize(3 * planarVoxelNum);
+  for (int i = 0; i < planarVoxelNum; i++) {
+    int indX = int(i / planarVoxelWidth);
+    int indY = i % planarVoxelWidth;
+
+    bool observed = int(planarPointElev[i].size()) >= localParams.minBlockPointNum;
+    int8_t cellOccupancy = -1;
+    if (planarVoxelMaxHeight[i] >= elevGridObsThre) cellOccupancy = 100;
+    else if (observed) cellOccupancy = 0;
+    occupancy[planarVoxelWidth * indY + indX] = cellOccupancy;
+
+    layers[i] = observed ? planarVoxelElev[i] : NAN;
+    layers[planarVoxelNum + i] = planarVoxelMaxHeight[i];
+    layers[2 * planarVoxelNum + i] = observed ? 1.0 : 0;
+  }
+}
@@ -0,0 +1,171 @@
+#include <math.h>
+#include <algorithm>
+
+#include "terrain_analysis/terrainVoxelMap.h"
+
+using namespace std;
+
+TerrainVoxelMap::TerrainVoxelMap(const TerrainVoxelMapParams& params)
+  : voxelCloud(params.terrainVoxelWidth), cloudDwz(new pcl::PointCloud<pcl::PointXYZI>())
+{
+  setParams(params);
+}
+
+void TerrainVoxelMap::setParams(const TerrainVoxelMapParams& params)
+{
+  mapParams = params;
+  halfWidth = (mapParams.terrainVoxelWidth - 1) / 2;
+  shiftX = 0;
+  shiftY = 0;
+
+  int voxelNum = mapParams.terrainVoxelWidth * mapParams.terrainVoxelWidth;
+  voxelCloud = RollingVoxelGrid<pcl::PointCloud<pcl::PointXYZI>::Ptr>(mapParams.terrainVoxelWidth);
+  for (int i = 0; i < voxelNum; i++) {
+    voxelCloud[i].reset(new pcl::PointCloud<pcl::PointXYZI>());
+  }
+  voxelUpdateNum.assign(voxelNum, 0);
+  voxelUpdateTime.assign(voxelNum, 0);
+
+  downSizeFilter.setLeafSize(mapParams.scanVoxelSize, mapParams.scanVoxelSize, mapParams.scanVoxelSize);
+}
+
+void TerrainVoxelMap::cropScan(const pcl::PointCloud<pcl::PointXYZI>& scan, float vehicleX, float vehicleY,
+                               float vehicleZ, double scanTime, pcl::PointCloud<pcl::PointXYZI>& cloudCrop) const
+{
+  int scanSize = scan.points.size();
+  for (int i = 0; i < scanSize; i++) {
+    pcl::PointXYZI point = scan.points[i];
+
+    float dis = sqrt((point.x - vehicleX) * (point.x - vehicleX) + (point.y - vehicleY) * (point.y - vehicleY));
+    if (inCropRange(point.z - vehicleZ, dis)) {
+      point.intensity = scanTime;
+      cloudCrop.push_back(point);
+    }
+  }
+}
+
+void TerrainVoxelMap::update(const pcl::PointCloud<pcl::PointXYZI>& cloudCrop, float vehicleX, float vehicleY,
+                             float vehicleZ, double scanTime, bool clearingCloud, double clearingDis)
+{
+  const TerrainVoxelMapParams& p = mapParams;
+  int width = p.terrainVoxelWidth;
+  float voxelSize = p.terrainVoxelSize;
+
+  // roll over, only the entering row or column is cleared
+  float voxelCenX = voxelSize * shiftX;
+  float voxelCenY = voxelSize * shiftY;
+
+  while (vehicleX - voxelCenX < -voxelSize) {
+    voxelCloud.shiftX(-1);
+    for (int indY = 0; indY < width; indY++) {
+      voxelCloud.at(0, indY)->clear();
+    }
+    shiftX--;
+    voxelCenX = voxelSize * shiftX;
+  }
+
+  while (vehicleX - voxelCenX > voxelSize) {
+    voxelCloud.shiftX(1);
+    for (int indY = 0; indY < width; indY++) {
+      voxelCloud.at(width - 1, indY)->clear();
+    }
+    shiftX++;
+    voxelCenX = voxelSize * shiftX;
+  }
+
+  while (vehicleY - voxelCenY < -voxelSize) {
+    voxelCloud.shiftY(-1);
+    for (int indX = 0; indX < width; indX++) {
+      voxelCloud.at(indX, 0)->clear();
+    }
+    shiftY--;
+    voxelCenY = voxelSize * shiftY;
+  }
+
+  while (vehicleY - voxelCenY > voxelSize) {
+    voxelCloud.shiftY(1);
+    for (int indX = 0; indX < width; indX++) {
+      voxelCloud.at(indX, width - 1)->clear();
+    }
+    shiftY++;
+    voxelCenY = voxelSize * shiftY;
+  }
+
+  // stack the cropped scan
+  int cloudCropSize = cloudCrop.points.size();
+  for (int i = 0; i < cloudCropSize; i++) {
+    const pcl::PointXYZI& point = cloudCrop.points[i];
+
+    int indX = int((point.x - vehicleX + voxelSize / 2) / voxelSize) + halfWidth;
+    int indY = int((point.y - vehicleY + voxelSize / 2) / voxelSize) + halfWidth;
+
+    if (point.x - vehicleX + voxelSize / 2 < 0) indX--;
+    if (point.y - vehicleY + voxelSize / 2 < 0) indY--;
+
+    if (indX >= 0 && indX < width && indY >= 0 && indY < width) {
+      voxelCloud[width * indX + indY]->push_back(point);
+      voxelUpdateNum[width * indX + indY]++;
+    }
+  }
+
+  // downsample, decay and clear the voxels due
+  int voxelNum = width * width;
+  for (int ind = 0; ind < voxelNum; ind++) {
+    if (voxelUpdateNum[ind] >= p.voxelPointUpdateThre || scanTime - voxelUpdateTime[ind] >= p.voxelTimeUpdateThre ||
+        clearingCloud) {
+      pcl::PointCloud<pcl::PointXYZI>::Ptr voxelCloudPtr = voxelCloud[ind];
+
+      cloudDwz->clear();
+      downSizeFilter.setInputCloud(voxelCloudPtr);
+      downSizeFilter.filter(*cloudDwz);
+
+      voxelCloudPtr->clear();
+      int cloudDwzSize = cloudDwz->points.size();
+      for (int i = 0; i < cloudDwzSize; i++) {
+        const pcl::PointXYZI& point = cloudDwz->points[i];
+        float dis = sqrt((point.x - vehicleX) * (point.x - vehicleX) + (point.y - vehicleY) * (point.y - vehicleY));
+        if (point.z - vehicleZ > p.minRelZ - p.disRatioZ * dis && point.z - vehicleZ < p.maxRelZ + p.disRatioZ * dis &&
+            (scanTime - point.intensity < p.decayTime || dis < p.noDecayDis) &&
+            !(dis < clearingDis && clearingCloud)) {
+          voxelCloudPtr->push_back(point);
+        }
+      }
+
+      voxelUpdateNum[ind] = 0;
+      voxelUpdateTime[ind] = scanTime;
+    }
+  }
+}
+
+void TerrainVoxelMap::collect(int halfRange, pcl::PointCloud<pcl::PointXYZI>& cloud) const
+{
+  int width = mapParams.terrainVoxelWidth;
+  for (int indX = halfWidth - halfRange; indX <= halfWidth + halfRange; indX++) {
+    for (int indY = halfWidth - halfRange; indY <= halfWidth + halfRange; indY++) {
+      if (indX >= 0 && indX < width && indY >= 0 && indY < width) {
+        cloud += *voxelCloud.at(indX, indY);
+      }
+    }
+  }
+}
+
+float planarVoxelGround(vector<float>& pointElev, bool useSorting, double quantileZ, bool limitGroundLift,
+                        double maxGroundLift)
+{
+  int pointElevSize = pointElev.size();
+  if (!useSorting) return *min_element(pointElev.begin(), pointElev.end());
+
+  int quantileID = int(quantileZ * pointElevSize);
+  if (quantileID < 0) quantileID = 0;
+  else if (quantileID >= pointElevSize) quantileID = pointElevSize - 1;
+
+  // only the quantile element is placed, everything before it is no higher, so the minimum is
+  // searched there instead of sorting the whole cell
+  nth_element(pointElev.begin(), pointElev.begin() + quantileID, pointElev.end());
+  float quantileElev = pointElev[quantileID];
+  if (!limitGroundLift) return quantileElev;
+
+  float minElev = *min_element(pointElev.begin(), pointElev.begin() + quantileID + 1);
+  if (quantileElev > minElev + maxGroundLift) return minElev + maxGroundLift;
+  return quantileElev;
+}
@@ -0,0 +1,106 @@
+#ifndef GOLDEN_SCANS_H
+#define GOLDEN_SCANS_H
+
+#include <math.h>
+#include <string.h>
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+// the scan sequence of the golden tests of both levels, scanNum scans 0.125 s apart with the vehicle
+// driving up a ramp along +x, past a box, a platform too high to be reached and a ceiling over the
+// -x, +y side that hides the ground under its far half, every scan point sits at the center of a
+// scanVoxelSize cell and no cell is hit by two scans, so downsampling a voxel keeps its points
+const int scanNum = 20;
+const float scanVoxelSize = 0.1;
+
+inline int cellScan(int indX, int indY)
+{
+  uint32_t hash = uint32_t(indX) * 73856093u ^ uint32_t(indY) * 19349663u;
+  hash ^= hash >> 13;
+  hash *= 0x5bd1e995u;
+  hash ^= hash >> 15;
+  return hash % scanNum;
+}
+
+inline void scanPose(int scan, float& vehicleX, float& vehicleY, float& vehicleZ)
+{
+  vehicleX = 0.35 * scan - 2.0;
+  vehicleY = 0.1 * scan;
+  vehicleZ = 0.75;
+}
+
+inline void makeScan(int scan, pcl::PointCloud<pcl::PointXYZI>& scanCloud)
+{
+  float vehicleX, vehicleY, vehicleZ;
+  scanPose(scan, vehicleX, vehicleY, vehicleZ);
+  int cenX = int(floor(vehicleX / scanVoxelSize)), cenY = int(floor(vehicleY / scanVoxelSize));
+
+  scanCloud.clear();
+  pcl::PointXYZI point;
+  point.intensity = 0;
+  for (int indX = cenX - 100; indX <= cenX + 100; indX++) {
+    for (int indY = cenY - 100; indY <= cenY + 100; indY++) {
+      if (cellScan(indX, indY) != scan) continue;
+
+      point.x = scanVoxelSize * (indX + 0.5);
+      point.y = scanVoxelSize * (indY + 0.5);
+      point.z = point.x > 3.0 ? std::min(0.3f * (point.x - 3.0f), 1.5f) : 0;
+      if (point.x > 1.0 && point.x < 2.0 && point.y > -3.0 && point.y < -2.0) point.z = 1.0;
+      if (point.x > -6.0 && point.x < -3.0 && point.y > -9.0 && point.y < -6.0) point.z = 1.2;
+
+      bool underCeiling = point.x > -14.0 && point.x < -8.0 && point.y > 4.0 && point.y < 12.0;
+      if (!underCeiling || point.y < 8.0) scanCloud.push_back(point);
+      if (underCeiling) {
+        point.z = 2.4;
+        scanCloud.push_back(point);
+      }
+    }
+  }
+}
+
+// the local terrain map handed in with each scan, a ring of points around the vehicle with their
+// height above the ground as intensity
+inline void makeLocalCloud(int scan, pcl::PointCloud<pcl::PointXYZI>& terrainCloudLocal)
+{
+  float vehicleX, vehicleY, vehicleZ;
+  scanPose(scan, vehicleX, vehicleY, vehicleZ);
+
+  terrainCloudLocal.clear();
+  pcl::PointXYZI point;
+  for (int i = 0; i < 60; i++) {
+    float dis = 1.0 + 0.1 * (i % 40);
+    point.x = vehicleX + dis * cos(0.37 * i);
+    point.y = vehicleY + dis * sin(0.37 * i);
+    point.z = 0.02 * (i % 7);
+    point.intensity = 0.05 * (i % 5);
+    terrainCloudLocal.push_back(point);
+  }
+}
+
+// FNV-1a over the points ordered by their bits, the output order depends on how the voxels keep
+// their points and is not part of the golden output
+inline uint64_t cloudHash(const pcl::PointCloud<pcl::PointXYZI>& cloud)
+{
+  std::vector<std::vector<uint32_t>> pointBits;
+  for (const pcl::PointXYZI& point : cloud.points) {
+    std::vector<uint32_t> bits(4);
+    memcpy(&bits[0], &point.x, 4);
+    memcpy(&bits[1], &point.y, 4);
+    memcpy(&bits[2], &point.z, 4);
+    memcpy(&bits[3], &point.intensity, 4);
+    pointBits.push_back(bits);
+  }
+  std::sort(pointBits.begin(), pointBits.end());
+
+  uint64_t hash = 1469598103934665603ull;
+  for (const std::vector<uint32_t>& bits : pointBits) {
+    for (uint32_t b : bits) hash = (hash ^ b) * 1099511628211ull;
+  }
+  return hash;
+}
+
+#endif
@@ -0,0 +1,121 @@
+#include <math.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "terrain_analysis/terrainVoxelMap.h"
+
+using namespace std;
+
+namespace
+{
+
+// the ground pick terrainAnalysis made by sorting the whole cell
+float sortedVoxelGround(vector<float> pointElev, bool useSorting, double quantileZ, bool limitGroundLift,
+                        double maxGroundLift)
+{
+  int pointElevSize = pointElev.size();
+  if (!useSorting) return *min_element(pointElev.begin(), pointElev.end());
+
+  sort(pointElev.begin(), pointElev.end());
+
+  int quantileID = int(quantileZ * pointElevSize);
+  if (quantileID < 0) quantileID = 0;
+  else if (quantileID >= pointElevSize) quantileID = pointElevSize - 1;
+
+  if (pointElev[quantileID] > pointElev[0] + maxGroundLift && limitGroundLift) {
+    return pointElev[0] + maxGroundLift;
+  }
+  return pointElev[quantileID];
+}
+
+// cells as they are gathered from a terrain scan, elevations quantized to quantStep so many are
+// tied, a ground band with obstacle points above it, and sizes from a single point up
+vector<vector<float> > testCells(unsigned seed, float quantStep)
+{
+  mt19937 generator(seed);
+  uniform_real_distribution<float> groundDist(-0.05, 0.05);
+  uniform_real_distribution<float> obstacleDist(0.1, 1.5);
+  uniform_real_distribution<float> unitDist(0, 1);
+
+  const int cellSizes[] = {1, 2, 3, 4, 5, 7, 10, 16, 33, 100, 257, 1000, 3000};
+  vector<vector<float> > cells;
+  for (int cellSize : cellSizes) {
+    for (float obstacleRate : {0.0f, 0.3f, 0.8f}) {
+      vector<float> cell;
+      for (int i = 0; i < cellSize; i++) {
+        float elev = unitDist(generator) < obstacleRate ? obstacleDist(generator) : groundDist(generator);
+        if (quantStep > 0) elev = quantStep * round(elev / quantStep);
+        cell.push_back(elev);
+      }
+      cells.push_back(cell);
+    }
+  }
+
+  // all tied, and two values only
+  cells.push_back(vector<float>(50, 0.3));
+  vector<float> twoValues;
+  for (int i = 0; i < 40; i++) twoValues.push_back(i % 3 == 0 ? 0 : 0.5);
+  cells.push_back(twoValues);
+  return cells;
+}
+
+void expectMatchesSort(const vector<vector<float> >& cells)
+{
+  const double quantileZs[] = {0, 0.1, 0.25, 0.5, 0.75, 0.999, 1.0};
+  const double maxGroundLifts[] = {0, 0.05, 0.15, 1.0};
+  for (size_t c = 0; c < cells.size(); c++) {
+    for (bool useSorting : {false, true}) {
+      for (double quantileZ : quantileZs) {
+        for (bool limitGroundLift : {false, true}) {
+          for (double maxGroundLift : maxGroundLifts) {
+            vector<float> pointElev = cells[c];
+            float elev = planarVoxelGround(pointElev, useSorting, quantileZ, limitGroundLift, maxGroundLift);
+            EXPECT_EQ(elev, sortedVoxelGround(cells[c], useSorting, quantileZ, limitGroundLift, maxGroundLift))
+                << "cell " << c << " of " << cells[c].size() << " points, quantileZ " << quantileZ
+                << ", limitGroundLift " << limitGroundLift << ", maxGroundLift " << maxGroundLift;
+
+            // only reordered
+            sort(pointElev.begin(), pointElev.end());
+            vector<float> sortedCell = cells[c];
+            sort(sortedCell.begin(), sortedCell.end());
+            EXPECT_EQ(pointElev, sortedCell);
+          }
+        }
+      }
+    }
+  }
+}
+
+}
+
+TEST(PlanarVoxelGround, MatchesSortOnContinuousElevations)
+{
+  expectMatchesSort(testCells(1, 0));
+  expectMatchesSort(testCells(2, 0));
+}
+
+TEST(PlanarVoxelGround, MatchesSortOnQuantizedElevations)
+{
+  // coarse steps tie most of a cell, the lift limit then often lands on a tie as well
+  for (float quantStep : {0.001f, 0.01f, 0.05f, 0.15f}) {
+    expectMatchesSort(testCells(3, quantStep));
+  }
+}
+
+TEST(PlanarVoxelGround, LimitsLiftAboveLowest)
+{
+  // 30 of 100 points on a 0.4 m step, the 0.75 quantile lands on the step
+  vector<float> cell;
+  for (int i = 0; i < 100; i++) cell.push_back(i < 30 ? 0.4 : 0.0);
+  vector<float> pointElev = cell;
+  EXPECT_FLOAT_EQ(planarVoxelGround(pointElev, true, 0.75, false, 0.15), 0.4);
+  pointElev = cell;
+  EXPECT_FLOAT_EQ(planarVoxelGround(pointElev, true, 0.75, true, 0.15), 0.15);
+  pointElev = cell;
+  EXPECT_FLOAT_EQ(planarVoxelGround(pointElev, true, 0.25, true, 0.15), 0.0);
+  pointElev = cell;
+  EXPECT_FLOAT_EQ(planarVoxelGround(pointElev, false, 0.75, true, 0.15), 0.0);
+}
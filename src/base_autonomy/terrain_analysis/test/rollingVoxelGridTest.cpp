@@ -0,0 +1,236 @@
+#include <math.h>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "terrain_analysis/rollingVoxelGrid.h"
+
+using namespace std;
+
+namespace
+{
+
+typedef shared_ptr<vector<int> > CellPtr;
+
+// the grid as terrainAnalysis kept it before, an array of cell pointers shifted one row or
+// column at a time with the cell leaving on one side cleared and put in on the other
+class ShiftedVoxelGrid
+{
+public:
+  explicit ShiftedVoxelGrid(int width) : width(width), cells(width * width)
+  {
+    for (int i = 0; i < width * width; i++) cells[i].reset(new vector<int>());
+  }
+
+  void shiftXNeg()
+  {
+    for (int indY = 0; indY < width; indY++) {
+      CellPtr cellPtr = cells[width * (width - 1) + indY];
+      for (int indX = width - 1; indX >= 1; indX--) {
+        cells[width * indX + indY] = cells[width * (indX - 1) + indY];
+      }
+      cells[indY] = cellPtr;
+      cells[indY]->clear();
+    }
+  }
+
+  void shiftXPos()
+  {
+    for (int indY = 0; indY < width; indY++) {
+      CellPtr cellPtr = cells[indY];
+      for (int indX = 0; indX < width - 1; indX++) {
+        cells[width * indX + indY] = cells[width * (indX + 1) + indY];
+      }
+      cells[width * (width - 1) + indY] = cellPtr;
+      cells[width * (width - 1) + indY]->clear();
+    }
+  }
+
+  void shiftYNeg()
+  {
+    for (int indX = 0; indX < width; indX++) {
+      CellPtr cellPtr = cells[width * indX + (width - 1)];
+      for (int indY = width - 1; indY >= 1; indY--) {
+        cells[width * indX + indY] = cells[width * indX + (indY - 1)];
+      }
+      cells[width * indX] = cellPtr;
+      cells[width * indX]->clear();
+    }
+  }
+
+  void shiftYPos()
+  {
+    for (int indX = 0; indX < width; indX++) {
+      CellPtr cellPtr = cells[width * indX];
+      for (int indY = 0; indY < width - 1; indY++) {
+        cells[width * indX + indY] = cells[width * indX + (indY + 1)];
+      }
+      cells[width * indX + (width - 1)] = cellPtr;
+      cells[width * indX + (width - 1)]->clear();
+    }
+  }
+
+  int width;
+  vector<CellPtr> cells;
+};
+
+// the rolling grid moved as TerrainVoxelMap::update() does, clearing the entering row or column
+class RolledVoxelGrid
+{
+public:
+  explicit RolledVoxelGrid(int width) : width(width), grid(width)
+  {
+    for (int i = 0; i < width * width; i++) grid[i].reset(new vector<int>());
+  }
+
+  void shiftXNeg()
+  {
+    grid.shiftX(-1);
+    for (int indY = 0; indY < width; indY++) grid.at(0, indY)->clear();
+  }
+
+  void shiftXPos()
+  {
+    grid.shiftX(1);
+    for (int indY = 0; indY < width; indY++) grid.at(width - 1, indY)->clear();
+  }
+
+  void shiftYNeg()
+  {
+    grid.shiftY(-1);
+    for (int indX = 0; indX < width; indX++) grid.at(indX, 0)->clear();
+  }
+
+  void shiftYPos()
+  {
+    grid.shiftY(1);
+    for (int indX = 0; indX < width; indX++) grid.at(indX, width - 1)->clear();
+  }
+
+  int width;
+  RollingVoxelGrid<CellPtr> grid;
+};
+
+// the voxel shift loops of terrainAnalysis, voxel centers every voxelSize, the grid follows the
+// vehicle once it is more than a voxel away from the center
+template <typename Grid>
+void followVehicle(float vehicleX, float vehicleY, float voxelSize, int& shiftX, int& shiftY, Grid& grid)
+{
+  float voxelCenX = voxelSize * shiftX;
+  float voxelCenY = voxelSize * shiftY;
+
+  while (vehicleX - voxelCenX < -voxelSize) {
+    grid.shiftXNeg();
+    shiftX--;
+    voxelCenX = voxelSize * shiftX;
+  }
+  while (vehicleX - voxelCenX > voxelSize) {
+    grid.shiftXPos();
+    shiftX++;
+    voxelCenX = voxelSize * shiftX;
+  }
+  while (vehicleY - voxelCenY < -voxelSize) {
+    grid.shiftYNeg();
+    shiftY--;
+    voxelCenY = voxelSize * shiftY;
+  }
+  while (vehicleY - voxelCenY > voxelSize) {
+    grid.shiftYPos();
+    shiftY++;
+    voxelCenY = voxelSize * shiftY;
+  }
+}
+
+// a random walk of the vehicle with points stacked around it after each move, the contents of
+// every cell must match the shifted grid, by flat index and by indX, indY
+void expectRandomWalkMatches(int width, float voxelSize, float maxStep, unsigned seed)
+{
+  mt19937 generator(seed);
+  uniform_real_distribution<float> stepDist(-maxStep, maxStep);
+  uniform_int_distribution<int> cellDist(0, width * width - 1);
+  uniform_int_distribution<int> pointNumDist(0, 20);
+
+  ShiftedVoxelGrid shifted(width);
+  RolledVoxelGrid rolled(width);
+  int shiftedShiftX = 0, shiftedShiftY = 0;
+  int rolledShiftX = 0, rolledShiftY = 0;
+
+  float vehicleX = 0, vehicleY = 0;
+  int pointID = 0;
+  for (int step = 0; step < 500; step++) {
+    // long straight runs now and then, so the grid also moves several cells at once
+    float stepX = stepDist(generator), stepY = stepDist(generator);
+    if (step % 50 == 49) {
+      stepX *= 2 * width;
+      stepY *= 2 * width;
+    }
+    vehicleX += stepX;
+    vehicleY += stepY;
+
+    followVehicle(vehicleX, vehicleY, voxelSize, shiftedShiftX, shiftedShiftY, shifted);
+    followVehicle(vehicleX, vehicleY, voxelSize, rolledShiftX, rolledShiftY, rolled);
+    ASSERT_EQ(shiftedShiftX, rolledShiftX);
+    ASSERT_EQ(shiftedShiftY, rolledShiftY);
+
+    int pointNum = pointNumDist(generator);
+    for (int i = 0; i < pointNum; i++) {
+      int ind = cellDist(generator);
+      shifted.cells[ind]->push_back(pointID);
+      rolled.grid[ind]->push_back(pointID);
+      pointID++;
+    }
+
+    set<vector<int>*> cellPtrs;
+    for (int indX = 0; indX < width; indX++) {
+      for (int indY = 0; indY < width; indY++) {
+        int ind = width * indX + indY;
+        ASSERT_EQ(*rolled.grid.at(indX, indY), *shifted.cells[ind])
+            << "step " << step << ", cell " << indX << ", " << indY;
+        ASSERT_EQ(rolled.grid.at(indX, indY), rolled.grid[ind]);
+        cellPtrs.insert(rolled.grid[ind].get());
+      }
+    }
+
+    // every cell is still its own
+    ASSERT_EQ(int(cellPtrs.size()), width * width);
+  }
+}
+
+}
+
+TEST(RollingVoxelGrid, RandomWalkMatchesShiftedGrid)
+{
+  // the terrain voxels of terrainAnalysis and of its extended level
+  expectRandomWalkMatches(21, 1.0, 0.6, 1);
+  expectRandomWalkMatches(41, 2.0, 1.5, 2);
+}
+
+TEST(RollingVoxelGrid, RandomWalkMatchesShiftedGridSmall)
+{
+  // steps of many cells wrap the origin around repeatedly
+  expectRandomWalkMatches(1, 1.0, 3.0, 3);
+  expectRandomWalkMatches(2, 1.0, 3.0, 4);
+  expectRandomWalkMatches(5, 0.5, 2.0, 5);
+}
+
+TEST(RollingVoxelGrid, ShiftAndBackRestoresLayout)
+{
+  RollingVoxelGrid<int> grid(4);
+  for (int i = 0; i < grid.size(); i++) grid[i] = i;
+
+  grid.shiftX(1);
+  grid.shiftY(-1);
+  EXPECT_EQ(grid.at(0, 1), 4);
+  EXPECT_EQ(grid.at(3, 0), 3);
+  grid.shiftY(1);
+  grid.shiftX(-1);
+  for (int i = 0; i < grid.size(); i++) EXPECT_EQ(grid[i], i);
+
+  // a zero direction does not move the window
+  grid.shiftX(0);
+  grid.shiftY(0);
+  for (int i = 0; i < grid.size(); i++) EXPECT_EQ(grid[i], i);
+}
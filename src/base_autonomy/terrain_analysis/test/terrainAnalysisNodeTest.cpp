@@ -0,0 +1,182 @@
+#include <math.h>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "rclcpp/rclcpp.hpp"
+#include "nav_msgs/msg/odometry.hpp"
+#include "sensor_msgs/msg/point_cloud2.hpp"
+#include <std_msgs/msg/float32.hpp>
+#include <pcl_conversions/pcl_conversions.h>
+
+#include "terrain_analysis/terrainAnalysisNode.h"
+#include "terrain_analysis/terrainExtAnalysis.h"
+#include "terrain_analysis/terrainVoxelMap.h"
+
+#include "goldenScans.h"
+
+using namespace std;
+
+namespace
+{
+
+// stands in for the state estimation and the registered scans, publishes the golden scan sequence and
+// the extended level clearing, and keeps the /terrain_map and /terrain_map_ext clouds published back
+class ScanDriver : public rclcpp::Node
+{
+public:
+  explicit ScanDriver(const rclcpp::NodeOptions& options)
+    : Node("scanDriver", options)
+  {
+    pubOdometry = create_publisher<nav_msgs::msg::Odometry>("/state_estimation", 5);
+    pubScan = create_publisher<sensor_msgs::msg::PointCloud2>("/registered_scan", 5);
+    pubExtClearing = create_publisher<std_msgs::msg::Float32>("/cloud_clearing", 5);
+    subTerrainMap = create_subscription<sensor_msgs::msg::PointCloud2>("/terrain_map", 2,
+                    [this](sensor_msgs::msg::PointCloud2::UniquePtr terrainCloud2) {
+                      terrainMaps.emplace_back();
+                      pcl::fromROSMsg(*terrainCloud2, terrainMaps.back());
+                    });
+    subTerrainMapExt = create_subscription<sensor_msgs::msg::PointCloud2>("/terrain_map_ext", 2,
+                       [this](sensor_msgs::msg::PointCloud2::UniquePtr terrainCloud2) {
+                         terrainMapExts.emplace_back();
+                         pcl::fromROSMsg(*terrainCloud2, terrainMapExts.back());
+                       });
+  }
+
+  void publish(int scan, double scanTime)
+  {
+    float vehicleX, vehicleY, vehicleZ;
+    scanPose(scan, vehicleX, vehicleY, vehicleZ);
+
+    auto odom = std::make_unique<nav_msgs::msg::Odometry>();
+    odom->header.stamp = rclcpp::Time(static_cast<uint64_t>(scanTime * 1e9));
+    odom->header.frame_id = "map";
+    odom->pose.pose.position.x = vehicleX;
+    odom->pose.pose.position.y = vehicleY;
+    odom->pose.pose.position.z = vehicleZ;
+    odom->pose.pose.orientation.w = 1.0;
+    pubOdometry->publish(std::move(odom));
+
+    pcl::PointCloud<pcl::PointXYZI> scanCloud;
+    makeScan(scan, scanCloud);
+    auto scan2 = std::make_unique<sensor_msgs::msg::PointCloud2>();
+    pcl::toROSMsg(scanCloud, *scan2);
+    scan2->header.stamp = rclcpp::Time(static_cast<uint64_t>(scanTime * 1e9));
+    scan2->header.frame_id = "map";
+    pubScan->publish(std::move(scan2));
+  }
+
+  void clearExt(float dis)
+  {
+    auto clearing = std::make_unique<std_msgs::msg::Float32>();
+    clearing->data = dis;
+    pubExtClearing->publish(std::move(clearing));
+  }
+
+  vector<pcl::PointCloud<pcl::PointXYZI> > terrainMaps;
+  vector<pcl::PointCloud<pcl::PointXYZI> > terrainMapExts;
+  rclcpp::Publisher<nav_msgs::msg::Odometry>::SharedPtr pubOdometry;
+  rclcpp::Publisher<sensor_msgs::msg::PointCloud2>::SharedPtr pubScan;
+  rclcpp::Publisher<std_msgs::msg::Float32>::SharedPtr pubExtClearing;
+  rclcpp::Subscription<sensor_msgs::msg::PointCloud2>::SharedPtr subTerrainMap;
+  rclcpp::Subscription<sensor_msgs::msg::PointCloud2>::SharedPtr subTerrainMapExt;
+};
+
+class TerrainAnalysisNodeTest : public ::testing::Test
+{
+protected:
+  static void SetUpTestCase()
+  {
+    rclcpp::init(0, NULL);
+  }
+
+  static void TearDownTestCase()
+  {
+    rclcpp::shutdown();
+  }
+};
+
+}
+
+// terrainAnalysis with useExtLevel against the standalone terrainAnalysisExt pipeline on the golden
+// scans, the reference crops each scan, updates and collects its own extended voxel map and merges
+// in the /terrain_map published for the same scan as terrainAnalysisExt does, with decay and a
+// clearing on /cloud_clearing halfway, the /terrain_map_ext of each scan has to match it point for point
+TEST_F(TerrainAnalysisNodeTest, ExtLevelMatchesStandalonePipeline)
+{
+  const double extDecayTime = 1.05;
+  const double extNoDecayDis = 2.0;
+  const double extVoxelTimeUpdateThre = 0.3;
+  const int clearingScan = 12;
+  const double clearingDis = 3.0;
+
+  rclcpp::NodeOptions terrainOptions;
+  terrainOptions.parameter_overrides({
+    rclcpp::Parameter("useExtLevel", true),
+    rclcpp::Parameter("extDecayTime", extDecayTime),
+    rclcpp::Parameter("extNoDecayDis", extNoDecayDis),
+    rclcpp::Parameter("extVoxelTimeUpdateThre", extVoxelTimeUpdateThre),
+  });
+
+  auto driver = std::make_shared<ScanDriver>(rclcpp::NodeOptions());
+  auto terrain = std::make_shared<terrain_analysis::TerrainAnalysisNode>(terrainOptions);
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(driver);
+  executor.add_node(terrain);
+
+  // the defaults of terrainAnalysisExt but for the decay
+  TerrainVoxelMapParams mapParams;
+  mapParams.terrainVoxelSize = 2.0;
+  mapParams.terrainVoxelWidth = 41;
+  mapParams.scanVoxelSize = 0.1;
+  mapParams.decayTime = extDecayTime;
+  mapParams.noDecayDis = extNoDecayDis;
+  mapParams.voxelPointUpdateThre = 100;
+  mapParams.voxelTimeUpdateThre = extVoxelTimeUpdateThre;
+  mapParams.minRelZ = -1.5;
+  mapParams.maxRelZ = 1.0;
+  mapParams.disRatioZ = 0.1;
+  TerrainVoxelMap terrainVoxelMap(mapParams);
+
+  TerrainExtParams extParams;
+  extParams.planarVoxelSize = 0.4;
+  extParams.planarVoxelWidth = 101;
+  TerrainExtAnalysis terrainExtAnalysis(extParams);
+
+  double startTime = 1700000000.0;
+  double systemInitTime = rclcpp::Time(static_cast<uint64_t>(startTime * 1e9)).seconds();
+  pcl::PointCloud<pcl::PointXYZI> scanCloud, cloudCrop, terrainCloud, terrainCloudElev;
+  for (int scan = 0; scan < scanNum; scan++) {
+    SCOPED_TRACE("scan " + to_string(scan));
+    double scanTime = startTime + 0.125 * scan;
+    if (scan == clearingScan) driver->clearExt(clearingDis);
+    driver->publish(scan, scanTime);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (driver->terrainMapExts.size() <= size_t(scan) && std::chrono::steady_clock::now() < deadline) {
+      executor.spin_once(std::chrono::milliseconds(10));
+    }
+    ASSERT_EQ(driver->terrainMaps.size(), size_t(scan + 1));
+    ASSERT_EQ(driver->terrainMapExts.size(), size_t(scan + 1));
+
+    float vehicleX, vehicleY, vehicleZ;
+    scanPose(scan, vehicleX, vehicleY, vehicleZ);
+    double laserCloudTime = rclcpp::Time(static_cast<uint64_t>(scanTime * 1e9)).seconds();
+    makeScan(scan, scanCloud);
+
+    cloudCrop.clear();
+    terrainVoxelMap.cropScan(scanCloud, vehicleX, vehicleY, vehicleZ, laserCloudTime - systemInitTime, cloudCrop);
+    terrainVoxelMap.update(cloudCrop, vehicleX, vehicleY, vehicleZ, laserCloudTime - systemInitTime,
+                           scan == clearingScan, clearingDis);
+
+    terrainCloud.clear();
+    terrainVoxelMap.collect(10, terrainCloud);
+    terrainExtAnalysis.compute(terrainCloud, driver->terrainMaps[scan], vehicleX, vehicleY, vehicleZ, terrainCloudElev);
+
+    ASSERT_GT(terrainCloudElev.points.size(), driver->terrainMaps[scan].points.size());
+    EXPECT_EQ(driver->terrainMapExts[scan].points.size(), terrainCloudElev.points.size());
+    EXPECT_EQ(cloudHash(driver->terrainMapExts[scan]), cloudHash(terrainCloudElev));
+  }
+}
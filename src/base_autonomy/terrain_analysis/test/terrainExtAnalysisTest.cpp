@@ -0,0 +1,496 @@
+#include <math.h>
+#include <stdint.h>
+#include <algorithm>
+#include <queue>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "terrain_analysis/terrainExtAnalysis.h"
+#include "terrain_analysis/terrainVoxelMap.h"
+
+#include "goldenScans.h"
+
+using namespace std;
+
+namespace
+{
+
+// flat ground with a ramp along +x up to a plateau and an overhang over the -x, +y side that hides
+// the ground under its far half, as terrainAnalysisExtBenchmark builds it
+void buildRampTerrain(float slope, float plateau, pcl::PointCloud<pcl::PointXYZI>& cloud)
+{
+  cloud.clear();
+  pcl::PointXYZI point;
+  point.intensity = 0;
+  for (int indX = -200; indX <= 200; indX++) {
+    for (int indY = -200; indY <= 200; indY++) {
+      point.x = 0.1 * indX;
+      point.y = 0.1 * indY;
+
+      bool underOverhang = point.x > -14.0 && point.x < -6.0 && point.y > 4.0 && point.y < 14.0;
+      if (!underOverhang || point.y < 9.0) {
+        point.z = point.x > 6.0 ? min(slope * (point.x - 6.0f), plateau) : 0;
+        cloud.push_back(point);
+      }
+      if (underOverhang) {
+        point.z = 2.6;
+        cloud.push_back(point);
+      }
+    }
+  }
+}
+
+// the single-layer analysis as it was with the breadth-first connectivity search, a voxel is
+// labeled once, from the first connected voxel that finds it
+void bfsTerrainElev(const TerrainExtParams& p, const pcl::PointCloud<pcl::PointXYZI>& terrainCloud, float vehicleX,
+                    float vehicleY, float vehicleZ, pcl::PointCloud<pcl::PointXYZI>& terrainCloudElev)
+{
+  float planarVoxelSize = p.planarVoxelSize;
+  int planarVoxelWidth = p.planarVoxelWidth;
+  int planarVoxelHalfWidth = (planarVoxelWidth - 1) / 2;
+  int planarVoxelNum = planarVoxelWidth * planarVoxelWidth;
+  vector<float> planarVoxelElev(planarVoxelNum, 0);
+  vector<int> planarVoxelConn(planarVoxelNum, 0);
+  vector<vector<float>> planarPointElev(planarVoxelNum);
+
+  for (const pcl::PointXYZI& point : terrainCloud.points) {
+    float dis = sqrt((point.x - vehicleX) * (point.x - vehicleX) + (point.y - vehicleY) * (point.y - vehicleY));
+    if (point.z - vehicleZ > p.lowerBoundZ - p.disRatioZ * dis &&
+        point.z - vehicleZ < p.upperBoundZ + p.disRatioZ * dis) {
+      int indX = int((point.x - vehicleX + planarVoxelSize / 2) / planarVoxelSize) + planarVoxelHalfWidth;
+      int indY = int((point.y - vehicleY + planarVoxelSize / 2) / planarVoxelSize) + planarVoxelHalfWidth;
+
+      if (point.x - vehicleX + planarVoxelSize / 2 < 0) indX--;
+      if (point.y - vehicleY + planarVoxelSize / 2 < 0) indY--;
+
+      for (int dX = -1; dX <= 1; dX++) {
+        for (int dY = -1; dY <= 1; dY++) {
+          if (indX + dX >= 0 && indX + dX < planarVoxelWidth && indY + dY >= 0 && indY + dY < planarVoxelWidth) {
+            planarPointElev[planarVoxelWidth * (indX + dX) + indY + dY].push_back(point.z);
+          }
+        }
+      }
+    }
+  }
+
+  for (int i = 0; i < planarVoxelNum; i++) {
+    if (planarPointElev[i].size() > 0) {
+      planarVoxelElev[i] = planarVoxelGround(planarPointElev[i], p.useSorting, p.quantileZ, false, 0);
+    }
+  }
+
+  int ind = planarVoxelWidth * planarVoxelHalfWidth + planarVoxelHalfWidth;
+  if (planarPointElev[ind].size() == 0) planarVoxelElev[ind] = vehicleZ + p.terrainUnderVehicle;
+
+  queue<int> planarVoxelQueue;
+  planarVoxelQueue.push(ind);
+  planarVoxelConn[ind] = 1;
+  while (!planarVoxelQueue.empty()) {
+    int front = planarVoxelQueue.front();
+    planarVoxelConn[front] = 2;
+    planarVoxelQueue.pop();
+
+    int indX = int(front / planarVoxelWidth);
+    int indY = front % planarVoxelWidth;
+    for (int dX = -10; dX <= 10; dX++) {
+      for (int dY = -10; dY <= 10; dY++) {
+        if (indX + dX >= 0 && indX + dX < planarVoxelWidth && indY + dY >= 0 && indY + dY < planarVoxelWidth) {
+          ind = planarVoxelWidth * (indX + dX) + indY + dY;
+          if (planarVoxelConn[ind] == 0 && planarPointElev[ind].size() > 0) {
+            if (fabs(planarVoxelElev[front] - planarVoxelElev[ind]) < p.terrainConnThre) {
+              planarVoxelQueue.push(ind);
+              planarVoxelConn[ind] = 1;
+            } else if (fabs(planarVoxelElev[front] - planarVoxelElev[ind]) > p.ceilingFilteringThre) {
+              planarVoxelConn[ind] = -1;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  terrainCloudElev.clear();
+  for (pcl::PointXYZI point : terrainCloud.points) {
+    float dis = sqrt((point.x - vehicleX) * (point.x - vehicleX) + (point.y - vehicleY) * (point.y - vehicleY));
+    if (point.z - vehicleZ > p.lowerBoundZ - p.disRatioZ * dis &&
+        point.z - vehicleZ < p.upperBoundZ + p.disRatioZ * dis && dis > p.localTerrainMapRadius) {
+      int indX = int((point.x - vehicleX + planarVoxelSize / 2) / planarVoxelSize) + planarVoxelHalfWidth;
+      int indY = int((point.y - vehicleY + planarVoxelSize / 2) / planarVoxelSize) + planarVoxelHalfWidth;
+
+      if (point.x - vehicleX + planarVoxelSize / 2 < 0) indX--;
+      if (point.y - vehicleY + planarVoxelSize / 2 < 0) indY--;
+
+      if (indX >= 0 && indX < planarVoxelWidth && indY >= 0 && indY < planarVoxelWidth) {
+        int ind = planarVoxelWidth * indX + indY;
+        float disZ = fabs(point.z - planarVoxelElev[ind]);
+        if (disZ < p.vehicleHeight && planarVoxelConn[ind] == 2) {
+          point.intensity = disZ;
+          terrainCloudElev.push_back(point);
+        }
+      }
+    }
+  }
+}
+
+void expectSameClouds(const pcl::PointCloud<pcl::PointXYZI>& cloud, const pcl::PointCloud<pcl::PointXYZI>& refCloud)
+{
+  ASSERT_EQ(cloud.points.size(), refCloud.points.size());
+  for (size_t i = 0; i < refCloud.points.size(); i++) {
+    const pcl::PointXYZI& point = cloud.points[i];
+    const pcl::PointXYZI& refPoint = refCloud.points[i];
+    ASSERT_TRUE(point.x == refPoint.x && point.y == refPoint.y && point.z == refPoint.z &&
+                point.intensity == refPoint.intensity)
+        << "point " << i;
+  }
+}
+
+// a horizontal patch of points on the 0.1 grid, [minIndX, maxIndX) by [minIndY, maxIndY) at z
+struct Slab
+{
+  int minIndX, maxIndX, minIndY, maxIndY;
+  float z;
+};
+
+void addSlab(const Slab& slab, pcl::PointCloud<pcl::PointXYZI>& cloud)
+{
+  pcl::PointXYZI point;
+  point.intensity = 0;
+  for (int indX = slab.minIndX; indX < slab.maxIndX; indX++) {
+    for (int indY = slab.minIndY; indY < slab.maxIndY; indY++) {
+      point.x = 0.1 * indX;
+      point.y = 0.1 * indY;
+      point.z = slab.z;
+      cloud.push_back(point);
+    }
+  }
+}
+
+bool inSlab(const pcl::PointXYZI& point, const Slab& slab)
+{
+  int indX = lround(point.x * 10.0), indY = lround(point.y * 10.0);
+  return point.z == slab.z && indX >= slab.minIndX && indX < slab.maxIndX && indY >= slab.minIndY &&
+         indY < slab.maxIndY;
+}
+
+// points of the slab the output reaches, those beyond localTerrainMapRadius from the vehicle
+int slabPointNum(const Slab& slab, float vehicleX, float vehicleY, float localTerrainMapRadius)
+{
+  pcl::PointCloud<pcl::PointXYZI> slabCloud;
+  addSlab(slab, slabCloud);
+  int pointNum = 0;
+  for (const pcl::PointXYZI& point : slabCloud.points) {
+    float dis = sqrt((point.x - vehicleX) * (point.x - vehicleX) + (point.y - vehicleY) * (point.y - vehicleY));
+    if (dis > localTerrainMapRadius) pointNum++;
+  }
+  return pointNum;
+}
+
+// output points of the slab, all of them at intensity, the height above the ground, unless NaN
+int slabOutputNum(const pcl::PointCloud<pcl::PointXYZI>& terrainCloudElev, const Slab& slab, float intensity = NAN)
+{
+  int pointNum = 0;
+  for (const pcl::PointXYZI& point : terrainCloudElev.points) {
+    if (inSlab(point, slab)) {
+      if (!isnan(intensity)) {
+        EXPECT_NEAR(point.intensity, intensity, 1e-5) << "point at " << point.x << ", " << point.y << ", " << point.z;
+      }
+      pointNum++;
+    }
+  }
+  return pointNum;
+}
+
+// flat ground over the 0.1 grid of +-20 m and the slabs of a scene on it
+void buildSlabScene(const vector<Slab>& slabs, pcl::PointCloud<pcl::PointXYZI>& cloud)
+{
+  cloud.clear();
+  addSlab({-200, 201, -200, 201, 0}, cloud);
+  for (const Slab& slab : slabs) addSlab(slab, cloud);
+}
+
+// the multi-layer mode with height bounds wide enough to see the ground and what is over it
+TerrainExtParams multiLayerParams()
+{
+  TerrainExtParams params;
+  params.lowerBoundZ = -3.5;
+  params.upperBoundZ = 3.0;
+  params.useMultiLayer = true;
+  return params;
+}
+
+struct GoldenScan
+{
+  int pointNum;
+  uint64_t hash;
+};
+
+// outputs of terrainAnalysisExt from before the terrain core was shared, with and without the
+// terrain connectivity check, the point count and cloudHash() per scan
+const GoldenScan goldenConn[scanNum] = {
+  {1741, 0x25597b547631bebfull},
+  {3560, 0x18b0b243af3350fcull},
+  {5261, 0x7d4dffe9cfb4778dull},
+  {6949, 0x35fd3d48b37b1a7dull},
+  {8630, 0xace2215a79b629faull},
+  {10387, 0x52126089a7744679ull},
+  {12088, 0x23605132dda7d12eull},
+  {13900, 0xbfd266818bdcf25aull},
+  {15546, 0xc45f40b6ecce844bull},
+  {15635, 0x0ec37a90e7c994ebull},
+  {17425, 0xfec24a858f1afb42ull},
+  {19159, 0x1bb4efdd3576d26dull},
+  {15660, 0x289b20db2e113275ull},
+  {17403, 0xeb055f9239d09525ull},
+  {19231, 0x6fddf71e0441ffb9ull},
+  {15918, 0x4f67d8438c067aaaull},
+  {17591, 0x4cbe4b02d4959a71ull},
+  {19273, 0x1ba2b89a68b3e079ull},
+  {15687, 0x84b1092009b1794bull},
+  {17396, 0x12c01faa807669a5ull},
+};
+
+const GoldenScan goldenNoConn[scanNum] = {
+  {1791, 0x5fa9ae91b6c34e3dull},
+  {3644, 0xff000fb9c9953827ull},
+  {5404, 0xd47331a8d97a3af4ull},
+  {7110, 0xf5919d9a14f4d69cull},
+  {8861, 0x9fc625e801d21cd1ull},
+  {10649, 0x22c7dee2cc12f17aull},
+  {12381, 0x054b4e4707bec813ull},
+  {14200, 0xd031e03634b5637dull},
+  {15919, 0x981a4dd665b94a28ull},
+  {15984, 0x4da75ff6ea5ebf84ull},
+  {17803, 0xd13d5b00717206a7ull},
+  {19510, 0xee69970331395146ull},
+  {15955, 0x1aef3d6f423da655ull},
+  {17716, 0xa07475e0ebabe58eull},
+  {19529, 0xa0aa878cbe4562ecull},
+  {16077, 0x3bd6218ce795efcbull},
+  {17812, 0x9d088747e8a2f72eull},
+  {19520, 0x84c2b10f50111471ull},
+  {15875, 0xfbe24f2a2f9ce899ull},
+  {17568, 0x7be1f4446ff89f87ull},
+};
+
+// runs the scan sequence as terrainAnalysisExt does, with a map clearing at clearingScan
+void expectGoldenOutput(bool checkTerrainConn, const GoldenScan* golden)
+{
+  TerrainVoxelMapParams mapParams;
+  mapParams.terrainVoxelSize = 2.0;
+  mapParams.terrainVoxelWidth = 41;
+  mapParams.scanVoxelSize = scanVoxelSize;
+  mapParams.decayTime = 1.05;
+  mapParams.noDecayDis = 2.0;
+  mapParams.voxelPointUpdateThre = 100;
+  mapParams.voxelTimeUpdateThre = 0.3;
+  mapParams.minRelZ = -1.5;
+  mapParams.maxRelZ = 1.0;
+  mapParams.disRatioZ = 0.1;
+  TerrainVoxelMap terrainVoxelMap(mapParams);
+
+  TerrainExtParams extParams;
+  extParams.checkTerrainConn = checkTerrainConn;
+  TerrainExtAnalysis terrainExtAnalysis(extParams);
+
+  const int clearingScan = 12;
+  const double clearingDis = 3.0;
+  pcl::PointCloud<pcl::PointXYZI> scanCloud, cloudCrop, terrainCloud, terrainCloudLocal, terrainCloudElev;
+  for (int scan = 0; scan < scanNum; scan++) {
+    float vehicleX, vehicleY, vehicleZ;
+    scanPose(scan, vehicleX, vehicleY, vehicleZ);
+    double scanTime = 0.125 * scan;
+    makeScan(scan, scanCloud);
+    makeLocalCloud(scan, terrainCloudLocal);
+
+    cloudCrop.clear();
+    terrainVoxelMap.cropScan(scanCloud, vehicleX, vehicleY, vehicleZ, scanTime, cloudCrop);
+    terrainVoxelMap.update(cloudCrop, vehicleX, vehicleY, vehicleZ, scanTime, scan == clearingScan, clearingDis);
+
+    terrainCloud.clear();
+    terrainVoxelMap.collect(10, terrainCloud);
+    terrainExtAnalysis.compute(terrainCloud, terrainCloudLocal, vehicleX, vehicleY, vehicleZ, terrainCloudElev);
+
+    EXPECT_EQ(int(terrainCloudElev.points.size()), golden[scan].pointNum) << "scan " << scan;
+    EXPECT_EQ(cloudHash(terrainCloudElev), golden[scan].hash) << "scan " << scan;
+  }
+}
+
+}
+
+TEST(TerrainExtAnalysis, GoldenScanSequence)
+{
+  expectGoldenOutput(true, goldenConn);
+}
+
+TEST(TerrainExtAnalysis, GoldenScanSequenceNoConn)
+{
+  expectGoldenOutput(false, goldenNoConn);
+}
+
+TEST(TerrainExtAnalysis, ConnMatchesBreadthFirstSearch)
+{
+  // wide height bounds so the ramp, the plateau and the overhang are all seen from both ends
+  TerrainExtParams params;
+  params.lowerBoundZ = -3.5;
+  params.upperBoundZ = 3.0;
+  const float plateau = 3.0;
+
+  pcl::PointCloud<pcl::PointXYZI> terrainCloud, terrainCloudLocal, terrainCloudElev, refCloudElev;
+  for (float slope : {0.2f, 0.3f, 0.6f, 1.0f}) {
+    buildRampTerrain(slope, plateau, terrainCloud);
+    TerrainExtAnalysis terrainExtAnalysis(params);
+
+    // from the ground and from the plateau, standing still, moving less than a voxel and moving
+    // on, so the labels are both reused and redone
+    float plateauX = 6.0 + plateau / slope + 3.0;
+    const float poses[][3] = {
+      {0, 0, 0.75}, {0, 0, 0.75}, {0.001, 0.001, 0.75}, {0.5, 0.2, 0.75}, {-9.0, 6.0, 0.75},
+      {plateauX, 1.0, plateau + 0.75f}, {plateauX, 1.0, plateau + 0.75f}, {plateauX - 0.3f, 1.0, plateau + 0.75f},
+    };
+    for (const float* pose : poses) {
+      SCOPED_TRACE("slope " + to_string(slope) + ", vehicle at " + to_string(pose[0]) + ", " + to_string(pose[1]));
+      terrainExtAnalysis.compute(terrainCloud, terrainCloudLocal, pose[0], pose[1], pose[2], terrainCloudElev);
+      bfsTerrainElev(params, terrainCloud, pose[0], pose[1], pose[2], refCloudElev);
+      expectSameClouds(terrainCloudElev, refCloudElev);
+    }
+  }
+
+  // on flat ground, a ring wider than the search reach cuts off the ground beyond and filling it
+  // back in joins it again, the ring voxels are unobserved and observed at the same elevation
+  pcl::PointCloud<pcl::PointXYZI> terrainCloudFlat, terrainCloudRing;
+  buildRampTerrain(0, 0, terrainCloud);
+  for (const pcl::PointXYZI& point : terrainCloud.points) {
+    if (point.z != 0) continue;
+    terrainCloudFlat.push_back(point);
+    float dis = sqrt(point.x * point.x + point.y * point.y);
+    if (dis < 4.0 || dis > 14.0) terrainCloudRing.push_back(point);
+  }
+  TerrainExtAnalysis terrainExtAnalysis(params);
+  const pcl::PointCloud<pcl::PointXYZI>* clouds[] = {&terrainCloudFlat, &terrainCloudRing, &terrainCloudFlat,
+                                                      &terrainCloudRing};
+  for (const pcl::PointCloud<pcl::PointXYZI>* cloud : clouds) {
+    SCOPED_TRACE(cloud == &terrainCloudFlat ? "ring filled" : "ring cut");
+    terrainExtAnalysis.compute(*cloud, terrainCloudLocal, 0, 0, 0.75, terrainCloudElev);
+    bfsTerrainElev(params, *cloud, 0, 0, 0.75, refCloudElev);
+    expectSameClouds(terrainCloudElev, refCloudElev);
+  }
+
+  // a trench along x or y from 4 m out, its unobserved voxels leave the observed ones on either side
+  // 10 voxels apart, just within the search reach, or 11 voxels apart, beyond it
+  for (int axis = 0; axis < 2; axis++) {
+    size_t reachedSize = 0;
+    for (float trenchEnd : {8.65f, 9.05f}) {
+      SCOPED_TRACE("trench along " + string(axis == 0 ? "x" : "y") + " to " + to_string(trenchEnd));
+      pcl::PointCloud<pcl::PointXYZI> terrainCloudTrench;
+      for (const pcl::PointXYZI& point : terrainCloudFlat.points) {
+        float dis = axis == 0 ? point.x : point.y;
+        if (dis <= 4.05 || dis >= trenchEnd) terrainCloudTrench.push_back(point);
+      }
+      terrainExtAnalysis.compute(terrainCloudTrench, terrainCloudLocal, 0, 0, 0.75, terrainCloudElev);
+      bfsTerrainElev(params, terrainCloudTrench, 0, 0, 0.75, refCloudElev);
+      expectSameClouds(terrainCloudElev, refCloudElev);
+
+      if (reachedSize == 0) reachedSize = terrainCloudElev.points.size();
+      else EXPECT_LT(terrainCloudElev.points.size(), reachedSize);
+    }
+  }
+}
+
+TEST(TerrainExtAnalysis, MultiLayerTable)
+{
+  // a table the vehicle fits under and a low one it does not, 8 to 10 m ahead
+  TerrainExtParams params = multiLayerParams();
+  const Slab table = {80, 100, -10, 10, 0.8}, underTable = {80, 100, -10, 10, 0};
+  const Slab lowTable = {80, 100, 40, 60, 0.4}, underLowTable = {80, 100, 40, 60, 0};
+
+  pcl::PointCloud<pcl::PointXYZI> terrainCloud, terrainCloudLocal, terrainCloudElev;
+  buildSlabScene({table, lowTable}, terrainCloud);
+  TerrainExtAnalysis terrainExtAnalysis(params);
+  terrainExtAnalysis.compute(terrainCloud, terrainCloudLocal, 0, 0, 0.75, terrainCloudElev);
+
+  // the ground under both stays ground, the table top is left out and the low table is an obstacle
+  float radius = params.localTerrainMapRadius;
+  EXPECT_EQ(slabOutputNum(terrainCloudElev, underTable, 0), slabPointNum(underTable, 0, 0, radius));
+  EXPECT_EQ(slabOutputNum(terrainCloudElev, underLowTable, 0), slabPointNum(underLowTable, 0, 0, radius));
+  EXPECT_EQ(slabOutputNum(terrainCloudElev, table), 0);
+  EXPECT_EQ(slabOutputNum(terrainCloudElev, lowTable, 0.4), slabPointNum(lowTable, 0, 0, radius));
+
+  // with a single layer, the table top is an obstacle as well
+  params.useMultiLayer = false;
+  terrainExtAnalysis.setParams(params);
+  terrainExtAnalysis.compute(terrainCloud, terrainCloudLocal, 0, 0, 0.75, terrainCloudElev);
+  EXPECT_EQ(slabOutputNum(terrainCloudElev, table, 0.8), slabPointNum(table, 0, 0, radius));
+}
+
+TEST(TerrainExtAnalysis, MultiLayerBridge)
+{
+  // a 4 m wide deck 1.5 m over the ground, seen from the ground ahead of it and from on it
+  TerrainExtParams params = multiLayerParams();
+  const Slab deck = {80, 120, -100, 100, 1.5}, underDeck = {80, 120, -100, 100, 0};
+
+  pcl::PointCloud<pcl::PointXYZI> terrainCloud, terrainCloudLocal, terrainCloudElev;
+  buildSlabScene({deck}, terrainCloud);
+  TerrainExtAnalysis terrainExtAnalysis(params);
+  float radius = params.localTerrainMapRadius;
+
+  terrainExtAnalysis.compute(terrainCloud, terrainCloudLocal, 0, 0, 0.75, terrainCloudElev);
+  EXPECT_EQ(slabOutputNum(terrainCloudElev, underDeck, 0), slabPointNum(underDeck, 0, 0, radius));
+  EXPECT_EQ(slabOutputNum(terrainCloudElev, deck), 0);
+
+  // on the deck, the deck is the ground and the ground below is neither kept nor connected
+  terrainExtAnalysis.compute(terrainCloud, terrainCloudLocal, 10.0, -8.0, 2.25, terrainCloudElev);
+  EXPECT_EQ(slabOutputNum(terrainCloudElev, deck, 0), slabPointNum(deck, 10.0, -8.0, radius));
+  for (const pcl::PointXYZI& point : terrainCloudElev.points) {
+    ASSERT_EQ(point.z, 1.5f) << "point at " << point.x << ", " << point.y;
+  }
+}
+
+TEST(TerrainExtAnalysis, MultiLayerStaircase)
+{
+  // 8 open treads of 0.3 m rising 0.18 m each from 6 m ahead up to a landing at 1.44 m, a point
+  // shares its voxel with points up to 3 treads away
+  TerrainExtParams params = multiLayerParams();
+  vector<Slab> treads, underTreads;
+  for (int k = 0; k < 8; k++) {
+    treads.push_back({60 + 3 * k, 63 + 3 * k, -20, 20, 0.18f * (k + 1)});
+    underTreads.push_back({60 + 3 * k, 63 + 3 * k, -20, 20, 0});
+  }
+  const Slab landing = {84, 160, -20, 20, 0.18f * 8};
+  vector<Slab> slabs = treads;
+  slabs.push_back(landing);
+
+  pcl::PointCloud<pcl::PointXYZI> terrainCloud, terrainCloudLocal, terrainCloudElev;
+  buildSlabScene(slabs, terrainCloud);
+  TerrainExtAnalysis terrainExtAnalysis(params);
+  float radius = params.localTerrainMapRadius;
+
+  // from below, the ground under the stairs stays ground, the lowest treads are obstacles and the
+  // treads from 0.6 m over the ground up are left out where no lower tread shares their voxels
+  terrainExtAnalysis.compute(terrainCloud, terrainCloudLocal, 0, 0, 0.75, terrainCloudElev);
+  for (int k = 0; k < 8; k++) {
+    SCOPED_TRACE("tread " + to_string(k));
+    EXPECT_EQ(slabOutputNum(terrainCloudElev, underTreads[k], 0), slabPointNum(underTreads[k], 0, 0, radius));
+    if (k < 2) {
+      EXPECT_EQ(slabOutputNum(terrainCloudElev, treads[k], treads[k].z), slabPointNum(treads[k], 0, 0, radius));
+    }
+    if (k >= 6) {
+      EXPECT_EQ(slabOutputNum(terrainCloudElev, treads[k]), 0);
+    }
+  }
+  EXPECT_EQ(slabOutputNum(terrainCloudElev, landing), 0);
+
+  // from the landing, the landing and every tread are kept, the landing clear of the treads is the
+  // ground, and under the treads clear of the ground the ground is left out
+  const Slab landingClear = {92, 160, -20, 20, landing.z};
+  terrainExtAnalysis.compute(terrainCloud, terrainCloudLocal, 14.0, 0, landing.z + 0.75f, terrainCloudElev);
+  EXPECT_EQ(slabOutputNum(terrainCloudElev, landing), slabPointNum(landing, 14.0, 0, radius));
+  EXPECT_EQ(slabOutputNum(terrainCloudElev, landingClear, 0), slabPointNum(landingClear, 14.0, 0, radius));
+  for (int k = 0; k < 8; k++) {
+    SCOPED_TRACE("tread " + to_string(k));
+    EXPECT_EQ(slabOutputNum(terrainCloudElev, treads[k]), slabPointNum(treads[k], 14.0, 0, radius));
+    if (k >= 4) {
+      EXPECT_EQ(slabOutputNum(terrainCloudElev, underTreads[k]), 0);
+    }
+  }
+}
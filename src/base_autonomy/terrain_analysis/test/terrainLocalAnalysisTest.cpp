@@ -0,0 +1,558 @@
+#include <math.h>
+#include <string.h>
+#include <random>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <gtest/gtest.h>
+
+#include "terrain_analysis/terrainLocalAnalysis.h"
+#include "terrain_analysis/terrainVoxelMap.h"
+
+#include "goldenScans.h"
+
+using namespace std;
+
+namespace
+{
+
+struct Pose
+{
+  float x, y, z, roll, pitch, yaw;
+};
+
+// stacked terrain points around the vehicle, a noisy ground with a few boxes and a hole, and a scan
+// of part of them so some voxels are cleared by the dynamic obstacle check
+void makeClouds(unsigned seed, const Pose& pose, pcl::PointCloud<pcl::PointXYZI>& terrainCloud,
+                pcl::PointCloud<pcl::PointXYZI>& laserCloudCrop)
+{
+  mt19937 generator(seed);
+  uniform_real_distribution<float> posDist(-5.5, 5.5);
+  uniform_real_distribution<float> noiseDist(-0.03, 0.03);
+  uniform_real_distribution<float> heightDist(0, 1.2);
+  uniform_real_distribution<float> unitDist(0, 1);
+
+  terrainCloud.clear();
+  laserCloudCrop.clear();
+  pcl::PointXYZI point;
+  for (int i = 0; i < 30000; i++) {
+    float relX = posDist(generator), relY = posDist(generator);
+
+    // a hole ahead of the vehicle, left for the no data check
+    if (relX > 0.8 && relX < 1.4 && fabs(relY) < 0.4) continue;
+
+    point.x = pose.x + relX;
+    point.y = pose.y + relY;
+    point.z = pose.z - 0.7 + 0.05 * relX + noiseDist(generator);
+    if ((relX > 2 && relX < 3 && relY > -1 && relY < 0) || (relX < -2 && relX > -3.5 && relY > 1.5)) {
+      point.z += heightDist(generator);
+    }
+    point.intensity = unitDist(generator);
+    terrainCloud.push_back(point);
+    if (unitDist(generator) < 0.2) laserCloudCrop.push_back(point);
+  }
+}
+
+vector<TerrainLocalParams> testParams()
+{
+  vector<TerrainLocalParams> paramsList;
+  TerrainLocalParams params;
+  paramsList.push_back(params);
+
+  params.clearDyObs = true;
+  params.minDyObsPointNum = 2;
+  paramsList.push_back(params);
+
+  params.useSorting = false;
+  params.considerDrop = true;
+  params.noDataObstacle = true;
+  params.noDataBlockSkipNum = 2;
+  paramsList.push_back(params);
+
+  params.useSorting = true;
+  params.quantileZ = 0.6;
+  params.limitGroundLift = true;
+  params.minBlockPointNum = 3;
+  paramsList.push_back(params);
+  return paramsList;
+}
+
+void expectSameClouds(const pcl::PointCloud<pcl::PointXYZI>& cloud, const pcl::PointCloud<pcl::PointXYZI>& refCloud)
+{
+  ASSERT_EQ(cloud.points.size(), refCloud.points.size());
+  for (size_t i = 0; i < refCloud.points.size(); i++) {
+    const pcl::PointXYZI& point = cloud.points[i];
+    const pcl::PointXYZI& refPoint = refCloud.points[i];
+    ASSERT_TRUE(point.x == refPoint.x && point.y == refPoint.y && point.z == refPoint.z &&
+                point.intensity == refPoint.intensity)
+        << "point " << i;
+  }
+}
+
+void expectSameVoxels(const TerrainLocalAnalysis& analysis, const TerrainLocalAnalysis& refAnalysis)
+{
+  int planarVoxelNum = refAnalysis.params().planarVoxelWidth * refAnalysis.params().planarVoxelWidth;
+  for (int i = 0; i < planarVoxelNum; i++) {
+    ASSERT_EQ(analysis.voxelPointNum(i), refAnalysis.voxelPointNum(i)) << "voxel " << i;
+    ASSERT_EQ(analysis.voxelDyObs(i), refAnalysis.voxelDyObs(i)) << "voxel " << i;
+    float elev = analysis.voxelElev(i), refElev = refAnalysis.voxelElev(i);
+    ASSERT_EQ(memcmp(&elev, &refElev, sizeof(float)), 0) << "voxel " << i;
+  }
+}
+
+const Pose testPoses[] = {
+  {0, 0, 0.5, 0, 0, 0},
+  {0.37, -0.21, 0.52, 0.08, -0.12, 0.6},
+  {1.1, -0.45, 0.55, -0.15, 0.05, 2.4},
+  {-3.7, 2.9, 0.4, 0.02, 0.2, -1.9},
+};
+
+// the dynamic obstacle marks as terrainAnalysis counted them before, yaw, pitch and roll applied one
+// after the other and the angles taken with atan2
+vector<int> atan2VoxelDyObs(const TerrainLocalParams& params, const pcl::PointCloud<pcl::PointXYZI>& terrainCloud,
+                            const pcl::PointCloud<pcl::PointXYZI>& laserCloudCrop, const Pose& pose)
+{
+  const double PI = 3.1415926;
+  float planarVoxelSize = params.planarVoxelSize;
+  int planarVoxelWidth = params.planarVoxelWidth;
+  int planarVoxelHalfWidth = (planarVoxelWidth - 1) / 2;
+  float sinVehicleRoll = sin(pose.roll), cosVehicleRoll = cos(pose.roll);
+  float sinVehiclePitch = sin(pose.pitch), cosVehiclePitch = cos(pose.pitch);
+  float sinVehicleYaw = sin(pose.yaw), cosVehicleYaw = cos(pose.yaw);
+
+  vector<int> voxelDyObs(planarVoxelWidth * planarVoxelWidth, 0);
+  for (int pass = 0; pass < 2; pass++) {
+    const pcl::PointCloud<pcl::PointXYZI>& cloud = pass == 0 ? terrainCloud : laserCloudCrop;
+    for (const pcl::PointXYZI& point : cloud.points) {
+      int indX = int((point.x - pose.x + planarVoxelSize / 2) / planarVoxelSize) + planarVoxelHalfWidth;
+      int indY = int((point.y - pose.y + planarVoxelSize / 2) / planarVoxelSize) + planarVoxelHalfWidth;
+
+      if (point.x - pose.x + planarVoxelSize / 2 < 0) indX--;
+      if (point.y - pose.y + planarVoxelSize / 2 < 0) indY--;
+      if (indX < 0 || indX >= planarVoxelWidth || indY < 0 || indY >= planarVoxelWidth) continue;
+
+      float pointX1 = point.x - pose.x;
+      float pointY1 = point.y - pose.y;
+      float pointZ1 = point.z - pose.z;
+
+      float dis1 = sqrt(pointX1 * pointX1 + pointY1 * pointY1);
+      float angle1 = atan2(pointZ1 - params.minDyObsRelZ, dis1) * 180.0 / PI;
+      if (pass == 1) {
+        if (angle1 > params.minDyObsAngle) voxelDyObs[planarVoxelWidth * indX + indY] = 0;
+      } else if (dis1 > params.minDyObsDis) {
+        if (angle1 > params.minDyObsAngle) {
+          float pointX2 = pointX1 * cosVehicleYaw + pointY1 * sinVehicleYaw;
+          float pointY2 = -pointX1 * sinVehicleYaw + pointY1 * cosVehicleYaw;
+          float pointZ2 = pointZ1;
+
+          float pointX3 = pointX2 * cosVehiclePitch - pointZ2 * sinVehiclePitch;
+          float pointY3 = pointY2;
+          float pointZ3 = pointX2 * sinVehiclePitch + pointZ2 * cosVehiclePitch;
+
+          float pointX4 = pointX3;
+          float pointY4 = pointY3 * cosVehicleRoll + pointZ3 * sinVehicleRoll;
+          float pointZ4 = -pointY3 * sinVehicleRoll + pointZ3 * cosVehicleRoll;
+
+          float dis4 = sqrt(pointX4 * pointX4 + pointY4 * pointY4);
+          float angle4 = atan2(pointZ4, dis4) * 180.0 / PI;
+          if ((angle4 > params.minDyObsVFOV && angle4 < params.maxDyObsVFOV) ||
+              fabs(pointZ4) < params.absDyObsRelZThre) {
+            voxelDyObs[planarVoxelWidth * indX + indY]++;
+          }
+        }
+      } else {
+        voxelDyObs[planarVoxelWidth * indX + indY] += params.minDyObsPointNum;
+      }
+    }
+  }
+  return voxelDyObs;
+}
+
+// whether a point is within rounding of one of the thresholds of the dynamic obstacle check, where
+// the two forms may tell it apart, worked out in double
+bool nearDyObsThreshold(const TerrainLocalParams& params, const pcl::PointXYZI& point, const Pose& pose)
+{
+  const double angleEps = 1e-3, disEps = 1e-5;
+  double pointX1 = point.x - pose.x, pointY1 = point.y - pose.y, pointZ1 = point.z - pose.z;
+  double dis1 = sqrt(pointX1 * pointX1 + pointY1 * pointY1);
+  if (dis1 == 0) return false;
+  if (fabs(dis1 - params.minDyObsDis) < disEps) return true;
+  if (fabs(atan2(pointZ1 - params.minDyObsRelZ, dis1) * 180.0 / M_PI - params.minDyObsAngle) < angleEps) return true;
+
+  double pointX2 = pointX1 * cos(pose.yaw) + pointY1 * sin(pose.yaw);
+  double pointY2 = -pointX1 * sin(pose.yaw) + pointY1 * cos(pose.yaw);
+  double pointX3 = pointX2 * cos(pose.pitch) - pointZ1 * sin(pose.pitch);
+  double pointZ3 = pointX2 * sin(pose.pitch) + pointZ1 * cos(pose.pitch);
+  double pointY4 = pointY2 * cos(pose.roll) + pointZ3 * sin(pose.roll);
+  double pointZ4 = -pointY2 * sin(pose.roll) + pointZ3 * cos(pose.roll);
+  double angle4 = atan2(pointZ4, sqrt(pointX3 * pointX3 + pointY4 * pointY4)) * 180.0 / M_PI;
+  return fabs(angle4 - params.minDyObsVFOV) < angleEps || fabs(angle4 - params.maxDyObsVFOV) < angleEps ||
+         fabs(fabs(pointZ4) - params.absDyObsRelZThre) < disEps;
+}
+
+struct GoldenScan
+{
+  int pointNum;
+  uint64_t hash;
+};
+
+// outputs of terrainAnalysis from before the terrain core was shared, with clearDyObs, noDataObstacle
+// and limitGroundLift on and with the defaults, the point count and cloudHash() per scan
+const GoldenScan goldenChecks[scanNum] = {
+  {0, 0x14650fb0739d0383ull},
+  {7, 0x803810ce07b4b1a9ull},
+  {147, 0xc921acd3b23aef39ull},
+  {602, 0xbcb58dce73fe8bd7ull},
+  {1312, 0x6ba85da86cabff2full},
+  {2088, 0x2d98fa04e578c00eull},
+  {3157, 0xfbaf5477ff21d488ull},
+  {3608, 0x74dad79146385574ull},
+  {3952, 0x1575f491e527965eull},
+  {3923, 0xe87c704c40a4fc1cull},
+  {4227, 0x6e4244a38af8a989ull},
+  {4388, 0x033bc7ddfbe078c1ull},
+  {1966, 0xb66c5b4dcc0b61ffull},
+  {2159, 0xe1f1024e15b88ca3ull},
+  {2238, 0xf90fddc4953069f4ull},
+  {1673, 0x5c4e60577b3c3e51ull},
+  {1885, 0x48e18b7255c315b3ull},
+  {2059, 0x156ab00bc0f0369cull},
+  {1918, 0x7b5795bbd268ac29ull},
+  {2068, 0xf437fd78dbc6c410ull},
+};
+
+const GoldenScan goldenDefaults[scanNum] = {
+  {0, 0x14650fb0739d0383ull},
+  {7, 0x803810ce07b4b1a9ull},
+  {147, 0xc921acd3b23aef39ull},
+  {604, 0xc19b775c069f109cull},
+  {1320, 0x99792e695889f387ull},
+  {2118, 0x91e7f0a5ec3b2b20ull},
+  {3194, 0x087fe11176f79276ull},
+  {3736, 0x96afd0fd3d301e2full},
+  {4263, 0x9878e0f4a4047b74ull},
+  {4401, 0x18106387ed357383ull},
+  {4894, 0x7e1495e157cde7f2ull},
+  {5166, 0xe0001e811b5bb90bull},
+  {2595, 0x058f6ac0692eba4full},
+  {2823, 0xef3ee29495728dc4ull},
+  {3056, 0x765428b135b90531ull},
+  {2259, 0x42c30c0ce5a80d5eull},
+  {2628, 0xf7db4cbdff58d982ull},
+  {2896, 0x978486741dde49f0ull},
+  {2614, 0xba82df980e2b66eeull},
+  {2794, 0x80fab9285a64f167ull},
+};
+
+// runs the scan sequence as terrainAnalysis does, with a map clearing at clearingScan that also
+// restarts the no data check, which only runs once the vehicle is noDecayDis from where it started
+void expectGoldenOutput(bool checks, const GoldenScan* golden)
+{
+  TerrainVoxelMapParams mapParams;
+  mapParams.decayTime = 1.05;
+  mapParams.noDecayDis = 2.0;
+  mapParams.voxelTimeUpdateThre = 0.3;
+  TerrainVoxelMap terrainVoxelMap(mapParams);
+
+  TerrainLocalParams localParams;
+  localParams.clearDyObs = checks;
+  localParams.noDataObstacle = checks;
+  localParams.limitGroundLift = checks;
+  TerrainLocalAnalysis terrainLocalAnalysis(localParams);
+
+  const int clearingScan = 12;
+  const double clearingDis = 3.0;
+  int noDataInited = 0;
+  float vehicleXRec = 0, vehicleYRec = 0;
+  pcl::PointCloud<pcl::PointXYZI> scanCloud, cloudCrop, terrainCloud, terrainCloudElev;
+  for (int scan = 0; scan < scanNum; scan++) {
+    float vehicleX, vehicleY, vehicleZ;
+    scanPose(scan, vehicleX, vehicleY, vehicleZ);
+    double scanTime = 0.125 * scan;
+
+    if (noDataInited == 0) {
+      vehicleXRec = vehicleX;
+      vehicleYRec = vehicleY;
+      noDataInited = 1;
+    }
+    if (noDataInited == 1) {
+      float dis = sqrt((vehicleX - vehicleXRec) * (vehicleX - vehicleXRec) +
+                       (vehicleY - vehicleYRec) * (vehicleY - vehicleYRec));
+      if (dis >= mapParams.noDecayDis) noDataInited = 2;
+    }
+    if (scan == clearingScan) noDataInited = 0;
+
+    makeScan(scan, scanCloud);
+    cloudCrop.clear();
+    terrainVoxelMap.cropScan(scanCloud, vehicleX, vehicleY, vehicleZ, scanTime, cloudCrop);
+    terrainVoxelMap.update(cloudCrop, vehicleX, vehicleY, vehicleZ, scanTime, scan == clearingScan, clearingDis);
+
+    terrainCloud.clear();
+    terrainVoxelMap.collect(5, terrainCloud);
+    terrainLocalAnalysis.compute(terrainCloud, cloudCrop, vehicleX, vehicleY, vehicleZ, 0, 0, 0, noDataInited == 2,
+                                 terrainCloudElev);
+
+    EXPECT_EQ(int(terrainCloudElev.points.size()), golden[scan].pointNum) << "scan " << scan;
+    EXPECT_EQ(cloudHash(terrainCloudElev), golden[scan].hash) << "scan " << scan;
+  }
+}
+}
+
+TEST(TerrainLocalAnalysis, SameOutputForAnyThreadNum)
+{
+  for (const TerrainLocalParams& params : testParams()) {
+    TerrainLocalAnalysis refAnalysis(params);
+    vector<TerrainLocalAnalysis> analyses;
+    for (int threadNum : {2, 3, 4, 7}) {
+      TerrainLocalParams threadParams = params;
+      threadParams.threadNum = threadNum;
+      analyses.push_back(TerrainLocalAnalysis(threadParams));
+    }
+
+    // the same instances over a sequence of scans, so the buckets of one scan are reused by the next
+    pcl::PointCloud<pcl::PointXYZI> terrainCloud, laserCloudCrop, refCloudElev, cloudElev;
+    for (size_t s = 0; s < sizeof(testPoses) / sizeof(testPoses[0]); s++) {
+      const Pose& pose = testPoses[s];
+      makeClouds(s + 1, pose, terrainCloud, laserCloudCrop);
+      bool markNoData = s > 0;
+      refAnalysis.compute(terrainCloud, laserCloudCrop, pose.x, pose.y, pose.z, pose.roll, pose.pitch, pose.yaw,
+                          markNoData, refCloudElev);
+      ASSERT_GT(refCloudElev.points.size(), 0u);
+
+      for (TerrainLocalAnalysis& analysis : analyses) {
+        SCOPED_TRACE("scan " + to_string(s) + ", threadNum " + to_string(analysis.params().threadNum));
+        analysis.compute(terrainCloud, laserCloudCrop, pose.x, pose.y, pose.z, pose.roll, pose.pitch, pose.yaw,
+                         markNoData, cloudElev);
+        expectSameClouds(cloudElev, refCloudElev);
+        expectSameVoxels(analysis, refAnalysis);
+      }
+    }
+  }
+}
+
+TEST(TerrainLocalAnalysis, FewerThreadsThanAskedFor)
+{
+#ifndef _OPENMP
+  GTEST_SKIP() << "built without OpenMP";
+#else
+  TerrainLocalParams params = testParams()[2];
+  TerrainLocalAnalysis refAnalysis(params);
+  params.threadNum = 4;
+  TerrainLocalAnalysis analysis(params);
+
+  pcl::PointCloud<pcl::PointXYZI> terrainCloud, laserCloudCrop, refCloudElev, cloudElev;
+  const Pose& pose = testPoses[1];
+  makeClouds(1, testPoses[0], terrainCloud, laserCloudCrop);
+  analysis.compute(terrainCloud, laserCloudCrop, testPoses[0].x, testPoses[0].y, testPoses[0].z, testPoses[0].roll,
+                   testPoses[0].pitch, testPoses[0].yaw, true, cloudElev);
+
+  // inside another parallel region the runtime starts a single thread, the buckets filled by the
+  // threads of the scan before must not come back
+  makeClouds(2, pose, terrainCloud, laserCloudCrop);
+  int maxActiveLevels = omp_get_max_active_levels();
+  omp_set_max_active_levels(1);
+  #pragma omp parallel num_threads(2)
+  {
+    if (omp_get_thread_num() == 0) {
+      analysis.compute(terrainCloud, laserCloudCrop, pose.x, pose.y, pose.z, pose.roll, pose.pitch, pose.yaw, true,
+                       cloudElev);
+    }
+  }
+  omp_set_max_active_levels(maxActiveLevels);
+
+  refAnalysis.compute(terrainCloud, laserCloudCrop, pose.x, pose.y, pose.z, pose.roll, pose.pitch, pose.yaw, true,
+                      refCloudElev);
+  expectSameClouds(cloudElev, refCloudElev);
+  expectSameVoxels(analysis, refAnalysis);
+#endif
+}
+
+TEST(TerrainLocalAnalysis, DyObsMarksMatchAtan2)
+{
+  TerrainLocalParams params;
+  params.clearDyObs = true;
+  vector<TerrainLocalParams> paramsList(3, params);
+  paramsList[1].minDyObsAngle = -10.0;
+  paramsList[1].minDyObsVFOV = -30.0;
+  paramsList[1].maxDyObsVFOV = 5.0;
+  paramsList[1].absDyObsRelZThre = 0.1;
+  paramsList[1].minDyObsPointNum = 3;
+  paramsList[2].minDyObsAngle = 20.0;
+  paramsList[2].minDyObsVFOV = -5.0;
+  paramsList[2].maxDyObsVFOV = 25.0;
+  paramsList[2].absDyObsRelZThre = 0;
+  paramsList[2].minDyObsDis = 1.0;
+
+  const Pose poses[] = {
+    {0.3, -0.2, 0.5, 0.25, -0.3, 0.8},
+    {-1.7, 2.2, 0.5, -0.4, 0.15, -2.6},
+    {0, 0, 0.5, 0.05, 0.35, 3.1},
+  };
+
+  mt19937 generator(7);
+  uniform_real_distribution<float> posDist(-5, 5);
+  uniform_real_distribution<float> relZDist(-2, 2.5);
+  uniform_real_distribution<float> unitDist(0, 1);
+  for (const TerrainLocalParams& params : paramsList) {
+    TerrainLocalAnalysis analysis(params);
+    for (const Pose& pose : poses) {
+      pcl::PointCloud<pcl::PointXYZI> terrainCloud, laserCloudCrop, cloudElev;
+      pcl::PointXYZI point;
+      point.intensity = 0;
+      for (int i = 0; i < 40000; i++) {
+        point.x = pose.x + posDist(generator);
+        point.y = pose.y + posDist(generator);
+        point.z = pose.z + relZDist(generator);
+        if (nearDyObsThreshold(params, point, pose)) continue;
+        if (unitDist(generator) < 0.9) terrainCloud.push_back(point);
+        else laserCloudCrop.push_back(point);
+      }
+
+      // straight above and below the vehicle, and right at minDyObsRelZ with vehicleZ 0.5 and
+      // minDyObsRelZ -0.5 so the height over it is exactly 0
+      for (float z : {-1.0f, 0.0f, 1.5f}) {
+        point.x = pose.x;
+        point.y = pose.y;
+        point.z = z;
+        terrainCloud.push_back(point);
+        TerrainLocalAnalysis zeroAnalysis(params);
+        pcl::PointCloud<pcl::PointXYZI> zeroCloud;
+        zeroCloud.push_back(point);
+        zeroAnalysis.compute(zeroCloud, zeroCloud, pose.x, pose.y, pose.z, pose.roll, pose.pitch, pose.yaw, false,
+                             cloudElev);
+        vector<int> voxelDyObs = atan2VoxelDyObs(params, zeroCloud, zeroCloud, pose);
+        for (size_t i = 0; i < voxelDyObs.size(); i++) {
+          ASSERT_EQ(zeroAnalysis.voxelDyObs(i), voxelDyObs[i])
+              << "point at z " << z << ", minDyObsAngle " << params.minDyObsAngle;
+        }
+      }
+
+      analysis.compute(terrainCloud, laserCloudCrop, pose.x, pose.y, pose.z, pose.roll, pose.pitch, pose.yaw, false,
+                       cloudElev);
+      vector<int> voxelDyObs = atan2VoxelDyObs(params, terrainCloud, laserCloudCrop, pose);
+      int markedNum = 0;
+      for (size_t i = 0; i < voxelDyObs.size(); i++) {
+        ASSERT_EQ(analysis.voxelDyObs(i), voxelDyObs[i]) << "voxel " << i << ", minDyObsAngle " << params.minDyObsAngle;
+        if (voxelDyObs[i] > 0) markedNum++;
+      }
+
+      // both outcomes are covered
+      EXPECT_GT(markedNum, 50);
+      EXPECT_LT(markedNum, int(voxelDyObs.size()) - 50);
+    }
+  }
+}
+
+TEST(TerrainLocalAnalysis, GridMatchesTerrainMap)
+{
+  TerrainLocalParams params = testParams()[2];
+  params.threadNum = 3;
+  TerrainLocalAnalysis analysis(params);
+  float planarVoxelSize = params.planarVoxelSize;
+  int planarVoxelWidth = params.planarVoxelWidth;
+  int planarVoxelHalfWidth = (planarVoxelWidth - 1) / 2;
+  int planarVoxelNum = planarVoxelWidth * planarVoxelWidth;
+  const float elevGridObsThre = 0.15;
+
+  mt19937 generator(11);
+  uniform_int_distribution<int> cellDist(-planarVoxelHalfWidth - 3, planarVoxelHalfWidth + 3);
+  uniform_real_distribution<float> offsetDist(-0.4, 0.4);
+  uniform_real_distribution<float> heightDist(0, 1.2);
+  uniform_real_distribution<float> unitDist(0, 1);
+
+  vector<int8_t> occupancy;
+  vector<float> layers;
+  for (const Pose& pose : testPoses) {
+    // points kept off the cell borders, so the reference binning below can not round the other way
+    pcl::PointCloud<pcl::PointXYZI> terrainCloud, laserCloudCrop, terrainCloudElev;
+    pcl::PointXYZI point;
+    point.intensity = 0;
+    for (int i = 0; i < 40000; i++) {
+      int cellX = cellDist(generator), cellY = cellDist(generator);
+      if (cellX > 10 && cellX < 18 && abs(cellY) < 5) continue;
+      point.x = pose.x + planarVoxelSize * (cellX + offsetDist(generator));
+      point.y = pose.y + planarVoxelSize * (cellY + offsetDist(generator));
+      point.z = pose.z - 0.7 + (unitDist(generator) < 0.15 ? heightDist(generator) : 0.02f * unitDist(generator));
+      terrainCloud.push_back(point);
+      if (unitDist(generator) < 0.2) laserCloudCrop.push_back(point);
+    }
+
+    analysis.compute(terrainCloud, laserCloudCrop, pose.x, pose.y, pose.z, pose.roll, pose.pitch, pose.yaw, true,
+                     terrainCloudElev);
+    analysis.computeGrid(terrainCloudElev, pose.x, pose.y, elevGridObsThre, occupancy, layers);
+    ASSERT_EQ(int(occupancy.size()), planarVoxelNum);
+    ASSERT_EQ(int(layers.size()), 3 * planarVoxelNum);
+
+    // /terrain_map binned by the grid origin and resolution
+    double originX = pose.x - planarVoxelSize * (planarVoxelHalfWidth + 0.5);
+    double originY = pose.y - planarVoxelSize * (planarVoxelHalfWidth + 0.5);
+    vector<float> maxHeight(planarVoxelNum, 0);
+    vector<bool> hasTerrainPoint(planarVoxelNum, false);
+    vector<int> pointCells;
+    for (const pcl::PointXYZI& mapPoint : terrainCloudElev.points) {
+      int indX = int(floor((mapPoint.x - originX) / planarVoxelSize));
+      int indY = int(floor((mapPoint.y - originY) / planarVoxelSize));
+      int ind = -1;
+      if (indX >= 0 && indX < planarVoxelWidth && indY >= 0 && indY < planarVoxelWidth) {
+        ind = planarVoxelWidth * indX + indY;
+        maxHeight[ind] = max(maxHeight[ind], mapPoint.intensity);
+        if (mapPoint.intensity < params.vehicleHeight) hasTerrainPoint[ind] = true;
+      }
+      pointCells.push_back(ind);
+    }
+
+    int occupiedNum = 0, freeNum = 0, unobservedNum = 0;
+    for (int indX = 0; indX < planarVoxelWidth; indX++) {
+      for (int indY = 0; indY < planarVoxelWidth; indY++) {
+        int ind = planarVoxelWidth * indX + indY;
+        float elev = layers[ind];
+        bool observed = layers[2 * planarVoxelNum + ind] == 1.0f;
+        ASSERT_TRUE(observed || layers[2 * planarVoxelNum + ind] == 0) << "cell " << indX << ", " << indY;
+        EXPECT_EQ(observed, analysis.voxelPointNum(ind) >= params.minBlockPointNum) << "cell " << indX << ", " << indY;
+        EXPECT_EQ(isnan(elev), !observed) << "cell " << indX << ", " << indY;
+        EXPECT_EQ(layers[planarVoxelNum + ind], maxHeight[ind]) << "cell " << indX << ", " << indY;
+
+        // a terrain point only makes it into the map from an observed cell
+        if (hasTerrainPoint[ind]) {
+          EXPECT_TRUE(observed) << "cell " << indX << ", " << indY;
+        }
+
+        int8_t cellOccupancy = occupancy[planarVoxelWidth * indY + indX];
+        if (maxHeight[ind] >= elevGridObsThre) {
+          EXPECT_EQ(cellOccupancy, 100) << "cell " << indX << ", " << indY;
+          occupiedNum++;
+        } else if (observed) {
+          EXPECT_EQ(cellOccupancy, 0) << "cell " << indX << ", " << indY;
+          freeNum++;
+        } else {
+          EXPECT_EQ(cellOccupancy, -1) << "cell " << indX << ", " << indY;
+          unobservedNum++;
+        }
+      }
+    }
+
+    // the terrain points hold their height above the ground layer of their cell
+    for (size_t i = 0; i < terrainCloudElev.points.size(); i++) {
+      const pcl::PointXYZI& mapPoint = terrainCloudElev.points[i];
+      if (pointCells[i] < 0 || mapPoint.intensity >= params.vehicleHeight) continue;
+      EXPECT_FLOAT_EQ(fabs(mapPoint.z - layers[pointCells[i]]), mapPoint.intensity) << "point " << i;
+    }
+
+    EXPECT_GT(occupiedNum, 100);
+    EXPECT_GT(freeNum, 100);
+    EXPECT_GT(unobservedNum, 10);
+  }
+}
+
+TEST(TerrainLocalAnalysis, GoldenScanSequence)
+{
+  expectGoldenOutput(true, goldenChecks);
+}
+
+TEST(TerrainLocalAnalysis, GoldenScanSequenceDefaults)
+{
+  expectGoldenOutput(false, goldenDefaults);
+}
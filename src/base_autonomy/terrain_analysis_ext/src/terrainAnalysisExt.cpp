@@ -3,7 +3,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <chrono>
-#include <queue>
 
 #include "rclcpp/rclcpp.hpp"
 #include "rclcpp/time.hpp"
@@ -31,6 +30,9 @@
 #include "rmw/types.h"
 #include "rmw/qos_profiles.h"
 
+#include "terrain_analysis/terrainExtAnalysis.h"
+#include "terrain_analysis/terrainVoxelMap.h"
+
 using namespace std;
 
 const double PI = 3.1415926;
@@ -53,35 +55,27 @@ double terrainUnderVehicle = -0.75;
 double terrainConnThre = 0.5;
 double ceilingFilteringThre = 2.0;
 double localTerrainMapRadius = 4.0;
+bool useMultiLayer = false;
+int maxLayerNum = 3;
+double layerGapThre = 0.3;
+double layerClearance = 0.6;
 
 // terrain voxel parameters
 float terrainVoxelSize = 2.0;
-int terrainVoxelShiftX = 0;
-int terrainVoxelShiftY = 0;
 const int terrainVoxelWidth = 41;
-int terrainVoxelHalfWidth = (terrainVoxelWidth - 1) / 2;
-const int terrainVoxelNum = terrainVoxelWidth * terrainVoxelWidth;
 
 // planar voxel parameters
 float planarVoxelSize = 0.4;
 const int planarVoxelWidth = 101;
-int planarVoxelHalfWidth = (planarVoxelWidth - 1) / 2;
-const int planarVoxelNum = planarVoxelWidth * planarVoxelWidth;
 
 pcl::PointCloud<pcl::PointXYZI>::Ptr laserCloud(new pcl::PointCloud<pcl::PointXYZI>());
 pcl::PointCloud<pcl::PointXYZI>::Ptr laserCloudCrop(new pcl::PointCloud<pcl::PointXYZI>());
-pcl::PointCloud<pcl::PointXYZI>::Ptr laserCloudDwz(new pcl::PointCloud<pcl::PointXYZI>());
 pcl::PointCloud<pcl::PointXYZI>::Ptr terrainCloud(new pcl::PointCloud<pcl::PointXYZI>());
 pcl::PointCloud<pcl::PointXYZI>::Ptr terrainCloudElev(new pcl::PointCloud<pcl::PointXYZI>());
 pcl::PointCloud<pcl::PointXYZI>::Ptr terrainCloudLocal(new pcl::PointCloud<pcl::PointXYZI>());
-pcl::PointCloud<pcl::PointXYZI>::Ptr terrainVoxelCloud[terrainVoxelNum];
 
-int terrainVoxelUpdateNum[terrainVoxelNum] = { 0 };
-float terrainVoxelUpdateTime[terrainVoxelNum] = { 0 };
-float planarVoxelElev[planarVoxelNum] = { 0 };
-int planarVoxelConn[planarVoxelNum] = { 0 };
-vector<float> planarPointElev[planarVoxelNum];
-queue<int> planarVoxelQueue;
+TerrainVoxelMap terrainVoxelMap;
+TerrainExtAnalysis terrainExtAnalysis;
 
 double laserCloudTime = 0;
 bool newlaserCloud = false;
@@ -92,9 +86,6 @@ bool systemInited = false;
 float vehicleRoll = 0, vehiclePitch = 0, vehicleYaw = 0;
 float vehicleX = 0, vehicleY = 0, vehicleZ = 0;
 
-pcl::VoxelGrid<pcl::PointXYZI> downSizeFilter;
-pcl::KdTreeFLANN<pcl::PointXYZI> kdtree;
-
 // state estimation callback function
 void odometryHandler(const nav_msgs::msg::Odometry::ConstSharedPtr odom)
 {
@@ -124,28 +115,8 @@ void laserCloudHandler(const sensor_msgs::msg::PointCloud2::ConstSharedPtr laser
   laserCloud->clear();
   pcl::fromROSMsg(*laserCloud2, *laserCloud);
 
-  pcl::PointXYZI point;
   laserCloudCrop->clear();
-  int laserCloudSize = laserCloud->points.size();
-  for (int i = 0; i < laserCloudSize; i++)
-  {
-    point = laserCloud->points[i];
-
-    float pointX = point.x;
-    float pointY = point.y;
-    float pointZ = point.z;
-
-    float dis = sqrt((pointX - vehicleX) * (pointX - vehicleX) + (pointY - vehicleY) * (pointY - vehicleY));
-    if (pointZ - vehicleZ > lowerBoundZ - disRatioZ * dis && pointZ - vehicleZ < upperBoundZ + disRatioZ * dis &&
-        dis < terrainVoxelSize * (terrainVoxelHalfWidth + 1))
-    {
-      point.x = pointX;
-      point.y = pointY;
-      point.z = pointZ;
-      point.intensity = laserCloudTime - systemInitTime;
-      laserCloudCrop->push_back(point);
-    }
-  }
+  terrainVoxelMap.cropScan(*laserCloud, vehicleX, vehicleY, vehicleZ, laserCloudTime - systemInitTime, *laserCloudCrop);
 
   newlaserCloud = true;
 }
@@ -195,6 +166,10 @@ int main(int argc, char** argv)
   nh->declare_parameter<double>("terrainConnThre", terrainConnThre);
   nh->declare_parameter<double>("ceilingFilteringThre", ceilingFilteringThre);
   nh->declare_parameter<double>("localTerrainMapRadius", localTerrainMapRadius);
+  nh->declare_parameter<bool>("useMultiLayer", useMultiLayer);
+  nh->declare_parameter<int>("maxLayerNum", maxLayerNum);
+  nh->declare_parameter<double>("layerGapThre", layerGapThre);
+  nh->declare_parameter<double>("layerClearance", layerClearance);
 
   nh->get_parameter("scanVoxelSize", scanVoxelSize);
   nh->get_parameter("decayTime", decayTime);
@@ -213,6 +188,10 @@ int main(int argc, char** argv)
   nh->get_parameter("terrainConnThre", terrainConnThre);
   nh->get_parameter("ceilingFilteringThre", ceilingFilteringThre);
   nh->get_parameter("localTerrainMapRadius", localTerrainMapRadius);
+  nh->get_parameter("useMultiLayer", useMultiLayer);
+  nh->get_parameter("maxLayerNum", maxLayerNum);
+  nh->get_parameter("layerGapThre", layerGapThre);
+  nh->get_parameter("layerClearance", layerClearance);
 
   auto subOdometry = nh->create_subscription<nav_msgs::msg::Odometry>("/state_estimation", 5, odometryHandler);
 
@@ -226,15 +205,38 @@ int main(int argc, char** argv)
 
   auto pubTerrainCloud = nh->create_publisher<sensor_msgs::msg::PointCloud2>("/terrain_map_ext", 2);
 
-  for (int i = 0; i < terrainVoxelNum; i++)
-  {
-    terrainVoxelCloud[i].reset(new pcl::PointCloud<pcl::PointXYZI>());
-  }
-
-  downSizeFilter.setLeafSize(scanVoxelSize, scanVoxelSize, scanVoxelSize);
-
-  std::vector<int> pointIdxNKNSearch;
-  std::vector<float> pointNKNSquaredDistance;
+  TerrainVoxelMapParams mapParams;
+  mapParams.terrainVoxelSize = terrainVoxelSize;
+  mapParams.terrainVoxelWidth = terrainVoxelWidth;
+  mapParams.scanVoxelSize = scanVoxelSize;
+  mapParams.decayTime = decayTime;
+  mapParams.noDecayDis = noDecayDis;
+  mapParams.voxelPointUpdateThre = voxelPointUpdateThre;
+  mapParams.voxelTimeUpdateThre = voxelTimeUpdateThre;
+  mapParams.minRelZ = lowerBoundZ;
+  mapParams.maxRelZ = upperBoundZ;
+  mapParams.disRatioZ = disRatioZ;
+  terrainVoxelMap.setParams(mapParams);
+
+  TerrainExtParams extParams;
+  extParams.planarVoxelSize = planarVoxelSize;
+  extParams.planarVoxelWidth = planarVoxelWidth;
+  extParams.useSorting = useSorting;
+  extParams.quantileZ = quantileZ;
+  extParams.vehicleHeight = vehicleHeight;
+  extParams.lowerBoundZ = lowerBoundZ;
+  extParams.upperBoundZ = upperBoundZ;
+  extParams.disRatioZ = disRatioZ;
+  extParams.checkTerrainConn = checkTerrainConn;
+  extParams.terrainUnderVehicle = terrainUnderVehicle;
+  extParams.terrainConnThre = terrainConnThre;
+  extParams.ceilingFilteringThre = ceilingFilteringThre;
+  extParams.localTerrainMapRadius = localTerrainMapRadius;
+  extParams.useMultiLayer = useMultiLayer;
+  extParams.maxLayerNum = maxLayerNum;
+  extParams.layerGapThre = layerGapThre;
+  extParams.layerClearance = layerClearance;
+  terrainExtAnalysis.setParams(extParams);
 
   rclcpp::Rate rate(100);
   bool status = rclcpp::ok();
@@ -246,309 +248,15 @@ int main(int argc, char** argv)
     {
       newlaserCloud = false;
 
-      // terrain voxel roll over
-      float terrainVoxelCenX = terrainVoxelSize * terrainVoxelShiftX;
-      float terrainVoxelCenY = terrainVoxelSize * terrainVoxelShiftY;
-
-      while (vehicleX - terrainVoxelCenX < -terrainVoxelSize)
-      {
-        for (int indY = 0; indY < terrainVoxelWidth; indY++)
-        {
-          pcl::PointCloud<pcl::PointXYZI>::Ptr terrainVoxelCloudPtr =
-              terrainVoxelCloud[terrainVoxelWidth * (terrainVoxelWidth - 1) + indY];
-          for (int indX = terrainVoxelWidth - 1; indX >= 1; indX--)
-          {
-            terrainVoxelCloud[terrainVoxelWidth * indX + indY] =
-                terrainVoxelCloud[terrainVoxelWidth * (indX - 1) + indY];
-          }
-          terrainVoxelCloud[indY] = terrainVoxelCloudPtr;
-          terrainVoxelCloud[indY]->clear();
-        }
-        terrainVoxelShiftX--;
-        terrainVoxelCenX = terrainVoxelSize * terrainVoxelShiftX;
-      }
-
-      while (vehicleX - terrainVoxelCenX > terrainVoxelSize)
-      {
-        for (int indY = 0; indY < terrainVoxelWidth; indY++)
-        {
-          pcl::PointCloud<pcl::PointXYZI>::Ptr terrainVoxelCloudPtr = terrainVoxelCloud[indY];
-          for (int indX = 0; indX < terrainVoxelWidth - 1; indX++)
-          {
-            terrainVoxelCloud[terrainVoxelWidth * indX + indY] =
-                terrainVoxelCloud[terrainVoxelWidth * (indX + 1) + indY];
-          }
-          terrainVoxelCloud[terrainVoxelWidth * (terrainVoxelWidth - 1) + indY] = terrainVoxelCloudPtr;
-          terrainVoxelCloud[terrainVoxelWidth * (terrainVoxelWidth - 1) + indY]->clear();
-        }
-        terrainVoxelShiftX++;
-        terrainVoxelCenX = terrainVoxelSize * terrainVoxelShiftX;
-      }
-
-      while (vehicleY - terrainVoxelCenY < -terrainVoxelSize)
-      {
-        for (int indX = 0; indX < terrainVoxelWidth; indX++)
-        {
-          pcl::PointCloud<pcl::PointXYZI>::Ptr terrainVoxelCloudPtr =
-              terrainVoxelCloud[terrainVoxelWidth * indX + (terrainVoxelWidth - 1)];
-          for (int indY = terrainVoxelWidth - 1; indY >= 1; indY--)
-          {
-            terrainVoxelCloud[terrainVoxelWidth * indX + indY] =
-                terrainVoxelCloud[terrainVoxelWidth * indX + (indY - 1)];
-          }
-          terrainVoxelCloud[terrainVoxelWidth * indX] = terrainVoxelCloudPtr;
-          terrainVoxelCloud[terrainVoxelWidth * indX]->clear();
-        }
-        terrainVoxelShiftY--;
-        terrainVoxelCenY = terrainVoxelSize * terrainVoxelShiftY;
-      }
-
-      while (vehicleY - terrainVoxelCenY > terrainVoxelSize)
-      {
-        for (int indX = 0; indX < terrainVoxelWidth; indX++)
-        {
-          pcl::PointCloud<pcl::PointXYZI>::Ptr terrainVoxelCloudPtr = terrainVoxelCloud[terrainVoxelWidth * indX];
-          for (int indY = 0; indY < terrainVoxelWidth - 1; indY++)
-          {
-            terrainVoxelCloud[terrainVoxelWidth * indX + indY] =
-                terrainVoxelCloud[terrainVoxelWidth * indX + (indY + 1)];
-          }
-          terrainVoxelCloud[terrainVoxelWidth * indX + (terrainVoxelWidth - 1)] = terrainVoxelCloudPtr;
-          terrainVoxelCloud[terrainVoxelWidth * indX + (terrainVoxelWidth - 1)]->clear();
-        }
-        terrainVoxelShiftY++;
-        terrainVoxelCenY = terrainVoxelSize * terrainVoxelShiftY;
-      }
-
-      // stack registered laser scans
-      pcl::PointXYZI point;
-      int laserCloudCropSize = laserCloudCrop->points.size();
-      for (int i = 0; i < laserCloudCropSize; i++)
-      {
-        point = laserCloudCrop->points[i];
-
-        int indX = int((point.x - vehicleX + terrainVoxelSize / 2) / terrainVoxelSize) + terrainVoxelHalfWidth;
-        int indY = int((point.y - vehicleY + terrainVoxelSize / 2) / terrainVoxelSize) + terrainVoxelHalfWidth;
-
-        if (point.x - vehicleX + terrainVoxelSize / 2 < 0)
-          indX--;
-        if (point.y - vehicleY + terrainVoxelSize / 2 < 0)
-          indY--;
-
-        if (indX >= 0 && indX < terrainVoxelWidth && indY >= 0 && indY < terrainVoxelWidth)
-        {
-          terrainVoxelCloud[terrainVoxelWidth * indX + indY]->push_back(point);
-          terrainVoxelUpdateNum[terrainVoxelWidth * indX + indY]++;
-        }
-      }
-
-      for (int ind = 0; ind < terrainVoxelNum; ind++)
-      {
-        if (terrainVoxelUpdateNum[ind] >= voxelPointUpdateThre ||
-            laserCloudTime - systemInitTime - terrainVoxelUpdateTime[ind] >= voxelTimeUpdateThre || clearingCloud)
-        {
-          pcl::PointCloud<pcl::PointXYZI>::Ptr terrainVoxelCloudPtr = terrainVoxelCloud[ind];
-
-          laserCloudDwz->clear();
-          downSizeFilter.setInputCloud(terrainVoxelCloudPtr);
-          downSizeFilter.filter(*laserCloudDwz);
-
-          terrainVoxelCloudPtr->clear();
-          int laserCloudDwzSize = laserCloudDwz->points.size();
-          for (int i = 0; i < laserCloudDwzSize; i++)
-          {
-            point = laserCloudDwz->points[i];
-            float dis = sqrt((point.x - vehicleX) * (point.x - vehicleX) + (point.y - vehicleY) * (point.y - vehicleY));
-            if (point.z - vehicleZ > lowerBoundZ - disRatioZ * dis &&
-                point.z - vehicleZ < upperBoundZ + disRatioZ * dis &&
-                (laserCloudTime - systemInitTime - point.intensity < decayTime || dis < noDecayDis) &&
-                !(dis < clearingDis && clearingCloud))
-            {
-              terrainVoxelCloudPtr->push_back(point);
-            }
-          }
-
-          terrainVoxelUpdateNum[ind] = 0;
-          terrainVoxelUpdateTime[ind] = laserCloudTime - systemInitTime;
-        }
-      }
+      // stack registered laser scans, roll over and refresh the terrain voxels
+      terrainVoxelMap.update(*laserCloudCrop, vehicleX, vehicleY, vehicleZ, laserCloudTime - systemInitTime,
+                             clearingCloud, clearingDis);
 
       terrainCloud->clear();
-      for (int indX = terrainVoxelHalfWidth - 10; indX <= terrainVoxelHalfWidth + 10; indX++)
-      {
-        for (int indY = terrainVoxelHalfWidth - 10; indY <= terrainVoxelHalfWidth + 10; indY++)
-        {
-          *terrainCloud += *terrainVoxelCloud[terrainVoxelWidth * indX + indY];
-        }
-      }
-
-      // estimate ground and compute elevation for each point
-      for (int i = 0; i < planarVoxelNum; i++)
-      {
-        planarVoxelElev[i] = 0;
-        planarVoxelConn[i] = 0;
-        planarPointElev[i].clear();
-      }
-
-      int terrainCloudSize = terrainCloud->points.size();
-      for (int i = 0; i < terrainCloudSize; i++)
-      {
-        point = terrainCloud->points[i];
-        float dis = sqrt((point.x - vehicleX) * (point.x - vehicleX) + (point.y - vehicleY) * (point.y - vehicleY));
-        if (point.z - vehicleZ > lowerBoundZ - disRatioZ * dis && point.z - vehicleZ < upperBoundZ + disRatioZ * dis)
-        {
-          int indX = int((point.x - vehicleX + planarVoxelSize / 2) / planarVoxelSize) + planarVoxelHalfWidth;
-          int indY = int((point.y - vehicleY + planarVoxelSize / 2) / planarVoxelSize) + planarVoxelHalfWidth;
-
-          if (point.x - vehicleX + planarVoxelSize / 2 < 0)
-            indX--;
-          if (point.y - vehicleY + planarVoxelSize / 2 < 0)
-            indY--;
-
-          for (int dX = -1; dX <= 1; dX++)
-          {
-            for (int dY = -1; dY <= 1; dY++)
-            {
-              if (indX + dX >= 0 && indX + dX < planarVoxelWidth && indY + dY >= 0 && indY + dY < planarVoxelWidth)
-              {
-                planarPointElev[planarVoxelWidth * (indX + dX) + indY + dY].push_back(point.z);
-              }
-            }
-          }
-        }
-      }
-
-      if (useSorting)
-      {
-        for (int i = 0; i < planarVoxelNum; i++)
-        {
-          int planarPointElevSize = planarPointElev[i].size();
-          if (planarPointElevSize > 0)
-          {
-            sort(planarPointElev[i].begin(), planarPointElev[i].end());
-
-            int quantileID = int(quantileZ * planarPointElevSize);
-            if (quantileID < 0)
-              quantileID = 0;
-            else if (quantileID >= planarPointElevSize)
-              quantileID = planarPointElevSize - 1;
-
-            planarVoxelElev[i] = planarPointElev[i][quantileID];
-          }
-        }
-      }
-      else
-      {
-        for (int i = 0; i < planarVoxelNum; i++)
-        {
-          int planarPointElevSize = planarPointElev[i].size();
-          if (planarPointElevSize > 0)
-          {
-            float minZ = 1000.0;
-            int minID = -1;
-            for (int j = 0; j < planarPointElevSize; j++)
-            {
-              if (planarPointElev[i][j] < minZ)
-              {
-                minZ = planarPointElev[i][j];
-                minID = j;
-              }
-            }
-
-            if (minID != -1)
-            {
-              planarVoxelElev[i] = planarPointElev[i][minID];
-            }
-          }
-        }
-      }
-  
-      // check terrain connectivity to remove ceiling
-      if (checkTerrainConn)
-      {
-        int ind = planarVoxelWidth * planarVoxelHalfWidth + planarVoxelHalfWidth;
-        if (planarPointElev[ind].size() == 0)
-          planarVoxelElev[ind] = vehicleZ + terrainUnderVehicle;
-
-        planarVoxelQueue.push(ind);
-        planarVoxelConn[ind] = 1;
-        while (!planarVoxelQueue.empty())
-        {
-          int front = planarVoxelQueue.front();
-          planarVoxelConn[front] = 2;
-          planarVoxelQueue.pop();
-
-          int indX = int(front / planarVoxelWidth);
-          int indY = front % planarVoxelWidth;
-          for (int dX = -10; dX <= 10; dX++)
-          {
-            for (int dY = -10; dY <= 10; dY++)
-            {
-              if (indX + dX >= 0 && indX + dX < planarVoxelWidth && indY + dY >= 0 && indY + dY < planarVoxelWidth)
-              {
-                ind = planarVoxelWidth * (indX + dX) + indY + dY;
-                if (planarVoxelConn[ind] == 0 && planarPointElev[ind].size() > 0)
-                {
-                  if (fabs(planarVoxelElev[front] - planarVoxelElev[ind]) < terrainConnThre)
-                  {
-                    planarVoxelQueue.push(ind);
-                    planarVoxelConn[ind] = 1;
-                  } else if (fabs(planarVoxelElev[front] - planarVoxelElev[ind]) > ceilingFilteringThre)
-                  {
-                    planarVoxelConn[ind] = -1;
-                  }
-                }
-              }
-            }
-          }
-        } 
-      }
-
-      // compute terrain map beyond localTerrainMapRadius
-      terrainCloudElev->clear();
-      int terrainCloudElevSize = 0;
-      for (int i = 0; i < terrainCloudSize; i++)
-      {
-        point = terrainCloud->points[i];
-        float dis = sqrt((point.x - vehicleX) * (point.x - vehicleX) + (point.y - vehicleY) * (point.y - vehicleY));
-        if (point.z - vehicleZ > lowerBoundZ - disRatioZ * dis && point.z - vehicleZ < upperBoundZ + disRatioZ * dis && dis > localTerrainMapRadius)
-        {
-          int indX = int((point.x - vehicleX + planarVoxelSize / 2) / planarVoxelSize) + planarVoxelHalfWidth;
-          int indY = int((point.y - vehicleY + planarVoxelSize / 2) / planarVoxelSize) + planarVoxelHalfWidth;
-
-          if (point.x - vehicleX + planarVoxelSize / 2 < 0)
-            indX--;
-          if (point.y - vehicleY + planarVoxelSize / 2 < 0)
-            indY--;
-
-          if (indX >= 0 && indX < planarVoxelWidth && indY >= 0 && indY < planarVoxelWidth)
-          {
-            int ind = planarVoxelWidth * indX + indY;
-            float disZ = fabs(point.z - planarVoxelElev[ind]);
-            if (disZ < vehicleHeight && (planarVoxelConn[ind] == 2 || !checkTerrainConn))
-            {
-              terrainCloudElev->push_back(point);
-              terrainCloudElev->points[terrainCloudElevSize].x = point.x;
-              terrainCloudElev->points[terrainCloudElevSize].y = point.y;
-              terrainCloudElev->points[terrainCloudElevSize].z = point.z;
-              terrainCloudElev->points[terrainCloudElevSize].intensity = disZ;
-
-              terrainCloudElevSize++;
-            }
-          }
-        }
-      }
-
-      // merge in local terrain map within localTerrainMapRadius
-      int terrainCloudLocalSize = terrainCloudLocal->points.size();
-      for (int i = 0; i < terrainCloudLocalSize; i++) {
-        point = terrainCloudLocal->points[i];
-        float dis = sqrt((point.x - vehicleX) * (point.x - vehicleX) + (point.y - vehicleY) * (point.y - vehicleY));
-        if (dis <= localTerrainMapRadius)
-        {
-          terrainCloudElev->push_back(point);
-        }
-      }
+      terrainVoxelMap.collect(10, *terrainCloud);
+
+      // estimate ground, remove ceiling and merge in local terrain map
+      terrainExtAnalysis.compute(*terrainCloud, *terrainCloudLocal, vehicleX, vehicleY, vehicleZ, *terrainCloudElev);
 
       clearingCloud = false;
 
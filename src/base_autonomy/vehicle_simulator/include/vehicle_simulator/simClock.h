@@ -0,0 +1,48 @@
+#ifndef SIM_CLOCK_H
+#define SIM_CLOCK_H
+
+#include <stdint.h>
+#include <chrono>
+#include <functional>
+
+// time of the headless simulation in ns, from startTime on in steps of stepTime, the steps are
+// paced against a steady clock at realTimeFactor times real time, or run as fast as possible if
+// realTimeFactor is not positive
+class SimClock
+{
+public:
+  SimClock(int64_t startTime, int64_t stepTime, double realTimeFactor);
+
+  // advances a step and returns the new time
+  int64_t step();
+
+  // sleeps until the wall time of the current step
+  void pace() const;
+
+  // lockstep with the consumers of the time, spinOnce() takes in pending messages and returns the
+  // stamp of the latest command, it is called until the command is stamped at or after the current
+  // time, i.e. answers the last step, or timeout s of wall time have passed, false on timeout
+  bool waitForCommand(const std::function<int64_t()>& spinOnce, double timeout) const;
+
+  // a step of the headless loop of vehicleSimulator, spinSome() takes in the pending messages and
+  // returns the stamp of the latest command, -1 before the first, stepModel() moves the vehicle a step
+  // with the command they left, the clock advances and publish() sends the odometry at the new time,
+  // then the step is paced and with lockstep, once a command came in, waits for the one answering it
+  // with spinOnce() as in waitForCommand(), false on a lockstep timeout
+  bool runStep(const std::function<int64_t()>& spinSome, const std::function<void()>& stepModel,
+               const std::function<void(int64_t)>& publish, bool lockstep, const std::function<int64_t()>& spinOnce,
+               double lockstepTimeout);
+
+  int64_t time() const { return simTime; }
+  int64_t stepCount() const { return stepNum; }
+
+private:
+  int64_t startTime;
+  int64_t stepTime;
+  double realTimeFactor;
+  int64_t simTime;
+  int64_t stepNum;
+  std::chrono::steady_clock::time_point wallStartTime;
+};
+
+#endif
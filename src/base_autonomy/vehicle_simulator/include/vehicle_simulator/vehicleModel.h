@@ -0,0 +1,42 @@
+#ifndef VEHICLE_MODEL_H
+#define VEHICLE_MODEL_H
+
+// settings of the vehicle model, names and defaults follow the vehicleSimulator parameters
+struct VehicleModelParams
+{
+  double sensorOffsetX = 0;
+  double sensorOffsetY = 0;
+  double vehicleHeight = 0.75;
+};
+
+// sensor pose in the map frame, angles in rad
+struct VehiclePose
+{
+  float vehicleX = 0;
+  float vehicleY = 0;
+  float vehicleZ = 0;
+  float vehicleRoll = 0;
+  float vehiclePitch = 0;
+  float vehicleYaw = 0;
+};
+
+// kinematic model of vehicleSimulator, the vehicle drives at the commanded speeds in its own frame
+// and turns about its center, sensorOffsetX and sensorOffsetY from the sensor, roll and pitch
+// follow the terrain inclination and z the terrain elevation plus vehicleHeight
+class VehicleModel
+{
+public:
+  explicit VehicleModel(const VehicleModelParams& params = VehicleModelParams());
+
+  void setParams(const VehicleModelParams& params);
+  const VehicleModelParams& params() const { return modelParams; }
+
+  // moves the pose over stepTime s, fwdSpeed and leftSpeed in m/s, yawRate in rad/s
+  void step(float fwdSpeed, float leftSpeed, float yawRate, float terrainZ, float terrainRoll, float terrainPitch,
+            double stepTime, VehiclePose& pose) const;
+
+private:
+  VehicleModelParams modelParams;
+};
+
+#endif
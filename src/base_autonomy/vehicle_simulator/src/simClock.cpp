@@ -0,0 +1,47 @@
+#include <thread>
+
+#include "vehicle_simulator/simClock.h"
+
+using namespace std;
+
+SimClock::SimClock(int64_t startTime, int64_t stepTime, double realTimeFactor)
+  : startTime(startTime), stepTime(stepTime), realTimeFactor(realTimeFactor), simTime(startTime), stepNum(0),
+    wallStartTime(chrono::steady_clock::now())
+{
+}
+
+int64_t SimClock::step()
+{
+  stepNum++;
+  simTime = startTime + stepNum * stepTime;
+  return simTime;
+}
+
+void SimClock::pace() const
+{
+  if (realTimeFactor <= 0) return;
+  this_thread::sleep_until(wallStartTime + chrono::nanoseconds(int64_t(stepNum * double(stepTime) / realTimeFactor)));
+}
+
+bool SimClock::waitForCommand(const function<int64_t()>& spinOnce, double timeout) const
+{
+  chrono::steady_clock::time_point deadline =
+      chrono::steady_clock::now() + chrono::nanoseconds(int64_t(timeout * 1.0e9));
+  while (spinOnce() < simTime) {
+    if (chrono::steady_clock::now() >= deadline) return false;
+  }
+  return true;
+}
+
+bool SimClock::runStep(const function<int64_t()>& spinSome, const function<void()>& stepModel,
+                       const function<void(int64_t)>& publish, bool lockstep, const function<int64_t()>& spinOnce,
+                       double lockstepTimeout)
+{
+  int64_t cmdTime = spinSome();
+  stepModel();
+  publish(step());
+
+  pace();
+  if (lockstep && cmdTime >= 0) return waitForCommand(spinOnce, lockstepTimeout);
+  return true;
+}
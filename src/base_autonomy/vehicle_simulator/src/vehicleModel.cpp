@@ -0,0 +1,38 @@
+#include <math.h>
+
+#include "vehicle_simulator/vehicleModel.h"
+
+using namespace std;
+
+static const double PI = 3.1415926;
+
+VehicleModel::VehicleModel(const VehicleModelParams& params)
+{
+  setParams(params);
+}
+
+void VehicleModel::setParams(const VehicleModelParams& params)
+{
+  modelParams = params;
+}
+
+void VehicleModel::step(float fwdSpeed, float leftSpeed, float yawRate, float terrainZ, float terrainRoll,
+                        float terrainPitch, double stepTime, VehiclePose& pose) const
+{
+  const VehicleModelParams& p = modelParams;
+  float& vehicleYaw = pose.vehicleYaw;
+
+  pose.vehicleRoll = terrainRoll * cos(vehicleYaw) + terrainPitch * sin(vehicleYaw);
+  pose.vehiclePitch = -terrainRoll * sin(vehicleYaw) + terrainPitch * cos(vehicleYaw);
+  vehicleYaw += stepTime * yawRate;
+  if (vehicleYaw > PI)
+    vehicleYaw -= 2 * PI;
+  else if (vehicleYaw < -PI)
+    vehicleYaw += 2 * PI;
+
+  pose.vehicleX += stepTime * cos(vehicleYaw) * fwdSpeed - stepTime * sin(vehicleYaw) * leftSpeed +
+                   stepTime * yawRate * (-sin(vehicleYaw) * p.sensorOffsetX - cos(vehicleYaw) * p.sensorOffsetY);
+  pose.vehicleY += stepTime * sin(vehicleYaw) * fwdSpeed + stepTime * cos(vehicleYaw) * leftSpeed +
+                   stepTime * yawRate * (cos(vehicleYaw) * p.sensorOffsetX - sin(vehicleYaw) * p.sensorOffsetY);
+  pose.vehicleZ = terrainZ + p.vehicleHeight;
+}
@@ -3,11 +3,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <chrono>
+#include <thread>
 #include <iostream>
 #include "rclcpp/rclcpp.hpp"
 #include "rclcpp/time.hpp"
 #include "rclcpp/clock.hpp"
 #include "builtin_interfaces/msg/time.hpp"
+#include "rosgraph_msgs/msg/clock.hpp"
 
 #include "nav_msgs/msg/odometry.hpp"
 #include "sensor_msgs/msg/point_cloud2.hpp"
@@ -35,6 +37,9 @@
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
 
+#include "vehicle_simulator/vehicleModel.h"
+#include "vehicle_simulator/simClock.h"
+
 #include "message_filters/subscriber.h"
 #include "message_filters/synchronizer.h"
 #include "message_filters/sync_policies/approximate_time.h"
@@ -60,6 +65,10 @@ int minTerrainPointNumIncl = 500;
 double smoothRateIncl = 0.2;
 double InclFittingThre = 0.2;
 double maxIncl = 30.0;
+bool headless = false;
+double realTimeFactor = 1.0;
+bool lockstep = false;
+double lockstepTimeout = 0.1;
 
 pcl::PointCloud<pcl::PointXYZI>::Ptr terrainCloud(new pcl::PointCloud<pcl::PointXYZI>());
 pcl::PointCloud<pcl::PointXYZI>::Ptr terrainCloudIncl(new pcl::PointCloud<pcl::PointXYZI>());
@@ -67,17 +76,16 @@ pcl::PointCloud<pcl::PointXYZI>::Ptr terrainCloudDwz(new pcl::PointCloud<pcl::Po
 
 rclcpp::Time odomTime;
 
-float vehicleX = 0;
-float vehicleY = 0;
-float vehicleZ = 0;
-float vehicleRoll = 0;
-float vehiclePitch = 0;
-float vehicleYaw = 0;
+VehicleModel vehicleModel;
+VehiclePose vehiclePose;
 
 float vehicleYawRate = 0;
 float vehicleFwdSpeed = 0;
 float vehicleLeftSpeed = 0;
 
+// stamp of the latest /cmd_vel in ns, -1 before the first
+int64_t cmdVelTime = -1;
+
 float terrainZ = 0;
 float terrainRoll = 0;
 float terrainPitch = 0;
@@ -104,7 +112,9 @@ void terrainCloudHandler(const sensor_msgs::msg::PointCloud2::ConstSharedPtr ter
   {
     point = terrainCloud->points[i];
 
-    float dis = sqrt((point.x - vehicleX) * (point.x - vehicleX) + (point.y - vehicleY) * (point.y - vehicleY));
+    float disX = point.x - vehiclePose.vehicleX;
+    float disY = point.y - vehiclePose.vehicleY;
+    float dis = sqrt(disX * disX + disY * disY);
 
     if (dis < terrainRadiusZ)
     {
@@ -162,8 +172,8 @@ void terrainCloudHandler(const sensor_msgs::msg::PointCloud2::ConstSharedPtr ter
     {
       point = terrainCloudDwz->points[i];
 
-      matA.at<float>(i, 0) = -point.x + vehicleX;
-      matA.at<float>(i, 1) = point.y - vehicleY;
+      matA.at<float>(i, 0) = -point.x + vehiclePose.vehicleX;
+      matA.at<float>(i, 1) = point.y - vehiclePose.vehicleY;
       matB.at<float>(i, 0) = point.z - elevMean;
 
       if (fabs(matA.at<float>(i, 0) * matX.at<float>(0, 0) + matA.at<float>(i, 1) * matX.at<float>(1, 0) -
@@ -205,6 +215,7 @@ void speedHandler(const geometry_msgs::msg::TwistStamped::ConstSharedPtr speedIn
   vehicleFwdSpeed = speedIn->twist.linear.x;
   vehicleLeftSpeed = speedIn->twist.linear.y;
   vehicleYawRate = speedIn->twist.angular.z;
+  cmdVelTime = rclcpp::Time(speedIn->header.stamp).nanoseconds();
 }
 
 int main(int argc, char** argv)
@@ -215,11 +226,11 @@ int main(int argc, char** argv)
   nh->declare_parameter<double>("sensorOffsetX", sensorOffsetX);
   nh->declare_parameter<double>("sensorOffsetY", sensorOffsetY);
   nh->declare_parameter<double>("vehicleHeight", vehicleHeight);
-  nh->declare_parameter<double>("vehicleX", vehicleX);
-  nh->declare_parameter<double>("vehicleY", vehicleY);
-  nh->declare_parameter<double>("vehicleZ", vehicleZ);
+  nh->declare_parameter<double>("vehicleX", vehiclePose.vehicleX);
+  nh->declare_parameter<double>("vehicleY", vehiclePose.vehicleY);
+  nh->declare_parameter<double>("vehicleZ", vehiclePose.vehicleZ);
   nh->declare_parameter<double>("terrainZ", terrainZ);
-  nh->declare_parameter<double>("vehicleYaw", vehicleYaw);
+  nh->declare_parameter<double>("vehicleYaw", vehiclePose.vehicleYaw);
   nh->declare_parameter<double>("terrainVoxelSize", terrainVoxelSize);
   nh->declare_parameter<double>("groundHeightThre", groundHeightThre);
   nh->declare_parameter<bool>("adjustZ", adjustZ);
@@ -230,15 +241,19 @@ int main(int argc, char** argv)
   nh->declare_parameter<int>("minTerrainPointNumIncl", minTerrainPointNumIncl);
   nh->declare_parameter<double>("InclFittingThre", InclFittingThre);
   nh->declare_parameter<double>("maxIncl", maxIncl);
+  nh->declare_parameter<bool>("headless", headless);
+  nh->declare_parameter<double>("realTimeFactor", realTimeFactor);
+  nh->declare_parameter<bool>("lockstep", lockstep);
+  nh->declare_parameter<double>("lockstepTimeout", lockstepTimeout);
 
   nh->get_parameter("sensorOffsetX", sensorOffsetX);
   nh->get_parameter("sensorOffsetY", sensorOffsetY);
   nh->get_parameter("vehicleHeight", vehicleHeight);
-  nh->get_parameter("vehicleX", vehicleX);
-  nh->get_parameter("vehicleY", vehicleY);
-  nh->get_parameter("vehicleZ", vehicleZ);
+  nh->get_parameter("vehicleX", vehiclePose.vehicleX);
+  nh->get_parameter("vehicleY", vehiclePose.vehicleY);
+  nh->get_parameter("vehicleZ", vehiclePose.vehicleZ);
   nh->get_parameter("terrainZ", terrainZ);
-  nh->get_parameter("vehicleYaw", vehicleYaw);
+  nh->get_parameter("vehicleYaw", vehiclePose.vehicleYaw);
   nh->get_parameter("terrainVoxelSize", terrainVoxelSize);
   nh->get_parameter("groundHeightThre", groundHeightThre);
   nh->get_parameter("adjustZ", adjustZ);
@@ -249,6 +264,16 @@ int main(int argc, char** argv)
   nh->get_parameter("minTerrainPointNumIncl", minTerrainPointNumIncl);
   nh->get_parameter("InclFittingThre", InclFittingThre);
   nh->get_parameter("maxIncl", maxIncl);
+  nh->get_parameter("headless", headless);
+  nh->get_parameter("realTimeFactor", realTimeFactor);
+  nh->get_parameter("lockstep", lockstep);
+  nh->get_parameter("lockstepTimeout", lockstepTimeout);
+
+  VehicleModelParams modelParams;
+  modelParams.sensorOffsetX = sensorOffsetX;
+  modelParams.sensorOffsetY = sensorOffsetY;
+  modelParams.vehicleHeight = vehicleHeight;
+  vehicleModel.setParams(modelParams);
 
   auto subTerrainCloud = nh->create_subscription<sensor_msgs::msg::PointCloud2>("/terrain_map", 2, terrainCloudHandler);
 
@@ -269,72 +294,110 @@ int main(int argc, char** argv)
   geometry_msgs::msg::PoseStamped robotState;
   robotState.header.frame_id = "map";
 
+  // headless, the simulator keeps its own time and publishes it on /clock for the other nodes to run
+  // with use_sim_time, it starts at the wall time and advances 5ms per step, the steps are paced at
+  // realTimeFactor times real time, or run as fast as possible if realTimeFactor is not positive,
+  // with lockstep, once a /cmd_vel came in, the next step waits for a /cmd_vel stamped at or after
+  // the last /clock, i.e. computed from the last odometry, for at most lockstepTimeout s
+  rclcpp::Publisher<rosgraph_msgs::msg::Clock>::SharedPtr pubClock;
+  rosgraph_msgs::msg::Clock clockData;
+  SimClock simClock(rclcpp::Clock(RCL_SYSTEM_TIME).now().nanoseconds(), 5000000, realTimeFactor);
+  if (headless)
+  {
+    pubClock = nh->create_publisher<rosgraph_msgs::msg::Clock>("/clock", 5);
+  }
+
   terrainDwzFilter.setLeafSize(terrainVoxelSize, terrainVoxelSize, terrainVoxelSize);
 
   RCLCPP_INFO(nh->get_logger(), "Simulation started.");
   
-  rclcpp::Rate rate(200);
-  bool status = rclcpp::ok();
-  while (status)
-  {
-    rclcpp::spin_some(nh);
-    float vehicleRecRoll = vehicleRoll;
-    float vehicleRecPitch = vehiclePitch;
-    float vehicleRecZ = vehicleZ;
-
-    vehicleRoll = terrainRoll * cos(vehicleYaw) + terrainPitch * sin(vehicleYaw);
-    vehiclePitch = -terrainRoll * sin(vehicleYaw) + terrainPitch * cos(vehicleYaw);
-    vehicleYaw += 0.005 * vehicleYawRate;
-    if (vehicleYaw > PI)
-      vehicleYaw -= 2 * PI;
-    else if (vehicleYaw < -PI)
-      vehicleYaw += 2 * PI;
-
-    vehicleX += 0.005 * cos(vehicleYaw) * vehicleFwdSpeed - 0.005 * sin(vehicleYaw) * vehicleLeftSpeed +
-                0.005 * vehicleYawRate * (-sin(vehicleYaw) * sensorOffsetX - cos(vehicleYaw) * sensorOffsetY);
-    vehicleY += 0.005 * sin(vehicleYaw) * vehicleFwdSpeed + 0.005 * cos(vehicleYaw) * vehicleLeftSpeed +
-                0.005 * vehicleYawRate * (cos(vehicleYaw) * sensorOffsetX - sin(vehicleYaw) * sensorOffsetY);
-    vehicleZ = terrainZ + vehicleHeight;
-
-    odomTime = nh->now();
-
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(nh);
+  auto spinForCmdVel = [&executor]() {
+    executor.spin_once(chrono::milliseconds(1));
+    return cmdVelTime;
+  };
+  auto spinSome = [&executor]() {
+    executor.spin_some();
+    return cmdVelTime;
+  };
+
+  float vehicleRecRoll = 0, vehicleRecPitch = 0, vehicleRecZ = 0;
+  auto stepModel = [&]() {
+    vehicleRecRoll = vehiclePose.vehicleRoll;
+    vehicleRecPitch = vehiclePose.vehiclePitch;
+    vehicleRecZ = vehiclePose.vehicleZ;
+
+    vehicleModel.step(vehicleFwdSpeed, vehicleLeftSpeed, vehicleYawRate, terrainZ, terrainRoll, terrainPitch, 0.005,
+                      vehiclePose);
+  };
+
+  auto publishState = [&]() {
     // publish 200Hz odometry messages
     tf2::Quaternion quat_tf;
-    quat_tf.setRPY(vehicleRoll, vehiclePitch, vehicleYaw);
+    quat_tf.setRPY(vehiclePose.vehicleRoll, vehiclePose.vehiclePitch, vehiclePose.vehicleYaw);
     geometry_msgs::msg::Quaternion geoQuat;
     tf2::convert(quat_tf, geoQuat);
 
     odomData.header.stamp = odomTime;
     odomData.pose.pose.orientation = geoQuat;
-    odomData.pose.pose.position.x = vehicleX;
-    odomData.pose.pose.position.y = vehicleY;
-    odomData.pose.pose.position.z = vehicleZ;
-    odomData.twist.twist.angular.x = 200.0 * (vehicleRoll - vehicleRecRoll);
-    odomData.twist.twist.angular.y = 200.0 * (vehiclePitch - vehicleRecPitch);
+    odomData.pose.pose.position.x = vehiclePose.vehicleX;
+    odomData.pose.pose.position.y = vehiclePose.vehicleY;
+    odomData.pose.pose.position.z = vehiclePose.vehicleZ;
+    odomData.twist.twist.angular.x = 200.0 * (vehiclePose.vehicleRoll - vehicleRecRoll);
+    odomData.twist.twist.angular.y = 200.0 * (vehiclePose.vehiclePitch - vehicleRecPitch);
     odomData.twist.twist.angular.z = vehicleYawRate;
     odomData.twist.twist.linear.x = vehicleFwdSpeed;
     odomData.twist.twist.linear.y = vehicleLeftSpeed;
-    odomData.twist.twist.linear.z = 200.0 * (vehicleZ - vehicleRecZ);
+    odomData.twist.twist.linear.z = 200.0 * (vehiclePose.vehicleZ - vehicleRecZ);
     pubVehicleOdom->publish(odomData);
 
     // publish 200Hz tf messages
     odomTrans.setRotation(tf2::Quaternion(geoQuat.x, geoQuat.y, geoQuat.z, geoQuat.w));
-    odomTrans.setOrigin(tf2::Vector3(vehicleX, vehicleY, vehicleZ));
+    odomTrans.setOrigin(tf2::Vector3(vehiclePose.vehicleX, vehiclePose.vehicleY, vehiclePose.vehicleZ));
     transformTfGeom = tf2::toMsg(odomTrans);
     transformTfGeom.child_frame_id = "sensor";
     transformTfGeom.header.stamp = odomTime;
     tfBroadcaster->sendTransform(transformTfGeom);
 
     // publish 200Hz Unity model state messages (this is for Unity Simulation)
-    robotState.header.stamp = odomTime;
-    robotState.pose.orientation = geoQuat;
-    robotState.pose.position.x = vehicleX;
-    robotState.pose.position.y = vehicleY;
-    robotState.pose.position.z = vehicleZ;
-    pubModelState->publish(robotState);
+    if (!headless)
+    {
+      robotState.header.stamp = odomTime;
+      robotState.pose.orientation = geoQuat;
+      robotState.pose.position.x = vehiclePose.vehicleX;
+      robotState.pose.position.y = vehiclePose.vehicleY;
+      robotState.pose.position.z = vehiclePose.vehicleZ;
+      pubModelState->publish(robotState);
+    }
+  };
+
+  // headless, the clock is published ahead of the odometry at its time
+  auto publishHeadless = [&](int64_t simTime) {
+    odomTime = rclcpp::Time(simTime);
+    clockData.clock = odomTime;
+    pubClock->publish(clockData);
+    publishState();
+  };
+
+  rclcpp::Rate rate(200);
+  bool status = rclcpp::ok();
+  while (status)
+  {
+    if (headless)
+    {
+      simClock.runStep(spinSome, stepModel, publishHeadless, lockstep, spinForCmdVel, lockstepTimeout);
+    }
+    else
+    {
+      spinSome();
+      stepModel();
+      odomTime = nh->now();
+      publishState();
+      rate.sleep();
+    }
 
     status = rclcpp::ok();
-    rate.sleep();
   }
 
   return 0;
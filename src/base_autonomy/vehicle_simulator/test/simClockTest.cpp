@@ -0,0 +1,240 @@
+#include <math.h>
+#include <stdint.h>
+#include <chrono>
+#include <deque>
+
+#include <gtest/gtest.h>
+
+#include "vehicle_simulator/simClock.h"
+#include "vehicle_simulator/vehicleModel.h"
+
+using namespace std;
+
+namespace
+{
+
+const int64_t stepTime = 5000000;
+const int64_t startTime = 1700000000000000000;
+
+struct Command
+{
+  int64_t stamp;
+  float fwdSpeed, leftSpeed, yawRate;
+};
+
+// stands in for pathFollower, answers the odometry at time t with a command stamped t, standing
+// still for the first second and then driving a slowly varying curve
+Command scriptCommand(int64_t t)
+{
+  double sec = (t - startTime) / 1.0e9;
+  Command cmd = {t, 0, 0, 0};
+  if (sec >= 1.0) {
+    cmd.fwdSpeed = 1.0 + 0.5 * sin(0.2 * sec);
+    cmd.leftSpeed = 0.3 * sin(0.05 * sec);
+    cmd.yawRate = 0.6 * sin(0.15 * sec) + 0.1;
+  }
+  return cmd;
+}
+
+// a consumer whose answer to an odometry comes in after latency spins of the simulator's executor
+class ScriptedConsumer
+{
+public:
+  explicit ScriptedConsumer(int latency) : latency(latency) {}
+
+  void receiveOdometry(int64_t t) { pending.push_back({latency, scriptCommand(t)}); }
+
+  // delivers the answers due at this spin, the latest one is the current command
+  void spin()
+  {
+    for (Pending& p : pending) p.spinsLeft--;
+    while (!pending.empty() && pending.front().spinsLeft <= 0) {
+      current = pending.front().cmd;
+      pending.pop_front();
+    }
+  }
+
+  Command current = {-1, 0, 0, 0};
+
+private:
+  struct Pending
+  {
+    int spinsLeft;
+    Command cmd;
+  };
+
+  int latency;
+  deque<Pending> pending;
+};
+
+struct DriveResult
+{
+  VehiclePose pose;
+  double wallTime;
+  int timeouts;
+};
+
+// the headless loop of vehicleSimulator on flat terrain, with its steps run as vehicleSimulator runs
+// them, the scripted consumer taking the odometry and answering with the commands
+DriveResult driveHeadless(double realTimeFactor, bool lockstep, int latency, double duration)
+{
+  VehicleModelParams modelParams;
+  modelParams.sensorOffsetX = 0.3;
+  modelParams.sensorOffsetY = -0.1;
+  VehicleModel model(modelParams);
+  SimClock simClock(startTime, stepTime, realTimeFactor);
+  ScriptedConsumer consumer(latency);
+
+  DriveResult result;
+  result.timeouts = 0;
+  auto spinOnce = [&consumer]() {
+    consumer.spin();
+    return consumer.current.stamp;
+  };
+  auto stepModel = [&]() {
+    const Command& cmd = consumer.current;
+    model.step(cmd.fwdSpeed, cmd.leftSpeed, cmd.yawRate, 0, 0, 0, stepTime / 1.0e9, result.pose);
+  };
+  auto publish = [&consumer](int64_t t) { consumer.receiveOdometry(t); };
+
+  chrono::steady_clock::time_point wallStart = chrono::steady_clock::now();
+  int stepNum = int(duration * 1.0e9 / stepTime + 0.5);
+  for (int i = 0; i < stepNum; i++) {
+    if (!simClock.runStep(spinOnce, stepModel, publish, lockstep, spinOnce, 0.1)) result.timeouts++;
+  }
+  result.wallTime = chrono::duration<double>(chrono::steady_clock::now() - wallStart).count();
+  return result;
+}
+
+void expectSamePose(const VehiclePose& pose, const VehiclePose& poseRef)
+{
+  EXPECT_EQ(pose.vehicleX, poseRef.vehicleX);
+  EXPECT_EQ(pose.vehicleY, poseRef.vehicleY);
+  EXPECT_EQ(pose.vehicleZ, poseRef.vehicleZ);
+  EXPECT_EQ(pose.vehicleRoll, poseRef.vehicleRoll);
+  EXPECT_EQ(pose.vehiclePitch, poseRef.vehiclePitch);
+  EXPECT_EQ(pose.vehicleYaw, poseRef.vehicleYaw);
+}
+
+double elapsedSince(chrono::steady_clock::time_point start)
+{
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+TEST(SimClock, Steps)
+{
+  SimClock simClock(1000, 5, 0);
+  EXPECT_EQ(simClock.time(), 1000);
+  EXPECT_EQ(simClock.stepCount(), 0);
+  EXPECT_EQ(simClock.step(), 1005);
+  EXPECT_EQ(simClock.step(), 1010);
+  EXPECT_EQ(simClock.time(), 1010);
+  EXPECT_EQ(simClock.stepCount(), 2);
+}
+
+TEST(SimClock, PacesAtRealTimeFactor)
+{
+  // 40 steps of 5ms at 4 times real time take 50ms of wall time
+  SimClock simClock(0, stepTime, 4.0);
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  for (int i = 0; i < 40; i++) {
+    simClock.step();
+    simClock.pace();
+  }
+  EXPECT_GE(elapsedSince(start), 0.05);
+
+  // and as fast as possible if the factor is not positive, 40 steps of 1s take a lot less than 40s
+  SimClock fastClock(0, 1000000000, 0);
+  start = chrono::steady_clock::now();
+  for (int i = 0; i < 40; i++) {
+    fastClock.step();
+    fastClock.pace();
+  }
+  EXPECT_LT(elapsedSince(start), 4.0);
+}
+
+TEST(SimClock, WaitForCommand)
+{
+  SimClock simClock(startTime, stepTime, 0);
+  simClock.step();
+
+  // answered already, a single spin
+  int spinNum = 0;
+  EXPECT_TRUE(simClock.waitForCommand([&]() { spinNum++; return simClock.time(); }, 0.1));
+  EXPECT_EQ(spinNum, 1);
+
+  // answered at the fourth spin, a stale command before
+  spinNum = 0;
+  auto answerAtFour = [&]() {
+    spinNum++;
+    return spinNum < 4 ? simClock.time() - stepTime : simClock.time();
+  };
+  EXPECT_TRUE(simClock.waitForCommand(answerAtFour, 0.1));
+  EXPECT_EQ(spinNum, 4);
+
+  // never answered, gives up after the timeout
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  EXPECT_FALSE(simClock.waitForCommand([&]() { return simClock.time() - stepTime; }, 0.05));
+  EXPECT_GE(elapsedSince(start), 0.05);
+}
+
+TEST(VehicleModel, TurnsAboutCenter)
+{
+  // turning in place, the sensor circles the vehicle center, sensorOffsetX and sensorOffsetY away
+  VehicleModelParams modelParams;
+  modelParams.sensorOffsetX = 0.3;
+  modelParams.sensorOffsetY = -0.1;
+  modelParams.vehicleHeight = 0.5;
+  VehicleModel model(modelParams);
+
+  VehiclePose pose;
+  pose.vehicleX = 2.0;
+  pose.vehicleY = 1.0;
+  float centerX = pose.vehicleX - modelParams.sensorOffsetX;
+  float centerY = pose.vehicleY - modelParams.sensorOffsetY;
+  for (int i = 0; i < 1000; i++) {
+    model.step(0, 0, 1.0, 0.2, 0, 0, 0.005, pose);
+
+    float offsetX = pose.vehicleX - centerX;
+    float offsetY = pose.vehicleY - centerY;
+    float yaw = pose.vehicleYaw;
+    EXPECT_NEAR(cos(yaw) * offsetX + sin(yaw) * offsetY, modelParams.sensorOffsetX, 0.005);
+    EXPECT_NEAR(-sin(yaw) * offsetX + cos(yaw) * offsetY, modelParams.sensorOffsetY, 0.005);
+    EXPECT_LE(fabs(yaw), 3.1415926);
+  }
+  EXPECT_FLOAT_EQ(pose.vehicleZ, 0.7);
+}
+
+TEST(SimClock, LockstepDrive)
+{
+  // a consumer answering the next spin drives the reference path, with a slower consumer the
+  // free-running clock runs ahead of the commands, lockstep waits for them and drives the same path,
+  // as fast as possible the 60s take a fraction of the wall time
+  const double duration = 60.0;
+  DriveResult reference = driveHeadless(0, false, 1, duration);
+  float disRef = sqrt(reference.pose.vehicleX * reference.pose.vehicleX +
+                      reference.pose.vehicleY * reference.pose.vehicleY);
+  EXPECT_GT(disRef, 5.0);
+
+  DriveResult freeRunning = driveHeadless(0, false, 5, duration);
+  EXPECT_GT(fabs(freeRunning.pose.vehicleX - reference.pose.vehicleX) +
+            fabs(freeRunning.pose.vehicleY - reference.pose.vehicleY), 0.01);
+
+  {
+    SCOPED_TRACE("as fast as possible");
+    DriveResult lockstep = driveHeadless(0, true, 5, duration);
+    expectSamePose(lockstep.pose, reference.pose);
+    EXPECT_EQ(lockstep.timeouts, 0);
+    EXPECT_LT(lockstep.wallTime, duration / 4);
+  }
+  {
+    SCOPED_TRACE("20 times real time");
+    DriveResult lockstep = driveHeadless(20.0, true, 5, duration);
+    expectSamePose(lockstep.pose, reference.pose);
+    EXPECT_EQ(lockstep.timeouts, 0);
+    // paced, so never ahead of the wall time, how far behind depends on the load of the host
+    EXPECT_GE(lockstep.wallTime, duration / 20.0);
+  }
+}
@@ -1,5 +1,130 @@
+#include <charconv>
+#include <cmath>
+#include <cstring>
 #include "ros2_sport_client.h"
 
+namespace
+{
+
+// write a float the way nlohmann::json::dump() does: widened to double with the shortest
+// round trip digits, ".0" on integral values, an exponent below 1e-4 and from 1e15 on, and
+// null for NaN and infinity, buf needs 32 chars
+char *writeJsonFloat(char *buf, float value)
+{
+    double v = value;
+    if (!std::isfinite(v))
+    {
+        memcpy(buf, "null", 4);
+        return buf + 4;
+    }
+
+    if (std::signbit(v))
+    {
+        *buf++ = '-';
+        v = -v;
+    }
+
+    if (v == 0)
+    {
+        memcpy(buf, "0.0", 3);
+        return buf + 3;
+    }
+
+    // d[.ddd]e+XX, collect the digits and the exponent of the last one
+    char sci[32];
+    std::to_chars_result res = std::to_chars(sci, sci + sizeof(sci), v, std::chars_format::scientific);
+    const char *c = sci;
+    int k = 0;
+    while (*c != 'e')
+    {
+        if (*c != '.') buf[k++] = *c;
+        c++;
+    }
+    c++;
+    bool expNeg = (*c == '-');
+    int exp = 0;
+    for (c++; c < res.ptr; c++)
+    {
+        exp = 10 * exp + (*c - '0');
+    }
+    if (expNeg) exp = -exp;
+
+    // position of the decimal point relative to the first digit, as in nlohmann format_buffer()
+    const int minExp = -4, maxExp = 15;
+    int n = exp + 1;
+    if (k <= n && n <= maxExp)
+    {
+        memset(buf + k, '0', n - k);
+        buf[n] = '.';
+        buf[n + 1] = '0';
+        return buf + n + 2;
+    }
+
+    if (0 < n && n <= maxExp)
+    {
+        memmove(buf + n + 1, buf + n, k - n);
+        buf[n] = '.';
+        return buf + k + 1;
+    }
+
+    if (minExp < n && n <= 0)
+    {
+        memmove(buf + 2 - n, buf, k);
+        buf[0] = '0';
+        buf[1] = '.';
+        memset(buf + 2, '0', -n);
+        return buf + 2 - n + k;
+    }
+
+    if (k > 1)
+    {
+        memmove(buf + 2, buf + 1, k - 1);
+        buf[1] = '.';
+        buf += k + 1;
+    }
+    else
+    {
+        buf += 1;
+    }
+
+    int e = n - 1;
+    *buf++ = 'e';
+    *buf++ = e < 0 ? '-' : '+';
+    if (e < 0) e = -e;
+    if (e >= 100) *buf++ = '0' + e / 100;
+    *buf++ = '0' + e / 10 % 10;
+    *buf++ = '0' + e % 10;
+    return buf;
+}
+
+// {"x":x,"y":y,"z":z} as nlohmann::json would dump it, keys in its sorted order, the string
+// keeps its capacity when the request is reused so steady commands do not allocate
+void writeXyzParameter(std::string &parameter, float x, float y, float z)
+{
+    char buf[128];
+    char *p = buf;
+    memcpy(p, "{\"x\":", 5);
+    p = writeJsonFloat(p + 5, x);
+    memcpy(p, ",\"y\":", 5);
+    p = writeJsonFloat(p + 5, y);
+    memcpy(p, ",\"z\":", 5);
+    p = writeJsonFloat(p + 5, z);
+    *p++ = '}';
+    parameter.assign(buf, p - buf);
+}
+
+void writeDataParameter(std::string &parameter, float data)
+{
+    char buf[64];
+    char *p = buf;
+    memcpy(p, "{\"data\":", 8);
+    p = writeJsonFloat(p + 8, data);
+    *p++ = '}';
+    parameter.assign(buf, p - buf);
+}
+
+}
+
 void SportClient::Damp(unitree_api::msg::Request &req)
 {
     req.header.identity.api_id = ROBOT_SPORT_API_ID_DAMP;
@@ -32,21 +157,13 @@ void SportClient::RecoveryStand(unitree_api::msg::Request &req)
 
 void SportClient::Euler(unitree_api::msg::Request &req, float roll, float pitch, float yaw)
 {
-    nlohmann::json js;
-    js["x"] = roll;
-    js["y"] = pitch;
-    js["z"] = yaw;
-    req.parameter = js.dump();
+    writeXyzParameter(req.parameter, roll, pitch, yaw);
     req.header.identity.api_id = ROBOT_SPORT_API_ID_EULER;
 }
 
 void SportClient::Move(unitree_api::msg::Request &req, float vx, float vy, float vyaw)
 {
-    nlohmann::json js;
-    js["x"] = vx;
-    js["y"] = vy;
-    js["z"] = vyaw;
-    req.parameter = js.dump();
+    writeXyzParameter(req.parameter, vx, vy, vyaw);
     req.header.identity.api_id = ROBOT_SPORT_API_ID_MOVE;
 }
 
@@ -75,17 +192,13 @@ void SportClient::Trigger(unitree_api::msg::Request &req)
 
 void SportClient::BodyHeight(unitree_api::msg::Request &req, float height)
 {
-    nlohmann::json js;
-    js["data"] = height;
-    req.parameter = js.dump();
+    writeDataParameter(req.parameter, height);
     req.header.identity.api_id = ROBOT_SPORT_API_ID_BODYHEIGHT;
 }
 
 void SportClient::FootRaiseHeight(unitree_api::msg::Request &req, float height)
 {
-    nlohmann::json js;
-    js["data"] = height;
-    req.parameter = js.dump();
+    writeDataParameter(req.parameter, height);
     req.header.identity.api_id = ROBOT_SPORT_API_ID_FOOTRAISEHEIGHT;
 }
 
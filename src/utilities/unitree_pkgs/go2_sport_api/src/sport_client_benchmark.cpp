@@ -0,0 +1,54 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "common/ros2_sport_client.h"
+#include "unitree_api/msg/request.hpp"
+
+// times the Move parameter written by SportClient against the nlohmann::json encoding it
+// replaced, sportClientTest checks that both parse to the same object
+
+std::string jsonMoveParameter(float vx, float vy, float vyaw)
+{
+    nlohmann::json js;
+    js["x"] = vx;
+    js["y"] = vy;
+    js["z"] = vyaw;
+    return js.dump();
+}
+
+int main(int argc, char **argv)
+{
+    int commandNum = 1000000;
+    if (argc > 1) commandNum = atoi(argv[1]);
+    if (commandNum <= 0)
+    {
+        printf("Usage: sport_client_benchmark [commandNum]\n");
+        return 1;
+    }
+
+    SportClient sport_req;
+    unitree_api::msg::Request req;
+
+    size_t paramSize = 0;
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    for (int i = 0; i < commandNum; i++)
+    {
+        req.parameter = jsonMoveParameter(0.001 * (i % 1000), -0.25, 0.3);
+        paramSize += req.parameter.size();
+    }
+    double jsonTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    startTime = std::chrono::steady_clock::now();
+    for (int i = 0; i < commandNum; i++)
+    {
+        sport_req.Move(req, 0.001 * (i % 1000), -0.25, 0.3);
+        paramSize += req.parameter.size();
+    }
+    double moveTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    printf("nlohmann::json: %.0f commands/s, Move: %.0f commands/s (%zu chars)\n", commandNum / jsonTime,
+           commandNum / moveTime, paramSize);
+
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "common/ros2_sport_client.h"
+#include "unitree_api/msg/request.hpp"
+
+namespace
+{
+
+// the nlohmann::json encoding the sport commands used before
+std::string jsonXyzParameter(float x, float y, float z)
+{
+    nlohmann::json js;
+    js["x"] = x;
+    js["y"] = y;
+    js["z"] = z;
+    return js.dump();
+}
+
+std::string jsonDataParameter(float data)
+{
+    nlohmann::json js;
+    js["data"] = data;
+    return js.dump();
+}
+
+std::string moveParameter(float vx, float vy, float vyaw)
+{
+    SportClient sport_req;
+    unitree_api::msg::Request req;
+    sport_req.Move(req, vx, vy, vyaw);
+    EXPECT_EQ(req.header.identity.api_id, ROBOT_SPORT_API_ID_MOVE);
+    return req.parameter;
+}
+
+// both must parse to the same object, NaN and infinity are null in both
+void expectSameJson(const std::string &parameter, const std::string &expected)
+{
+    nlohmann::json js = nlohmann::json::parse(parameter);
+    nlohmann::json expectedJs = nlohmann::json::parse(expected);
+    EXPECT_EQ(js, expectedJs) << parameter << " vs " << expected;
+
+    // json equality does not tell -0.0 from 0.0
+    for (const auto &item : expectedJs.items())
+    {
+        if (item.value().is_number_float())
+        {
+            EXPECT_EQ(std::signbit(js[item.key()].get<double>()), std::signbit(item.value().get<double>()))
+                << parameter << " vs " << expected;
+        }
+    }
+}
+
+// floats around the limits of the encoding, with their neighbours
+std::vector<float> edgeValues()
+{
+    std::vector<float> values = {0.0f,
+                                 -0.0f,
+                                 std::numeric_limits<float>::quiet_NaN(),
+                                 -std::numeric_limits<float>::quiet_NaN(),
+                                 std::numeric_limits<float>::infinity(),
+                                 -std::numeric_limits<float>::infinity(),
+                                 std::numeric_limits<float>::denorm_min(),
+                                 -std::numeric_limits<float>::denorm_min(),
+                                 FLT_MIN / 3,
+                                 std::nextafter(FLT_MIN, 0.0f),
+                                 FLT_MIN,
+                                 FLT_MAX,
+                                 -FLT_MAX,
+                                 1.0f,
+                                 -1.0f,
+                                 0.1f,
+                                 0.3f,
+                                 -0.25f,
+                                 123456.0f,
+                                 16777216.0f};
+
+    // the decimal point turns into an exponent below 1e-4 and from 1e15 on
+    const float boundaries[] = {1e-5f, 1e-4f, 1e-3f, 1e14f, 1e15f, 1e16f};
+    for (float b : boundaries)
+    {
+        for (float sign : {1.0f, -1.0f})
+        {
+            float v = sign * b;
+            values.push_back(v);
+            values.push_back(std::nextafter(v, 0.0f));
+            values.push_back(std::nextafter(v, sign * INFINITY));
+        }
+    }
+    return values;
+}
+
+}
+
+TEST(SportClient, MoveEdgeValuesMatchJson)
+{
+    std::vector<float> values = edgeValues();
+    for (float v : values)
+    {
+        expectSameJson(moveParameter(v, 0.5f, -v), jsonXyzParameter(v, 0.5f, -v));
+    }
+}
+
+TEST(SportClient, EdgeValuesKeepJsonText)
+{
+    // the shortest digits agree here, the layout of the decimal point and exponent must too
+    std::vector<float> values = edgeValues();
+    for (float v : values)
+    {
+        EXPECT_EQ(moveParameter(v, 0.5f, -v), jsonXyzParameter(v, 0.5f, -v));
+    }
+}
+
+TEST(SportClient, EdgeValueText)
+{
+    EXPECT_EQ(moveParameter(0.0f, -0.0f, 1.0f), "{\"x\":0.0,\"y\":-0.0,\"z\":1.0}");
+    EXPECT_EQ(moveParameter(NAN, INFINITY, -INFINITY), "{\"x\":null,\"y\":null,\"z\":null}");
+}
+
+TEST(SportClient, MoveRandomBitsMatchJson)
+{
+    // random bit patterns cover the exponent range, subnormals, NaN and infinity
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<uint32_t> bitDist;
+    std::uniform_real_distribution<float> speedDist(-2.0, 2.0);
+    for (int i = 0; i < 100000; i++)
+    {
+        uint32_t bits = bitDist(rng);
+        float vx;
+        memcpy(&vx, &bits, sizeof(vx));
+        float vy = speedDist(rng);
+        float vyaw = std::round(100 * speedDist(rng)) / 100;
+        expectSameJson(moveParameter(vx, vy, vyaw), jsonXyzParameter(vx, vy, vyaw));
+        if (HasFailure()) break;
+    }
+}
+
+TEST(SportClient, EulerAndHeightsMatchJson)
+{
+    SportClient sport_req;
+    unitree_api::msg::Request req;
+    std::vector<float> values = edgeValues();
+    for (float v : values)
+    {
+        sport_req.Euler(req, v, -v, 0.1f);
+        EXPECT_EQ(req.header.identity.api_id, ROBOT_SPORT_API_ID_EULER);
+        expectSameJson(req.parameter, jsonXyzParameter(v, -v, 0.1f));
+
+        sport_req.BodyHeight(req, v);
+        EXPECT_EQ(req.header.identity.api_id, ROBOT_SPORT_API_ID_BODYHEIGHT);
+        expectSameJson(req.parameter, jsonDataParameter(v));
+
+        sport_req.FootRaiseHeight(req, v);
+        EXPECT_EQ(req.header.identity.api_id, ROBOT_SPORT_API_ID_FOOTRAISEHEIGHT);
+        expectSameJson(req.parameter, jsonDataParameter(v));
+    }
+}